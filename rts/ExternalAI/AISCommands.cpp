@@ -129,7 +129,9 @@ void freeSUnitCommand(void* sCommandData, int sCommandId) {
 	FREE(sCommandData);
 }
 
-static float* allocFloatArr3(const std::vector<float>& from, const size_t firstValIndex = 0) {
+// Command::params is a std::vector<float> for AIs and a CommandParams in the engine
+template<typename ParamsType>
+static float* allocFloatArr3(const ParamsType& from, const size_t firstValIndex = 0) {
 
 	float* to = (float*) calloc(3, sizeof(float));
 
@@ -14,13 +14,13 @@ CSkirmishAI::CSkirmishAI(int skirmishAIId, int teamId, const SkirmishAIKey& key,
 		skirmishAIId(skirmishAIId),
 		key(key),
 		callback(callback),
-		timerName("AI t:" + IntToString(teamId) +
+		timerID(profiler.GetTimerID("AI t:" + IntToString(teamId) +
 		          " id:" + IntToString(skirmishAIId) +
-		          " " + key.GetShortName() + " " + key.GetVersion()),
+		          " " + key.GetShortName() + " " + key.GetVersion())),
 		initOk(false),
 		dieing(false)
 {
-	SCOPED_TIMER(timerName.c_str());
+	ScopedTimer timer(timerID);
 	library = IAILibraryManager::GetInstance()->FetchSkirmishAILibrary(key);
 	if (library == NULL) {
 		dieing = true;
@@ -31,7 +31,7 @@ CSkirmishAI::CSkirmishAI(int skirmishAIId, int teamId, const SkirmishAIKey& key,
 
 CSkirmishAI::~CSkirmishAI() {
 
-	SCOPED_TIMER(timerName.c_str());
+	ScopedTimer timer(timerID);
 	if (initOk) {
 		library->Release(skirmishAIId);
 	}
@@ -52,7 +52,7 @@ void CSkirmishAI::Dieing() {
 
 int CSkirmishAI::HandleEvent(int topic, const void* data) const {
 
-	SCOPED_TIMER(timerName.c_str());
+	ScopedTimer timer(timerID);
 	if (!dieing || (topic == EVENT_RELEASE)) {
 		return library->HandleEvent(skirmishAIId, topic, data);
 	} else {
@@ -47,7 +47,7 @@ private:
 	const SkirmishAIKey key;
 	const CSkirmishAILibrary* library;
 	const SSkirmishAICallback* callback;
-	const std::string timerName;
+	const int timerID;
 	bool initOk;
 	bool dieing;
 };
@@ -1,5 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
 #include <vector>
 #include <cstdio>
 
@@ -13,10 +14,13 @@
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Features/FeatureHandler.h"
 #include "System/TimeProfiler.h"
+#include "System/Log/ILog.h"
+#include "System/Platform/Misc.h"
 
 bool CBenchmark::enabled = false;
 int CBenchmark::startFrame = 0;
 int CBenchmark::endFrame = 5 * 60 * GAME_SPEED;
+std::string CBenchmark::reportFile;
 
 
 CBenchmark::CBenchmark()
@@ -58,20 +62,31 @@ CBenchmark::~CBenchmark()
 
 void CBenchmark::GameFrame(int gameFrame)
 {
-	if (gameFrame == 0 && (startFrame - 15 * GAME_SPEED > 0)) {
+	if (gameFrame == 0 && (startFrame - 15 * GAME_SPEED > 0 || !reportFile.empty())) {
 		std::vector<string> cmds;
 		cmds.push_back("@@setmaxspeed 100");
 		cmds.push_back("@@setminspeed 100");
 		guihandler->RunCustomCommands(cmds, false);
 	}
 
-	if (gameFrame == (startFrame - 15 * GAME_SPEED)) {
+	// when only measuring the sim there are no fps samples to take in realtime
+	if (gameFrame == (startFrame - 15 * GAME_SPEED) && reportFile.empty()) {
 		std::vector<string> cmds;
 		cmds.push_back("@@setminspeed 1");
 		cmds.push_back("@@setmaxspeed 1");
 		guihandler->RunCustomCommands(cmds, false);
 	}
 
+	if (gameFrame == startFrame && !reportFile.empty()) {
+		profiler.ProcessEvents();
+
+		for (const auto& p: profiler.profile) {
+			startTimerTotals[p.first] = p.second.total;
+		}
+
+		startTime = spring_gettime();
+	}
+
 	if (gameFrame >= startFrame) {
 		simFPS[gameFrame] = (gu->avgSimFrameTime == 0.0f)? 0.0f: 1000.0f / gu->avgSimFrameTime;
 		units[gameFrame] = unitHandler->units.size();
@@ -81,10 +96,58 @@ void CBenchmark::GameFrame(int gameFrame)
 	}
 
 	if (gameFrame == endFrame) {
+		if (!reportFile.empty())
+			WriteReport();
+
 		gu->globalQuit = true;
 	}
 }
 
+void CBenchmark::WriteReport() const
+{
+	profiler.ProcessEvents();
+
+	FILE* pFile = fopen(reportFile.c_str(), "w");
+
+	if (pFile == NULL) {
+		LOG_L(L_ERROR, "[Benchmark] could not open \"%s\" for writing", reportFile.c_str());
+		return;
+	}
+
+	const int numFrames = endFrame - startFrame;
+	const float wallTime = (spring_gettime() - startTime).toSecsf();
+
+	fprintf(pFile, "{\n");
+	fprintf(pFile, "\t\"startFrame\": %i,\n", startFrame);
+	fprintf(pFile, "\t\"endFrame\": %i,\n", endFrame);
+	fprintf(pFile, "\t\"wallTime\": %f,\n", wallTime);
+	fprintf(pFile, "\t\"simFramesPerSec\": %f,\n", (wallTime > 0.0f)? (numFrames / wallTime): 0.0f);
+	fprintf(pFile, "\t\"peakRSS\": %llu,\n", Platform::GetPeakMemoryUsage());
+	fprintf(pFile, "\t\"units\": " _STPF_ ",\n", unitHandler->units.size());
+	fprintf(pFile, "\t\"features\": " _STPF_ ",\n", featureHandler->GetActiveFeatures().size());
+
+	// time spent per profiler timer during the measured frames, in ms
+	fprintf(pFile, "\t\"timers\": {");
+
+	for (auto pi = profiler.profile.cbegin(); pi != profiler.profile.cend(); ++pi) {
+		const auto si = startTimerTotals.find(pi->first);
+		const spring_time total = pi->second.total - ((si != startTimerTotals.end())? si->second: spring_notime);
+
+		fprintf(pFile, "%s\n\t\t\"%s\": {\"total\": %f, \"perFrame\": %f, \"maxLag\": %f}",
+			(pi == profiler.profile.cbegin())? "": ",",
+			pi->first.c_str(),
+			total.toMilliSecsf(),
+			total.toMilliSecsf() / std::max(numFrames, 1),
+			pi->second.maxLag);
+	}
+
+	fprintf(pFile, "\n\t}\n");
+	fprintf(pFile, "}\n");
+	fclose(pFile);
+
+	LOG("[Benchmark] %i frames in %.2fs (%.1f frames/s), report written to \"%s\"", numFrames, wallTime, numFrames / std::max(wallTime, 0.001f), reportFile.c_str());
+}
+
 void CBenchmark::DrawWorld()
 {
 	if (!simFPS.empty()) {
@@ -4,8 +4,10 @@
 #define _ROAM_MESH_DRAWER_H_
 
 #include <map>
+#include <string>
 
 #include "System/EventHandler.h"
+#include "System/Misc/SpringTime.h"
 
 
 class CBenchmark : public CEventClient
@@ -14,6 +16,8 @@ public:
 	static bool enabled;
 	static int startFrame;
 	static int endFrame;
+	/// if set, the sim runs at max speed and a JSON summary is written here at endFrame
+	static std::string reportFile;
 
 public:
 	CBenchmark();
@@ -27,6 +31,7 @@ public:
 		features.clear();
 		gameSpeed.clear();
 		luaUsage.clear();
+		startTimerTotals.clear();
 	}
 
 	// CEventClient interface
@@ -39,6 +44,9 @@ public:
 	void GameFrame(int gameFrame);
 	void DrawWorld();
 
+private:
+	void WriteReport() const;
+
 private:
 	std::map<float, float> realFPS;
 	std::map<float, float> drawFPS;
@@ -47,6 +55,10 @@ private:
 	std::map<int, size_t>  features;
 	std::map<int, float>   gameSpeed;
 	std::map<int, float>   luaUsage;
+
+	/// profiler totals and wall-time at startFrame, for the report
+	std::map<std::string, spring_time> startTimerTotals;
+	spring_time startTime;
 };
 
 #endif // _ROAM_MESH_DRAWER_H_
@@ -125,6 +125,7 @@
 #include "System/EventHandler.h"
 #include "System/Exceptions.h"
 #include "System/Sync/FPUCheck.h"
+#include "System/Sync/SyncedPrimitiveBase.h"
 #include "System/GlobalConfig.h"
 #include "System/myMath.h"
 #include "Net/GameServer.h"
@@ -132,6 +133,8 @@
 #include "System/SpringApp.h"
 #include "System/Util.h"
 #include "System/Input/KeyInput.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/VFSHandler.h"
 #include "System/LoadSave/LoadSaveHandler.h"
@@ -155,6 +158,7 @@ CONFIG(int, ShowPlayerInfo).defaultValue(1).headlessValue(0);
 CONFIG(float, GuiOpacity).defaultValue(0.8f).minimumValue(0.0f).maximumValue(1.0f).description("Sets the opacity of the built-in Spring UI. Generally has no effect on LuaUI widgets. Can be set in-game using shift+, to decrease and shift+. to increase.");
 CONFIG(std::string, InputTextGeo).defaultValue("");
 CONFIG(bool, LuaModUICtrl).defaultValue(true).headlessValue(false);
+CONFIG(std::string, ProfilingTraceFile).defaultValue("").description("If set, all profiler timer events of a game are recorded and written to this file (Chrome trace-event JSON, see chrome://tracing) when it ends.");
 
 
 CGame* game = NULL;
@@ -330,6 +334,20 @@ CGame::CGame(const std::string& mapName, const std::string& modName, ILoadSaveHa
 	CWordCompletion::CreateInstance();
 }
 
+static void StopProfilingTrace()
+{
+	if (!profiler.IsTracing())
+		return;
+
+	std::string fileName = configHandler->GetString("ProfilingTraceFile");
+
+	if (fileName.empty())
+		fileName = "profiling_trace.json";
+
+	profiler.StopTrace(dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE));
+}
+
+
 CGame::~CGame()
 {
 #ifdef TRACE_SYNC
@@ -339,6 +357,8 @@ CGame::~CGame()
 	ENTER_SYNCED_CODE();
 	LOG("[%s]1]", __FUNCTION__);
 
+	StopProfilingTrace();
+
 	KillLua();
 	KillMisc();
 	KillRendering();
@@ -1479,6 +1499,9 @@ void CGame::StartPlaying()
 	playing = true;
 	lastReadNetTime = spring_gettime();
 
+	if (!configHandler->GetString("ProfilingTraceFile").empty())
+		profiler.StartTrace();
+
 	gu->startTime = gu->gameTime;
 	gu->myTeam = playerHandler->Player(gu->myPlayerNum)->team;
 	gu->myAllyTeam = teamHandler->AllyTeam(gu->myTeam);
@@ -1556,18 +1579,38 @@ void CGame::SimFrame() {
 	SCOPED_TIMER("SimFrame");
 	helper->Update();
 	mapDamage->Update();
-	pathManager->Update();
-	unitHandler->Update();
-	projectileHandler->Update();
-	featureHandler->Update();
-	GCobEngine.Tick(33);
-	GUnitScriptEngine.Tick(33);
+	{
+		SCOPED_SYNC_LANE(SYNC_LANE_PATHING);
+		pathManager->Update();
+	}
+	{
+		SCOPED_SYNC_LANE(SYNC_LANE_UNITS);
+		unitHandler->Update();
+	}
+	{
+		SCOPED_SYNC_LANE(SYNC_LANE_PROJECTILES);
+		projectileHandler->Update();
+	}
+	{
+		SCOPED_SYNC_LANE(SYNC_LANE_FEATURES);
+		featureHandler->Update();
+	}
+	{
+		SCOPED_SYNC_LANE(SYNC_LANE_SCRIPTS);
+		GCobEngine.Tick(33);
+		GUnitScriptEngine.Tick(33);
+	}
 	wind.Update();
-	losHandler->Update();
-	interceptHandler.Update(false);
-
-	teamHandler->GameFrame(gs->frameNum);
-	playerHandler->GameFrame(gs->frameNum);
+	{
+		SCOPED_SYNC_LANE(SYNC_LANE_LOS);
+		losHandler->Update();
+		interceptHandler.Update(false);
+	}
+	{
+		SCOPED_SYNC_LANE(SYNC_LANE_TEAMS);
+		teamHandler->GameFrame(gs->frameNum);
+		playerHandler->GameFrame(gs->frameNum);
+	}
 
 	lastSimFrameTime = spring_gettime();
 	gu->avgSimFrameTime = mix(gu->avgSimFrameTime, (lastSimFrameTime - lastFrameTime).toMilliSecsf(), 0.05f);
@@ -1646,6 +1689,7 @@ void CGame::GameEnd(const std::vector<unsigned char>& winningAllyTeams, bool tim
 #ifdef    HEADLESS
 	profiler.PrintProfilingInfo();
 #endif // HEADLESS
+	StopProfilingTrace();
 
 	CDemoRecorder* record = clientNet->GetDemoRecorder();
 
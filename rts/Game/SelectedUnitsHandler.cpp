@@ -929,7 +929,7 @@ void CSelectedUnitsHandler::SendCommand(const Command& c)
 		selectionChanged = false;
 	}
 
-	clientNet->Send(CBaseNetProtocol::Get().SendCommand(gu->myPlayerNum, c.GetID(), c.options, c.params));
+	clientNet->Send(CBaseNetProtocol::Get().SendCommand(gu->myPlayerNum, c.GetID(), c.options, c.params.data(), c.params.size()));
 }
 
 
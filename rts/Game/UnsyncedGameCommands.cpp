@@ -80,6 +80,8 @@
 #include "System/Log/ILog.h"
 #include "System/GlobalConfig.h"
 #include "Net/Protocol/NetProtocol.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/SimpleParser.h"
 #include "System/Sound/ISound.h"
 #include "System/Sound/ISoundChannels.h"
@@ -2873,6 +2875,29 @@ public:
 
 
 
+class ProfilingTraceActionExecutor : public IUnsyncedActionExecutor {
+public:
+	ProfilingTraceActionExecutor() : IUnsyncedActionExecutor("ProfilingTrace",
+			"Starts recording all profiler timer events, or stops and writes"
+			" them as Chrome trace-event JSON to the given file (default:"
+			" profiling_trace.json)") {}
+
+	bool Execute(const UnsyncedAction& action) const {
+		if (!profiler.IsTracing()) {
+			profiler.StartTrace();
+			LOG("[ProfilingTrace] recording");
+			return true;
+		}
+
+		const std::string fileName = action.GetArgs().empty()? "profiling_trace.json": action.GetArgs();
+
+		profiler.StopTrace(dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE));
+		return true;
+	}
+};
+
+
+
 class RedirectToSyncedActionExecutor : public IUnsyncedActionExecutor {
 public:
 	RedirectToSyncedActionExecutor(const std::string& command)
@@ -3195,6 +3220,7 @@ void UnsyncedGameCommands::AddDefaultActionExecutors() {
 	AddActionExecutor(new ReloadGameActionExecutor());
 	AddActionExecutor(new ReloadShadersActionExecutor());
 	AddActionExecutor(new DebugInfoActionExecutor());
+	AddActionExecutor(new ProfilingTraceActionExecutor());
 
 	// XXX are these redirects really required?
 	AddActionExecutor(new RedirectToSyncedActionExecutor("ATM"));
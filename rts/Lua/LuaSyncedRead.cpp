@@ -173,6 +173,7 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitsInPlanes);
 	REGISTER_LUA_CFUNC(GetUnitsInSphere);
 	REGISTER_LUA_CFUNC(GetUnitsInCylinder);
+	REGISTER_LUA_CFUNC(GetUnitsInCylinders);
 
 	REGISTER_LUA_CFUNC(GetFeaturesInRectangle);
 	REGISTER_LUA_CFUNC(GetFeaturesInSphere);
@@ -1983,13 +1984,18 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
 
 // Macro Requirements:
 //   L, units
+//
+// RESULTIDX is either 0 (fill the table on top of the stack) or the
+// stack index of an optional caller-owned result table; if present it
+// is refilled in place (stale trailing entries are cleared) so frequent
+// spatial queries do not have to create a new table per call
 
-#define LOOP_UNIT_CONTAINER(ALLEGIANCE_TEST, CUSTOM_TEST, NEWTABLE) \
+#define LOOP_UNIT_CONTAINER(ALLEGIANCE_TEST, CUSTOM_TEST, RESULTIDX) \
 	{                                                               \
 		unsigned int count = 0;                                     \
                                                                     \
-		if (NEWTABLE) {                                             \
-			lua_createtable(L, units.size(), 0);                    \
+		if (RESULTIDX > 0) {                                        \
+			PushResultTable(L, RESULTIDX, units.size());            \
 		}                                                           \
                                                                     \
 		for (auto it = units.begin(); it != units.end(); ++it) {    \
@@ -2000,6 +2006,10 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
                                                                     \
 			lua_pushnumber(L, unit->id);                            \
 			lua_rawseti(L, -2, ++count);                            \
+		}                                                           \
+                                                                    \
+		if (RESULTIDX > 0) {                                        \
+			TrimResultTable(L, count);                              \
 		}                                                           \
 	}
 
@@ -2031,6 +2041,34 @@ int LuaSyncedRead::GetTeamUnitCount(lua_State* L)
 	if (!IsUnitVisible(L, unit)) { continue; }
 
 
+// reused across calls to avoid a heap allocation per spatial query
+static vector<CUnit*> queryUnits;
+static vector< vector<CUnit*> > queryUnitsBatch;
+static vector<float3> queryMins;
+static vector<float3> queryMaxs;
+static vector<float3> queryParams;
+
+
+// pushes the table at <index> for reuse if there is one, else a new table
+static inline void PushResultTable(lua_State* L, int index, int sizeHint)
+{
+	if (lua_istable(L, index)) {
+		lua_pushvalue(L, index);
+	} else {
+		lua_createtable(L, sizeHint, 0);
+	}
+}
+
+// clears entries left over in a reused table from a previous larger result
+static inline void TrimResultTable(lua_State* L, unsigned int count)
+{
+	for (unsigned int i = lua_objlen(L, -1); i > count; i--) {
+		lua_pushnil(L);
+		lua_rawseti(L, -2, i);
+	}
+}
+
+
 static int ParseAllegiance(lua_State* L, const char* caller, int index)
 {
 	if (!lua_isnumber(L, index)) {
@@ -2064,27 +2102,28 @@ int LuaSyncedRead::GetUnitsInRectangle(lua_State* L)
 
 #define RECTANGLE_TEST ; // no test, GetUnitsExact is sufficient
 
-	const vector<CUnit*>& units = quadField->GetUnitsExact(mins, maxs);
+	quadField->GetUnitsExact(queryUnits, mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
 	if (allegiance >= 0) {
 		if (IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, RECTANGLE_TEST, true);
+			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, RECTANGLE_TEST, 6);
 		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, RECTANGLE_TEST, true);
+			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, RECTANGLE_TEST, 6);
 		}
 	}
 	else if (allegiance == MyUnits) {
 		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, RECTANGLE_TEST, 6);
 	}
 	else if (allegiance == AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, RECTANGLE_TEST, 6);
 	}
 	else if (allegiance == EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, RECTANGLE_TEST, 6);
 	}
 	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, RECTANGLE_TEST, true);
+		LOOP_UNIT_CONTAINER(VISIBLE_TEST, RECTANGLE_TEST, 6);
 	}
 
 	return 1;
@@ -2111,27 +2150,28 @@ int LuaSyncedRead::GetUnitsInBox(lua_State* L)
 		continue;                     \
 	}
 
-	const vector<CUnit*>& units = quadField->GetUnitsExact(mins, maxs);
+	quadField->GetUnitsExact(queryUnits, mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
 	if (allegiance >= 0) {
 		if (IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, BOX_TEST, true);
+			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, BOX_TEST, 8);
 		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, BOX_TEST, true);
+			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, BOX_TEST, 8);
 		}
 	}
 	else if (allegiance == MyUnits) {
 		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, BOX_TEST, true);
+		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, BOX_TEST, 8);
 	}
 	else if (allegiance == AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, BOX_TEST, true);
+		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, BOX_TEST, 8);
 	}
 	else if (allegiance == EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, BOX_TEST, true);
+		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, BOX_TEST, 8);
 	}
 	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, BOX_TEST, true);
+		LOOP_UNIT_CONTAINER(VISIBLE_TEST, BOX_TEST, 8);
 	}
 
 	return 1;
@@ -2159,27 +2199,28 @@ int LuaSyncedRead::GetUnitsInCylinder(lua_State* L)
 		continue;                                 \
 	}                                           \
 
-	const vector<CUnit*>& units = quadField->GetUnitsExact(mins, maxs);
+	quadField->GetUnitsExact(queryUnits, mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
 	if (allegiance >= 0) {
 		if (IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, CYLINDER_TEST, true);
+			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, CYLINDER_TEST, 5);
 		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, CYLINDER_TEST, true);
+			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, CYLINDER_TEST, 5);
 		}
 	}
 	else if (allegiance == MyUnits) {
 		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, CYLINDER_TEST, 5);
 	}
 	else if (allegiance == AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, CYLINDER_TEST, 5);
 	}
 	else if (allegiance == EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, CYLINDER_TEST, 5);
 	}
 	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, CYLINDER_TEST, true);
+		LOOP_UNIT_CONTAINER(VISIBLE_TEST, CYLINDER_TEST, 5);
 	}
 
 	return 1;
@@ -2211,29 +2252,115 @@ int LuaSyncedRead::GetUnitsInSphere(lua_State* L)
 		continue;                                 \
 	}                                           \
 
-	const vector<CUnit*>& units = quadField->GetUnitsExact(mins, maxs);
+	quadField->GetUnitsExact(queryUnits, mins, maxs);
+	const vector<CUnit*>& units = queryUnits;
 
 	if (allegiance >= 0) {
 		if (IsAlliedTeam(L, allegiance)) {
-			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, SPHERE_TEST, true);
+			LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, SPHERE_TEST, 6);
 		} else {
-			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, SPHERE_TEST, true);
+			LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, SPHERE_TEST, 6);
 		}
 	}
 	else if (allegiance == MyUnits) {
 		const int readTeam = CLuaHandle::GetHandleReadTeam(L);
-		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(MY_UNIT_TEST, SPHERE_TEST, 6);
 	}
 	else if (allegiance == AllyUnits) {
-		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, SPHERE_TEST, 6);
 	}
 	else if (allegiance == EnemyUnits) {
-		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, SPHERE_TEST, 6);
 	}
 	else { // AllUnits
-		LOOP_UNIT_CONTAINER(VISIBLE_TEST, SPHERE_TEST, true);
+		LOOP_UNIT_CONTAINER(VISIBLE_TEST, SPHERE_TEST, 6);
+	}
+
+	return 1;
+}
+
+
+int LuaSyncedRead::GetUnitsInCylinders(lua_State* L)
+{
+	// {x1, z1, radius1, x2, z2, radius2, ...}
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	const int numValues = lua_objlen(L, 1);
+	const int numQueries = numValues / 3;
+
+	if ((numValues % 3) != 0) {
+		luaL_error(L, "Incorrect arguments to GetUnitsInCylinders(): expected {x, z, radius, ...}");
+	}
+
+	queryMins.resize(numQueries);
+	queryMaxs.resize(numQueries);
+	queryParams.resize(numQueries);
+
+	for (int i = 0; i < numQueries; i++) {
+		lua_rawgeti(L, 1, i * 3 + 1);
+		lua_rawgeti(L, 1, i * 3 + 2);
+		lua_rawgeti(L, 1, i * 3 + 3);
+
+		const float x      = luaL_checkfloat(L, -3);
+		const float z      = luaL_checkfloat(L, -2);
+		const float radius = luaL_checkfloat(L, -1);
+
+		lua_pop(L, 3);
+
+		queryMins[i] = float3(x - radius, 0.0f, z - radius);
+		queryMaxs[i] = float3(x + radius, 0.0f, z + radius);
+		queryParams[i] = float3(x, radius, z);
+	}
+
+	const int allegiance = ParseAllegiance(L, __FUNCTION__, 2);
+
+	quadField->GetUnitsExact(queryUnitsBatch, queryMins, queryMaxs);
+
+	PushResultTable(L, 3, numQueries);
+
+	for (int i = 0; i < numQueries; i++) {
+		const float x      = queryParams[i].x;
+		const float z      = queryParams[i].z;
+		const float radius = queryParams[i].y;
+		const float radSqr = (radius * radius);
+
+		const vector<CUnit*>& units = queryUnitsBatch[i];
+
+		// refill the per-query sub-tables of a reused result table
+		lua_rawgeti(L, -1, i + 1);
+
+		if (lua_istable(L, -1)) {
+			TrimResultTable(L, 0);
+		} else {
+			lua_pop(L, 1);
+			lua_createtable(L, units.size(), 0);
+		}
+
+		if (allegiance >= 0) {
+			if (IsAlliedTeam(L, allegiance)) {
+				LOOP_UNIT_CONTAINER(SIMPLE_TEAM_TEST, CYLINDER_TEST, 0);
+			} else {
+				LOOP_UNIT_CONTAINER(VISIBLE_TEAM_TEST, CYLINDER_TEST, 0);
+			}
+		}
+		else if (allegiance == MyUnits) {
+			const int readTeam = CLuaHandle::GetHandleReadTeam(L);
+			LOOP_UNIT_CONTAINER(MY_UNIT_TEST, CYLINDER_TEST, 0);
+		}
+		else if (allegiance == AllyUnits) {
+			LOOP_UNIT_CONTAINER(ALLY_UNIT_TEST, CYLINDER_TEST, 0);
+		}
+		else if (allegiance == EnemyUnits) {
+			LOOP_UNIT_CONTAINER(ENEMY_UNIT_TEST, CYLINDER_TEST, 0);
+		}
+		else { // AllUnits
+			LOOP_UNIT_CONTAINER(VISIBLE_TEST, CYLINDER_TEST, 0);
+		}
+
+		lua_rawseti(L, -2, i + 1);
 	}
 
+	TrimResultTable(L, numQueries);
 	return 1;
 }
 
@@ -2309,32 +2436,32 @@ int LuaSyncedRead::GetUnitsInPlanes(lua_State* L)
 		if (allegiance >= 0) {
 			if (allegiance == team) {
 				if (IsAlliedTeam(L, allegiance)) {
-					LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+					LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, 0);
 				} else {
-					LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, false);
+					LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, 0);
 				}
 			}
 		}
 		else if (allegiance == MyUnits) {
 			if (readTeam == team) {
-				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, 0);
 			}
 		}
 		else if (allegiance == AllyUnits) {
 			if (CLuaHandle::GetHandleReadAllyTeam(L) == teamHandler->AllyTeam(team)) {
-				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, 0);
 			}
 		}
 		else if (allegiance == EnemyUnits) {
 			if (CLuaHandle::GetHandleReadAllyTeam(L) != teamHandler->AllyTeam(team)) {
-				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, 0);
 			}
 		}
 		else { // AllUnits
 			if (IsAlliedTeam(L, team)) {
-				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(NULL_TEST, PLANES_TEST, 0);
 			} else {
-				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, false);
+				LOOP_UNIT_CONTAINER(VISIBLE_TEST, PLANES_TEST, 0);
 			}
 		}
 	}
@@ -80,6 +80,7 @@ class LuaSyncedRead {
 		static int GetUnitsInPlanes(lua_State* L);
 		static int GetUnitsInSphere(lua_State* L);
 		static int GetUnitsInCylinder(lua_State* L);
+		static int GetUnitsInCylinders(lua_State* L);
 
 		static int GetUnitNearestAlly(lua_State* L);
 		static int GetUnitNearestEnemy(lua_State* L);
@@ -195,13 +195,60 @@ void CBasicMapDamage::Update()
 		}
 
 		if (e->ttl == 0) {
-			RecalcArea(e->x1 - 1, e->x2 + 1, e->y1 - 1, e->y2 + 1);
+			recalcAreas.push_back(SRectangle(e->x1 - 1, e->y1 - 1, e->x2 + 1, e->y2 + 1));
 		}
 	}
 
+	// heavy artillery makes many craters expire in the same frame,
+	// avoid recomputing the (overlapping) derived data repeatedly
+	CoalesceRecalcAreas();
+
+	for (const SRectangle& r: recalcAreas) {
+		RecalcArea(r.x1, r.x2, r.z1, r.z2);
+	}
+
+	recalcAreas.clear();
+
 	while (!explosions.empty() && explosions.front()->ttl == 0) {
 		delete explosions.front();
 		explosions.pop_front();
 	}
 }
 
+
+
+void CBasicMapDamage::CoalesceRecalcAreas()
+{
+	// NOTE:
+	//   rectangles here are inclusive on both ends (as for RecalcArea)
+	//   two are merged if they overlap or touch and their bounding box
+	//   is not larger than the sum of their areas, so merging does not
+	//   cost more than updating both separately; the result depends
+	//   only on the (synced) explosion order
+	const auto GetArea = [](const SRectangle& r) {
+		return ((r.x2 - r.x1 + 1) * (r.z2 - r.z1 + 1));
+	};
+
+	for (unsigned int i = 0; i < recalcAreas.size(); i++) {
+		for (unsigned int j = i + 1; j < recalcAreas.size(); ) {
+			SRectangle& a = recalcAreas[i];
+			SRectangle& b = recalcAreas[j];
+
+			if (a.x1 > (b.x2 + 1) || b.x1 > (a.x2 + 1) || a.z1 > (b.z2 + 1) || b.z1 > (a.z2 + 1)) {
+				j++; continue;
+			}
+
+			const SRectangle u(std::min(a.x1, b.x1), std::min(a.z1, b.z1), std::max(a.x2, b.x2), std::max(a.z2, b.z2));
+
+			if (GetArea(u) > (GetArea(a) + GetArea(b))) {
+				j++; continue;
+			}
+
+			a = u;
+
+			// the grown rectangle may now absorb ones already skipped
+			recalcAreas.erase(recalcAreas.begin() + j);
+			j = i + 1;
+		}
+	}
+}
@@ -4,6 +4,7 @@
 #define _BASIC_MAP_DAMAGE_H
 
 #include "MapDamage.h"
+#include "System/Rectangle.h"
 
 #include <deque>
 #include <vector>
@@ -21,6 +22,8 @@ public:
 	void Update();
 
 private:
+	void CoalesceRecalcAreas();
+
 	struct ExploBuilding {
 		/**
 		 * Searching for building pointers inside these on DependentDied
@@ -44,6 +47,9 @@ private:
 
 	std::deque<Explo*> explosions;
 
+	/// areas of explosions that expired this frame, coalesced before RecalcArea
+	std::vector<SRectangle> recalcAreas;
+
 	static const unsigned int CRATER_TABLE_SIZE = 200;
 
 	float craterTable[CRATER_TABLE_SIZE + 1];
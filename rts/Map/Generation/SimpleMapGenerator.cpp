@@ -1,6 +1,12 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "SimpleMapGenerator.h"
+#include "Game/GameSetup.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/myMath.h"
+
+#include <cmath>
+#include <cstdlib>
 
 CSimpleMapGenerator::CSimpleMapGenerator(const CGameSetup* setup) : CMapGenerator(setup)
 {
@@ -14,23 +20,76 @@ CSimpleMapGenerator::~CSimpleMapGenerator()
 
 void CSimpleMapGenerator::GenerateInfo()
 {
-	mapSize = int2(5, 5);
+	// the size can be set through the "mapsize" map option
+	const std::map<std::string, std::string>& mapOptions = setup->GetMapOptionsCont();
+	const std::map<std::string, std::string>::const_iterator it = mapOptions.find("mapsize");
+
+	const int size = (it != mapOptions.end())? std::atoi(it->second.c_str()): 5;
+
+	mapSize = int2(Clamp(size, 2, 32), Clamp(size, 2, 32));
 }
 
 void CSimpleMapGenerator::GenerateMap()
 {
-	startPositions.push_back(int2(20, 20));
-	startPositions.push_back(int2(500, 500));
+	const int2 gs = GetGridSize();
+
+	startPositions.push_back(int2(256, 256));
+	startPositions.push_back(int2(gs.x * SQUARE_SIZE - 256, gs.y * SQUARE_SIZE - 256));
 
 	mapDescription = "The Split Canyon";
 
-	int2 gs = GetGridSize();
+	// everything below only depends on the seed, so the same
+	// seed always gives the same map (benchmarks rely on this)
+	unsigned int rngState = setup->mapSeed;
+	auto Rand = [&rngState](float min, float max) -> float {
+		rngState = rngState * 1103515245u + 12345u;
+		return (min + (max - min) * ((rngState >> 8) & 0xFFFF) / float(0xFFFF));
+	};
+
+	struct Hill { float x, y, radius, height; };
+	std::vector<Hill> hills(24);
+
+	for (Hill& h: hills) {
+		h.x = Rand(0.0f, gs.x);
+		h.y = Rand(0.0f, gs.y);
+		h.radius = Rand(gs.x * 0.03f, gs.x * 0.12f);
+		h.height = Rand(20.0f, 120.0f);
+	}
+
+	// a ridge along the middle, only crossable through a few passes
+	const float ridgeX = gs.x * 0.5f;
+	const float ridgeWidth = gs.x * 0.04f;
+	const float ridgeHeight = 300.0f;
+	const float passWidth = gs.y * 0.05f;
+	const float passes[] = {Rand(0.1f, 0.3f) * gs.y, Rand(0.4f, 0.6f) * gs.y, Rand(0.7f, 0.9f) * gs.y};
+
 	std::vector<float>& map = GetHeightMap();
-	for(int x = 0; x < gs.x; x++)
-	{
-		for(int y = 0; y < gs.y; y++)
-		{
-			map[y * gs.x + x] = 50.0f;
+
+	for (int y = 0; y <= gs.y; y++) {
+		float passDist = gs.y;
+
+		for (const float p: passes) {
+			passDist = std::min(passDist, std::abs(y - p));
+		}
+
+		const float passFactor = Clamp(passDist / passWidth - 0.5f, 0.0f, 1.0f);
+
+		for (int x = 0; x <= gs.x; x++) {
+			float height = 50.0f;
+
+			for (const Hill& h: hills) {
+				const float dx = (x - h.x) / h.radius;
+				const float dy = (y - h.y) / h.radius;
+				const float sqDist = dx * dx + dy * dy;
+
+				if (sqDist < 1.0f)
+					height += h.height * (1.0f - sqDist) * (1.0f - sqDist);
+			}
+
+			const float ridgeFactor = Clamp(1.0f - std::abs(x - ridgeX) / ridgeWidth, 0.0f, 1.0f);
+
+			height += ridgeHeight * ridgeFactor * passFactor;
+			map[y * (gs.x + 1) + x] = height;
 		}
 	}
 }
@@ -142,6 +142,119 @@ static inline float LineGroundSquareCol(
 }
 
 
+/**
+ * Decides which squares LineGroundCol does not have to test because the
+ * ray (or rather the line through <from> and <to>, LineGroundSquareCol can
+ * return points outside the segment) passes over them above the highest
+ * corner of their max-height block, plus a safety margin. Such squares can
+ * not report a collision, so skipping them does not change the result.
+ */
+class SquareSkipper {
+public:
+	SquareSkipper(const float3& from, const float3& to, bool synced)
+		: pos(from)
+		, dir(to - from)
+		, numLevels(0)
+		, clearRect(0, 0, -1, -1)
+		, testRect(0, 0, -1, -1)
+	{
+		// the blocks are built from the synced heightmap
+		if (synced || readMap->GetSharedCornerHeightMap(false) == readMap->GetSharedCornerHeightMap(true))
+			numLevels = readMap->GetNumMaxHeightBlockLevels();
+	}
+
+	bool Skip(const int x, const int z) {
+		if (numLevels == 0)
+			return false;
+		if (x < 0 || z < 0 || x > mapDims.mapxm1 || z > mapDims.mapym1)
+			return false;
+
+		if (x >= clearRect.x1 && x <= clearRect.x2 && z >= clearRect.z1 && z <= clearRect.z2)
+			return true;
+		if (x >= testRect.x1 && x <= testRect.x2 && z >= testRect.z1 && z <= testRect.z2)
+			return false;
+
+		if (!LineClearsBlock(0, x, z)) {
+			testRect = GetBlockRect(0, x, z);
+			return false;
+		}
+
+		// find the largest block that can be skipped as a whole
+		unsigned int level = 0;
+
+		while ((level + 1) < numLevels && LineClearsBlock(level + 1, x, z))
+			level++;
+
+		clearRect = GetBlockRect(level, x, z);
+		return true;
+	}
+
+private:
+	static SRectangle GetBlockRect(const unsigned int level, const int x, const int z) {
+		const int shift = CReadMap::MAX_HEIGHT_BLOCK_SHIFT + level;
+		const int bx = x >> shift;
+		const int bz = z >> shift;
+
+		return SRectangle(bx << shift, bz << shift, ((bx + 1) << shift) - 1, ((bz + 1) << shift) - 1);
+	}
+
+	bool LineClearsBlock(const unsigned int level, const int x, const int z) const {
+		const int shift = CReadMap::MAX_HEIGHT_BLOCK_SHIFT + level;
+		const int numBlocksX = ((mapDims.mapx - 1) >> shift) + 1;
+		const float maxHeight = readMap->GetMaxHeightBlocksSynced(level)[(z >> shift) * numBlocksX + (x >> shift)];
+
+		// block extends, grown by a square to stay on the safe side
+		const SRectangle& rect = GetBlockRect(level, x, z);
+		const float xmin = (rect.x1    ) * SQUARE_SIZE - SQUARE_SIZE;
+		const float xmax = (rect.x2 + 1) * SQUARE_SIZE + SQUARE_SIZE;
+		const float zmin = (rect.z1    ) * SQUARE_SIZE - SQUARE_SIZE;
+		const float zmax = (rect.z2 + 1) * SQUARE_SIZE + SQUARE_SIZE;
+
+		float tmin = -std::numeric_limits<float>::max();
+		float tmax =  std::numeric_limits<float>::max();
+
+		if (dir.x != 0.0f) {
+			const float t0 = (xmin - pos.x) / dir.x;
+			const float t1 = (xmax - pos.x) / dir.x;
+
+			tmin = std::max(tmin, std::min(t0, t1));
+			tmax = std::min(tmax, std::max(t0, t1));
+		} else if (pos.x < xmin || pos.x > xmax) {
+			return true;
+		}
+
+		if (dir.z != 0.0f) {
+			const float t0 = (zmin - pos.z) / dir.z;
+			const float t1 = (zmax - pos.z) / dir.z;
+
+			tmin = std::max(tmin, std::min(t0, t1));
+			tmax = std::min(tmax, std::max(t0, t1));
+		} else if (pos.z < zmin || pos.z > zmax) {
+			return true;
+		}
+
+		if (tmin > tmax)
+			return true;
+
+		// the line is lowest where it enters or leaves the block
+		const float minHeight = pos.y + dir.y * ((dir.y < 0.0f)? tmax: tmin);
+
+		return (minHeight > (maxHeight + SQUARE_SIZE));
+	}
+
+private:
+	const float3 pos;
+	const float3 dir;
+
+	unsigned int numLevels;
+
+	/// squares of the last block that the line passes above
+	SRectangle clearRect;
+	/// squares of the last level 0 block that has to be tested
+	SRectangle testRect;
+};
+
+
 
 /*
 void CGround::CheckColSquare(CProjectile* p, int x, int y)
@@ -261,6 +374,8 @@ float CGround::LineGroundCol(float3 from, float3 to, bool synced)
 
 	bool keepgoing = true;
 
+	SquareSkipper skipper(from, to, synced);
+
 	if ((fsx == tsx) && (fsz == tsz)) {
 		// <from> and <to> are the same
 		const float ret = LineGroundSquareCol(hm, nm,  from, to,  fsx, fsz);
@@ -273,7 +388,7 @@ float CGround::LineGroundCol(float3 from, float3 to, bool synced)
 		int zp = fsz;
 
 		while (keepgoing) {
-			const float ret = LineGroundSquareCol(hm, nm,  from, to,  fsx, zp);
+			const float ret = skipper.Skip(fsx, zp)? -1.0f: LineGroundSquareCol(hm, nm,  from, to,  fsx, zp);
 
 			if (ret >= 0.0f) {
 				return (ret + skippedDist);
@@ -287,7 +402,7 @@ float CGround::LineGroundCol(float3 from, float3 to, bool synced)
 		int xp = fsx;
 
 		while (keepgoing) {
-			const float ret = LineGroundSquareCol(hm, nm,  from, to,  xp, fsz);
+			const float ret = skipper.Skip(xp, fsz)? -1.0f: LineGroundSquareCol(hm, nm,  from, to,  xp, fsz);
 
 			if (ret >= 0.0f) {
 				return (ret + skippedDist);
@@ -323,8 +438,8 @@ float CGround::LineGroundCol(float3 from, float3 to, bool synced)
 		int curz = fsz;
 
 		while (keepgoing) {
-			// do the collision test with the squares triangles
-			const float ret = LineGroundSquareCol(hm, nm,  from, to,  curx, curz);
+			// do the collision test with the squares triangles (unless the ray passes above them)
+			const float ret = skipper.Skip(curx, curz)? -1.0f: LineGroundSquareCol(hm, nm,  from, to,  curx, curz);
 
 			if (ret >= 0.0f) {
 				return (ret + skippedDist);
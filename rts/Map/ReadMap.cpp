@@ -28,6 +28,10 @@
 #include "Sim/Misc/LosHandler.h"
 #endif
 
+#ifndef DEDICATED_NOSSE
+#include <emmintrin.h>
+#endif
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -85,6 +89,7 @@ CR_REG_METADATA(CReadMap, (
 	CR_IGNORED(centerNormalsSynced),
 	CR_IGNORED(centerNormalsUnsynced),
 	CR_IGNORED(slopeMap),
+	CR_IGNORED(maxHeightBlocks),
 	CR_IGNORED(sharedCornerHeightMaps),
 	CR_IGNORED(sharedCenterHeightMaps),
 	CR_IGNORED(sharedFaceNormals),
@@ -177,6 +182,9 @@ void CReadMap::PostLoad()
 	sharedSlopeMaps[0] = &slopeMap[0]; // NO UNSYNCED VARIANT
 	sharedSlopeMaps[1] = &slopeMap[0];
 
+	// Serialize only recalculates the inner part of the map
+	UpdateMaxHeightBlocks(SRectangle(0, 0, mapDims.mapxm1, mapDims.mapym1));
+
 	//FIXME reconstruct
 	/*mipPointerHeightMaps.resize(numHeightMipMaps, NULL);
 	mipPointerHeightMaps[0] = &centerHeightMap[0];
@@ -267,6 +275,17 @@ void CReadMap::Initialize()
 	slopeMap.resize(mapDims.hmapx * mapDims.hmapy);
 	visVertexNormals.resize(mapDims.mapxp1 * mapDims.mapyp1);
 
+	// levels up to (and including) the first one that has a single block
+	for (int shift = MAX_HEIGHT_BLOCK_SHIFT; ; shift++) {
+		const int numBlocksX = ((mapDims.mapx - 1) >> shift) + 1;
+		const int numBlocksZ = ((mapDims.mapy - 1) >> shift) + 1;
+
+		maxHeightBlocks.push_back(std::vector<float>(numBlocksX * numBlocksZ, std::numeric_limits<float>::max()));
+
+		if (numBlocksX == 1 && numBlocksZ == 1)
+			break;
+	}
+
 	// note: if USE_UNSYNCED_HEIGHTMAP is false, then
 	// heightMapUnsyncedPtr points to an empty vector
 	// for SMF maps so indexing it is forbidden (!)
@@ -402,6 +421,7 @@ void CReadMap::UpdateHeightMapSynced(SRectangle rect, bool initialize)
 	UpdateMipHeightmaps(rect, initialize);
 	UpdateFaceNormals(rect, initialize);
 	UpdateSlopemap(rect, initialize); // must happen after UpdateFaceNormals()!
+	UpdateMaxHeightBlocks(rect);
 
 #ifdef USE_UNSYNCED_HEIGHTMAP
 	// push the unsynced update
@@ -431,12 +451,64 @@ void CReadMap::UpdateHeightMapSynced(SRectangle rect, bool initialize)
 }
 
 
+#ifndef DEDICATED_NOSSE
+// SSE2 kernels for the derived heightmap data
+//
+// NOTE:
+//   the synced results must stay bit-identical to the scalar code (and
+//   therefore across machines), so every kernel performs exactly the same
+//   IEEE single-precision operations in the same order as its scalar loop
+//   (no reassociation, no rcp/rsqrt estimates); isqrt4 reproduces the
+//   integer-magic-plus-two-Newton-steps of fastmath::isqrt2_nosse
+static inline __m128 isqrt4(const __m128 x)
+{
+	const __m128 xh = _mm_mul_ps(_mm_set1_ps(0.5f), x);
+	const __m128i i = _mm_sub_epi32(_mm_set1_epi32(0x5f375a86), _mm_srai_epi32(_mm_castps_si128(x), 1));
+	const __m128 c = _mm_set1_ps(1.5f);
+
+	__m128 r = _mm_castsi128_ps(i);
+	r = _mm_mul_ps(r, _mm_sub_ps(c, _mm_mul_ps(xh, _mm_mul_ps(r, r))));
+	r = _mm_mul_ps(r, _mm_sub_ps(c, _mm_mul_ps(xh, _mm_mul_ps(r, r))));
+	return r;
+}
+
+/// lane-wise float3::SafeNormalize of the vectors (x[i], y[i], z[i])
+static inline void SafeNormalize4(__m128& x, __m128& y, __m128& z)
+{
+	const __m128 sql = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+	const __m128 msk = _mm_cmpgt_ps(sql, _mm_set1_ps(float3::NORMALIZE_EPS));
+	const __m128 scl = isqrt4(sql);
+
+	x = _mm_or_ps(_mm_and_ps(msk, _mm_mul_ps(x, scl)), _mm_andnot_ps(msk, x));
+	y = _mm_or_ps(_mm_and_ps(msk, _mm_mul_ps(y, scl)), _mm_andnot_ps(msk, y));
+	z = _mm_or_ps(_mm_and_ps(msk, _mm_mul_ps(z, scl)), _mm_andnot_ps(msk, z));
+}
+#endif
+
+
 void CReadMap::UpdateCenterHeightmap(const SRectangle& rect, bool initialize)
 {
 	const float* heightmapSynced = GetCornerHeightMapSynced();
 
 	for (int y = rect.z1; y <= rect.z2; y++) {
-		for (int x = rect.x1; x <= rect.x2; x++) {
+		int x = rect.x1;
+
+		#ifndef DEDICATED_NOSSE
+		const __m128 quarter = _mm_set1_ps(0.25f);
+
+		for (; (x + 3) <= rect.x2; x += 4) {
+			const float* rowT = &heightmapSynced[(y    ) * mapDims.mapxp1 + x];
+			const float* rowB = &heightmapSynced[(y + 1) * mapDims.mapxp1 + x];
+
+			__m128 height = _mm_add_ps(_mm_loadu_ps(rowT), _mm_loadu_ps(rowT + 1));
+			height = _mm_add_ps(height, _mm_loadu_ps(rowB));
+			height = _mm_add_ps(height, _mm_loadu_ps(rowB + 1));
+
+			_mm_storeu_ps(&centerHeightMap[y * mapDims.mapx + x], _mm_mul_ps(height, quarter));
+		}
+		#endif
+
+		for (; x <= rect.x2; x++) {
 			const int idxTL = (y    ) * mapDims.mapxp1 + x;
 			const int idxTR = (y    ) * mapDims.mapxp1 + x + 1;
 			const int idxBL = (y + 1) * mapDims.mapxp1 + x;
@@ -453,6 +525,80 @@ void CReadMap::UpdateCenterHeightmap(const SRectangle& rect, bool initialize)
 }
 
 
+void CReadMap::UpdateMaxHeightBlocks(const SRectangle& rect)
+{
+	const float* heightmapSynced = GetCornerHeightMapSynced();
+
+	for (unsigned int level = 0; level < maxHeightBlocks.size(); level++) {
+		const int shift = MAX_HEIGHT_BLOCK_SHIFT + level;
+		const int numBlocksX = ((mapDims.mapx - 1) >> shift) + 1;
+		const int numSubBlocksX = ((mapDims.mapx - 1) >> (shift - 1)) + 1;
+		const int numSubBlocksZ = ((mapDims.mapy - 1) >> (shift - 1)) + 1;
+
+		std::vector<float>& blocks = maxHeightBlocks[level];
+
+		for (int bz = (rect.z1 >> shift); bz <= (rect.z2 >> shift); bz++) {
+			for (int bx = (rect.x1 >> shift); bx <= (rect.x2 >> shift); bx++) {
+				float maxHeight = -std::numeric_limits<float>::max();
+
+				if (level == 0) {
+					// all corners of the squares in the block
+					const int x2 = std::min((bx + 1) << shift, mapDims.mapx);
+					const int z2 = std::min((bz + 1) << shift, mapDims.mapy);
+
+					for (int z = (bz << shift); z <= z2; z++) {
+						for (int x = (bx << shift); x <= x2; x++) {
+							maxHeight = std::max(maxHeight, heightmapSynced[z * mapDims.mapxp1 + x]);
+						}
+					}
+				} else {
+					const std::vector<float>& subBlocks = maxHeightBlocks[level - 1];
+
+					for (int z = (bz << 1); z < std::min((bz << 1) + 2, numSubBlocksZ); z++) {
+						for (int x = (bx << 1); x < std::min((bx << 1) + 2, numSubBlocksX); x++) {
+							maxHeight = std::max(maxHeight, subBlocks[z * numSubBlocksX + x]);
+						}
+					}
+				}
+
+				blocks[bz * numBlocksX + bx] = maxHeight;
+			}
+		}
+	}
+}
+
+
+void CReadMap::RaiseMaxHeightBlocks(const int idx, const float h)
+{
+	// squares sharing the corner <idx>
+	const int x1 = std::max(0, (idx % mapDims.mapxp1) - 1);
+	const int z1 = std::max(0, (idx / mapDims.mapxp1) - 1);
+	const int x2 = std::min(mapDims.mapxm1, idx % mapDims.mapxp1);
+	const int z2 = std::min(mapDims.mapym1, idx / mapDims.mapxp1);
+
+	for (unsigned int level = 0; level < maxHeightBlocks.size(); level++) {
+		const int shift = MAX_HEIGHT_BLOCK_SHIFT + level;
+		const int numBlocksX = ((mapDims.mapx - 1) >> shift) + 1;
+
+		std::vector<float>& blocks = maxHeightBlocks[level];
+		bool raised = false;
+
+		for (int bz = (z1 >> shift); bz <= (z2 >> shift); bz++) {
+			for (int bx = (x1 >> shift); bx <= (x2 >> shift); bx++) {
+				float& maxHeight = blocks[bz * numBlocksX + bx];
+
+				raised |= (h > maxHeight);
+				maxHeight = std::max(maxHeight, h);
+			}
+		}
+
+		// parents are never lower than their children
+		if (!raised)
+			break;
+	}
+}
+
+
 void CReadMap::UpdateMipHeightmaps(const SRectangle& rect, bool initialize)
 {
 	for (int i = 0; i < numHeightMipMaps - 1; i++) {
@@ -466,7 +612,36 @@ void CReadMap::UpdateMipHeightmaps(const SRectangle& rect, bool initialize)
 		float* subMipMap = mipPointerHeightMaps[i + 1];
 
 		for (int y = sy; y < ey; y += 2) {
-			for (int x = sx; x < ex; x += 2) {
+			int x = sx;
+
+			#ifndef DEDICATED_NOSSE
+			const __m128 quarter = _mm_set1_ps(0.25f);
+
+			// four sub-mip texels (eight top-mip columns) per iteration
+			for (; (x + 6) < ex; x += 8) {
+				const float* rowT = &topMipMap[x + (y    ) * hmapx];
+				const float* rowB = &topMipMap[x + (y + 1) * hmapx];
+
+				const __m128 t0 = _mm_loadu_ps(rowT    );
+				const __m128 t1 = _mm_loadu_ps(rowT + 4);
+				const __m128 b0 = _mm_loadu_ps(rowB    );
+				const __m128 b1 = _mm_loadu_ps(rowB + 4);
+
+				const __m128 tEven = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 tOdd  = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1));
+				const __m128 bEven = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 bOdd  = _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1));
+
+				// same summation order as the scalar loop below
+				__m128 height = _mm_add_ps(tEven, bEven);
+				height = _mm_add_ps(height, tOdd);
+				height = _mm_add_ps(height, bOdd);
+
+				_mm_storeu_ps(&subMipMap[(x / 2) + (y / 2) * hmapx / 2], _mm_mul_ps(height, quarter));
+			}
+			#endif
+
+			for (; x < ex; x += 2) {
 				const float height =
 					topMipMap[(x    ) + (y    ) * hmapx] +
 					topMipMap[(x    ) + (y + 1) * hmapx] +
@@ -492,7 +667,64 @@ void CReadMap::UpdateFaceNormals(const SRectangle& rect, bool initialize)
 		float3 fnTL;
 		float3 fnBR;
 
-		for (int x = x1; x <= x2; x++) {
+		int x = x1;
+
+		#ifndef DEDICATED_NOSSE
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 squareSize = _mm_set1_ps(SQUARE_SIZE);
+
+		for (; (x + 3) <= x2; x += 4) {
+			const float* rowT = &heightmapSynced[(y    ) * mapDims.mapxp1 + x];
+			const float* rowB = &heightmapSynced[(y + 1) * mapDims.mapxp1 + x];
+
+			const __m128 hTL = _mm_loadu_ps(rowT    );
+			const __m128 hTR = _mm_loadu_ps(rowT + 1);
+			const __m128 hBL = _mm_loadu_ps(rowB    );
+			const __m128 hBR = _mm_loadu_ps(rowB + 1);
+
+			// see the scalar loop for the derivation
+			// (negation flips the sign-bit, exactly like unary minus)
+			__m128 tlx = _mm_xor_ps(_mm_sub_ps(hTR, hTL), signMask);
+			__m128 tly = squareSize;
+			__m128 tlz = _mm_xor_ps(_mm_sub_ps(hBL, hTL), signMask);
+			__m128 brx = _mm_sub_ps(hBL, hBR);
+			__m128 bry = squareSize;
+			__m128 brz = _mm_sub_ps(hTR, hBR);
+
+			SafeNormalize4(tlx, tly, tlz);
+			SafeNormalize4(brx, bry, brz);
+
+			__m128 cnx = _mm_add_ps(tlx, brx);
+			__m128 cny = _mm_add_ps(tly, bry);
+			__m128 cnz = _mm_add_ps(tlz, brz);
+
+			SafeNormalize4(cnx, cny, cnz);
+
+			float v[9][4];
+
+			_mm_storeu_ps(v[0], tlx); _mm_storeu_ps(v[1], tly); _mm_storeu_ps(v[2], tlz);
+			_mm_storeu_ps(v[3], brx); _mm_storeu_ps(v[4], bry); _mm_storeu_ps(v[5], brz);
+			_mm_storeu_ps(v[6], cnx); _mm_storeu_ps(v[7], cny); _mm_storeu_ps(v[8], cnz);
+
+			for (int n = 0; n < 4; n++) {
+				const int idx = y * mapDims.mapx + x + n;
+
+				faceNormalsSynced[idx * 2    ] = float3(v[0][n], v[1][n], v[2][n]);
+				faceNormalsSynced[idx * 2 + 1] = float3(v[3][n], v[4][n], v[5][n]);
+				centerNormalsSynced[idx] = float3(v[6][n], v[7][n], v[8][n]);
+
+				#ifdef USE_UNSYNCED_HEIGHTMAP
+				if (initialize) {
+					faceNormalsUnsynced[idx * 2    ] = faceNormalsSynced[idx * 2    ];
+					faceNormalsUnsynced[idx * 2 + 1] = faceNormalsSynced[idx * 2 + 1];
+					centerNormalsUnsynced[idx] = centerNormalsSynced[idx];
+				}
+				#endif
+			}
+		}
+		#endif
+
+		for (; x <= x2; x++) {
 			const int idxTL = (y    ) * mapDims.mapxp1 + x; // TL
 			const int idxBL = (y + 1) * mapDims.mapxp1 + x; // BL
 
@@ -556,7 +788,49 @@ void CReadMap::UpdateSlopemap(const SRectangle& rect, bool initialize)
 	const int ey = std::min(mapDims.hmapy - 1, (rect.z2 / 2) + 1);
 
 	for (int y = sy; y <= ey; y++) {
-		for (int x = sx; x <= ex; x++) {
+		int x = sx;
+
+		#ifndef DEDICATED_NOSSE
+		for (; (x + 3) <= ex; x += 4) {
+			// gather the eight face-normal y-components of each of the four
+			// slope-squares, face <f> of square <n> ends up in lane n of s[f]
+			float s[8][4];
+
+			for (int n = 0; n < 4; n++) {
+				const int idx0 = (y*2    ) * (mapDims.mapx) + (x + n)*2;
+				const int idx1 = (y*2 + 1) * (mapDims.mapx) + (x + n)*2;
+
+				s[0][n] = faceNormalsSynced[(idx0    ) * 2    ].y;
+				s[1][n] = faceNormalsSynced[(idx0    ) * 2 + 1].y;
+				s[2][n] = faceNormalsSynced[(idx0 + 1) * 2    ].y;
+				s[3][n] = faceNormalsSynced[(idx0 + 1) * 2 + 1].y;
+				s[4][n] = faceNormalsSynced[(idx1    ) * 2    ].y;
+				s[5][n] = faceNormalsSynced[(idx1    ) * 2 + 1].y;
+				s[6][n] = faceNormalsSynced[(idx1 + 1) * 2    ].y;
+				s[7][n] = faceNormalsSynced[(idx1 + 1) * 2 + 1].y;
+			}
+
+			__m128 avgslope = _mm_setzero_ps();
+			__m128 maxslope = _mm_loadu_ps(s[0]);
+
+			for (int f = 0; f < 8; f++) {
+				const __m128 fy = _mm_loadu_ps(s[f]);
+
+				avgslope = _mm_add_ps(avgslope, fy);
+				// std::min(maxslope, fy) returns maxslope unless fy < maxslope
+				maxslope = _mm_min_ps(fy, maxslope);
+			}
+
+			avgslope = _mm_mul_ps(avgslope, _mm_set1_ps(0.125f));
+
+			const __m128 lerp = _mm_div_ps(maxslope, avgslope);
+			const __m128 slope = _mm_add_ps(maxslope, _mm_mul_ps(_mm_sub_ps(avgslope, maxslope), lerp));
+
+			_mm_storeu_ps(&slopeMap[y * mapDims.hmapx + x], _mm_sub_ps(_mm_set1_ps(1.0f), slope));
+		}
+		#endif
+
+		for (; x <= ex; x++) {
 			const int idx0 = (y*2    ) * (mapDims.mapx) + x*2;
 			const int idx1 = (y*2 + 1) * (mapDims.mapx) + x*2;
 
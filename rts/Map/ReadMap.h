@@ -204,6 +204,9 @@ public:
 	const float* GetCenterHeightMapSynced() const { return &centerHeightMap[0]; }
 	const float* GetMIPHeightMapSynced(unsigned int mip) const { return mipPointerHeightMaps[mip]; }
 	const float* GetSlopeMapSynced() const { return &slopeMap[0]; }
+	/// maximum corner-height of each block of (MAX_HEIGHT_BLOCK_SIZE << level)^2 squares, row-major
+	const float* GetMaxHeightBlocksSynced(unsigned int level) const { return &maxHeightBlocks[level][0]; }
+	unsigned int GetNumMaxHeightBlockLevels() const { return maxHeightBlocks.size(); }
 	const unsigned char* GetTypeMapSynced() const { return &typeMap[0]; }
 	      unsigned char* GetTypeMapSynced()       { return &typeMap[0]; }
 
@@ -253,6 +256,8 @@ private:
 	void UpdateMipHeightmaps(const SRectangle& rect, bool initialize);
 	void UpdateFaceNormals(const SRectangle& rect, bool initialize);
 	void UpdateSlopemap(const SRectangle& rect, bool initialize);
+	void UpdateMaxHeightBlocks(const SRectangle& rect);
+	void RaiseMaxHeightBlocks(const int idx, const float h);
 
 	inline void HeightMapUpdateLOSCheck(const SRectangle& rect);
 	inline bool HasHeightMapChanged(const int lmx, const int lmy);
@@ -262,6 +267,10 @@ public:
 	/// number of heightmap mipmaps, including full resolution
 	static const int numHeightMipMaps = 7;
 
+	/// size (in squares) of the blocks at level 0 of the max-height pyramid
+	static const int MAX_HEIGHT_BLOCK_SHIFT = 2;
+	static const int MAX_HEIGHT_BLOCK_SIZE = 1 << MAX_HEIGHT_BLOCK_SHIFT;
+
 	/// Metal-density/height-map
 	CMetalMap* metalMap;
 
@@ -289,6 +298,14 @@ protected:
 	std::vector<float3> centerNormalsUnsynced;
 
 	std::vector<float> slopeMap;               //< size: (mapx/2)    * (mapy/2)  , same as 1.0 - interpolate(centernomal[i]).y [SYNCED]
+
+	/**
+	 * maxHeightBlocks[n][i] is the highest corner-height of all squares in
+	 * block i of level n; level n+1 blocks cover 2x2 level n blocks, the top
+	 * level covers the whole map. Used by CGround::LineGroundCol to skip the
+	 * triangle tests wherever a ray stays above the terrain [SYNCED]
+	 */
+	std::vector< std::vector<float> > maxHeightBlocks;
 	std::vector<unsigned char> typeMap;
 
 	CRectangleOptimizer unsyncedHeightMapUpdates;
@@ -333,6 +350,9 @@ inline float CReadMap::SetHeight(const int idx, const float h, const int add) {
 	currMinHeight = std::min(x, currMinHeight);
 	currMaxHeight = std::max(x, currMaxHeight);
 
+	// blocks have to stay conservative until UpdateHeightMapSynced
+	RaiseMaxHeightBlocks(idx, x);
+
 	return x;
 }
 
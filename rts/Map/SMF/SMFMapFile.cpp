@@ -13,11 +13,17 @@ using std::string;
 
 
 CSMFMapFile::CSMFMapFile(const string& mapFileName)
-	: ifs(mapFileName), featureFileOffset(0)
+	: featureFileOffset(0)
 {
 	memset(&header, 0, sizeof(header));
 	memset(&featureHeader, 0, sizeof(featureHeader));
 
+	// maps in .sdd directories and stored zip entries can be mapped
+	// directly; the .smf content then lives in clean page-cache pages
+	// (only the touched ones are resident) instead of a heap copy that
+	// is kept for the whole game
+	ifs.OpenView(mapFileName);
+
 	if (!ifs.FileExists())
 		throw content_error("Couldn't open map file " + mapFileName);
 
@@ -74,19 +80,24 @@ void CSMFMapFile::ReadHeightmap(float* sHeightMap, float* uHeightMap, float base
 {
 	const int hmx = header.mapx + 1;
 	const int hmy = header.mapy + 1;
-	unsigned short* temphm = new unsigned short[hmx * hmy];
+	const int hmSize = hmx * hmy * sizeof(unsigned short);
 
-	ifs.Seek(header.heightmapPtr);
-	ifs.Read(temphm, hmx * hmy * 2);
+	// the file content is held in memory (see OpenView), so convert
+	// in-place instead of reading into a temporary copy first
+	const boost::uint8_t* hmData = ifs.GetData(header.heightmapPtr);
+
+	if (hmData == NULL || (header.heightmapPtr + hmSize) > ifs.FileSize())
+		throw content_error("Corrupt heightmap in map file");
 
 	for (int y = 0; y < hmx * hmy; ++y) {
-		const float h = base + swabWord(temphm[y]) * mod;
+		unsigned short rawHeight;
+		memcpy(&rawHeight, hmData + y * sizeof(unsigned short), sizeof(unsigned short));
+
+		const float h = base + swabWord(rawHeight) * mod;
 
 		if (sHeightMap != NULL) { sHeightMap[y] = h; }
 		if (uHeightMap != NULL) { uHeightMap[y] = h; }
 	}
-
-	delete[] temphm;
 }
 
 
@@ -35,6 +35,9 @@ public:
 
 	const SMFHeader& GetHeader() const { return header; }
 
+	/// true if the map file is memory-mapped rather than copied into memory
+	bool IsMapped() const { return ifs.IsMapped(); }
+
 	/**
 	 * @deprecated do not use, just here for backward compatibility
 	 *   with SMFGroundTextures.cpp
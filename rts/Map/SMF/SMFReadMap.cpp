@@ -18,7 +18,9 @@
 #include "System/EventHandler.h"
 #include "System/Exceptions.h"
 #include "System/FileSystem/FileHandler.h"
+#include "System/Log/ILog.h"
 #include "System/ThreadPool.h"
+#include "System/TimeProfiler.h"
 #include "System/myMath.h"
 #include "System/Util.h"
 
@@ -55,8 +57,15 @@ CSMFReadMap::CSMFReadMap(std::string mapname)
 	haveSplatTexture = (!mapInfo->smf.splatDetailTexName.empty() && !mapInfo->smf.splatDistrTexName.empty());
 	minimapOverride = !(mapInfo->smf.minimapTexName.empty());
 
-	ParseHeader();
-	LoadHeightMap();
+	{
+		ScopedOnceTimer timer("SMFReadMap::LoadHeightMap");
+
+		ParseHeader();
+		LoadHeightMap();
+
+		LOG("[SMFReadMap] map file is %s", (file.IsMapped())? "memory-mapped": "held in memory");
+	}
+
 	CReadMap::Initialize();
 
 	LoadMinimap();
@@ -25,6 +25,12 @@ void GameParticipant::SendData(boost::shared_ptr<const netcode::RawPacket> packe
 		link->SendData(packet);
 }
 
+void GameParticipant::SendSharedData(boost::shared_ptr<const netcode::BroadcastBlock> block)
+{
+	if (link)
+		link->SendSharedData(block);
+}
+
 void GameParticipant::Connected(boost::shared_ptr<netcode::CConnection> _link, bool local)
 {
 	link = _link;
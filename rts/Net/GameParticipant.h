@@ -8,9 +8,11 @@
 #include "Game/Players/PlayerBase.h"
 #include "Game/Players/PlayerStatistics.h"
 #include "System/Net/LoopbackConnection.h"
+#include "System/Sync/SyncChecker.h"
 
 namespace netcode
 {
+	class BroadcastBlock;
 	class CConnection;
 	class RawPacket;
 }
@@ -20,6 +22,7 @@ class GameParticipant : public PlayerBase
 public:
 	GameParticipant();
 	void SendData(boost::shared_ptr<const netcode::RawPacket> packet);
+	void SendSharedData(boost::shared_ptr<const netcode::BroadcastBlock> block);
 
 	void Connected(boost::shared_ptr<netcode::CConnection> link, bool local);
 	void Kill(const std::string& reason, const bool flush = false);
@@ -55,7 +58,7 @@ public:
 	std::map<unsigned char, PlayerLinkData> linkData;
 
 #ifdef SYNCCHECK
-	std::map<int, unsigned> syncResponse; // syncResponse[frameNum] = checksum
+	std::map<int, SyncChecksums> syncResponse; // syncResponse[frameNum] = checksums
 #endif
 };
 
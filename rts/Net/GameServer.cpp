@@ -2,6 +2,7 @@
 
 #include "System/Net/UDPListener.h"
 #include "System/Net/UDPConnection.h"
+#include "System/Net/BroadcastBlock.h"
 
 #include <boost/bind.hpp>
 #include <boost/format.hpp>
@@ -443,10 +444,12 @@ void CGameServer::SkipTo(int targetFrameNum)
 		if ((serverFrameNum % 20) != 0) { continue; }
 
 		// send data every few frames, as otherwise packets would grow too big
+		FlushBroadcasts();
 		UDPNet->Update();
 	}
 
 	Broadcast(boost::shared_ptr<const netcode::RawPacket>(endMsg.Pack()));
+	FlushBroadcasts();
 
 	if (UDPNet) {
 		UDPNet->Update();
@@ -568,10 +571,15 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 
 void CGameServer::Broadcast(boost::shared_ptr<const netcode::RawPacket> packet)
 {
+	// the local client reads messages straight from its queue, remote ones
+	// get them in blocks that are chunked once for all (see FlushBroadcasts)
 	for (GameParticipant& p: players) {
-		p.SendData(packet);
+		if (p.isLocal)
+			p.SendData(packet);
 	}
 
+	pendingBroadcasts.push_back(packet);
+
 	if (canReconnect || allowSpecJoin || !gameHasStarted)
 		AddToPacketCache(packet);
 
@@ -579,6 +587,22 @@ void CGameServer::Broadcast(boost::shared_ptr<const netcode::RawPacket> packet)
 		demoRecorder->SaveToDemo(packet->data, packet->length, GetDemoTime());
 }
 
+void CGameServer::FlushBroadcasts()
+{
+	if (pendingBroadcasts.empty())
+		return;
+
+	// a run of NETMSG_NEWFRAME's (e.g. when catching up) ends up as a
+	// handful of bytes in the same shared chunk, rather than as one queue
+	// entry per frame for every connection
+	const boost::shared_ptr<const netcode::BroadcastBlock> block(new netcode::BroadcastBlock(pendingBroadcasts));
+
+	for (GameParticipant& p: players) {
+		if (!p.isLocal)
+			p.SendSharedData(block);
+	}
+}
+
 void CGameServer::Message(const std::string& message, bool broadcast)
 {
 	if (broadcast) {
@@ -597,6 +621,8 @@ void CGameServer::Message(const std::string& message, bool broadcast)
 }
 
 void CGameServer::PrivateMessage(int playerNum, const std::string& message) {
+	// keep the order with respect to broadcasts
+	FlushBroadcasts();
 	players[playerNum].SendData(CBaseNetProtocol::Get().SendSystemMessage(SERVER_PLAYER, message));
 }
 
@@ -610,9 +636,9 @@ void CGameServer::CheckSync()
 		bool bGotCorrectChecksum = false;
 		if (hasLocalClient) {
 			// dictatorship
-			std::map<int, unsigned>::iterator it = players[localClientNumber].syncResponse.find(*f);
+			std::map<int, SyncChecksums>::iterator it = players[localClientNumber].syncResponse.find(*f);
 			if (it != players[localClientNumber].syncResponse.end()) {
-				correctChecksum = it->second;
+				correctChecksum = it->second.checksum;
 				bGotCorrectChecksum = true;
 			}
 		}
@@ -625,11 +651,11 @@ void CGameServer::CheckSync()
 				if (!p.link)
 					continue;
 
-				std::map<int, unsigned>::const_iterator it = p.syncResponse.find(*f);
+				std::map<int, SyncChecksums>::const_iterator it = p.syncResponse.find(*f);
 				if (it != p.syncResponse.end()) {
 					bool found = false;
 					for (chkList::iterator it2 = checksums.begin(); it2 != checksums.end(); ++it2) {
-						if (it2->first == it->second) {
+						if (it2->first == it->second.checksum) {
 							found = true;
 							it2->second++;
 							if (checkMaxCount < it2->second) {
@@ -639,10 +665,10 @@ void CGameServer::CheckSync()
 						}
 					}
 					if (!found) {
-						checksums.push_back(std::pair<unsigned, unsigned>(it->second, 1));
+						checksums.push_back(std::pair<unsigned, unsigned>(it->second.checksum, 1));
 						if (checkMaxCount == 0) {
 							checkMaxCount = 1;
-							correctChecksum = it->second;
+							correctChecksum = it->second.checksum;
 						}
 					}
 				}
@@ -654,30 +680,43 @@ void CGameServer::CheckSync()
 		// maps incorrect checksum to players with that checksum
 		std::map<unsigned, std::vector<int> > desyncGroups;
 		std::map<int, unsigned> desyncSpecs;
+		// lane checksums of a player that has the correct checksum
+		const SyncChecksums* correctChecksums = NULL;
 		bool bComplete = true;
 		for (GameParticipant& p: players) {
 			if (!p.link) {
 				continue;
 			}
-			std::map<int, unsigned>::iterator it = p.syncResponse.find(*f);
+			std::map<int, SyncChecksums>::iterator it = p.syncResponse.find(*f);
 			if (it == p.syncResponse.end()) {
 				if (*f >= serverFrameNum - static_cast<int>(SYNCCHECK_TIMEOUT))
 					bComplete = false;
 				else if (*f < p.lastFrameResponse)
 					noSyncResponse.push_back(p.id);
 			} else {
-				if (bGotCorrectChecksum && it->second != correctChecksum) {
+				if (bGotCorrectChecksum && it->second.checksum != correctChecksum) {
 					p.desynced = true;
 					if (demoReader || !p.spectator)
-						desyncGroups[it->second].push_back(p.id);
+						desyncGroups[it->second.checksum].push_back(p.id);
 					else
-						desyncSpecs[p.id] = it->second;
+						desyncSpecs[p.id] = it->second.checksum;
 				}
-				else
+				else {
 					p.desynced = false;
+					if (bGotCorrectChecksum)
+						correctChecksums = &it->second;
+				}
 			}
 		}
 
+		// name the subsystem whose lane diverged first for player <playerNum>
+		const auto DivergingLaneName = [&](int playerNum) {
+			if (correctChecksums == NULL)
+				return GetSyncLaneName(NUM_SYNC_LANES);
+
+			return GetSyncLaneName(correctChecksums->FirstDivergingLane(players[playerNum].syncResponse[*f]));
+		};
+
 		if (!noSyncResponse.empty()) {
 			if (!syncWarningFrame || (*f - syncWarningFrame > static_cast<int>(SYNCCHECK_MSG_TIMEOUT))) {
 				syncWarningFrame = *f;
@@ -711,17 +750,19 @@ void CGameServer::CheckSync()
 				std::map<unsigned, std::vector<int> >::const_iterator g = desyncGroups.begin();
 				for (; g != desyncGroups.end(); ++g) {
 					std::string playernames = GetPlayerNames(g->second);
-					Message(str(format(SyncError) %playernames %(*f) %g->first %correctChecksum));
+					Message(str(format(SyncError) %playernames %(*f) %g->first %correctChecksum %DivergingLaneName(g->second[0])));
 				}
 
 				// send spectator desyncs as private messages to reduce spam
 				for (std::map<int, unsigned>::const_iterator s = desyncSpecs.begin(); s != desyncSpecs.end(); ++s) {
 					int playerNum = s->first;
 
-					LOG_L(L_ERROR, "%s", str(format(SyncError) %players[playerNum].name %(*f) %s->second %correctChecksum).c_str());
-					Message(str(format(SyncError) %players[playerNum].name %(*f) %s->second %correctChecksum));
+					const char* laneName = DivergingLaneName(playerNum);
+
+					LOG_L(L_ERROR, "%s", str(format(SyncError) %players[playerNum].name %(*f) %s->second %correctChecksum %laneName).c_str());
+					Message(str(format(SyncError) %players[playerNum].name %(*f) %s->second %correctChecksum %laneName));
 
-					PrivateMessage(playerNum, str(format(SyncError) %players[playerNum].name %(*f) %s->second %correctChecksum));
+					PrivateMessage(playerNum, str(format(SyncError) %players[playerNum].name %(*f) %s->second %correctChecksum %laneName));
 				}
 			}
 			SetExitCode(-1);
@@ -1011,6 +1052,7 @@ void CGameServer::ProcessPacket(const unsigned playerNum, boost::shared_ptr<cons
 		case NETMSG_QUIT: {
 			Message(str(format(PlayerLeft) %players[a].GetType() %players[a].name %" normal quit"));
 			Broadcast(CBaseNetProtocol::Get().SendPlayerLeft(a, 1));
+			FlushBroadcasts(); // Kill sends the quit message directly, it must not overtake them
 			players[a].Kill("[GameServer] user exited", true);
 			if (hostif)
 				hostif->SendPlayerLeft(a, 1);
@@ -1237,13 +1279,19 @@ void CGameServer::ProcessPacket(const unsigned playerNum, boost::shared_ptr<cons
 
 			unsigned char playerNum; pckt >> playerNum;
 			          int  frameNum; pckt >> frameNum;
-			unsigned  int  checkSum; pckt >> checkSum;
+
+			SyncChecksums checkSums;
+			pckt >> checkSums.checksum;
+
+			for (unsigned int n = 0; n < NUM_SYNC_LANES; ++n) {
+				pckt >> checkSums.laneChecksums[n];
+			}
 
 			assert(a == playerNum);
 			GameParticipant& p = players[a];
 
 			if (outstandingSyncFrames.find(frameNum) != outstandingSyncFrames.end())
-				p.syncResponse[frameNum] = checkSum;
+				p.syncResponse[frameNum] = checkSums;
 
 			// update player's ping (if !defined(SYNCCHECK) this is done in NETMSG_KEYFRAME)
 			if (frameNum <= serverFrameNum && frameNum > p.lastFrameResponse)
@@ -1253,7 +1301,7 @@ void CGameServer::ProcessPacket(const unsigned playerNum, boost::shared_ptr<cons
 			// (the only purpose of this is to allow a client to
 			// detect if it is desynced wrt. a demo-stream)
 			if ((frameNum % syncResponseEchoInterval) == 0) {
-				Broadcast((CBaseNetProtocol::Get()).SendSyncResponse(playerNum, frameNum, checkSum));
+				Broadcast((CBaseNetProtocol::Get()).SendSyncResponse(playerNum, frameNum, checkSums));
 			}
 #endif
 		} break;
@@ -1781,6 +1829,7 @@ void CGameServer::ServerReadNet()
 		if (plink->CheckTimeout(0, !gameHasStarted)) {
 			Message(str(format(PlayerLeft) %player.GetType() %player.name %" timeout")); //this must happen BEFORE the reset!
 			Broadcast(CBaseNetProtocol::Get().SendPlayerLeft(player.id, 0));
+			FlushBroadcasts();
 			player.Kill("User timeout");
 			if (hostif)
 				hostif->SendPlayerLeft(player.id, 0);
@@ -2383,6 +2432,7 @@ void CGameServer::CreateNewFrame(bool fromServerThread, bool fixedFrameTime)
 			if ((serverFrameNum % gameProgressFrameInterval) == 0) {
 				CBaseNetProtocol::PacketType progressPacket = CBaseNetProtocol::Get().SendCurrentFrameProgress(serverFrameNum);
 				// we cannot use broadcast here, since we want to skip caching
+				FlushBroadcasts();
 				for (GameParticipant& p: players) {
 					p.SendData(progressPacket);
 				}
@@ -2433,12 +2483,14 @@ void CGameServer::UpdateLoop()
 			Threading::RecursiveScopedLock scoped_lock(gameServerMutex);
 			ServerReadNet();
 			Update();
+			FlushBroadcasts();
 		}
 
 		if (hostif)
 			hostif->SendQuit();
 
 		Broadcast(CBaseNetProtocol::Get().SendQuit("Server shutdown"));
+		FlushBroadcasts();
 
 		if (!reloadingServer) {
 			// this is to make sure the Flush has any effect at all (we don't want a forced flush)
@@ -2469,6 +2521,7 @@ void CGameServer::KickPlayer(const int playerNum)
 	}
 	Message(str(format(PlayerLeft) %players[playerNum].GetType() %players[playerNum].name %"kicked"));
 	Broadcast(CBaseNetProtocol::Get().SendPlayerLeft(playerNum, 2));
+	FlushBroadcasts();
 	players[playerNum].Kill("Kicked from the battle", true);
 	if (hostif)
 		hostif->SendPlayerLeft(playerNum, 2);
@@ -2678,15 +2731,30 @@ unsigned CGameServer::BindConnection(std::string name, const std::string& passwd
 		return newPlayerNumber;
 	}
 
+	// pending broadcasts are already in the packet cache, which the new player gets below
+	FlushBroadcasts();
+
 	newPlayer.Connected(link, isLocal);
 	newPlayer.SendData(boost::shared_ptr<const RawPacket>(myGameData->Pack()));
 	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
 
 	// after gamedata and playerNum, the player can start loading
 	// throw at him all stuff he missed until now
-	for (auto& pv: packetCache)
-		for (boost::shared_ptr<const netcode::RawPacket>& p: pv)
-			newPlayer.SendData(p);
+	// (full parts of the cache are chunked once and shared by all joiners,
+	// the block takes over their packets)
+	for (CachedPackets& pv: packetCache) {
+		if (pv.block == NULL && pv.packets.size() >= PKTCACHE_VECSIZE) {
+			pv.block.reset(new netcode::BroadcastBlock(pv.packets));
+			netcode::BroadcastBlock::MessageList().swap(pv.packets);
+		}
+
+		if (pv.block != NULL) {
+			newPlayer.SendSharedData(pv.block);
+		} else {
+			netcode::BroadcastBlock::MessageList msgs(pv.packets);
+			newPlayer.SendSharedData(boost::shared_ptr<const netcode::BroadcastBlock>(new netcode::BroadcastBlock(msgs)));
+		}
+	}
 
 	if (demoReader == NULL || myGameSetup->demoName.empty()) {
 		// player wants to play -> join team
@@ -2771,9 +2839,9 @@ void CGameServer::FreeSkirmishAIId(const unsigned char skirmishAIId)
 
 void CGameServer::AddToPacketCache(boost::shared_ptr<const netcode::RawPacket> &pckt)
 {
-	if (packetCache.empty() || packetCache.back().size() >= PKTCACHE_VECSIZE) {
-		packetCache.push_back(std::vector<boost::shared_ptr<const netcode::RawPacket> >());
-		packetCache.back().reserve(PKTCACHE_VECSIZE);
+	if (packetCache.empty() || packetCache.back().block != NULL || packetCache.back().packets.size() >= PKTCACHE_VECSIZE) {
+		packetCache.push_back(CachedPackets());
+		packetCache.back().packets.reserve(PKTCACHE_VECSIZE);
 	}
-	packetCache.back().push_back(pckt);
+	packetCache.back().packets.push_back(pckt);
 }
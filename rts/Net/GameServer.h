@@ -33,6 +33,7 @@ namespace boost {
 
 namespace netcode
 {
+	class BroadcastBlock;
 	class RawPacket;
 	class CConnection;
 	class UDPListener;
@@ -162,6 +163,12 @@ private:
 	bool SendDemoData(int targetFrameNum);
 
 	void Broadcast(boost::shared_ptr<const netcode::RawPacket> packet);
+	/**
+	 * Hands the broadcasts since the last call to all remote clients as one
+	 * shared block; has to be called before anything is sent to a single
+	 * client directly (SendData, GameParticipant::Kill) to keep the order.
+	 */
+	void FlushBroadcasts();
 
 	/**
 	 * @brief skip frames
@@ -238,7 +245,15 @@ private:
 	bool logInfoMessages;
 	bool logDebugMessages;
 
-	std::list< std::vector<boost::shared_ptr<const netcode::RawPacket> > > packetCache;
+	struct CachedPackets {
+		/// empty once the block holds them
+		std::vector< boost::shared_ptr<const netcode::RawPacket> > packets;
+		/// the packets chunked for joiners, made once the vector is full and someone joins
+		boost::shared_ptr<const netcode::BroadcastBlock> block;
+	};
+	std::list<CachedPackets> packetCache;
+	/// broadcast messages not yet handed to the remote clients
+	std::vector< boost::shared_ptr<const netcode::RawPacket> > pendingBroadcasts;
 
 	/////////////////// sync stuff ///////////////////
 #ifdef SYNCCHECK
@@ -34,6 +34,7 @@
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/Net/UnpackPacket.h"
 #include "System/Sound/ISound.h"
+#include "System/Sync/SyncChecker.h"
 
 #include <boost/cstdint.hpp>
 
@@ -41,7 +42,7 @@
 LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_NET)
 
 
-static std::map<int, unsigned int> mySyncChecksums;
+static std::map<int, SyncChecksums> mySyncChecksums;
 
 
 void CGame::AddTraffic(int playerID, int packetCode, int length)
@@ -509,11 +510,11 @@ void CGame::ClientReadNet()
 				// both NETMSG_SYNCRESPONSE and NETMSG_NEWFRAME are used for ping calculation by server
 				ASSERT_SYNCED(gs->frameNum);
 				ASSERT_SYNCED(CSyncChecker::GetChecksum());
-				clientNet->Send(CBaseNetProtocol::Get().SendSyncResponse(gu->myPlayerNum, gs->frameNum, CSyncChecker::GetChecksum()));
+				clientNet->Send(CBaseNetProtocol::Get().SendSyncResponse(gu->myPlayerNum, gs->frameNum, CSyncChecker::GetChecksums()));
 
 				if (gameServer != NULL && gameServer->GetDemoReader() != NULL) {
 					// buffer all checksums, so we can check sync later between demo & local
-					mySyncChecksums[gs->frameNum] = CSyncChecker::GetChecksum();
+					mySyncChecksums[gs->frameNum] = CSyncChecker::GetChecksums();
 				}
 
 				if ((gs->frameNum & 4095) == 0) {
@@ -539,21 +540,29 @@ void CGame::ClientReadNet()
 
 					unsigned char playerNum; pckt >> playerNum;
 						  int  frameNum; pckt >> frameNum;
-					unsigned  int  checkSum; pckt >> checkSum;
 
-					const unsigned int ourCheckSum = mySyncChecksums[frameNum];
+					SyncChecksums checkSums;
+					pckt >> checkSums.checksum;
+
+					for (unsigned int n = 0; n < NUM_SYNC_LANES; ++n) {
+						pckt >> checkSums.laneChecksums[n];
+					}
+
+					const SyncChecksums& ourCheckSums = mySyncChecksums[frameNum];
 					const CPlayer* player = playerHandler->Player(playerNum);
 
 					// check if our checksum for this frame matches what
 					// player <playerNum> sent to the server at the same
 					// frame in the original game (in case of a demo)
 					if (playerNum == gu->myPlayerNum) { break; }
-					if (checkSum == ourCheckSum) { break; }
+					if (checkSums.checksum == ourCheckSums.checksum) { break; }
 
+					const unsigned int lane = ourCheckSums.FirstDivergingLane(checkSums);
 					const char* fmtStr =
 						"[DESYNC_WARNING] checksum %x from player %d (%s)"
-						" does not match our checksum %x for frame-number %d";
-					LOG_L(L_ERROR, fmtStr, checkSum, playerNum, player->name.c_str(), ourCheckSum, frameNum);
+						" does not match our checksum %x for frame-number %d"
+						" (first diverging subsystem: %s)";
+					LOG_L(L_ERROR, fmtStr, checkSums.checksum, playerNum, player->name.c_str(), ourCheckSums.checksum, frameNum, GetSyncLaneName(lane));
 				}
 #endif
 			} break;
@@ -7,6 +7,7 @@
 #include "System/Net/RawPacket.h"
 #include "System/Net/PackPacket.h"
 #include "System/Net/ProtocolDef.h"
+#include "System/Sync/SyncChecker.h"
 #include <boost/cstdint.hpp>
 
 using netcode::PackPacket;
@@ -85,11 +86,14 @@ PacketType CBaseNetProtocol::SendPathCheckSum(uchar myPlayerNum, boost::uint32_t
 }
 
 
-PacketType CBaseNetProtocol::SendCommand(uchar myPlayerNum, int id, uchar options, const std::vector<float>& params)
+PacketType CBaseNetProtocol::SendCommand(uchar myPlayerNum, int id, uchar options, const float* params, unsigned int numParams)
 {
-	unsigned size = 9 + params.size() * sizeof(float);
+	unsigned size = 9 + numParams * sizeof(float);
 	PackPacket* packet = new PackPacket(size, NETMSG_COMMAND);
-	*packet << static_cast<unsigned short>(size) << myPlayerNum << id << options << params;
+	*packet << static_cast<unsigned short>(size) << myPlayerNum << id << options;
+	for (unsigned int i = 0; i < numParams; i++) {
+		*packet << params[i];
+	}
 	return PacketType(packet);
 }
 
@@ -111,10 +115,10 @@ PacketType CBaseNetProtocol::SendPause(uchar myPlayerNum, uchar bPaused)
 
 
 
-PacketType CBaseNetProtocol::SendAICommand(uchar myPlayerNum, unsigned char aiID, short unitID, int id, int aiCommandId, uchar options, const std::vector<float>& params)
+PacketType CBaseNetProtocol::SendAICommand(uchar myPlayerNum, unsigned char aiID, short unitID, int id, int aiCommandId, uchar options, const float* params, unsigned int numParams)
 {
 	int cmdTypeId = NETMSG_AICOMMAND;
-	unsigned size = 12 + (params.size() * sizeof(float));
+	unsigned size = 12 + (numParams * sizeof(float));
 	if (aiCommandId != -1) {
 		cmdTypeId = NETMSG_AICOMMAND_TRACKED;
 		size += 4;
@@ -124,7 +128,9 @@ PacketType CBaseNetProtocol::SendAICommand(uchar myPlayerNum, unsigned char aiID
 	if (cmdTypeId == NETMSG_AICOMMAND_TRACKED) {
 		*packet << aiCommandId;
 	}
-	*packet << params;
+	for (unsigned int i = 0; i < numParams; i++) {
+		*packet << params[i];
+	}
 	return PacketType(packet);
 }
 
@@ -270,10 +276,15 @@ PacketType CBaseNetProtocol::SendMapDrawLine(uchar myPlayerNum, short x1, short
 }
 
 
-PacketType CBaseNetProtocol::SendSyncResponse(uchar myPlayerNum, int frameNum, uint checksum)
+PacketType CBaseNetProtocol::SendSyncResponse(uchar myPlayerNum, int frameNum, const SyncChecksums& checksums)
 {
-	PackPacket* packet = new PackPacket(10, NETMSG_SYNCRESPONSE);
-	*packet << myPlayerNum << frameNum << checksum;
+	PackPacket* packet = new PackPacket(10 + NUM_SYNC_LANES * sizeof(uint), NETMSG_SYNCRESPONSE);
+	*packet << myPlayerNum << frameNum << checksums.checksum;
+
+	for (unsigned int n = 0; n < NUM_SYNC_LANES; ++n) {
+		*packet << checksums.laneChecksums[n];
+	}
+
 	return PacketType(packet);
 }
 
@@ -482,7 +493,7 @@ CBaseNetProtocol::CBaseNetProtocol()
 	proto->AddType(NETMSG_PLAYERSTAT, 2 + sizeof(PlayerStatistics));
 	proto->AddType(NETMSG_GAMEOVER, -1);
 	proto->AddType(NETMSG_MAPDRAW, -1);
-	proto->AddType(NETMSG_SYNCRESPONSE, 10);
+	proto->AddType(NETMSG_SYNCRESPONSE, 10 + NUM_SYNC_LANES * sizeof(uint));
 	proto->AddType(NETMSG_SYSTEMMSG, -2);
 	proto->AddType(NETMSG_STARTPOS, 16);
 	proto->AddType(NETMSG_PLAYERINFO, 10);
@@ -42,7 +42,9 @@ CR_BIND(LocalModel, (NULL))
 CR_REG_METADATA(LocalModel, (
 	CR_IGNORED(dirtyPieces),
 	CR_IGNORED(lodCount), //FIXME?
-	CR_MEMBER(pieces)
+	CR_MEMBER(pieces),
+	CR_IGNORED(parentIndices),
+	CR_IGNORED(changedPieces)
 ))
 
 
@@ -156,6 +158,51 @@ void LocalModel::ReloadDisplayLists()
 	}
 }
 
+void LocalModel::UpdateParentIndices()
+{
+	parentIndices.resize(pieces.size());
+
+	for (unsigned int i = 0; i < pieces.size(); i++) {
+		const LocalModelPiece* parent = pieces[i].parent;
+
+		parentIndices[i] = (parent != NULL)? parent->GetLModelPieceIndex(): -1;
+		assert(parentIndices[i] < int(i));
+	}
+
+	changedPieces.resize((pieces.size() + 31) / 32);
+}
+
+void LocalModel::UpdatePieceMatrices()
+{
+	if (dirtyPieces == 0)
+		return;
+
+	dirtyPieces = 0;
+
+	// (re)built lazily after loading a savegame
+	if (parentIndices.size() != pieces.size())
+		UpdateParentIndices();
+
+	std::fill(changedPieces.begin(), changedPieces.end(), 0);
+
+	// forward kinematics in one linear pass: pieces are stored depth-first, so
+	// a parent's model-space matrix is always final before any child reads it
+	for (unsigned int i = 0; i < pieces.size(); i++) {
+		LocalModelPiece& lmp = pieces[i];
+
+		const int parentIdx = parentIndices[i];
+		const bool parentChanged = (parentIdx >= 0) && ((changedPieces[parentIdx >> 5] >> (parentIdx & 31)) & 1);
+
+		const bool pieceChanged = lmp.UpdatePieceSpaceMatrix();
+
+		if (!pieceChanged && !parentChanged)
+			continue;
+
+		lmp.UpdateModelSpaceMatrix((parentIdx >= 0)? &pieces[parentIdx]: NULL);
+		changedPieces[i >> 5] |= (1u << (i & 31));
+	}
+}
+
 LocalModelPiece* LocalModel::CreateLocalModelPieces(const S3DModelPiece* mpParent)
 {
 	LocalModelPiece* lmpChild = NULL;
@@ -7,6 +7,7 @@
 #include <string>
 #include <set>
 #include <map>
+#include <boost/cstdint.hpp>
 #include "Rendering/GL/VBO.h"
 #include "System/Matrix44f.h"
 #include "System/creg/creg_cond.h"
@@ -242,6 +243,22 @@ struct LocalModelPiece
 
 	bool UpdateMatrix();
 	void UpdateMatricesRec(bool updateChildMatrices);
+	/// recomputes pieceSpaceMat if the piece was transformed, returns true if it was
+	bool UpdatePieceSpaceMatrix() {
+		if (lastMatrixUpdate == numUpdatesSynced)
+			return false;
+
+		lastMatrixUpdate = numUpdatesSynced;
+		identityTransform = UpdateMatrix();
+		return true;
+	}
+	void UpdateModelSpaceMatrix(const LocalModelPiece* parentPiece) {
+		modelSpaceMat = pieceSpaceMat;
+
+		if (parentPiece != NULL) {
+			modelSpaceMat >>= parentPiece->modelSpaceMat;
+		}
+	}
 
 	bool GetEmitDirPos(float3& pos, float3& dir) const;
 	float3 GetAbsolutePos() const;
@@ -301,6 +318,7 @@ struct LocalModel
 		pieces.reserve(model->numPieces);
 		CreateLocalModelPieces(model->GetRootPiece());
 		assert(pieces.size() == model->numPieces);
+		UpdateParentIndices();
 	}
 
 	~LocalModel()
@@ -320,13 +338,7 @@ struct LocalModel
 		DrawPiecesLOD(lod);
 	}
 
-	void UpdatePieceMatrices() {
-		if (dirtyPieces > 0) {
-			pieces[0].UpdateMatricesRec(false);
-		}
-		dirtyPieces = 0;
-	}
-
+	void UpdatePieceMatrices();
 
 
 	void DrawPieces() const;
@@ -350,13 +362,21 @@ struct LocalModel
 
 private:
 	LocalModelPiece* CreateLocalModelPieces(const S3DModelPiece* mpParent);
+	void UpdateParentIndices();
 
 public:
 	// increased by UnitScript whenever a piece is transformed
 	unsigned int dirtyPieces;
 	unsigned int lodCount;
 
+	// depth-first order, so every piece comes after its parent
 	std::vector<LocalModelPiece> pieces;
+
+private:
+	// index into pieces of the parent of every piece, -1 for the root
+	std::vector<int> parentIndices;
+	// bit N is set if the model-space matrix of piece N changes in this update
+	std::vector<boost::uint32_t> changedPieces;
 };
 
 #endif /* _3DMODEL_H */
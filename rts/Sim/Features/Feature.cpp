@@ -31,8 +31,7 @@ CR_REG_METADATA(CFeature, (
 	CR_MEMBER(defID),
 	CR_MEMBER(isRepairingBeforeResurrect),
 	CR_MEMBER(isAtFinalHeight),
-	CR_MEMBER(inUpdateQue),
-	CR_MEMBER(deleteMe),
+	CR_MEMBER(updateSlot),
 	CR_MEMBER(resurrectProgress),
 	CR_MEMBER(reclaimLeft),
 	CR_MEMBER(resources),
@@ -40,9 +39,6 @@ CR_REG_METADATA(CFeature, (
 	CR_MEMBER(lastReclaim),
 	CR_MEMBER(drawQuad),
 	CR_MEMBER(drawAlpha),
-	CR_MEMBER(fireTime),
-	CR_MEMBER(smokeTime),
-	CR_MEMBER(fireTime),
 	CR_IGNORED(def), //reconstructed in PostLoad
 	CR_MEMBER(udef),
 	CR_MEMBER(myFire),
@@ -57,8 +53,7 @@ CFeature::CFeature()
 , defID(-1)
 , isRepairingBeforeResurrect(false)
 , isAtFinalHeight(false)
-, inUpdateQue(false)
-, deleteMe(false)
+, updateSlot(-1)
 , finalHeight(0.0f)
 , resurrectProgress(0.0f)
 , reclaimLeft(1.0f)
@@ -66,8 +61,6 @@ CFeature::CFeature()
 , resources(0.0f, 1.0f)
 , drawQuad(-2)
 , drawAlpha(1.0)
-, fireTime(0)
-, smokeTime(0)
 , def(NULL)
 , udef(NULL)
 , myFire(NULL)
@@ -167,7 +160,6 @@ void CFeature::Initialize(const FeatureLoadParams& params)
 
 	heading = params.heading;
 	buildFacing = params.facing;
-	smokeTime = params.smokeTime;
 
 	mass = def->mass;
 	health = def->health;
@@ -214,6 +206,7 @@ void CFeature::Initialize(const FeatureLoadParams& params)
 	// feature does not have an assigned ID yet
 	// this MUST be done before the Block() call
 	featureHandler->AddFeature(this);
+	featureHandler->SetFeatureSmokeTime(this, params.smokeTime);
 	quadField->AddFeature(this);
 
 	ChangeTeam(team);
@@ -475,6 +468,10 @@ void CFeature::ForcedMove(const float3& newPos)
 
 	// insert into managers
 	quadField->AddFeature(this);
+
+	// a queued feature has to recheck its position
+	if (updateSlot >= 0)
+		featureHandler->SetFeatureUpdateable(this);
 }
 
 
@@ -613,42 +610,22 @@ void CFeature::UpdateFinalHeight(bool useGroundHeight)
 }
 
 
-bool CFeature::Update()
+void CFeature::EmitSmoke(int smokeTime)
 {
-	bool continueUpdating = UpdatePosition();
-
-	continueUpdating |= (smokeTime != 0);
-	continueUpdating |= (fireTime != 0);
-	continueUpdating |= (def->geoThermal);
-
-	if (smokeTime != 0) {
-		if (!((gs->frameNum + id) & 3) && projectileHandler->GetParticleSaturation() < 0.7f) {
-			new CSmokeProjectile(NULL, midPos + gu->RandVector() * radius * 0.3f,
-				gu->RandVector() * 0.3f + UpVector, smokeTime / 6 + 20, 6, 0.4f, 0.5f);
-		}
-	}
-	if (fireTime == 1) {
-		featureHandler->DeleteFeature(this);
-	}
-	if (def->geoThermal) {
-		EmitGeoSmoke();
-	}
-
-	smokeTime = std::max(smokeTime - 1, 0);
-	fireTime = std::max(fireTime - 1, 0);
+	if (projectileHandler->GetParticleSaturation() >= 0.7f)
+		return;
 
-	// return true so long as we need to stay in the FH update-queue
-	return continueUpdating;
+	new CSmokeProjectile(NULL, midPos + gu->RandVector() * radius * 0.3f,
+		gu->RandVector() * 0.3f + UpVector, smokeTime / 6 + 20, 6, 0.4f, 0.5f);
 }
 
 
 void CFeature::StartFire()
 {
-	if (fireTime != 0 || !def->burnable)
+	if (!def->burnable || featureHandler->GetFeatureFireTime(this) != 0)
 		return;
 
-	fireTime = 200 + (int)(gs->randFloat() * GAME_SPEED);
-	featureHandler->SetFeatureUpdateable(this);
+	featureHandler->SetFeatureFireTime(this, 200 + (int)(gs->randFloat() * GAME_SPEED));
 
 	myFire = new CFireProjectile(midPos, UpVector, 0, 300, 70, radius * 0.8f, 20.0f);
 }
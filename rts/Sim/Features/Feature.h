@@ -48,10 +48,10 @@ public:
 	void SetVelocity(const float3& v);
 	void ForcedMove(const float3& newPos);
 	void ForcedSpin(const float3& newDir);
-	bool Update();
 	bool UpdatePosition();
 	void UpdateFinalHeight(bool useGroundHeight);
 	void StartFire();
+	void EmitSmoke(int smokeTime);
 	void EmitGeoSmoke();
 
 	void CalculateTransform();
@@ -82,8 +82,9 @@ public:
 	 */
 	bool isRepairingBeforeResurrect;
 	bool isAtFinalHeight;
-	bool inUpdateQue;
-	bool deleteMe;
+
+	/// index into CFeatureHandler's update-queue, -1 if not queued
+	int updateSlot;
 
 	float finalHeight;
 
@@ -95,8 +96,6 @@ public:
 	/// which drawQuad we are part of
 	int drawQuad;
 	float drawAlpha;
-	int fireTime;
-	int smokeTime;
 
 	const FeatureDef* def;
 	const UnitDef* udef; /// type of unit this feature should be resurrected to
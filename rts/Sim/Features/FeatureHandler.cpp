@@ -28,7 +28,11 @@ CR_REG_METADATA(CFeatureHandler, (
 	CR_MEMBER(toBeFreedFeatureIDs),
 	CR_MEMBER(activeFeatures),
 	CR_MEMBER(features),
-	CR_MEMBER(updateFeatures)
+	CR_MEMBER(updateFeatures),
+	CR_MEMBER(updateFeatureIDs),
+	CR_MEMBER(updateSmokeTimes),
+	CR_MEMBER(updateFireTimes),
+	CR_MEMBER(updateFlags)
 ))
 
 /******************************************************************************/
@@ -383,7 +387,7 @@ bool CFeatureHandler::AddFeature(CFeature* feature)
 void CFeatureHandler::DeleteFeature(CFeature* feature)
 {
 	SetFeatureUpdateable(feature);
-	feature->deleteMe = true;
+	updateFlags[feature->updateSlot] |= UPDATE_DELETE;
 }
 
 CFeature* CFeatureHandler::GetFeature(int id)
@@ -449,13 +453,13 @@ void CFeatureHandler::Update()
 		}
 	}
 
-	auto fi = updateFeatures.begin();
+	for (unsigned int slot = 0; slot < updateFeatures.size(); ) {
+		const unsigned int flags = updateFlags[slot];
+
+		if (flags & UPDATE_DELETE) {
+			CFeature* feature = updateFeatures[slot];
+			assert(feature->updateSlot == int(slot));
 
-	while (fi != updateFeatures.end()) {
-		CFeature* feature = *fi;
-		assert(feature->inUpdateQue);
-		
-		if (feature->deleteMe) {
 			eventHandler.RenderFeatureDestroyed(feature);
 			eventHandler.FeatureDestroyed(feature);
 			toBeFreedFeatureIDs.push_back(feature->id);
@@ -463,37 +467,124 @@ void CFeatureHandler::Update()
 			features[feature->id] = NULL;
 
 			CSolidObject::SetDeletingRefID(feature->id + unitHandler->MaxUnits());
-			// destructor removes feature from update-queue
 			delete feature;
 			CSolidObject::SetDeletingRefID(-1);
-			
-			*fi = updateFeatures.back();
-			updateFeatures.pop_back();
-		} else {
-
-			if (!feature->Update()) {
-				// feature is done updating itself, remove from queue
-				feature->inUpdateQue = false;
-				*fi = updateFeatures.back();
-				updateFeatures.pop_back();
-				
-			} else {
-				++fi;
+
+			RemoveFromUpdateQueue(slot);
+			continue;
+		}
+
+		const int smokeTime = updateSmokeTimes[slot];
+		const int fireTime  = updateFireTimes[slot];
+		const bool emitSmoke = (smokeTime != 0) && (((gs->frameNum + updateFeatureIDs[slot]) & 3) == 0);
+
+		bool continueUpdating = (smokeTime != 0) || (fireTime != 0);
+
+		// most queued features only count down their timers, don't touch those
+		if ((flags & (UPDATE_SETTLED | UPDATE_GEOTHERMAL)) != UPDATE_SETTLED || emitSmoke || fireTime == 1) {
+			CFeature* feature = updateFeatures[slot];
+			assert(feature->updateSlot == int(slot));
+
+			if ((flags & UPDATE_SETTLED) == 0) {
+				const float3 oldPos = feature->pos;
+
+				if (feature->UpdatePosition()) {
+					continueUpdating = true;
+				} else if (feature->pos.x == oldPos.x && feature->pos.y == oldPos.y && feature->pos.z == oldPos.z) {
+					// at rest, further calls would not change anything
+					// until the feature or the ground below it is moved
+					updateFlags[slot] |= UPDATE_SETTLED;
+				}
+			}
+
+			if (emitSmoke) {
+				feature->EmitSmoke(smokeTime);
+			}
+			if (fireTime == 1) {
+				DeleteFeature(feature);
 			}
+			if (flags & UPDATE_GEOTHERMAL) {
+				feature->EmitGeoSmoke();
+				continueUpdating = true;
+			}
+		}
+
+		updateSmokeTimes[slot] = std::max(updateSmokeTimes[slot] - 1, 0);
+		updateFireTimes[slot]  = std::max(updateFireTimes[slot]  - 1, 0);
+
+		if (continueUpdating || (updateFlags[slot] & UPDATE_DELETE) != 0) {
+			++slot;
+			continue;
 		}
+
+		// feature is done updating itself, remove from queue
+		updateFeatures[slot]->updateSlot = -1;
+		RemoveFromUpdateQueue(slot);
+	}
+}
+
+
+void CFeatureHandler::RemoveFromUpdateQueue(unsigned int slot)
+{
+	// does not touch the removed feature, it might be deleted already
+	const unsigned int last = updateFeatures.size() - 1;
+
+	if (slot != last) {
+		updateFeatures[slot]   = updateFeatures[last];
+		updateFeatureIDs[slot] = updateFeatureIDs[last];
+		updateSmokeTimes[slot] = updateSmokeTimes[last];
+		updateFireTimes[slot]  = updateFireTimes[last];
+		updateFlags[slot]      = updateFlags[last];
+
+		updateFeatures[slot]->updateSlot = slot;
 	}
+
+	updateFeatures.pop_back();
+	updateFeatureIDs.pop_back();
+	updateSmokeTimes.pop_back();
+	updateFireTimes.pop_back();
+	updateFlags.pop_back();
 }
 
 
 void CFeatureHandler::SetFeatureUpdateable(CFeature* feature)
 {
-	if (feature->inUpdateQue) {
-			assert(std::find(updateFeatures.begin(), updateFeatures.end(), feature) != updateFeatures.end());
-			return;
+	if (feature->updateSlot >= 0) {
+		assert(updateFeatures[feature->updateSlot] == feature);
+
+		// something about it changed, it has to recheck its position
+		updateFlags[feature->updateSlot] &= ~UPDATE_SETTLED;
+		return;
 	}
-	assert(std::find(updateFeatures.begin(), updateFeatures.end(), feature) == updateFeatures.end());
+
+	feature->updateSlot = updateFeatures.size();
+
 	updateFeatures.push_back(feature);
-	feature->inUpdateQue = true;
+	updateFeatureIDs.push_back(feature->id);
+	updateSmokeTimes.push_back(0);
+	updateFireTimes.push_back(0);
+	updateFlags.push_back(feature->def->geoThermal? UPDATE_GEOTHERMAL: 0);
+}
+
+
+void CFeatureHandler::SetFeatureSmokeTime(CFeature* feature, int smokeTime)
+{
+	SetFeatureUpdateable(feature);
+	updateSmokeTimes[feature->updateSlot] = smokeTime;
+}
+
+void CFeatureHandler::SetFeatureFireTime(CFeature* feature, int fireTime)
+{
+	SetFeatureUpdateable(feature);
+	updateFireTimes[feature->updateSlot] = fireTime;
+}
+
+int CFeatureHandler::GetFeatureFireTime(const CFeature* feature) const
+{
+	if (feature->updateSlot < 0)
+		return 0;
+
+	return updateFireTimes[feature->updateSlot];
 }
 
 
@@ -506,8 +597,20 @@ void CFeatureHandler::TerrainChanged(int x1, int y1, int x2, int y2)
 
 	for (const int qi: quads) {
 		for (CFeature* feature: quadField->GetQuad(qi).features) {
+			const float oldFinalHeight = feature->finalHeight;
+
 			feature->UpdateFinalHeight(true);
 
+			// map features (trees, rocks, ...) resting on ground whose height
+			// did not change below them would not do anything when updated;
+			// floating ones and wrecks also depend on heights not tracked here
+			const bool unchanged =
+				(feature->udef == NULL && !feature->def->floating && !feature->isAtFinalHeight) &&
+				(!feature->IsMoving() && feature->finalHeight == oldFinalHeight && feature->pos.y == oldFinalHeight);
+
+			if (unchanged)
+				continue;
+
 			// put this feature back in the update-queue
 			SetFeatureUpdateable(feature);
 		}
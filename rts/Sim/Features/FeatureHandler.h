@@ -7,6 +7,7 @@
 #include <list>
 #include <vector>
 #include <boost/noncopyable.hpp>
+#include <boost/cstdint.hpp>
 #include "System/creg/creg_cond.h"
 
 #include "FeatureDef.h"
@@ -59,6 +60,12 @@ public:
 	void SetFeatureUpdateable(CFeature* feature);
 	void TerrainChanged(int x1, int y1, int x2, int y2);
 
+	/// (re)starts the smoke resp. fire timer of {@param feature}, which gets queued for updates
+	void SetFeatureSmokeTime(CFeature* feature, int smokeTime);
+	void SetFeatureFireTime(CFeature* feature, int fireTime);
+	/// only features in the update-queue have running timers
+	int GetFeatureFireTime(const CFeature* feature) const;
+
 	const std::map<std::string, const FeatureDef*>& GetFeatureDefs() const { return featureDefs; }
 	const CFeatureSet& GetActiveFeatures() const { return activeFeatures; }
 
@@ -78,6 +85,7 @@ private:
 	bool NeedAllocateNewFeatureIDs(const CFeature* feature) const;
 	void AllocateNewFeatureIDs(const CFeature* feature);
 	void InsertActiveFeature(CFeature* feature);
+	void RemoveFromUpdateQueue(unsigned int slot);
 
 	FeatureDef* CreateDefaultTreeFeatureDef(const std::string& name) const;
 	FeatureDef* CreateDefaultGeoFeatureDef(const std::string& name) const;
@@ -95,7 +103,21 @@ private:
 	CFeatureSet activeFeatures;
 	std::vector<CFeature*> features;
 
+	enum {
+		UPDATE_SETTLED    = 1, ///< position is up to date, UpdatePosition would change nothing
+		UPDATE_GEOTHERMAL = 2, ///< emits geo-smoke every frame, never leaves the queue
+		UPDATE_DELETE     = 4, ///< DeleteFeature was called
+	};
+
+	// the update-queue; the per-frame state of the queued features is kept
+	// in parallel arrays (indexed by CFeature::updateSlot) so Update() can
+	// process all of them in one pass and only needs to touch the feature
+	// objects that have more to do than counting down their timers
 	std::vector<CFeature*> updateFeatures;
+	std::vector<int> updateFeatureIDs;
+	std::vector<int> updateSmokeTimes;
+	std::vector<int> updateFireTimes;
+	std::vector<boost::uint8_t> updateFlags;
 };
 
 extern CFeatureHandler* featureHandler;
@@ -6,11 +6,13 @@
 #include "InterceptHandler.h"
 
 #include "Map/Ground.h"
+#include "Map/ReadMap.h"
 #include "Sim/Weapons/Weapon.h"
 #include "Sim/Projectiles/WeaponProjectiles/WeaponProjectile.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Weapons/WeaponDef.h"
 #include "Sim/Weapons/PlasmaRepulser.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "System/EventHandler.h"
 #include "System/float3.h"
@@ -22,97 +24,312 @@ CR_BIND_DERIVED(CInterceptHandler, CObject, )
 CR_REG_METADATA(CInterceptHandler, (
 	CR_MEMBER(interceptors),
 	CR_MEMBER(repulsors),
-	CR_MEMBER(interceptables)
+	CR_MEMBER(interceptables),
+	CR_IGNORED(coverageCells),
+	CR_IGNORED(coverageMins),
+	CR_IGNORED(coverageMaxs),
+	CR_IGNORED(coverageGridFrame),
+	CR_IGNORED(numCoverageCellsX),
+	CR_IGNORED(numCoverageCellsZ),
+	CR_POSTLOAD(PostLoad)
 ))
 
 CInterceptHandler interceptHandler;
 
 
+/// size (in elmos) of the coverage grid cells
+static const int COVERAGE_CELL_SIZE = 512;
+
+static int GetCoverageCell(float pos, int numCells)
+{
+	// clamp before converting, coverage ranges can be (near-)infinite
+	const float cellPos = Clamp(pos, -COVERAGE_CELL_SIZE * 1.0f, numCells * COVERAGE_CELL_SIZE * 1.0f);
+
+	return Clamp(int(math::floor(cellPos / COVERAGE_CELL_SIZE)), 0, numCells - 1);
+}
+
+/// clips [tMin, tMax] to the part of the ray (pos + dir * t) inside [lo, hi]
+static bool ClipRaySlab(float pos, float dir, float lo, float hi, float& tMin, float& tMax)
+{
+	if (dir == 0.0f)
+		return (pos >= lo && pos <= hi);
+
+	float t1 = (lo - pos) / dir;
+	float t2 = (hi - pos) / dir;
+
+	if (t1 > t2)
+		std::swap(t1, t2);
+
+	tMin = std::max(tMin, t1);
+	tMax = std::min(tMax, t2);
+
+	return (tMin <= tMax);
+}
+
+
 
 void CInterceptHandler::Update(bool forced) {
 	if (((gs->frameNum % UNIT_SLOWUPDATE_RATE) != 0) && !forced)
 		return;
 
-	for (CWeapon* w: interceptors) {
-		const WeaponDef* wDef = w->weaponDef;
-		const CUnit* wOwner = w->owner;
+	UpdateCoverageGrid();
 
-		assert(wDef->interceptor || wDef->isShield);
+	// indexed, interceptables can be added by Lua call-ins from in here
+	for (size_t n = 0; n < interceptables.size(); n++) {
+		UpdateInterceptors(interceptables[n]);
+	}
+}
 
-		for (CWeaponProjectile* p: interceptables) {
-			if (!p->CanBeInterceptedBy(wDef))
-				continue;
-			if (w->incomingProjectiles.find(p->id) != w->incomingProjectiles.end())
-				continue;
 
-			const int pAllyTeam = p->GetAllyteamID();
+void CInterceptHandler::UpdateInterceptors(CWeaponProjectile* p) {
+	// interceptors whose coverage area contains p's target position
+	// or overlaps its (2D) path, see the four cases below; the path
+	// starts one step back since impactDist can be -1
+	std::vector<int> candidates;
 
-			if (teamHandler->IsValidAllyTeam(pAllyTeam)  && teamHandler->Ally(wOwner->allyteam, pAllyTeam))
-				continue;
+	GetCellCandidates(p->GetTargetPos(), candidates);
+	GetRayCandidates(p->pos - p->dir, p->dir, candidates);
 
-			// note: will be called every Update so long as gadget does not return true
-			if (!eventHandler.AllowWeaponInterceptTarget(wOwner, w, p))
-				continue;
+	if (candidates.empty())
+		return;
 
-			// there are four cases when an interceptor <w> should fire at a projectile <p>:
-			//     1. p's target position inside w's interception circle (w's owner can move!)
-			//     2. p's current position inside w's interception circle
-			//     3. p's projected impact position inside w's interception circle
-			//     4. p's trajectory intersects w's interception circle
-			//
-			// these checks all need to be evaluated periodically, not just
-			// when a projectile is created and handed to AddInterceptTarget
-			const float weaponDist = w->aimFromPos.distance(p->pos);
-			const float impactDist = CGround::LineGroundCol(p->pos, p->pos + p->dir * weaponDist);
+	// keep the order of <interceptors>
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
 
-			const float3& pImpactPos = p->pos + p->dir * impactDist;
-			const float3& pTargetPos = p->GetTargetPos();
-			const float3  pWeaponVec = p->pos - w->aimFromPos;
+	const int pAllyTeam = p->GetAllyteamID();
 
-			if (w->aimFromPos.SqDistance2D(pTargetPos) < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->incomingProjectiles[p->id] = p;
-				continue; // 1
-			}
+	float maxWeaponDist = 0.0f;
+	size_t numCandidates = 0;
 
-			if (false /*wDef->noFlyThroughIntercept*/) {
-				// <w> is just a static interceptor and fires only at projectiles
-				// TARGETED within its current interception area; any projectiles
-				// CROSSING its interception area aren't targeted
-				//XXX implement in lua?
-				continue;
-			}
+	for (const int i: candidates) {
+		const CWeapon* w = interceptors[i];
+
+		assert(w->weaponDef->interceptor || w->weaponDef->isShield);
 
-			if (pWeaponVec.SqLength2D() < Square(wDef->coverageRange)) {
+		if (!p->CanBeInterceptedBy(w->weaponDef))
+			continue;
+		if (w->HasIncomingProjectile(p->id))
+			continue;
+		if (teamHandler->IsValidAllyTeam(pAllyTeam) && teamHandler->Ally(w->owner->allyteam, pAllyTeam))
+			continue;
+
+		maxWeaponDist = std::max(maxWeaponDist, w->aimFromPos.distance(p->pos));
+		candidates[numCandidates++] = i;
+	}
+
+	candidates.resize(numCandidates);
+
+	// distance to p's ground impact along its current direction, traced
+	// once (up to the farthest candidate) for all of them; -2 = not yet
+	float groundDist = -2.0f;
+
+	for (const int i: candidates) {
+		CWeapon* w = interceptors[i];
+
+		const WeaponDef* wDef = w->weaponDef;
+		const CUnit* wOwner = w->owner;
+
+		// note: will be called every Update so long as gadget does not return true
+		if (!eventHandler.AllowWeaponInterceptTarget(wOwner, w, p))
+			continue;
+
+		if (groundDist == -2.0f)
+			groundDist = CGround::LineGroundCol(p->pos, p->pos + p->dir * maxWeaponDist);
+
+		// there are four cases when an interceptor <w> should fire at a projectile <p>:
+		//     1. p's target position inside w's interception circle (w's owner can move!)
+		//     2. p's current position inside w's interception circle
+		//     3. p's projected impact position inside w's interception circle
+		//     4. p's trajectory intersects w's interception circle
+		//
+		// these checks all need to be evaluated periodically, not just
+		// when a projectile is created and handed to AddInterceptTarget
+		const float weaponDist = w->aimFromPos.distance(p->pos);
+		const float impactDist = (groundDist <= weaponDist)? groundDist: -1.0f;
+
+		const float3& pImpactPos = p->pos + p->dir * impactDist;
+		const float3& pTargetPos = p->GetTargetPos();
+		const float3  pWeaponVec = p->pos - w->aimFromPos;
+
+		if (w->aimFromPos.SqDistance2D(pTargetPos) < Square(wDef->coverageRange)) {
+			w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+			w->AddIncomingProjectile(p);
+			continue; // 1
+		}
+
+		if (false /*wDef->noFlyThroughIntercept*/) {
+			// <w> is just a static interceptor and fires only at projectiles
+			// TARGETED within its current interception area; any projectiles
+			// CROSSING its interception area aren't targeted
+			//XXX implement in lua?
+			continue;
+		}
+
+		if (pWeaponVec.SqLength2D() < Square(wDef->coverageRange)) {
+			w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+			w->AddIncomingProjectile(p);
+			continue; // 2
+		}
+
+		if (w->aimFromPos.SqDistance2D(pImpactPos) < Square(wDef->coverageRange)) {
+			const float3 pTargetDir = (pTargetPos - p->pos).SafeNormalize();
+			const float3 pImpactDir = (pImpactPos - p->pos).SafeNormalize();
+
+			// the projected impact position can briefly shift into the covered
+			// area during transition from vertical to horizontal flight, so we
+			// perform an extra test (NOTE: assumes non-parabolic trajectory)
+			if (pTargetDir.dot(pImpactDir) >= 0.999f) {
 				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->incomingProjectiles[p->id] = p;
-				continue; // 2
+				w->AddIncomingProjectile(p);
+				continue; // 3
 			}
+		}
 
-			if (w->aimFromPos.SqDistance2D(pImpactPos) < Square(wDef->coverageRange)) {
-				const float3 pTargetDir = (pTargetPos - p->pos).SafeNormalize();
-				const float3 pImpactDir = (pImpactPos - p->pos).SafeNormalize();
-
-				// the projected impact position can briefly shift into the covered
-				// area during transition from vertical to horizontal flight, so we
-				// perform an extra test (NOTE: assumes non-parabolic trajectory)
-				if (pTargetDir.dot(pImpactDir) >= 0.999f) {
-					w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-					w->incomingProjectiles[p->id] = p;
-					continue; // 3
-				}
-			}
+		const float3 pMinSepPos = p->pos + p->dir * Clamp(-(pWeaponVec.dot(p->dir)), 0.0f, impactDist);
+		const float3 pMinSepVec = w->aimFromPos - pMinSepPos;
 
-			const float3 pMinSepPos = p->pos + p->dir * Clamp(-(pWeaponVec.dot(p->dir)), 0.0f, impactDist);
-			const float3 pMinSepVec = w->aimFromPos - pMinSepPos;
+		if (pMinSepVec.SqLength() < Square(wDef->coverageRange)) {
+			w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+			w->AddIncomingProjectile(p);
+			continue; // 4
+		}
+	}
+}
 
-			if (pMinSepVec.SqLength() < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->incomingProjectiles[p->id] = p;
-				continue; // 4
+
+
+void CInterceptHandler::UpdateCoverageGrid()
+{
+	if (coverageGridFrame == gs->frameNum)
+		return;
+
+	coverageGridFrame = gs->frameNum;
+
+	numCoverageCellsX = (mapDims.mapx * SQUARE_SIZE + COVERAGE_CELL_SIZE - 1) / COVERAGE_CELL_SIZE;
+	numCoverageCellsZ = (mapDims.mapy * SQUARE_SIZE + COVERAGE_CELL_SIZE - 1) / COVERAGE_CELL_SIZE;
+
+	coverageCells.resize(numCoverageCellsX * numCoverageCellsZ);
+
+	for (std::vector<int>& cell: coverageCells) {
+		cell.clear();
+	}
+
+	coverageMins = float3( std::numeric_limits<float>::max(), 0.0f,  std::numeric_limits<float>::max());
+	coverageMaxs = float3(-std::numeric_limits<float>::max(), 0.0f, -std::numeric_limits<float>::max());
+
+	for (size_t i = 0; i < interceptors.size(); i++) {
+		const CWeapon* w = interceptors[i];
+
+		// projectiles can be matched later in the same frame, leave
+		// some slack for the owner moving in the meantime (and cells
+		// are only looked up at single points along paths)
+		const float radius = w->weaponDef->coverageRange + w->owner->speed.w + SQUARE_SIZE;
+
+		const float3 mins = w->aimFromPos - float3(radius, 0.0f, radius);
+		const float3 maxs = w->aimFromPos + float3(radius, 0.0f, radius);
+
+		coverageMins.x = std::min(coverageMins.x, mins.x);
+		coverageMins.z = std::min(coverageMins.z, mins.z);
+		coverageMaxs.x = std::max(coverageMaxs.x, maxs.x);
+		coverageMaxs.z = std::max(coverageMaxs.z, maxs.z);
+
+		const int x1 = GetCoverageCell(mins.x, numCoverageCellsX);
+		const int z1 = GetCoverageCell(mins.z, numCoverageCellsZ);
+		const int x2 = GetCoverageCell(maxs.x, numCoverageCellsX);
+		const int z2 = GetCoverageCell(maxs.z, numCoverageCellsZ);
+
+		for (int z = z1; z <= z2; z++) {
+			for (int x = x1; x <= x2; x++) {
+				coverageCells[z * numCoverageCellsX + x].push_back(i);
 			}
 		}
 	}
+
+	// projectiles more than a map size beyond the border are not worth walking a ray for
+	const float mapSizeX = mapDims.mapx * SQUARE_SIZE;
+	const float mapSizeZ = mapDims.mapy * SQUARE_SIZE;
+
+	coverageMins.x = std::max(coverageMins.x, -mapSizeX);
+	coverageMins.z = std::max(coverageMins.z, -mapSizeZ);
+	coverageMaxs.x = std::min(coverageMaxs.x, mapSizeX * 2.0f);
+	coverageMaxs.z = std::min(coverageMaxs.z, mapSizeZ * 2.0f);
+}
+
+
+void CInterceptHandler::GetCellCandidates(const float3& pos, std::vector<int>& candidates) const
+{
+	// positions outside the map map to the nearest border cell, the
+	// same way coverage areas extending past the border are clipped
+	const int x = GetCoverageCell(pos.x, numCoverageCellsX);
+	const int z = GetCoverageCell(pos.z, numCoverageCellsZ);
+
+	const std::vector<int>& cell = coverageCells[z * numCoverageCellsX + x];
+
+	candidates.insert(candidates.end(), cell.begin(), cell.end());
+}
+
+
+void CInterceptHandler::GetRayCandidates(const float3& pos, const float3& dir, std::vector<int>& candidates) const
+{
+	if (dir.x == 0.0f && dir.z == 0.0f) {
+		GetCellCandidates(pos, candidates);
+		return;
+	}
+
+	// clip the ray to the area covered by any interceptor, beyond
+	// that there is nothing to find (but it can be long, there are
+	// interceptors with near-infinite coverage)
+	float tMin = 0.0f;
+	float tMax = std::numeric_limits<float>::max();
+
+	if (!ClipRaySlab(pos.x, dir.x, coverageMins.x, coverageMaxs.x, tMin, tMax))
+		return;
+	if (!ClipRaySlab(pos.z, dir.z, coverageMins.z, coverageMaxs.z, tMin, tMax))
+		return;
+
+	const float3 p1 = pos + dir * tMin;
+	const float3 p2 = pos + dir * tMax;
+
+	// walk the (unclipped) cells along the ray
+	int x = math::floor(p1.x / COVERAGE_CELL_SIZE);
+	int z = math::floor(p1.z / COVERAGE_CELL_SIZE);
+
+	const int numSteps =
+		std::abs(int(math::floor(p2.x / COVERAGE_CELL_SIZE)) - x) +
+		std::abs(int(math::floor(p2.z / COVERAGE_CELL_SIZE)) - z);
+
+	const int stepX = (dir.x > 0.0f)? 1: -1;
+	const int stepZ = (dir.z > 0.0f)? 1: -1;
+
+	const float infinity = std::numeric_limits<float>::max();
+	const float deltaX = (dir.x != 0.0f)? (COVERAGE_CELL_SIZE / math::fabs(dir.x)): infinity;
+	const float deltaZ = (dir.z != 0.0f)? (COVERAGE_CELL_SIZE / math::fabs(dir.z)): infinity;
+
+	float nextX = (dir.x != 0.0f)? (((x + (stepX > 0)) * COVERAGE_CELL_SIZE - pos.x) / dir.x): infinity;
+	float nextZ = (dir.z != 0.0f)? (((z + (stepZ > 0)) * COVERAGE_CELL_SIZE - pos.z) / dir.z): infinity;
+
+	int prevCell = -1;
+
+	for (int n = 0; n <= numSteps; n++) {
+		const int cx = Clamp(x, 0, numCoverageCellsX - 1);
+		const int cz = Clamp(z, 0, numCoverageCellsZ - 1);
+		const int cell = cz * numCoverageCellsX + cx;
+
+		// outside the map consecutive cells clip to the same border cell
+		if (cell != prevCell) {
+			candidates.insert(candidates.end(), coverageCells[cell].begin(), coverageCells[cell].end());
+			prevCell = cell;
+		}
+
+		if (nextX < nextZ) {
+			nextX += deltaX;
+			x += stepX;
+		} else {
+			nextZ += deltaZ;
+			z += stepZ;
+		}
+	}
 }
 
 
@@ -120,6 +337,7 @@ void CInterceptHandler::Update(bool forced) {
 void CInterceptHandler::AddInterceptorWeapon(CWeapon* weapon)
 {
 	interceptors.push_back(weapon);
+	coverageGridFrame = -1;
 }
 
 
@@ -128,6 +346,7 @@ void CInterceptHandler::RemoveInterceptorWeapon(CWeapon* weapon)
 	auto it = std::find(interceptors.begin(), interceptors.end(), weapon);
 	if (it != interceptors.end()) {
 		interceptors.erase(it);
+		coverageGridFrame = -1;
 	}
 }
 
@@ -156,7 +375,9 @@ void CInterceptHandler::AddInterceptTarget(CWeaponProjectile* target, const floa
 	// die before the interceptable itself does)
 	AddDeathDependence(target, DEPENDENCE_INTERCEPTABLE);
 
-	Update(true);
+	// the others are rechecked at the next SlowUpdate
+	UpdateCoverageGrid();
+	UpdateInterceptors(target);
 }
 
 
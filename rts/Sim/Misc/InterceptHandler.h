@@ -4,20 +4,24 @@
 #define INTERCEPT_HANDLER_H
 
 #include <deque>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include "System/Object.h"
+#include "System/float3.h"
 
 class CWeapon;
 class CWeaponProjectile;
 class CPlasmaRepulser;
 class CProjectile;
-class float3;
 
 class CInterceptHandler : public CObject, boost::noncopyable
 {
 	CR_DECLARE(CInterceptHandler)
 
 public:
+	CInterceptHandler(): coverageGridFrame(-1), numCoverageCellsX(0), numCoverageCellsZ(0) {}
+
+	void PostLoad() { coverageGridFrame = -1; }
 	void Update(bool forced);
 
 	void AddInterceptorWeapon(CWeapon* weapon);
@@ -31,10 +35,34 @@ public:
 
 	void DependentDied(CObject* o);
 
+private:
+	void UpdateCoverageGrid();
+	void UpdateInterceptors(CWeaponProjectile* p);
+
+	void GetCellCandidates(const float3& pos, std::vector<int>& candidates) const;
+	void GetRayCandidates(const float3& pos, const float3& dir, std::vector<int>& candidates) const;
+
 private:
 	std::deque<CWeapon*> interceptors;
 	std::deque<CPlasmaRepulser*> repulsors;
 	std::deque<CWeaponProjectile*> interceptables;
+
+	/**
+	 * Indices (into <interceptors>) of the interceptors whose coverage area
+	 * overlaps each cell, so a projectile is only matched against those
+	 * near its position, target and path. Rebuilt at most once per frame.
+	 */
+	std::vector< std::vector<int> > coverageCells;
+
+	/// bounding rectangle of all coverage areas (y unused), at most
+	/// a map's size beyond the border
+	float3 coverageMins;
+	float3 coverageMaxs;
+
+	/// frame the grid was built in, -1 when the interceptors changed since
+	int coverageGridFrame;
+	int numCoverageCellsX;
+	int numCoverageCellsZ;
 };
 
 extern CInterceptHandler interceptHandler;
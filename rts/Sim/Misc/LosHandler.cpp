@@ -68,7 +68,6 @@ size_t ILosType::cacheHits  = 1;
 size_t ILosType::cacheReactivated = 1;
 constexpr float CLosHandler::defBaseRadarErrorSize;
 constexpr float CLosHandler::defBaseRadarErrorMult;
-constexpr SLosInstance::RLE SLosInstance::EMPTY_RLE;
 
 
 ILosType::ILosType(const int mipLevel_, LosType type_)
@@ -80,7 +79,7 @@ ILosType::ILosType(const int mipLevel_, LosType type_)
 	, algoType((type == LOS_TYPE_LOS || type == LOS_TYPE_RADAR) ? LOS_ALGO_RAYCAST : LOS_ALGO_CIRCLE)
 	, losMaps(
 		(type != LOS_TYPE_JAMMER && type != LOS_TYPE_SONAR_JAMMER) ? teamHandler->ActiveAllyTeams() : 1,
-		CLosMap(size, type == LOS_TYPE_LOS, readMap->GetMIPHeightMapSynced(mipLevel_), int2(mapDims.mapx, mapDims.mapy)))
+		CLosMap(size, type == LOS_TYPE_LOS, readMap->GetMIPHeightMapSynced(mipLevel_), readMap->GetCenterHeightMapSynced(), int2(mapDims.mapx, mapDims.mapy)))
 {
 }
 
@@ -412,6 +411,7 @@ void ILosType::Update()
 
 	std::vector<SLosInstance*> losRemove;
 	std::vector<SLosInstance*> losRecalc;
+	std::vector<SLosInstance*> losTerra; // only recast the rays over the changed terrain
 	std::vector<SLosInstance*> losAdd;
 	std::vector<SLosInstance*> losDeleted;
 	losRemove.reserve(losUpdate.size());
@@ -432,6 +432,10 @@ void ILosType::Update()
 				losAdd.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::RECALC: {
+				if (algoType == LOS_ALGO_RAYCAST && losMaps[li->allyteam].CanUpdateRaycast(li)) {
+					losTerra.push_back(li);
+					break;
+				}
 				losRemove.push_back(li);
 				if (algoType == LOS_ALGO_RAYCAST) losRecalc.push_back(li);
 				losAdd.push_back(li);
@@ -466,6 +470,21 @@ void ILosType::Update()
 			li->squares.clear();
 			losMaps[li->allyteam].PrepareRaycast(li);
 		});
+
+		std::vector< std::vector<int> > squaresAdded(losTerra.size());
+		std::vector< std::vector<int> > squaresRemoved(losTerra.size());
+
+		for_mt(0, losTerra.size(), [&](const int idx) {
+			auto li = losTerra[idx];
+			assert(li->refCount > 0);
+			losMaps[li->allyteam].PrepareRaycastUpdate(li, squaresAdded[idx], squaresRemoved[idx]);
+		});
+
+		for (size_t n = 0; n < losTerra.size(); ++n) {
+			CLosMap& losMap = losMaps[losTerra[n]->allyteam];
+			losMap.AddSquares(losTerra[n], squaresRemoved[n], -1);
+			losMap.AddSquares(losTerra[n], squaresAdded[n], 1);
+		}
 	}
 
 	// add sight
@@ -501,29 +520,27 @@ void ILosType::UpdateHeightMapSynced(SRectangle rect)
 	if (algoType == LOS_ALGO_CIRCLE)
 		return;
 
-	auto CheckOverlap = [&](SLosInstance* li, SRectangle rect) -> bool {
-		int2 pos = li->basePos * divisor;
-		const int radius = li->radius * divisor;
-
-		const int hw = rect.GetWidth() * (SQUARE_SIZE / 2);
-		const int hh = rect.GetHeight() * (SQUARE_SIZE / 2);
-
-		int2 circleDistance;
-		circleDistance.x = std::abs(pos.x - rect.x1 * SQUARE_SIZE) - hw;
-		circleDistance.y = std::abs(pos.y - rect.y1 * SQUARE_SIZE) - hh;
-
-		if (circleDistance.x > radius) { return false; }
-		if (circleDistance.y > radius) { return false; }
-		if (circleDistance.x <= 0) { return true; }
-		if (circleDistance.y <= 0) { return true; }
-
-		return (Square(circleDistance.x) + Square(circleDistance.y)) <= Square(radius);
+	// the changed heightmap corners affect the center heights of the squares
+	// around them, convert those to the LOS map's squares (bounds inclusive)
+	const SRectangle losRect(
+		std::max((rect.x1 - 1) >> mipLevel, 0),
+		std::max((rect.y1 - 1) >> mipLevel, 0),
+		std::min(rect.x2 >> mipLevel, size.x - 1),
+		std::min(rect.y2 >> mipLevel, size.y - 1)
+	);
+
+	auto CheckOverlap = [&](SLosInstance* li, const SRectangle& rect) -> bool {
+		const int dx = std::max(0, std::max(rect.x1 - li->basePos.x, li->basePos.x - rect.x2));
+		const int dy = std::max(0, std::max(rect.y1 - li->basePos.y, li->basePos.y - rect.y2));
+
+		// +1: the rays reach a bit beyond the exact radius
+		return (Square(dx) + Square(dy)) <= Square(li->radius + 1);
 	};
 
 	// delete unused instances that overlap with the changed rectangle
 	for (auto it = losCache.begin(); it != losCache.end();) {
 		SLosInstance* li = *it;
-		if (li->refCount > 0 || !CheckOverlap(li, rect)) {
+		if (li->refCount > 0 || !CheckOverlap(li, losRect)) {
 			++it;
 			continue;
 		}
@@ -536,11 +553,19 @@ void ILosType::UpdateHeightMapSynced(SRectangle rect)
 	for (auto& p: instanceHash) {
 		SLosInstance* li = p.second;
 
-		if (li->status & SLosInstance::TLosStatus::RECALC)
+		if (!CheckOverlap(li, losRect))
 			continue;
-		if (!CheckOverlap(li, rect))
+
+		if (li->status & SLosInstance::TLosStatus::RECALC) {
+			SRectangle& terraRect = li->terraRect;
+			terraRect.x1 = std::min(terraRect.x1, losRect.x1);
+			terraRect.y1 = std::min(terraRect.y1, losRect.y1);
+			terraRect.x2 = std::max(terraRect.x2, losRect.x2);
+			terraRect.y2 = std::max(terraRect.y2, losRect.y2);
 			continue;
+		}
 
+		li->terraRect = losRect;
 		UpdateInstanceStatus(li, SLosInstance::TLosStatus::RECALC);
 	}
 }
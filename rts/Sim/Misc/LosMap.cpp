@@ -1,7 +1,6 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "LosMap.h"
-#include "LosHandler.h"
 #include "Map/ReadMap.h"
 #include "System/myMath.h"
 #include "System/float3.h"
@@ -16,6 +15,7 @@
 
 
 constexpr float LOS_BONUS_HEIGHT = 5.f;
+constexpr SLosInstance::RLE SLosInstance::EMPTY_RLE;
 
 
 static spring::spinlock mutex;
@@ -102,19 +102,29 @@ void MidpointCircleAlgoPerLine(int radius, F func)
 typedef std::vector<int2> LosLine;
 typedef std::vector<LosLine> LosTable;
 
+/// for each square of the upper right sector, the indices of the rays passing it
+struct LosSquareRays {
+	/// rays of square (x,y) are rays[offsets[i] .. offsets[i + 1]) with i = y * (radius + 1) + x
+	std::vector<int> offsets;
+	std::vector<int> rays;
+};
+
 class CLosTables
 {
 public:
 	static const LosTable& GetForLosSize(size_t losSize);
+	static const LosSquareRays& GetSquareRaysForLosSize(size_t losSize);
 
 private:
 	static CLosTables instance;
 	std::vector<LosTable> lostables;
+	std::vector<LosSquareRays> squareRays;
 
 private:
 	CLosTables();
 	static LosLine GetRay(int x, int y);
 	static LosTable GetLosRays(int radius);
+	static LosSquareRays GetSquareRays(const LosTable& losRays, int radius);
 	static void Debug(const LosTable& losRays, const std::vector<int2>& points, int radius);
 	static std::vector<int2> GetCircleSurface(const int radius);
 	static void AddMissing(LosTable& losRays, const std::vector<int2>& circlePoints, const int radius);
@@ -145,10 +155,35 @@ const LosTable& CLosTables::GetForLosSize(size_t losSize)
 }
 
 
+const LosSquareRays& CLosTables::GetSquareRaysForLosSize(size_t losSize)
+{
+	const LosTable& table = GetForLosSize(losSize);
+
+	if (instance.squareRays.size() <= losSize) {
+		boost::lock_guard<spring::spinlock> lck(mutex);
+		if (instance.squareRays.size() <= losSize) {
+			instance.squareRays.resize(losSize+1);
+		}
+	}
+
+	LosSquareRays& sr = instance.squareRays[losSize];
+	if (sr.offsets.empty() && losSize > 0) {
+		auto srays = GetSquareRays(table, losSize);
+		boost::lock_guard<spring::spinlock> lck(mutex);
+		if (sr.offsets.empty()) {
+			sr = std::move(srays);
+		}
+	}
+
+	return sr;
+}
+
+
 CLosTables::CLosTables()
 {
 	lostables.reserve(128);
 	lostables.emplace_back(); // zero radius
+	squareRays.reserve(128);
 }
 
 
@@ -181,6 +216,39 @@ LosTable CLosTables::GetLosRays(const int radius)
 }
 
 
+/**
+ * @brief Inverts the ray table, so the rays crossing a square can be found
+ * without walking all of them (used to recast after terrain changes).
+ */
+LosSquareRays CLosTables::GetSquareRays(const LosTable& losRays, const int radius)
+{
+	const int width = radius + 1;
+
+	LosSquareRays sr;
+	sr.offsets.resize(width * width + 1, 0);
+
+	for (const LosLine& line: losRays) {
+		for (const int2& p: line) {
+			++sr.offsets[p.y * width + p.x + 1];
+		}
+	}
+	for (size_t i = 1; i < sr.offsets.size(); ++i) {
+		sr.offsets[i] += sr.offsets[i - 1];
+	}
+
+	std::vector<int> fillPos(sr.offsets.begin(), sr.offsets.end() - 1);
+	sr.rays.resize(sr.offsets.back());
+
+	for (size_t n = 0; n < losRays.size(); ++n) {
+		for (const int2& p: losRays[n]) {
+			sr.rays[fillPos[p.y * width + p.x]++] = n;
+		}
+	}
+
+	return sr;
+}
+
+
 /**
  * @brief returns the surface coords of a 2d circle.
  * Note, we only return the upper right part, the other 3 are generated via mirroring.
@@ -400,36 +468,54 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 		return;
 	}
 
+	const bool updateUnsyncedHeightMap = UpdatesUnsyncedHeightMap(instance, amount);
+
+	for (const SLosInstance::RLE rle: instance->squares) {
+		int idx = rle.start;
+		for (int l = rle.length; l>0; --l, ++idx) {
+			AddToSquare(idx, amount, updateUnsyncedHeightMap);
+		}
+	}
+}
+
+
+void CLosMap::AddSquares(const SLosInstance* instance, const std::vector<int>& squares, int amount)
+{
+	const bool updateUnsyncedHeightMap = UpdatesUnsyncedHeightMap(instance, amount);
+
+	for (const int idx: squares) {
+		AddToSquare(idx, amount, updateUnsyncedHeightMap);
+	}
+}
+
+
+bool CLosMap::UpdatesUnsyncedHeightMap(const SLosInstance* instance, int amount) const
+{
 #ifdef USE_UNSYNCED_HEIGHTMAP
 	// Inform ReadMap when squares enter LoS
-	const bool updateUnsyncedHeightMap = (sendReadmapEvents && instance->allyteam >= 0 && (instance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
-	if ((amount > 0) && updateUnsyncedHeightMap) {
-		for (const SLosInstance::RLE rle: instance->squares) {
-			int idx = rle.start;
-			for (int l = rle.length; l>0; --l, ++idx) {
-				const bool squareEnteredLOS = (losmap[idx] == 0);
-				losmap[idx] += amount;
+	return ((amount > 0) && sendReadmapEvents && instance->allyteam >= 0 && (instance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
+#else
+	return false;
+#endif
+}
 
-				if (!squareEnteredLOS) { continue; }
 
-				const int2 lm = IdxToCoord(idx, size.x);
-				const int2 p1 = lm * LOS2HEIGHT;
-				const int2 p2 = std::min(p1 + int2(1,1), int2(mapDims.mapxm1, mapDims.mapym1));
+inline void CLosMap::AddToSquare(int idx, int amount, bool updateUnsyncedHeightMap)
+{
+#ifdef USE_UNSYNCED_HEIGHTMAP
+	if (updateUnsyncedHeightMap && losmap[idx] == 0) {
+		losmap[idx] += amount;
 
-				readMap->UpdateLOS(SRectangle(p1.x, p1.y, p2.x, p2.y));
-			}
-		}
+		const int2 lm = IdxToCoord(idx, size.x);
+		const int2 p1 = lm * LOS2HEIGHT;
+		const int2 p2 = std::min(p1 + int2(1,1), mapSize - int2(1,1));
 
+		readMap->UpdateLOS(SRectangle(p1.x, p1.y, p2.x, p2.y));
 		return;
 	}
 #endif
 
-	for (const SLosInstance::RLE rle: instance->squares) {
-		int idx = rle.start;
-		for (int l = rle.length; l>0; --l, ++idx) {
-			losmap[idx] += amount;
-		}
-	}
+	losmap[idx] += amount;
 }
 
 
@@ -454,14 +540,13 @@ void CLosMap::LosAdd(SLosInstance* li) const
 		float2 fpos = pos;
 		fpos += 0.5f;
 		fpos /= float2(size);
-		int2 ipos = fpos * float2(mapDims.mapx, mapDims.mapy);
-		//assert(ipos.y * mapDims.mapx + ipos.x < (mapDims.mapx * mapDims.mapy));
-		return ipos.y * mapDims.mapx + ipos.x;
+		int2 ipos = fpos * float2(mapSize);
+		//assert(ipos.y * mapSize.x + ipos.x < (mapSize.x * mapSize.y));
+		return ipos.y * mapSize.x + ipos.x;
 	};
 
 	//assert(li->radius > 0);
-	const float* heightmapFull = readMap->GetCenterHeightMapSynced();
-	if (SRectangle(0,0,size.x,size.y).Inside(li->basePos) && li->baseHeight <= heightmapFull[MAP_SQUARE_FULLRES(li->basePos)]) { return; }
+	if (SRectangle(0,0,size.x,size.y).Inside(li->basePos) && li->baseHeight <= centerHeightmap[MAP_SQUARE_FULLRES(li->basePos)]) { return; }
 
 	// add all squares that are in the los radius
 	SRectangle safeRect(li->radius, li->radius, size.x - li->radius, size.y - li->radius);
@@ -482,6 +567,25 @@ inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
 }
 
 
+inline static float GetLosAngle(const float height, const float losHeight, const float invR)
+{
+	const float dh = std::max(0.f, height) - losHeight;
+	return (dh + LOS_BONUS_HEIGHT) * invR;
+}
+
+
+/// maps a square of the upper right sector (as stored in the LosTable) into one of the 4 sectors
+inline static int2 MirrorLosOffset(const int2 square, const int mirror)
+{
+	switch (mirror) {
+		case 0: return square;
+		case 1: return -square;
+		case 2: return int2(square.y, -square.x);
+		default: return int2(-square.y, square.x);
+	}
+}
+
+
 
 void CLosMap::CastLos(float* maxAng, const int2 off, std::vector<bool>& squaresMap, std::vector<float>& anglesMap, const int radius) const
 {
@@ -513,7 +617,7 @@ void CLosMap::AddSquaresToInstance(SLosInstance* li, const std::vector<bool>& sq
 				++rle.length;
 			} else {
 				if (rle.length > 0) li->squares.push_back(rle);
-				rle.start  = MAP_SQUARE(pos + off);
+				rle.start  = MAP_SQUARE(pos + off) + 1;
 				rle.length = 0;
 			}
 		}
@@ -559,11 +663,10 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 			const float invR = isqrt_lookup(off.x*off.x + off.y*off.y);
 
 			const int idx = MAP_SQUARE(wpos);
-			const float dh = std::max(0.f, heightmap[idx]) - losHeight;
 			const size_t oidx = ToAngleMapIdx(off, radius);
 
 			//assert(anglesMap[oidx] == -1e8);
-			anglesMap[oidx] = (dh + LOS_BONUS_HEIGHT) * invR;
+			anglesMap[oidx] = GetLosAngle(heightmap[idx], losHeight, invR);
 		}
 	});
 
@@ -616,10 +719,9 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 				const float invR = isqrt_lookup(off.x*off.x + off.y*off.y);
 
 				const int idx = MAP_SQUARE(wpos);
-				const float dh = std::max(0.f, heightmap[idx]) - losHeight;
 				const size_t oidx = ToAngleMapIdx(off, radius);
 
-				anglesMap[oidx] = (dh + LOS_BONUS_HEIGHT) * invR;
+				anglesMap[oidx] = GetLosAngle(heightmap[idx], losHeight, invR);
 			}
 		}
 	});
@@ -679,3 +781,183 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 	// translate visible square indices to map square idx + RLE
 	AddSquaresToInstance(li, squaresMap);
 }
+
+
+bool CLosMap::CanUpdateRaycast(const SLosInstance* li) const
+{
+	// never cast or buried; whether it still is can't be derived from the changed rays
+	if (li->squares.empty() || li->squares.front().length == SLosInstance::EMPTY_RLE.length)
+		return false;
+
+	// the emit square itself changed, this affects all rays (and may bury the emitter)
+	const SRectangle& rect = li->terraRect;
+	const int2 pos = li->basePos;
+	return (pos.x < rect.x1 || pos.x > rect.x2 || pos.y < rect.y1 || pos.y > rect.y2);
+}
+
+
+void CLosMap::PrepareRaycastUpdate(SLosInstance* li, std::vector<int>& squaresAdded, std::vector<int>& squaresRemoved) const
+{
+	// How does it work?
+	// A square can only change its visibility when one of the rays passing it
+	// crosses a changed square before (or at) it. So we collect those squares
+	// behind the changed ones and recast all rays passing them, with the same
+	// rules as Unsafe-/SafeLosAdd, but without precalculating the whole circle.
+
+	assert(CanUpdateRaycast(li));
+
+	const int2 pos   = li->basePos;
+	const int radius = li->radius;
+	const float losHeight = li->baseHeight;
+	const size_t area = Square((2*radius) + 1);
+
+	// changed squares as offsets to the emit position, clipped to the circle's bounding box
+	const int2 dmin(std::max(li->terraRect.x1 - pos.x, -radius), std::max(li->terraRect.y1 - pos.y, -radius));
+	const int2 dmax(std::min(li->terraRect.x2 - pos.x,  radius), std::min(li->terraRect.y2 - pos.y,  radius));
+
+	if (dmin.x > dmax.x || dmin.y > dmax.y)
+		return;
+
+	const LosTable& table = CLosTables::GetForLosSize(radius);
+	const LosSquareRays& squareRays = CLosTables::GetSquareRaysForLosSize(radius);
+
+	// rays are identified by (lineIdx * 4 + mirror)
+	std::vector<bool> rayMarked(table.size() * 4, false);
+	std::vector<int> rays;
+
+	auto MarkRaysPassing = [&](const int2 off) {
+		// inverse of MirrorLosOffset
+		static const int inverse[4] = {0, 1, 3, 2};
+
+		for (int m = 0; m < 4; ++m) {
+			const int2 square = MirrorLosOffset(off, inverse[m]);
+
+			if (square.x < 0 || square.y < 0)
+				continue;
+
+			const int i = square.y * (radius + 1) + square.x;
+
+			for (int k = squareRays.offsets[i]; k < squareRays.offsets[i + 1]; ++k) {
+				const int ray = squareRays.rays[k] * 4 + m;
+
+				if (rayMarked[ray])
+					continue;
+
+				rayMarked[ray] = true;
+				rays.push_back(ray);
+			}
+		}
+	};
+
+	// 1. rays crossing the changed squares
+	for (int y = dmin.y; y <= dmax.y; ++y) {
+		for (int x = dmin.x; x <= dmax.x; ++x) {
+			MarkRaysPassing(int2(x, y));
+		}
+	}
+
+	// 2. squares on these rays behind the first changed one
+	std::vector<bool> touched(area, false);
+	std::vector<int2> touchedSquares;
+
+	for (const int ray: rays) {
+		bool behindChange = false;
+
+		for (const int2& square: table[ray >> 2]) {
+			const int2 off = MirrorLosOffset(square, ray & 3);
+
+			behindChange |= (off.x >= dmin.x && off.x <= dmax.x && off.y >= dmin.y && off.y <= dmax.y);
+
+			if (!behindChange)
+				continue;
+
+			const size_t oidx = ToAngleMapIdx(off, radius);
+
+			if (touched[oidx])
+				continue;
+
+			touched[oidx] = true;
+			touchedSquares.push_back(off);
+		}
+	}
+
+	// 3. all rays passing them decide about their new visibility
+	for (const int2 off: touchedSquares) {
+		MarkRaysPassing(off);
+	}
+
+	// the filled circle (see MidpointCircleAlgoPerLine), squares outside of it have no angle
+	std::vector<int> halfWidths(2*radius + 1, -1);
+	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
+		halfWidths[y + radius] = std::max(halfWidths[y + radius], width);
+	});
+
+	const SRectangle mapRect(0, 0, size.x, size.y);
+	const bool emitPosInsideMap = mapRect.Inside(pos);
+	std::vector<bool> visible(area, false);
+
+	for (const int ray: rays) {
+		float maxAng = -1e7;
+
+		for (const int2& square: table[ray >> 2]) {
+			const int2 off = MirrorLosOffset(square, ray & 3);
+
+			if (!mapRect.Inside(pos + off)) {
+				if (emitPosInsideMap)
+					break;
+
+				continue;
+			}
+
+			if (std::abs(off.x) > halfWidths[off.y + radius])
+				continue;
+
+			const float invR = isqrt_lookup(off.x*off.x + off.y*off.y);
+			const float angle = GetLosAngle(heightmap[MAP_SQUARE(pos + off)], losHeight, invR);
+
+			if (angle < maxAng)
+				continue;
+
+			maxAng = angle - LOS_BONUS_HEIGHT * invR;
+			visible[ToAngleMapIdx(off, radius)] = true;
+		}
+	}
+
+	// 4. diff against the old squares
+	std::vector<bool> squaresMap(area, false);
+
+	for (const SLosInstance::RLE rle: li->squares) {
+		int idx = rle.start;
+		for (int l = rle.length; l>0; --l, ++idx) {
+			squaresMap[ToAngleMapIdx(IdxToCoord(idx, size.x) - pos, radius)] = true;
+		}
+	}
+
+	const size_t numAdded   = squaresAdded.size();
+	const size_t numRemoved = squaresRemoved.size();
+
+	for (const int2 off: touchedSquares) {
+		const size_t oidx = ToAngleMapIdx(off, radius);
+
+		if (squaresMap[oidx] == visible[oidx])
+			continue;
+
+		squaresMap[oidx] = visible[oidx];
+
+		if (visible[oidx]) {
+			squaresAdded.push_back(MAP_SQUARE(pos + off));
+		} else {
+			squaresRemoved.push_back(MAP_SQUARE(pos + off));
+		}
+	}
+
+	if (squaresAdded.size() == numAdded && squaresRemoved.size() == numRemoved)
+		return;
+
+	li->squares.clear();
+	AddSquaresToInstance(li, squaresMap);
+
+	if (li->squares.empty()) {
+		li->squares.push_back(SLosInstance::EMPTY_RLE);
+	}
+}
@@ -8,21 +8,86 @@
 #include <vector>
 #include "System/type2.h"
 #include "System/myMath.h"
+#include "System/Rectangle.h"
+
+
+/**
+ * LoS Instance
+ *
+ * The main goal of this object is to store the squares on the LOS map that
+ * have been incremented (CLosHandler::LosAdd) when the unit last moved.
+ * (CLosHandler::MoveUnit)
+ *
+ * These squares must be remembered because 1) ray-casting against the terrain
+ * is not particularly fast and more importantly 2) the terrain may have changed
+ * between the LosAdd and the moment we want to undo the LosAdd.
+ *
+ * LosInstances may be shared between multiple units. Reference counting is
+ * used to track how many units currently use one instance.
+ *
+ * An instance will be shared iff the other unit is in the same square
+ * (basePos, baseSquare) on the LOS map, has the same radius, is in the
+ * same ally-team and has the same height.
+ */
+struct SLosInstance
+{
+	SLosInstance(int id)
+		: allyteam(-1)
+		, radius(-1)
+		, basePos()
+		, baseHeight(-1)
+		, refCount(0)
+		, hashNum(-1)
+		, status(NONE)
+		, toBeDeleted(false)
+		, id(id)
+	{}
+	void Init(int radius, int allyteam, int2 basePos, float baseHeight, int hashNum);
+
+	// hash properties
+	int allyteam;
+	int radius;
+	int2 basePos;
+	float baseHeight;
+
+	// working data
+	int refCount;
+	struct RLE { int start; unsigned length; };
+	static constexpr RLE EMPTY_RLE = {0,0};
+	std::vector<RLE> squares;
+
+	// helpers
+	int hashNum;
+	enum TLosStatus {
+		NONE = 0,
+		NEW  = 1,
+		REACTIVATE = 2,
+		RECALC = 4,
+		REMOVE = 8,
+	};
+	int status;
+	bool toBeDeleted;
+	int id;
+
+	/// LOS-map squares (bounds inclusive) whose height changed since the
+	/// last raycast, only valid while status has the RECALC bit set
+	SRectangle terraRect;
+};
 
 
-struct SLosInstance;
-
 
 /// map containing counts of how many units have Line Of Sight (LOS) to each square
 class CLosMap
 {
 public:
-	CLosMap(int2 size_, bool sendReadmapEvents_, const float* heightmap_, const int2 mapDims)
+	CLosMap(int2 size_, bool sendReadmapEvents_, const float* heightmap_, const float* centerHeightmap_, const int2 mapSize_)
 	: size(size_)
-	, LOS2HEIGHT(mapDims / size)
+	, mapSize(mapSize_)
+	, LOS2HEIGHT(mapSize_ / size)
 	, losmap(size.x * size.y, 0)
 	, sendReadmapEvents(sendReadmapEvents_)
 	, heightmap(heightmap_)
+	, centerHeightmap(centerHeightmap_)
 	{ }
 
 public:
@@ -35,6 +100,22 @@ public:
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void PrepareRaycast(SLosInstance* instance) const;
 
+	/// adds {@param amount} to the given map squares of a raycast {@param instance}
+	void AddSquares(const SLosInstance* instance, const std::vector<int>& squares, int amount);
+
+	/// whether PrepareRaycastUpdate can handle the terrain change in instance->terraRect,
+	/// otherwise the instance has to be removed, raycast from scratch and added again
+	bool CanUpdateRaycast(const SLosInstance* instance) const;
+
+	/**
+	 * Recasts only the rays of {@param instance} that pass over the changed
+	 * squares in instance->terraRect and updates its squares accordingly.
+	 * The map squares that entered resp. left its sight are returned in
+	 * {@param squaresAdded} and {@param squaresRemoved}, they still have to
+	 * be applied to the losmap via AddSquares.
+	 */
+	void PrepareRaycastUpdate(SLosInstance* instance, std::vector<int>& squaresAdded, std::vector<int>& squaresRemoved) const;
+
 public:
 	int At(int2 p) const {
 		p.x = Clamp(p.x, 0, size.x - 1);
@@ -53,12 +134,17 @@ private:
 	inline void CastLos(float* maxAng, const int2 off, std::vector<bool>& squaresMap, std::vector<float>& anglesMap, const int radius) const;
 	void AddSquaresToInstance(SLosInstance* li, const std::vector<bool>& squaresMap) const;
 
+	bool UpdatesUnsyncedHeightMap(const SLosInstance* instance, int amount) const;
+	inline void AddToSquare(int idx, int amount, bool updateUnsyncedHeightMap);
+
 protected:
 	const int2 size;
+	const int2 mapSize;
 	const int2 LOS2HEIGHT;
 	std::vector<unsigned short> losmap;
 	bool sendReadmapEvents;
 	const float* const heightmap;
+	const float* const centerHeightmap;
 };
 
 #endif // LOS_MAP_H
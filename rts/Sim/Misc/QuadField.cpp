@@ -11,6 +11,7 @@
 
 #ifndef UNIT_TEST
 	#include "Sim/Features/Feature.h"
+	#include "Sim/MoveTypes/GroundCollisionBroadphase.h"
 	#include "Sim/Units/Unit.h"
 	#include "Sim/Projectiles/Projectile.h"
 #endif
@@ -269,6 +270,9 @@ std::vector<int> CQuadField::GetQuadsOnRay(const float3 start, const float3 dir,
 #ifndef UNIT_TEST
 void CQuadField::MovedUnit(CUnit* unit)
 {
+	// teleports, transports, new units, ...
+	groundCollisionBroadphase.MovedUnit(unit);
+
 	auto newQuads = std::move(GetQuads(unit->pos, unit->radius));
 
 	// compare if the quads have changed, if not stop here
@@ -451,11 +455,26 @@ std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& pos, float radius, b
 
 std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& mins, const float3& maxs)
 {
-	const auto& quads = GetQuadsRectangle(mins, maxs);
-	const int tempNum = gs->tempNum++;
 	std::vector<CUnit*> units;
+	GetUnitsExact(units, mins, maxs);
+	return units;
+}
+
+void CQuadField::GetUnitsExact(std::vector<CUnit*>& units, const float3& mins, const float3& maxs)
+{
+	mins.AssertNaNs();
+	maxs.AssertNaNs();
+
+	const int2 qmin = WorldPosToQuadField(mins);
+	const int2 qmax = WorldPosToQuadField(maxs);
+	const int tempNum = gs->tempNum++;
+
+	units.clear();
+
+	for (int z = qmin.y; z <= qmax.y; ++z) {
+	for (int x = qmin.x; x <= qmax.x; ++x) {
+		const int qi = z * numQuadsX + x;
 
-	for (const int qi: quads) {
 		for (CUnit* unit: baseQuads[qi].units) {
 			const float3& pos = unit->midPos;
 
@@ -467,8 +486,107 @@ std::vector<CUnit*> CQuadField::GetUnitsExact(const float3& mins, const float3&
 			units.push_back(unit);
 		}
 	}
+	}
+}
 
-	return units;
+void CQuadField::GetUnitsExact(
+	std::vector< std::vector<CUnit*> >& results,
+	const std::vector<float3>& mins,
+	const std::vector<float3>& maxs
+) {
+	assert(mins.size() == maxs.size());
+
+	const unsigned int numQueries = mins.size();
+
+	results.resize(numQueries);
+
+	for (unsigned int i = 0; i < numQueries; i++) {
+		results[i].clear();
+	}
+
+	if (quadQuerySlots.size() != baseQuads.size())
+		quadQuerySlots.assign(baseQuads.size(), -1);
+
+	touchedQuads.clear();
+	queryOffsets.assign(1, 0);
+
+	// first pass: count how many queries overlap each touched quad
+	for (unsigned int i = 0; i < numQueries; i++) {
+		const int2 qmin = WorldPosToQuadField(mins[i]);
+		const int2 qmax = WorldPosToQuadField(maxs[i]);
+
+		for (int z = qmin.y; z <= qmax.y; ++z) {
+		for (int x = qmin.x; x <= qmax.x; ++x) {
+			const int qi = z * numQuadsX + x;
+
+			if (quadQuerySlots[qi] < 0) {
+				quadQuerySlots[qi] = touchedQuads.size();
+				touchedQuads.push_back(qi);
+				queryOffsets.push_back(0);
+			}
+
+			queryOffsets[quadQuerySlots[qi] + 1] += 1;
+		}
+		}
+	}
+
+	// turn the counts into offsets shifted by one slot, such that
+	// after the second pass [offsets[n], offsets[n + 1]) is the
+	// range of queryIndices belonging to touched quad <n>
+	unsigned int numIndices = 0;
+
+	for (unsigned int n = 1; n < queryOffsets.size(); n++) {
+		const int cnt = queryOffsets[n];
+		queryOffsets[n] = numIndices;
+		numIndices += cnt;
+	}
+
+	queryIndices.resize(numIndices);
+
+	// second pass: bucket the query indices per touched quad
+	for (unsigned int i = 0; i < numQueries; i++) {
+		const int2 qmin = WorldPosToQuadField(mins[i]);
+		const int2 qmax = WorldPosToQuadField(maxs[i]);
+
+		for (int z = qmin.y; z <= qmax.y; ++z) {
+		for (int x = qmin.x; x <= qmax.x; ++x) {
+			queryIndices[queryOffsets[quadQuerySlots[z * numQuadsX + x] + 1]++] = i;
+		}
+		}
+	}
+
+	// visit every unit in the touched area once; a rectangle can
+	// only contain a unit if it also covers the quad of its midPos
+	// (the single-query version relies on the same property)
+	const int tempNum = gs->tempNum++;
+
+	for (const int qi: touchedQuads) {
+		for (CUnit* unit: baseQuads[qi].units) {
+			if (unit->tempNum == tempNum)
+				continue;
+
+			unit->tempNum = tempNum;
+
+			const float3& pos = unit->midPos;
+			const int slot = quadQuerySlots[WorldPosToQuadFieldIdx(pos)];
+
+			if (slot < 0)
+				continue;
+
+			for (int n = queryOffsets[slot]; n < queryOffsets[slot + 1]; n++) {
+				const int i = queryIndices[n];
+
+				if (pos.x < mins[i].x || pos.x > maxs[i].x) { continue; }
+				if (pos.z < mins[i].z || pos.z > maxs[i].z) { continue; }
+
+				results[i].push_back(unit);
+			}
+		}
+	}
+
+	for (const int qi: touchedQuads) {
+		quadQuerySlots[qi] = -1;
+	}
 }
 
 
@@ -63,6 +63,21 @@ needed to support dynamic resizing (not used yet)
 	 * mins and maxs, which extends infinitely along the y-axis
 	 */
 	std::vector<CUnit*> GetUnitsExact(const float3& mins, const float3& maxs);
+	/**
+	 * Same as above, but refills the caller-owned @c units
+	 * so repeated queries do not have to allocate
+	 */
+	void GetUnitsExact(std::vector<CUnit*>& units, const float3& mins, const float3& maxs);
+	/**
+	 * Batched form of GetUnitsExact(mins, maxs): collects the units
+	 * inside each rectangle <mins[i], maxs[i]> into results[i] with
+	 * a single pass over the union of all quads the rectangles touch
+	 */
+	void GetUnitsExact(
+		std::vector< std::vector<CUnit*> >& results,
+		const std::vector<float3>& mins,
+		const std::vector<float3>& maxs
+	);
 	/**
 	 * Returns all features within @c radius of @c pos,
 	 * takes the 3D model radius of each feature into account,
@@ -138,6 +153,12 @@ private:
 private:
 	std::vector<Quad> baseQuads;
 
+	// scratch buffers for the batched GetUnitsExact, not serialized
+	std::vector<int> quadQuerySlots;
+	std::vector<int> touchedQuads;
+	std::vector<int> queryOffsets;
+	std::vector<int> queryIndices;
+
 	int numQuadsX;
 	int numQuadsZ;
 
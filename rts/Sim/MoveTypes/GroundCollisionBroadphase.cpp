@@ -0,0 +1,176 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+
+#include "GroundCollisionBroadphase.h"
+#include "MoveDefHandler.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Units/Unit.h"
+#include "System/myMath.h"
+
+CGroundCollisionBroadphase groundCollisionBroadphase;
+
+
+static bool UnitIDLess(const CUnit* a, const CUnit* b) { return (a->id < b->id); }
+
+
+float CGroundCollisionBroadphase::GetSlack(const CUnit* unit)
+{
+	// one frame of movement plus some pushing, anything
+	// beyond that is caught by MovedUnit
+	return (unit->speed.w + SQUARE_SIZE);
+}
+
+float CGroundCollisionBroadphase::GetExtent(const CUnit* unit)
+{
+	const float speed = unit->speed.w;
+	const float midPosOffset = unit->pos.distance2D(unit->midPos);
+
+	// what CGroundMoveType queries around a collider: its collision search radius
+	// (footprint-based, over-estimated here) and its obstacle-avoidance radius
+	float queryRadius = 0.0f;
+
+	if (unit->moveDef != NULL) {
+		const float footprintRadius = (unit->moveDef->xsize + unit->moveDef->zsize) * 0.5f * SQUARE_SIZE;
+		const float collisionRadius = speed + footprintRadius * 2.0f;
+		const float avoidanceRadius = std::max(speed, 1.0f) * unit->radius * 2.0f;
+
+		queryRadius = std::max(collisionRadius, avoidanceRadius);
+	}
+
+	// whatever is queried is matched against the midPos and radius of
+	// the other party; as long as neither party moved beyond its slack
+	// the (padded) bounds of every pair within query-range overlap
+	return (queryRadius + unit->radius + midPosOffset + GetSlack(unit));
+}
+
+void CGroundCollisionBroadphase::Update(const std::vector<CUnit*>& units)
+{
+	bounds.clear();
+	bounds.reserve(units.size());
+
+	int maxUnitID = -1;
+
+	for (CUnit* unit: units) {
+		const float extent = GetExtent(unit);
+		const Bounds b = {
+			unit->pos.x - extent, unit->pos.x + extent,
+			unit->pos.z - extent, unit->pos.z + extent,
+			unit->pos.x, unit->pos.z,
+			GetSlack(unit),
+			unit
+		};
+
+		bounds.push_back(b);
+		maxUnitID = std::max(maxUnitID, unit->id);
+	}
+
+	// sort along x, ties broken by ID so the result does not depend on the input order
+	std::sort(bounds.begin(), bounds.end(), [](const Bounds& a, const Bounds& b) {
+		return ((a.xmin < b.xmin) || (a.xmin == b.xmin && a.unit->id < b.unit->id));
+	});
+
+	// sweep: every later entry starting before the current one ends overlaps it in x
+	overlaps.clear();
+	displacedUnits.clear();
+
+	for (size_t i = 0; i < bounds.size(); i++) {
+		const Bounds& bi = bounds[i];
+
+		for (size_t j = i + 1; j < bounds.size() && bounds[j].xmin <= bi.xmax; j++) {
+			const Bounds& bj = bounds[j];
+
+			if (bj.zmin > bi.zmax || bj.zmax < bi.zmin)
+				continue;
+
+			overlaps.push_back(std::make_pair(i, j));
+		}
+	}
+
+	// bucket the pairs (in both directions) per unit
+	candidateOffsets.assign(bounds.size() + 1, 0);
+	candidateUnits.resize(overlaps.size() * 2);
+
+	for (const auto& p: overlaps) {
+		candidateOffsets[p.first  + 1]++;
+		candidateOffsets[p.second + 1]++;
+	}
+	for (size_t i = 1; i < candidateOffsets.size(); i++) {
+		candidateOffsets[i] += candidateOffsets[i - 1];
+	}
+
+	{
+		std::vector<int> writePos(candidateOffsets.begin(), candidateOffsets.end() - 1);
+
+		for (const auto& p: overlaps) {
+			candidateUnits[writePos[p.first ]++] = bounds[p.second].unit;
+			candidateUnits[writePos[p.second]++] = bounds[p.first ].unit;
+		}
+	}
+
+	boundsIndices.assign(maxUnitID + 1, -1);
+
+	for (size_t i = 0; i < bounds.size(); i++) {
+		std::sort(candidateUnits.begin() + candidateOffsets[i], candidateUnits.begin() + candidateOffsets[i + 1], UnitIDLess);
+
+		boundsIndices[bounds[i].unit->id] = i;
+	}
+
+	sweepFrame = gs->frameNum;
+}
+
+void CGroundCollisionBroadphase::MovedUnit(CUnit* unit)
+{
+	if (sweepFrame != gs->frameNum)
+		return;
+
+	const int idx = (unit->id >= 0 && unit->id < int(boundsIndices.size()))? boundsIndices[unit->id]: -1;
+
+	if (idx >= 0 && bounds[idx].unit == unit) {
+		const Bounds& b = bounds[idx];
+
+		if ((Square(unit->pos.x - b.x) + Square(unit->pos.z - b.z)) <= Square(b.slack))
+			return;
+	}
+
+	const auto it = std::lower_bound(displacedUnits.begin(), displacedUnits.end(), unit, UnitIDLess);
+
+	if (it != displacedUnits.end() && *it == unit)
+		return;
+
+	displacedUnits.insert(it, unit);
+}
+
+bool CGroundCollisionBroadphase::GetCandidates(const CUnit* unit, std::vector<CUnit*>& candidates) const
+{
+	candidates.clear();
+
+	if (sweepFrame != gs->frameNum)
+		return false;
+	if (unit->id < 0 || unit->id >= int(boundsIndices.size()))
+		return false;
+
+	const int idx = boundsIndices[unit->id];
+
+	if (idx < 0 || bounds[idx].unit != unit)
+		return false;
+	// the querying unit itself may not have been reported yet
+	if (Square(unit->pos.x - bounds[idx].x) + Square(unit->pos.z - bounds[idx].z) > Square(bounds[idx].slack))
+		return false;
+	if (std::binary_search(displacedUnits.begin(), displacedUnits.end(), unit, UnitIDLess))
+		return false;
+
+	candidates.assign(candidateUnits.begin() + candidateOffsets[idx], candidateUnits.begin() + candidateOffsets[idx + 1]);
+
+	if (displacedUnits.empty())
+		return true;
+
+	// displaced units may have come within range of anyone
+	const size_t numSwept = candidates.size();
+
+	candidates.insert(candidates.end(), displacedUnits.begin(), displacedUnits.end());
+	std::inplace_merge(candidates.begin(), candidates.begin() + numSwept, candidates.end(), UnitIDLess);
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	return true;
+}
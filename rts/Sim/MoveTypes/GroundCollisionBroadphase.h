@@ -0,0 +1,70 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef GROUND_COLLISION_BROADPHASE_H
+#define GROUND_COLLISION_BROADPHASE_H
+
+#include <vector>
+
+class CUnit;
+
+/**
+ * Per-frame sort-and-sweep over all active units, run once before the
+ * MoveType updates. It yields for every unit the units whose (generously
+ * padded) 2D bounds overlap its own, which CGroundMoveType then uses instead
+ * of querying the QuadField for unit collisions and obstacle avoidance.
+ *
+ * The bounds include the collision search-radius, the avoidance radius and
+ * one frame of movement (the slack), callers still do the exact distance
+ * tests. Units that move further than their slack after the sweep (pushed
+ * by a collision, teleported, unloaded, ...) or that are created after it
+ * are reported through MovedUnit; they fall back to the QuadField for their
+ * own queries and are added to the candidates of every other unit.
+ */
+class CGroundCollisionBroadphase
+{
+public:
+	CGroundCollisionBroadphase(): sweepFrame(-1) {}
+
+	void Update(const std::vector<CUnit*>& units);
+
+	/// checks whether <unit> left the bounds it was swept with
+	void MovedUnit(CUnit* unit);
+
+	/**
+	 * Fills <candidates> (sorted by unit ID) for <unit>.
+	 * @return false if <unit> was not part of this frame's sweep
+	 */
+	bool GetCandidates(const CUnit* unit, std::vector<CUnit*>& candidates) const;
+
+private:
+	static float GetSlack(const CUnit* unit);
+	static float GetExtent(const CUnit* unit);
+
+	struct Bounds {
+		float xmin, xmax;
+		float zmin, zmax;
+		/// position at the time of the sweep
+		float x, z;
+		float slack;
+		CUnit* unit;
+	};
+
+	std::vector<Bounds> bounds;
+	/// index into bounds by unit ID, -1 if not swept
+	std::vector<int> boundsIndices;
+
+	/// candidate lists of all swept units (in bounds order) back to back
+	std::vector<CUnit*> candidateUnits;
+	std::vector<int> candidateOffsets;
+
+	std::vector< std::pair<int, int> > overlaps;
+
+	/// units that moved beyond their slack or were not swept, sorted by ID
+	std::vector<CUnit*> displacedUnits;
+
+	int sweepFrame;
+};
+
+extern CGroundCollisionBroadphase groundCollisionBroadphase;
+
+#endif // GROUND_COLLISION_BROADPHASE_H
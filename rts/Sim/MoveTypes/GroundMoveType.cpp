@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "GroundMoveType.h"
+#include "GroundCollisionBroadphase.h"
 #include "MoveDefHandler.h"
 #include "ExternalAI/EngineOutHandler.h"
 #include "Game/Camera.h"
@@ -1069,7 +1070,23 @@ float3 CGroundMoveType::GetObstacleAvoidanceDir(const float3& desiredDir) {
 	const float avoidanceRadius = std::max(currentSpeed, 1.0f) * (avoider->radius * 2.0f);
 	const float avoiderRadius = FOOTPRINT_RADIUS(avoiderMD->xsize, avoiderMD->zsize, 1.0f);
 
-	const vector<CSolidObject*>& objects = quadField->GetSolidsExact(avoider->pos, avoidanceRadius, 0xFFFFFFFF, CSolidObject::CSTATE_BIT_SOLIDOBJECTS);
+	// only mobile objects are avoided, so the units from the broadphase suffice
+	// (the same filter as QuadField::GetSolidsExact is applied on those)
+	std::vector<CUnit*> nearUnits;
+	std::vector<CSolidObject*> objects;
+
+	if (groundCollisionBroadphase.GetCandidates(avoider, nearUnits)) {
+		for (CUnit* u: nearUnits) {
+			if (!u->HasCollidableStateBit(CSolidObject::CSTATE_BIT_SOLIDOBJECTS))
+				continue;
+			if ((avoider->pos - u->midPos).SqLength() >= Square(avoidanceRadius + u->radius))
+				continue;
+
+			objects.push_back(u);
+		}
+	} else {
+		objects = quadField->GetSolidsExact(avoider->pos, avoidanceRadius, 0xFFFFFFFF, CSolidObject::CSTATE_BIT_SOLIDOBJECTS);
+	}
 
 	for (vector<CSolidObject*>::const_iterator oi = objects.begin(); oi != objects.end(); ++oi) {
 		const CSolidObject* avoidee = *oi;
@@ -1758,7 +1775,17 @@ void CGroundMoveType::HandleUnitCollisions(
 ) {
 	const float searchRadius = colliderSpeed + (colliderRadius * 2.0f);
 
-	const std::vector<CUnit*>& nearUnits = quadField->GetUnitsExact(collider->pos, searchRadius);
+	// candidates come from this frame's broadphase, filtered like QuadField::GetUnitsExact
+	std::vector<CUnit*> nearUnits;
+
+	if (groundCollisionBroadphase.GetCandidates(collider, nearUnits)) {
+		auto it = std::remove_if(nearUnits.begin(), nearUnits.end(), [&](const CUnit* u) {
+			return (collider->pos.SqDistance(u->midPos) >= Square(searchRadius + u->radius));
+		});
+		nearUnits.erase(it, nearUnits.end());
+	} else {
+		nearUnits = quadField->GetUnitsExact(collider->pos, searchRadius);
+	}
 
 	// NOTE: probably too large for most units (eg. causes tree falling animations to be skipped)
 	const int dirSign = Sign(int(!reversing));
@@ -1934,6 +1961,7 @@ void CGroundMoveType::HandleUnitCollisions(
 		if ((pushCollidee || !pushCollider) && collideeMobile) {
 			if (collideeMD->TestMoveSquare(collidee, collidee->pos + collideeMoveVec, collideeMoveVec)) {
 				collidee->Move(collideeMoveVec, true);
+				groundCollisionBroadphase.MovedUnit(collidee);
 			}
 		}
 	}
@@ -175,6 +175,18 @@ struct PathNodeStateBuffer {
 		}
 	}
 
+	/// lets {@param buf} read our synced extra-costs (through its overlay),
+	/// must be called again whenever they are (re)set here
+	void ShareNodeExtraCosts(PathNodeStateBuffer& buf) const {
+		if (extraCostsOverlaySynced != NULL) {
+			buf.SetNodeExtraCosts(extraCostsOverlaySynced, sr.x, sr.y, true);
+		} else if (!extraCostSynced.empty()) {
+			buf.SetNodeExtraCosts(&extraCostSynced[0], br.x, br.y, true);
+		} else {
+			buf.SetNodeExtraCosts(NULL, 0, 0, true);
+		}
+	}
+
 public:
 	std::vector<float> fCost;
 	std::vector<float> gCost;
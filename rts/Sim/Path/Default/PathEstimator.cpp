@@ -4,7 +4,10 @@
 
 #include "PathEstimator.h"
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
+#include <numeric>
 #include <boost/bind.hpp>
 #include <boost/thread/barrier.hpp>
 #include <boost/thread/thread.hpp>
@@ -16,6 +19,7 @@
 #include "PathFlowMap.hpp"
 #include "PathLog.h"
 #include "Game/LoadScreen.h"
+#include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GroundBlockingObjectMap.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
@@ -33,7 +37,10 @@
 #include "System/Sync/HsiehHash.h"
 
 
-CONFIG(int, MaxPathCostsMemoryFootPrint).defaultValue(512).minimumValue(64).description("Maximum memusage (in MByte) of mutlithreaded pathcache generator at loading time.");
+CONFIG(int, MaxPathCostsMemoryFootPrint).defaultValue(512).minimumValue(64).description("Maximum memusage (in MByte) of mutlithreaded pathcache generator at loading time (and of the helper pathfinders used for the in-game updates).");
+
+// frames without obsolete blocks after which the in-game helper pathfinders are freed
+static const unsigned int VERTEX_PATHFINDERS_IDLE_FRAMES = GAME_SPEED * 10;
 
 
 
@@ -58,8 +65,13 @@ CPathEstimator::CPathEstimator(IPathFinder* pf, unsigned int BLOCK_SIZE, const s
 	, offsetBlockNum(nbrOfBlocks.x * nbrOfBlocks.y)
 	, costBlockNum(nbrOfBlocks.x * nbrOfBlocks.y)
 	, pathFinder(pf)
+	, maxVertexPathFinders(1)
+	, idleUpdates(0)
 	, nextPathEstimator(nullptr)
-	, blockUpdatePenalty(0)
+	, requestedBlockIdx(0)
+	, requestedBlocksChanged(false)
+	, avgBlockUpdateCost(BLOCK_SIZE * BLOCK_SIZE * (1 + PATH_DIRECTION_VERTICES))
+	, blockUpdateDebt(0)
 {
 	vertexCosts.resize(moveDefHandler->GetNumMoveDefs() * blockStates.GetSize() * PATH_DIRECTION_VERTICES, PATHCOST_INFINITY);
 
@@ -91,6 +103,10 @@ CPathEstimator::CPathEstimator(IPathFinder* pf, unsigned int BLOCK_SIZE, const s
 
 CPathEstimator::~CPathEstimator()
 {
+	for (unsigned int i = 1; i < pathFinders.size(); i++) {
+		delete pathFinders[i];
+	}
+
 	delete pathCache[0]; pathCache[0] = NULL;
 	delete pathCache[1]; pathCache[1] = NULL;
 }
@@ -165,6 +181,9 @@ void CPathEstimator::InitEstimator(const std::string& cacheFileName, const std::
 	delete pathFinders[0];
 	pathFinders[0] = pathFinder;
 
+	InitMoveDefGroups();
+	InitVertexPathFinders();
+
 	pathCache[0] = new CPathCache(nbrOfBlocks.x, nbrOfBlocks.y);
 	pathCache[1] = new CPathCache(nbrOfBlocks.x, nbrOfBlocks.y);
 }
@@ -179,6 +198,79 @@ void CPathEstimator::InitBlocks()
 }
 
 
+/**
+ * Groups the MoveDefs in use by all parameters that FindOffset and the
+ * vertex searches (which ignore mobile units) depend on.
+ */
+void CPathEstimator::InitMoveDefGroups()
+{
+	const auto HaveEqualBlockCosts = [](const MoveDef* a, const MoveDef* b) {
+		if (a->speedModClass != b->speedModClass || a->terrainClass != b->terrainClass)
+			return false;
+		if (a->xsize != b->xsize || a->zsize != b->zsize)
+			return false;
+		if (a->depth != b->depth || a->maxSlope != b->maxSlope || a->slopeMod != b->slopeMod)
+			return false;
+		if (a->crushStrength != b->crushStrength || a->subMarine != b->subMarine)
+			return false;
+
+		return (std::equal(&a->depthModParams[0], &a->depthModParams[MoveDef::DEPTHMOD_NUM_PARAMS], &b->depthModParams[0]));
+	};
+
+	moveDefGroups.clear();
+
+	for (unsigned int i = 0; i < moveDefHandler->GetNumMoveDefs(); i++) {
+		const MoveDef* md = moveDefHandler->GetMoveDefByPathType(i);
+
+		if (md->udRefCount == 0)
+			continue;
+
+		const auto pred = [&](const std::vector<const MoveDef*>& group) { return (HaveEqualBlockCosts(group[0], md)); };
+		const auto it = std::find_if(moveDefGroups.begin(), moveDefGroups.end(), pred);
+
+		if (it != moveDefGroups.end()) {
+			it->push_back(md);
+		} else {
+			moveDefGroups.emplace_back(1, md);
+		}
+	}
+}
+
+
+/**
+ * Determines how many threads may run vertex searches in Update, each
+ * extra one needs a private CPathFinder (within the same memory bounds
+ * as at load-time). The helpers are only created while there are blocks
+ * to update, see Update and FreeVertexPathFinders.
+ * Estimators searching another estimator stay single-threaded, since the
+ * results depend on its path-cache.
+ */
+void CPathEstimator::InitVertexPathFinders()
+{
+	pathFinders.resize(1);
+	maxVertexPathFinders = 1;
+
+	if (dynamic_cast<CPathFinder*>(pathFinder) == nullptr)
+		return;
+
+	const unsigned int minMemFootPrint = sizeof(CPathFinder) + pathFinder->GetMemFootPrint();
+	const unsigned int maxMemFootPrint = configHandler->GetInt("MaxPathCostsMemoryFootPrint") * 1024 * 1024;
+	const unsigned int numExtraThreads = Clamp(int(maxMemFootPrint / minMemFootPrint) - 1, 0, ThreadPool::GetMaxThreads() - 1);
+
+	maxVertexPathFinders = numExtraThreads + 1;
+}
+
+
+void CPathEstimator::FreeVertexPathFinders()
+{
+	for (unsigned int i = 1; i < pathFinders.size(); i++) {
+		delete pathFinders[i];
+	}
+
+	pathFinders.resize(1);
+}
+
+
 __FORCE_ALIGN_STACK__
 void CPathEstimator::CalcOffsetsAndPathCosts(unsigned int threadNum)
 {
@@ -311,22 +403,27 @@ int2 CPathEstimator::FindOffset(const MoveDef& moveDef, unsigned int blockX, uns
 
 
 /**
- * Calculate all vertices connected from the given block
+ * Calculate all vertices connected from the given block,
+ * returns the number of nodes searched for them
  */
-void CPathEstimator::CalculateVertices(const MoveDef& moveDef, int2 block, unsigned int thread)
+unsigned int CPathEstimator::CalculateVertices(const MoveDef& moveDef, int2 block, unsigned int thread)
 {
+	unsigned int searchedNodes = 0;
+
 	// see code comment of GetBlockVertexOffset() for more info why those directions are choosen
-	CalculateVertex(moveDef, block, PATHDIR_LEFT,     thread);
-	CalculateVertex(moveDef, block, PATHDIR_LEFT_UP,  thread);
-	CalculateVertex(moveDef, block, PATHDIR_UP,       thread);
-	CalculateVertex(moveDef, block, PATHDIR_RIGHT_UP, thread);
+	searchedNodes += CalculateVertex(moveDef, block, PATHDIR_LEFT,     thread);
+	searchedNodes += CalculateVertex(moveDef, block, PATHDIR_LEFT_UP,  thread);
+	searchedNodes += CalculateVertex(moveDef, block, PATHDIR_UP,       thread);
+	searchedNodes += CalculateVertex(moveDef, block, PATHDIR_RIGHT_UP, thread);
+
+	return searchedNodes;
 }
 
 
 /**
- * Calculate requested vertex
+ * Calculate requested vertex, returns the number of nodes searched for it
  */
-void CPathEstimator::CalculateVertex(
+unsigned int CPathEstimator::CalculateVertex(
 	const MoveDef& moveDef,
 	int2 parentBlock,
 	unsigned int direction,
@@ -343,7 +440,7 @@ void CPathEstimator::CalculateVertex(
 	// outside map?
 	if ((unsigned)childBlock.x >= nbrOfBlocks.x || (unsigned)childBlock.y >= nbrOfBlocks.y) {
 		vertexCosts[vertexNbr] = PATHCOST_INFINITY;
-		return;
+		return 0;
 	}
 
 
@@ -369,7 +466,7 @@ void CPathEstimator::CalculateVertex(
 	const bool goalBlocked = pfDef.IsGoalBlocked(moveDef, CMoveMath::BLOCK_STRUCTURE, nullptr);
 	if (strtBlocked || goalBlocked) {
 		vertexCosts[vertexNbr] = PATHCOST_INFINITY;
-		return;
+		return 0;
 	}
 
 	// find path from parent to child block
@@ -382,7 +479,12 @@ void CPathEstimator::CalculateVertex(
 	pfDef.exactPath  = true;
 	pfDef.dirIndependent = true;
 	IPath::Path path;
-	IPath::SearchResult result = pathFinders[threadNum]->GetPath(moveDef, pfDef, nullptr, startPos, path, MAX_SEARCHED_NODES_PF >> 2);
+	IPathFinder* pf = pathFinders[threadNum];
+
+	// only reset when a search is started, not on cache-hits
+	pf->testedBlocks = 0;
+
+	IPath::SearchResult result = pf->GetPath(moveDef, pfDef, nullptr, startPos, path, MAX_SEARCHED_NODES_PF >> 2);
 
 	// store the result
 	if (result == IPath::Ok) {
@@ -390,6 +492,8 @@ void CPathEstimator::CalculateVertex(
 	} else {
 		vertexCosts[vertexNbr] = PATHCOST_INFINITY;
 	}
+
+	return (pf->testedBlocks);
 }
 
 
@@ -423,102 +527,286 @@ void CPathEstimator::MapChanged(unsigned int x1, unsigned int z1, unsigned int x
 
 
 /**
- * Update some obsolete blocks using the FIFO-principle
+ * Remember where units want to go, these areas get updated first
+ */
+void CPathEstimator::PathRequested(const float3& startPos, const float3& goalPos)
+{
+	static const unsigned int MAX_REQUESTED_BLOCKS = 32;
+
+	const int2 blocks[2] = {
+		int2(Clamp(int(startPos.x / BLOCK_PIXEL_SIZE), 0, int(nbrOfBlocks.x - 1)), Clamp(int(startPos.z / BLOCK_PIXEL_SIZE), 0, int(nbrOfBlocks.y - 1))),
+		int2(Clamp(int( goalPos.x / BLOCK_PIXEL_SIZE), 0, int(nbrOfBlocks.x - 1)), Clamp(int( goalPos.z / BLOCK_PIXEL_SIZE), 0, int(nbrOfBlocks.y - 1))),
+	};
+
+	for (const int2& block: blocks) {
+		if (requestedBlocks.size() < MAX_REQUESTED_BLOCKS) {
+			requestedBlocks.push_back(block);
+			requestedBlocksChanged = true;
+		} else if (requestedBlocks[requestedBlockIdx] != block) {
+			requestedBlocks[requestedBlockIdx] = block;
+			requestedBlocksChanged = true;
+		}
+
+		requestedBlockIdx = (requestedBlockIdx + 1) % MAX_REQUESTED_BLOCKS;
+	}
+}
+
+
+/**
+ * Sort the obsolete blocks by their distance to the closest recently
+ * requested block. Ties are broken from upper to lower (because of the
+ * placement of the bi-directional vertices), which also is the order
+ * while there were no requests yet. Every block has its own key, so the
+ * whole queue ends up in a fully specified order.
+ *
+ * The keys only change with the requests: while those stay the same,
+ * only the blocks queued since the last call are keyed and merged in.
+ */
+void CPathEstimator::PrioritizeUpdatedBlocks()
+{
+	typedef std::pair<boost::uint64_t, int2> KeyedBlock;
+
+	if (requestedBlocksChanged) {
+		updatedBlockKeys.clear();
+		requestedBlocksChanged = false;
+	}
+
+	const unsigned int numKeyedBlocks = updatedBlockKeys.size();
+
+	if (numKeyedBlocks == updatedBlocks.size())
+		return;
+
+	std::vector<KeyedBlock> newBlocks;
+	newBlocks.reserve(updatedBlocks.size() - numKeyedBlocks);
+
+	for (unsigned int n = numKeyedBlocks; n < updatedBlocks.size(); n++) {
+		const int2& block = updatedBlocks[n];
+
+		unsigned int minSqDist = 0;
+
+		if (!requestedBlocks.empty()) {
+			minSqDist = std::numeric_limits<unsigned int>::max();
+
+			for (const int2& reqBlock: requestedBlocks) {
+				const int dx = block.x - reqBlock.x;
+				const int dz = block.y - reqBlock.y;
+
+				minSqDist = std::min(minSqDist, unsigned(dx * dx + dz * dz));
+			}
+		}
+
+		const boost::uint64_t key = (boost::uint64_t(minSqDist) << 32) | (blockStates.GetSize() - 1 - BlockPosToIdx(block));
+		newBlocks.emplace_back(key, block);
+	}
+
+	const auto cmp = [](const KeyedBlock& a, const KeyedBlock& b) { return (a.first < b.first); };
+
+	std::sort(newBlocks.begin(), newBlocks.end(), cmp);
+
+	if (numKeyedBlocks == 0) {
+		for (unsigned int n = 0; n < newBlocks.size(); n++) {
+			updatedBlocks[n] = newBlocks[n].second;
+			updatedBlockKeys.push_back(newBlocks[n].first);
+		}
+
+		return;
+	}
+
+	// merge with the (still sorted) blocks keyed before
+	std::vector<KeyedBlock> keyedBlocks;
+	keyedBlocks.reserve(updatedBlocks.size());
+
+	for (unsigned int n = 0; n < numKeyedBlocks; n++) {
+		keyedBlocks.emplace_back(updatedBlockKeys[n], updatedBlocks[n]);
+	}
+
+	keyedBlocks.insert(keyedBlocks.end(), newBlocks.begin(), newBlocks.end());
+	std::inplace_merge(keyedBlocks.begin(), keyedBlocks.begin() + numKeyedBlocks, keyedBlocks.end(), cmp);
+
+	updatedBlockKeys.clear();
+
+	for (unsigned int n = 0; n < keyedBlocks.size(); n++) {
+		updatedBlocks[n] = keyedBlocks[n].second;
+		updatedBlockKeys.push_back(keyedBlocks[n].first);
+	}
+}
+
+
+/**
+ * Update some obsolete blocks, closest to the recent path requests first
  */
 void CPathEstimator::Update()
 {
 	pathCache[0]->Update();
 	pathCache[1]->Update();
 
-	const auto numMoveDefs = moveDefHandler->GetNumMoveDefs();
-	if (numMoveDefs == 0) {
+	if (moveDefGroups.empty())
+		return;
+
+	if (updatedBlocks.empty()) {
+		// the helpers take as much memory as the main pathfinder each,
+		// give them back once the terrain stopped changing for a while
+		if (pathFinders.size() > 1 && (++idleUpdates) >= VERTEX_PATHFINDERS_IDLE_FRAMES)
+			FreeVertexPathFinders();
+
 		return;
 	}
 
+	idleUpdates = 0;
+
+	const int numGroups = moveDefGroups.size();
+
 	// determine how many blocks we should update
+	//
+	// the budget is counted in searched nodes (time would differ between
+	// clients) and converted to blocks based on the measured cost of the
+	// previous updates, so cheap blocks (e.g. flat or fully blocked ones)
+	// are worked off faster than expensive ones
 	int blocksToUpdate = 0;
-	int consumeBlocks = 0;
+	int frameBudget = 0;
 	{
-		const int progressiveUpdates = updatedBlocks.size() * numMoveDefs * modInfo.pfUpdateRate;
+		const int progressiveUpdates = updatedBlocks.size() * numGroups * modInfo.pfUpdateRate;
 		const int MIN_BLOCKS_TO_UPDATE = std::max<int>(BLOCKS_TO_UPDATE >> 1, 4U);
 		const int MAX_BLOCKS_TO_UPDATE = std::max<int>(BLOCKS_TO_UPDATE << 1, MIN_BLOCKS_TO_UPDATE);
-		blocksToUpdate = Clamp(progressiveUpdates, MIN_BLOCKS_TO_UPDATE, MAX_BLOCKS_TO_UPDATE);
-
-		blockUpdatePenalty = std::max(0, blockUpdatePenalty - blocksToUpdate);
 
-		if (blockUpdatePenalty > 0)
-			blocksToUpdate = std::max(0, blocksToUpdate - blockUpdatePenalty);
+		frameBudget = Clamp(progressiveUpdates, MIN_BLOCKS_TO_UPDATE, MAX_BLOCKS_TO_UPDATE) * int(BLOCK_SIZE * BLOCK_SIZE * (1 + PATH_DIRECTION_VERTICES));
 
-		// we have to update blocks for all movedefs (cause PATHOPT_OBSOLETE is per block and not movedef)
-		consumeBlocks = int(progressiveUpdates != 0) * int(ceil(float(blocksToUpdate) / numMoveDefs)) * numMoveDefs;
+		if (blockUpdateDebt >= frameBudget) {
+			blockUpdateDebt -= frameBudget;
+			return;
+		}
 
-		blockUpdatePenalty += consumeBlocks;
+		// we have to update blocks for all groups (cause PATHOPT_OBSOLETE is per block and not movedef)
+		blocksToUpdate = std::max(1, (frameBudget - blockUpdateDebt) / (avgBlockUpdateCost * numGroups));
+		blocksToUpdate = std::min(blocksToUpdate, int(updatedBlocks.size()));
 	}
 
-	if (blocksToUpdate == 0)
-		return;
-
-	if (updatedBlocks.empty())
-		return;
+	if (blocksToUpdate < int(updatedBlocks.size()))
+		PrioritizeUpdatedBlocks();
 
 	struct SingleBlock {
 		int2 blockPos;
-		const MoveDef* moveDef;
-		SingleBlock(const int2& pos, const MoveDef* md) : blockPos(pos), moveDef(md) {}
+		unsigned int groupIdx;
+		unsigned int vertexMask; ///< (1 << PATHDIR_*) bits of the vertices to calculate
+		SingleBlock(const int2& pos, unsigned int group, unsigned int mask) : blockPos(pos), groupIdx(group), vertexMask(mask) {}
 	};
 	std::vector<SingleBlock> consumedBlocks;
-	consumedBlocks.reserve(consumeBlocks);
+	consumedBlocks.reserve(blocksToUpdate * numGroups);
+
+	// get blocks to update, for the first MoveDef of each group
+	for (int n = 0; n < blocksToUpdate; n++) {
+		for (int g = 0; g < numGroups; g++) {
+			consumedBlocks.emplace_back(updatedBlocks[n], g, (1 << PATH_DIRECTION_VERTICES) - 1);
+		}
+	}
+
+	const unsigned int numBlockUpdates = consumedBlocks.size();
+
+	// FindOffset (threadsafe)
+	std::vector<int2> blockOffsets(numBlockUpdates);
+	{
+		SCOPED_TIMER("CPathEstimator::FindOffset");
+		for_mt(0, numBlockUpdates, [&](const int n) {
+			// copy the next block in line
+			const SingleBlock sb = consumedBlocks[n];
+			blockOffsets[n] = FindOffset(*moveDefGroups[sb.groupIdx][0], sb.blockPos.x, sb.blockPos.y);
+		});
+	}
 
-	// get blocks to update
-	while (!updatedBlocks.empty()) {
-		int2& pos = updatedBlocks.front();
-		const int idx = BlockPosToIdx(pos);
+	// when the offset of a block moves, so do the vertices leading into it
+	// from the lower side: recalculate those of blocks that are not queued
+	// (still PATHOPT_OBSOLETE, which includes the ones being updated now)
+	for (unsigned int n = 0; n < numBlockUpdates; n++) {
+		const SingleBlock sb = consumedBlocks[n];
+		const unsigned int pathType = moveDefGroups[sb.groupIdx][0]->pathType;
 
-		if ((blockStates.nodeMask[idx] & PATHOPT_OBSOLETE) == 0) {
-			updatedBlocks.pop_front();
+		short2& offset = blockStates.peNodeOffsets[pathType][BlockPosToIdx(sb.blockPos)];
+
+		if (offset == blockOffsets[n])
 			continue;
-		}
 
-		if (consumedBlocks.size() >= blocksToUpdate) {
-			break;
-		}
+		offset = blockOffsets[n];
+
+		for (unsigned int dir = 0; dir < PATH_DIRECTION_VERTICES; dir++) {
+			const int2 parentBlock = sb.blockPos - PE_DIRECTION_VECTORS[dir];
 
-		// issue repathing for all active movedefs
-		for (unsigned int i = 0; i < numMoveDefs; i++) {
-			const MoveDef* md = moveDefHandler->GetMoveDefByPathType(i);
-			if (md->udRefCount > 0)
-				consumedBlocks.emplace_back(pos, md);
+			if ((unsigned)parentBlock.x >= nbrOfBlocks.x || (unsigned)parentBlock.y >= nbrOfBlocks.y)
+				continue;
+			if ((blockStates.nodeMask[BlockPosToIdx(parentBlock)] & PATHOPT_OBSOLETE) != 0)
+				continue;
+
+			consumedBlocks.emplace_back(parentBlock, sb.groupIdx, 1 << dir);
 		}
+	}
+
+	for (int n = 0; n < blocksToUpdate; n++) {
+		const int2 pos = updatedBlocks[n];
 
 		// inform dependent pathEstimator that we change vertex cost of those blocks
 		if (nextPathEstimator)
 			nextPathEstimator->MapChanged(pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE, pos.x * BLOCK_SIZE, pos.y * BLOCK_SIZE);
 
-		updatedBlocks.pop_front(); // must happen _after_ last usage of the `pos` reference!
-		blockStates.nodeMask[idx] &= ~PATHOPT_OBSOLETE;
+		blockStates.nodeMask[BlockPosToIdx(pos)] &= ~PATHOPT_OBSOLETE;
 	}
 
-	// FindOffset (threadsafe)
-	{
-		SCOPED_TIMER("CPathEstimator::FindOffset");
-		for_mt(0, consumedBlocks.size(), [&](const int n) {
-			// copy the next block in line
-			const SingleBlock sb = consumedBlocks[n];
-			const int blockN = BlockPosToIdx(sb.blockPos);
-			const MoveDef* currBlockMD = sb.moveDef;
-			blockStates.peNodeOffsets[currBlockMD->pathType][blockN] = FindOffset(*currBlockMD, sb.blockPos.x, sb.blockPos.y);
-		});
+	updatedBlocks.erase(updatedBlocks.begin(), updatedBlocks.begin() + blocksToUpdate);
+	updatedBlockKeys.erase(updatedBlockKeys.begin(), updatedBlockKeys.begin() + std::min<size_t>(blocksToUpdate, updatedBlockKeys.size()));
+
+	// CalculateVertex (threadsafe when each thread has its own pathfinder,
+	// every one of them gets a fixed share of the blocks so the results do
+	// not depend on scheduling); no more threads than blocks this frame
+	const unsigned int numThreads = Clamp<unsigned int>(consumedBlocks.size(), 1, maxVertexPathFinders);
+
+	while (pathFinders.size() < numThreads) {
+		pathFinders.push_back(new CPathFinder());
 	}
 
-	// CalculateVertices (not threadsafe)
+	std::vector<unsigned int> searchedNodes(numThreads, 0);
 	{
 		SCOPED_TIMER("CPathEstimator::CalculateVertices");
-		for (unsigned int n = 0; n < consumedBlocks.size(); ++n) {
-			// copy the next block in line
-			const SingleBlock sb = consumedBlocks[n];
-			CalculateVertices(*sb.moveDef, sb.blockPos);
+
+		for (unsigned int i = 1; i < numThreads; i++) {
+			pathFinder->GetNodeStateBuffer().ShareNodeExtraCosts(pathFinders[i]->GetNodeStateBuffer());
+		}
+
+		for_mt(0, numThreads, [&](const int threadNum) {
+			for (unsigned int n = threadNum; n < consumedBlocks.size(); n += numThreads) {
+				const SingleBlock& sb = consumedBlocks[n];
+
+				for (unsigned int dir = 0; dir < PATH_DIRECTION_VERTICES; dir++) {
+					if ((sb.vertexMask & (1 << dir)) == 0)
+						continue;
+
+					searchedNodes[threadNum] += CalculateVertex(*moveDefGroups[sb.groupIdx][0], sb.blockPos, dir, threadNum);
+				}
+			}
+		});
+	}
+
+	// copy the results to the other MoveDefs of each group
+	for (const SingleBlock& sb: consumedBlocks) {
+		const std::vector<const MoveDef*>& group = moveDefGroups[sb.groupIdx];
+		const unsigned int blockIdx = BlockPosToIdx(sb.blockPos);
+		const unsigned int srcVertexIdx = (group[0]->pathType * blockStates.GetSize() + blockIdx) * PATH_DIRECTION_VERTICES;
+
+		for (unsigned int i = 1; i < group.size(); i++) {
+			const unsigned int dstVertexIdx = (group[i]->pathType * blockStates.GetSize() + blockIdx) * PATH_DIRECTION_VERTICES;
+
+			blockStates.peNodeOffsets[group[i]->pathType][blockIdx] = blockStates.peNodeOffsets[group[0]->pathType][blockIdx];
+
+			for (unsigned int dir = 0; dir < PATH_DIRECTION_VERTICES; dir++) {
+				if ((sb.vertexMask & (1 << dir)) != 0) {
+					vertexCosts[dstVertexIdx + dir] = vertexCosts[srcVertexIdx + dir];
+				}
+			}
 		}
 	}
+
+	// FindOffset tests up to BLOCK_SIZE^2 squares per block
+	const int updateCost = std::accumulate(searchedNodes.begin(), searchedNodes.end(), 0) + int(numBlockUpdates * BLOCK_SIZE * BLOCK_SIZE);
+
+	avgBlockUpdateCost = std::max(1, (avgBlockUpdateCost * 7 + updateCost / int(numBlockUpdates)) / 8);
+	blockUpdateDebt = std::max(0, blockUpdateDebt + updateCost - frameBudget);
 }
 
 
@@ -3,9 +3,9 @@
 #ifndef PATHESTIMATOR_H
 #define PATHESTIMATOR_H
 
+#include <deque>
 #include <string>
 #include <vector>
-#include <deque>
 
 #include "IPath.h"
 #include "IPathFinder.h"
@@ -57,6 +57,12 @@ public:
 	 */
 	void MapChanged(unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2);
 
+	/**
+	 * This is called for every synced path request, obsolete blocks
+	 * close to the most recent requests are updated first.
+	 */
+	void PathRequested(const float3& startPos, const float3& goalPos);
+
 	/**
 	 * called every frame
 	 */
@@ -68,6 +74,12 @@ public:
 	 */
 	boost::uint32_t GetPathChecksum() const { return pathChecksum; }
 
+	/**
+	 * Returns the number of pending block updates (obsolete blocks
+	 * times the number of MoveDefs that need separate vertex costs).
+	 */
+	unsigned int GetNumQueuedUpdates() const { return (updatedBlocks.size() * moveDefGroups.size()); }
+
 	static const int2* GetDirectionVectorsTable();
 
 protected: // IPathFinder impl
@@ -103,14 +115,19 @@ protected: // IPathFinder impl
 private:
 	void InitEstimator(const std::string& cacheFileName, const std::string& map);
 	void InitBlocks();
+	void InitMoveDefGroups();
+	void InitVertexPathFinders();
+	void FreeVertexPathFinders();
 
 	void CalcOffsetsAndPathCosts(unsigned int threadNum);
 	void CalculateBlockOffsets(unsigned int, unsigned int);
 	void EstimatePathCosts(unsigned int, unsigned int);
 
 	int2 FindOffset(const MoveDef&, unsigned int, unsigned int) const;
-	void CalculateVertices(const MoveDef&, int2, unsigned int threadNum = 0);
-	void CalculateVertex(const MoveDef&, int2, unsigned int, unsigned int threadNum = 0);
+	unsigned int CalculateVertices(const MoveDef&, int2, unsigned int threadNum = 0);
+	unsigned int CalculateVertex(const MoveDef&, int2, unsigned int, unsigned int threadNum = 0);
+
+	void PrioritizeUpdatedBlocks();
 
 	bool ReadFile(const std::string& cacheFileName, const std::string& map);
 	void WriteFile(const std::string& cacheFileName, const std::string& map);
@@ -136,14 +153,26 @@ private:
 	CPathCache* pathCache[2];                   /// [0] = !synced, [1] = synced
 
 	std::vector<IPathFinder*> pathFinders;
+	unsigned int maxVertexPathFinders;          /// [0] plus the helpers Update may create on demand
+	unsigned int idleUpdates;                   /// Updates without obsolete blocks since the last one
 	std::vector<boost::thread*> threads;
 
 	CPathEstimator* nextPathEstimator;
 
-	std::vector<float> vertexCosts;	
+	std::vector<float> vertexCosts;
 	std::deque<int2> updatedBlocks;       /// Blocks that may need an update due to map changes.
+	std::deque<boost::uint64_t> updatedBlockKeys; /// Priorities of the first updatedBlockKeys.size() queued blocks (ascending)
+	std::vector<int2> requestedBlocks;    /// Start and goal blocks of the recent synced path requests (ring-buffer)
+
+	/// MoveDefs (in use) that always get the same offsets and vertex costs,
+	/// only the first one of each group is computed and copied to the rest
+	std::vector< std::vector<const MoveDef*> > moveDefGroups;
+
+	unsigned int requestedBlockIdx;
+	bool requestedBlocksChanged;          /// requestedBlocks differ from those updatedBlockKeys were computed for
 
-	int blockUpdatePenalty;
+	int avgBlockUpdateCost;               /// Searched nodes per block and MoveDef group (running average)
+	int blockUpdateDebt;                  /// Searched nodes beyond the budget of previous frames
 
 	struct SOffsetBlock {
 		float cost;
@@ -259,6 +259,11 @@ unsigned int CPathManager::RequestPath(
 		caller->UnBlock();
 	}
 
+	if (synced) {
+		medResPE->PathRequested(startPos, goalPos);
+		lowResPE->PathRequested(startPos, goalPos);
+	}
+
 	IPath::SearchResult result = ArrangePath(newPath, moveDef, startPos, goalPos, pfDef, caller);
 	pfDef->DisableConstraint(true);
 
@@ -686,8 +691,8 @@ int2 CPathManager::GetNumQueuedUpdates() const {
 	int2 data;
 
 	if (IsFinalized()) {
-		data.x = medResPE->updatedBlocks.size();
-		data.y = lowResPE->updatedBlocks.size();
+		data.x = medResPE->GetNumQueuedUpdates();
+		data.y = lowResPE->GetNumQueuedUpdates();
 	}
 
 	return data;
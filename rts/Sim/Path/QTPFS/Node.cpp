@@ -641,41 +641,49 @@ unsigned int QTPFS::QTNode::GetMaxNumNeighbors() const {
 
 
 
-void QTPFS::QTNode::Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsigned int* streamSize, bool readMode) {
-	// overwritten when de-serializing
-	unsigned int numChildren = QTNODE_CHILD_COUNT * (1 - int(IsLeaf()));
+void QTPFS::QTNode::Serialize(std::vector<QTNodeRecord>& records) const {
+	QTNodeRecord record;
 
-	(*streamSize) += (2 * sizeof(unsigned int));
-	(*streamSize) += (3 * sizeof(float));
+	record.nodeNumber  = nodeNumber;
+	record.numChildren = QTNODE_CHILD_COUNT * (1 - int(IsLeaf()));
+	record.speedModAvg = speedModAvg;
+	record.speedModSum = speedModSum;
+	record.moveCostAvg = moveCostAvg;
 
-	if (readMode) {
-		fStream.read(reinterpret_cast<char*>(&nodeNumber), sizeof(unsigned int));
-		fStream.read(reinterpret_cast<char*>(&numChildren), sizeof(unsigned int));
+	records.push_back(record);
 
-		fStream.read(reinterpret_cast<char*>(&speedModAvg), sizeof(float));
-		fStream.read(reinterpret_cast<char*>(&speedModSum), sizeof(float));
-		fStream.read(reinterpret_cast<char*>(&moveCostAvg), sizeof(float));
+	for (unsigned int i = 0; i < record.numChildren; i++) {
+		children[i]->Serialize(records);
+	}
+}
 
-		if (numChildren > 0) {
-			// re-create child nodes
-			assert(IsLeaf());
-			Split(nodeLayer, true);
-		} else {
-			// node was a leaf in an earlier life, register it
-			nodeLayer.RegisterNode(this);
-		}
+// NOTE:
+//   the records must have been validated (see PathManager::MapCacheFile),
+//   returns the record following the last one of this (sub-)tree
+const QTPFS::QTNodeRecord* QTPFS::QTNode::Deserialize(NodeLayer& nodeLayer, const QTNodeRecord* record) {
+	nodeNumber  = record->nodeNumber;
+	speedModAvg = record->speedModAvg;
+	speedModSum = record->speedModSum;
+	moveCostAvg = record->moveCostAvg;
+
+	const unsigned int numChildren = record->numChildren;
+
+	if (numChildren > 0) {
+		// re-create child nodes
+		assert(IsLeaf());
+		Split(nodeLayer, true);
 	} else {
-		fStream.write(reinterpret_cast<const char*>(&nodeNumber), sizeof(unsigned int));
-		fStream.write(reinterpret_cast<const char*>(&numChildren), sizeof(unsigned int));
-
-		fStream.write(reinterpret_cast<const char*>(&speedModAvg), sizeof(float));
-		fStream.write(reinterpret_cast<const char*>(&speedModSum), sizeof(float));
-		fStream.write(reinterpret_cast<const char*>(&moveCostAvg), sizeof(float));
+		// node was a leaf in an earlier life, register it
+		nodeLayer.RegisterNode(this);
 	}
 
+	record += 1;
+
 	for (unsigned int i = 0; i < numChildren; i++) {
-		children[i]->Serialize(fStream, nodeLayer, streamSize, readMode);
+		record = children[i]->Deserialize(nodeLayer, record);
 	}
+
+	return record;
 }
 
 unsigned int QTPFS::QTNode::GetNeighbors(const std::vector<INode*>& nodes, std::vector<INode*>& ngbs) {
@@ -5,7 +5,6 @@
 
 #include <array>
 #include <vector>
-#include <fstream>
 #include <boost/cstdint.hpp>
 
 #include "PathEnums.hpp"
@@ -22,6 +21,17 @@
 
 namespace QTPFS {
 	struct NodeLayer;
+
+	// one node of a tree flattened (in pre-order) for the cache-file
+	struct QTNodeRecord {
+		boost::uint32_t nodeNumber;
+		boost::uint32_t numChildren;
+
+		float speedModAvg;
+		float speedModSum;
+		float moveCostAvg;
+	};
+
 	struct INode {
 	public:
 		void SetNodeNumber(unsigned int n) { nodeNumber = n; }
@@ -37,7 +47,6 @@ namespace QTPFS {
 		bool operator >= (const INode* n) const { return (fCost >= n->fCost); }
 
 		#ifdef QTPFS_VIRTUAL_NODE_FUNCTIONS
-		virtual void Serialize(std::fstream&, NodeLayer&, unsigned int*, bool) = 0;
 		virtual unsigned int GetNeighbors(const std::vector<INode*>&, std::vector<INode*>&) = 0;
 		virtual const std::vector<INode*>& GetNeighbors(const std::vector<INode*>& v) = 0;
 		virtual bool UpdateNeighborCache(const std::vector<INode*>& nodes) = 0;
@@ -129,7 +138,8 @@ namespace QTPFS {
 		void Delete();
 		void PreTesselate(NodeLayer& nl, const SRectangle& r, SRectangle& ur);
 		void Tesselate(NodeLayer& nl, const SRectangle& r);
-		void Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsigned int* streamSize, bool readMode);
+		void Serialize(std::vector<QTNodeRecord>& records) const;
+		const QTNodeRecord* Deserialize(NodeLayer& nodeLayer, const QTNodeRecord* record);
 
 		bool IsLeaf() const;
 		bool CanSplit(bool forced) const;
@@ -171,6 +181,7 @@ namespace QTPFS {
 
 		static unsigned int MinSizeX() { return MIN_SIZE_X; }
 		static unsigned int MinSizeZ() { return MIN_SIZE_Z; }
+		static unsigned int MaxDepth() { return MAX_DEPTH; }
 
 	private:
 		bool UpdateMoveCost(
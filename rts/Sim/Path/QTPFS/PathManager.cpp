@@ -4,6 +4,9 @@
 #include <boost/thread.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/cstdint.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 #include "System/ThreadPool.h"
 
@@ -20,10 +23,12 @@
 #include "Sim/Objects/SolidObject.h"
 #include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/Archives/FileView.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Threading.h"
 #include "System/Rectangle.h"
+#include "System/Sync/HsiehHash.h"
 #include "System/TimeProfiler.h"
 #include "System/Util.h"
 
@@ -88,6 +93,29 @@ namespace QTPFS {
 		return ((numThreads == 0)? numCores: numThreads);
 	}
 
+	// the cache-file holds all trees as one array of pre-order node
+	// records, preceded by this header and the record count per tree
+	struct CacheFileHeader {
+		char magic[8];
+
+		boost::uint32_t version;
+		boost::uint32_t mapSizeX;
+		boost::uint32_t mapSizeZ;
+		boost::uint32_t minNodeSizeX;
+		boost::uint32_t minNodeSizeZ;
+		boost::uint32_t maxNodeDepth;
+
+		boost::uint32_t numTrees;
+		boost::uint32_t numRecords;
+
+		// hash over the record counts and records
+		boost::uint32_t dataCheckSum;
+		// PathManager::pfsCheckSum of the game that wrote the file
+		boost::uint32_t pfsCheckSum;
+	};
+
+	static const char CACHE_FILE_MAGIC[8] = {'Q', 'T', 'P', 'F', 'S', 'C', 'F', '\0'};
+
 	unsigned int PathManager::LAYERS_PER_UPDATE;
 	unsigned int PathManager::MAX_TEAM_SEARCHES;
 }
@@ -125,10 +153,13 @@ QTPFS::PathManager::~PathManager() {
 	pathTypes.clear();
 	pathTraces.clear();
 
-	numCurrExecutedSearches.clear();
-	numPrevExecutedSearches.clear();
+	sharedPaths.clear();
+	failedPathIDs.clear();
+	newPathTraces.clear();
+	numTeamSearches.clear();
+	searchStateOffsets.clear();
 
-	PathSearch::FreeGlobalQueue();
+	PathSearch::FreeGlobalQueues();
 
 	#ifdef QTPFS_ENABLE_THREADED_UPDATE
 	// at this point the thread is waiting, so notify it
@@ -174,8 +205,6 @@ void QTPFS::PathManager::InitStatic() {
 void QTPFS::PathManager::Load() {
 	pmLoadScreen.SetLoading(true);
 
-	// NOTE: offset *must* start at a non-zero value
-	searchStateOffset = NODE_STATE_OFFSET;
 	numTerrainChanges = 0;
 	numPathRequests   = 0;
 	maxNumLeafNodes   = 0;
@@ -185,23 +214,43 @@ void QTPFS::PathManager::Load() {
 	pathCaches.resize(moveDefHandler->GetNumMoveDefs());
 	pathSearches.resize(moveDefHandler->GetNumMoveDefs());
 
+	sharedPaths.resize(moveDefHandler->GetNumMoveDefs());
+	failedPathIDs.resize(moveDefHandler->GetNumMoveDefs());
+	newPathTraces.resize(moveDefHandler->GetNumMoveDefs());
 	// add one extra element for object-less requests
-	numCurrExecutedSearches.resize(teamHandler->ActiveTeams() + 1, 0);
-	numPrevExecutedSearches.resize(teamHandler->ActiveTeams() + 1, 0);
+	numTeamSearches.resize(moveDefHandler->GetNumMoveDefs(), std::vector<unsigned int>(teamHandler->ActiveTeams() + 1, 0));
+	// NOTE: offsets *must* start at a non-zero value
+	searchStateOffsets.resize(moveDefHandler->GetNumMoveDefs(), NODE_STATE_OFFSET);
 
 	{
 		const boost::uint32_t mapCheckSum = archiveScanner->GetArchiveCompleteChecksum(gameSetup->mapName);
 		const boost::uint32_t modCheckSum = archiveScanner->GetArchiveCompleteChecksum(gameSetup->modName);
 		const std::string& cacheDirName = GetCacheDirName(mapCheckSum, modCheckSum);
+		const std::string& cacheFileName = cacheDirName + "trees";
+
+		boost::uint32_t cachedCheckSum = 0;
 
 		{
+			const spring_time t0 = spring_gettime();
+
+			CFileView cacheFile;
+
 			layersInited = false;
-			haveCacheDir = FileSystem::DirExists(cacheDirName);
+			haveCacheFile = MapCacheFile(cacheFileName, cacheFile);
 
+			// construct each tree from scratch IFF there is no (valid) cache-file
 			InitNodeLayersThreaded(MAP_RECTANGLE);
-			Serialize(cacheDirName);
+
+			if (haveCacheFile)
+				cachedCheckSum = ReadCacheFile(cacheFile);
 
 			layersInited = true;
+
+			char loadMsg[512] = {'\0'};
+			const char* fmtString = "[PathManager::%s] %s node-trees in %ums";
+
+			sprintf(loadMsg, fmtString, __FUNCTION__, (haveCacheFile? "loaded cached": "tesselated"), unsigned((spring_gettime() - t0).toMilliSecsi()));
+			pmLoadScreen.AddLoadMessage(loadMsg);
 		}
 
 		// NOTE:
@@ -219,8 +268,8 @@ void QTPFS::PathManager::Load() {
 				continue;
 
 			#ifndef QTPFS_CONSERVATIVE_NEIGHBOR_CACHE_UPDATES
-			if (haveCacheDir) {
-				// if cache-dir exists, must set node relations after de-serializing its trees
+			if (haveCacheFile) {
+				// if cache-file exists, must set node relations after de-serializing its trees
 				nodeLayers[layerNum].ExecNodeNeighborCacheUpdates(MAP_RECTANGLE, numTerrainChanges);
 			}
 			#endif
@@ -229,9 +278,20 @@ void QTPFS::PathManager::Load() {
 			maxNumLeafNodes = std::max(nodeLayers[layerNum].GetNumLeafNodes(), maxNumLeafNodes);
 		}
 
+		if (!haveCacheFile) {
+			WriteCacheFile(cacheFileName);
+		} else if (cachedCheckSum != pfsCheckSum) {
+			// trees differ from those of the game that wrote the cache (ie.
+			// tesselation depends on something outside the map and mod), so
+			// it can not be trusted; have the next game rebuild it
+			LOG_L(L_ERROR, "[PathManager::%s] pfs-checksum %08x does not match cached value %08x, removing %s", __FUNCTION__, pfsCheckSum, cachedCheckSum, cacheFileName.c_str());
+			FileSystem::Remove(cacheFileName);
+			FileSystem::Remove(cacheFileName + "-tmp");
+		}
+
 		{ SyncedUint tmp(pfsCheckSum); }
 
-		PathSearch::InitGlobalQueue(maxNumLeafNodes);
+		PathSearch::InitGlobalQueues(ThreadPool::GetMaxThreads(), maxNumLeafNodes);
 	}
 
 	{
@@ -278,7 +338,7 @@ void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 
 	#ifdef QTPFS_OPENMP_ENABLED
 	{
-		sprintf(loadMsg, fmtString, __FUNCTION__, ThreadPool::GetNumThreads(), nodeLayers.size(), (haveCacheDir? "cached": "uncached"));
+		sprintf(loadMsg, fmtString, __FUNCTION__, ThreadPool::GetNumThreads(), nodeLayers.size(), (haveCacheFile? "cached": "uncached"));
 		pmLoadScreen.AddLoadMessage(loadMsg);
 
 		#ifndef NDEBUG
@@ -313,7 +373,7 @@ void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 	}
 	#else
 	{
-		sprintf(loadMsg, fmtString, __FUNCTION__, GetNumThreads(), nodeLayers.size(), (haveCacheDir? "cached": "uncached"));
+		sprintf(loadMsg, fmtString, __FUNCTION__, GetNumThreads(), nodeLayers.size(), (haveCacheFile? "cached": "uncached"));
 		pmLoadScreen.AddLoadMessage(loadMsg);
 
 		SpawnBoostThreads(&PathManager::InitNodeLayersThread, rect);
@@ -442,7 +502,7 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 	ur.x2 = mr.x2;
 	ur.z2 = mr.z2;
 
-	const bool wantTesselation = (layersInited || !haveCacheDir);
+	const bool wantTesselation = (layersInited || !haveCacheFile);
 	const bool needTesselation = nodeLayers[layerNum].Update(mr, md);
 
 	if (needTesselation && wantTesselation) {
@@ -538,90 +598,207 @@ std::string QTPFS::PathManager::GetCacheDirName(boost::uint32_t mapCheckSum, boo
 	return dir;
 }
 
-void QTPFS::PathManager::Serialize(const std::string& cacheFileDir) {
-	std::vector<std::string> fileNames(nodeTrees.size(), "");
-	std::vector<std::fstream*> fileStreams(nodeTrees.size(), NULL);
-	std::vector<unsigned int> fileSizes(nodeTrees.size(), 0);
+bool QTPFS::PathManager::MapCacheFile(const std::string& cacheFileName, CFileView& cacheFile) const {
+	#ifdef QTPFS_CACHE_XACCESS
+	{
+		// give any other (concurrently loading) Spring process some time
+		// to finish writing the cache, it signals completion by writing
+		// the file-size into a second file; needed for validation-tests
+		for (unsigned int n = 0; n < 100 && FileSystem::FileExists(cacheFileName) && !FileSystem::FileExists(cacheFileName + "-tmp"); n++) {
+			boost::this_thread::sleep(boost::posix_time::millisec(100));
+		}
 
-	if (!haveCacheDir) {
-		FileSystem::CreateDirectory(cacheFileDir);
-		assert(FileSystem::DirExists(cacheFileDir));
-	}
+		boost::uint32_t fileSize = 0;
 
-	#ifndef NDEBUG
-	char loadMsg[512] = {'\0'};
-	const char* fmtString = "[PathManager::%s] serializing node-tree %u (%s)";
+		std::ifstream sizeFile((cacheFileName + "-tmp").c_str(), std::ios::in | std::ios::binary);
+		sizeFile.read(reinterpret_cast<char*>(&fileSize), sizeof(fileSize));
+
+		if (!sizeFile.good() || FileSystem::GetFileSize(cacheFileName) != fileSize)
+			return false;
+	}
 	#endif
 
-	// TODO: compress the tree cache-files?
-	for (unsigned int i = 0; i < nodeTrees.size(); i++) {
-		const MoveDef* md = moveDefHandler->GetMoveDefByPathType(i);
+	if (!FileSystem::FileExists(cacheFileName))
+		return false;
 
-		if (md->udRefCount == 0)
-			continue;
+	const size_t fileSize = FileSystem::GetFileSize(cacheFileName);
 
-		fileNames[i] = cacheFileDir + "tree" + IntToString(i, "%02x") + "-" + md->name;
-		fileStreams[i] = new std::fstream();
-
-		if (haveCacheDir) {
-			#ifdef QTPFS_CACHE_XACCESS
-			{
-				// FIXME: lock fileNames[i] instead of doing this
-				// fstreams can not be easily locked however, see
-				// http://stackoverflow.com/questions/839856/
-				while (!FileSystem::FileExists(fileNames[i] + "-tmp")) {
-					boost::this_thread::sleep(boost::posix_time::millisec(100));
-				}
-				while (FileSystem::GetFileSize(fileNames[i] + "-tmp") != sizeof(unsigned int)) {
-					boost::this_thread::sleep(boost::posix_time::millisec(100));
-				}
+	if (fileSize < sizeof(CacheFileHeader))
+		return false;
 
-				fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::in | std::ios::binary);
-				fileStreams[i]->read(reinterpret_cast<char*>(&fileSizes[i]), sizeof(unsigned int));
-				fileStreams[i]->close();
+	if (!cacheFile.Map(cacheFileName, 0, fileSize)) {
+		// fall back to reading it in one go
+		std::vector<boost::uint8_t> buffer(fileSize);
+		std::ifstream fileStream(cacheFileName.c_str(), std::ios::in | std::ios::binary);
 
-				while (!FileSystem::FileExists(fileNames[i])) {
-					boost::this_thread::sleep(boost::posix_time::millisec(100));
-				}
-				while (FileSystem::GetFileSize(fileNames[i]) != fileSizes[i]) {
-					boost::this_thread::sleep(boost::posix_time::millisec(100));
+		if (!fileStream.read(reinterpret_cast<char*>(&buffer[0]), fileSize))
+			return false;
+
+		cacheFile.Assign(buffer);
+	}
+
+	const CacheFileHeader* header = reinterpret_cast<const CacheFileHeader*>(cacheFile.GetData());
+	const boost::uint32_t* treeSizes = reinterpret_cast<const boost::uint32_t*>(header + 1);
+	const QTNodeRecord* records = reinterpret_cast<const QTNodeRecord*>(treeSizes + nodeTrees.size());
+
+	const char* fmtString = "[PathManager::%s] ignoring cache-file %s (%s)";
+
+	if (memcmp(header->magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC)) != 0 || header->version != QTPFS_CACHE_VERSION) {
+		LOG_L(L_WARNING, fmtString, __FUNCTION__, cacheFileName.c_str(), "unknown format");
+		return false;
+	}
+	if (header->mapSizeX != boost::uint32_t(mapDims.mapx) || header->mapSizeZ != boost::uint32_t(mapDims.mapy) || header->numTrees != nodeTrees.size()) {
+		LOG_L(L_WARNING, fmtString, __FUNCTION__, cacheFileName.c_str(), "map or move-types differ");
+		return false;
+	}
+	if (header->minNodeSizeX != QTNode::MinSizeX() || header->minNodeSizeZ != QTNode::MinSizeZ() || header->maxNodeDepth != QTNode::MaxDepth()) {
+		LOG_L(L_WARNING, fmtString, __FUNCTION__, cacheFileName.c_str(), "node constants differ");
+		return false;
+	}
+	if (fileSize != (sizeof(CacheFileHeader) + header->numTrees * sizeof(boost::uint32_t) + header->numRecords * sizeof(QTNodeRecord))) {
+		LOG_L(L_WARNING, fmtString, __FUNCTION__, cacheFileName.c_str(), "truncated");
+		return false;
+	}
+
+	const size_t dataSize = fileSize - sizeof(CacheFileHeader);
+	const boost::uint32_t dataCheckSum = HsiehHash(treeSizes, dataSize, 0);
+
+	if (dataCheckSum != header->dataCheckSum) {
+		LOG_L(L_WARNING, fmtString, __FUNCTION__, cacheFileName.c_str(), "corrupt");
+		return false;
+	}
+
+	{
+		// every tree must be complete: in pre-order, the number of
+		// subtrees still to be read only drops to zero at its last
+		// record (so Deserialize can never run past the array)
+		unsigned int numRecords = 0;
+
+		for (unsigned int i = 0; i < nodeTrees.size(); i++) {
+			unsigned int numOpenSubTrees = (treeSizes[i] > 0);
+
+			for (unsigned int n = 0; n < treeSizes[i]; n++) {
+				const QTNodeRecord& record = records[numRecords + n];
+
+				if (numOpenSubTrees == 0 || (record.numChildren != 0 && record.numChildren != QTNODE_CHILD_COUNT)) {
+					numOpenSubTrees = -1u; break;
 				}
+
+				numOpenSubTrees += (record.numChildren - 1);
 			}
-			#else
-			assert(FileSystem::FileExists(fileNames[i]));
-			#endif
 
-			// read fileNames[i] into nodeTrees[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::in | std::ios::binary);
-			assert(fileStreams[i]->good());
-			assert(nodeTrees[i]->IsLeaf());
-		} else {
-			// write nodeTrees[i] into fileNames[i]
-			fileStreams[i]->open(fileNames[i].c_str(), std::ios::out | std::ios::binary);
+			if (numOpenSubTrees != 0) {
+				LOG_L(L_WARNING, fmtString, __FUNCTION__, cacheFileName.c_str(), "malformed tree");
+				return false;
+			}
+
+			numRecords += treeSizes[i];
 		}
 
-		#ifndef NDEBUG
-		sprintf(loadMsg, fmtString, __FUNCTION__, i, md->name.c_str());
-		pmLoadScreen.AddLoadMessage(loadMsg);
-		#endif
+		if (numRecords != header->numRecords) {
+			LOG_L(L_WARNING, fmtString, __FUNCTION__, cacheFileName.c_str(), "malformed tree");
+			return false;
+		}
+	}
 
-		nodeTrees[i]->Serialize(*fileStreams[i], nodeLayers[i], &fileSizes[i], haveCacheDir);
+	return true;
+}
 
-		fileStreams[i]->flush();
-		fileStreams[i]->close();
+boost::uint32_t QTPFS::PathManager::ReadCacheFile(const CFileView& cacheFile) {
+	const CacheFileHeader* header = reinterpret_cast<const CacheFileHeader*>(cacheFile.GetData());
+	const boost::uint32_t* treeSizes = reinterpret_cast<const boost::uint32_t*>(header + 1);
+	const QTNodeRecord* records = reinterpret_cast<const QTNodeRecord*>(treeSizes + nodeTrees.size());
 
-		#ifdef QTPFS_CACHE_XACCESS
-		if (!haveCacheDir) {
-			// signal any other (concurrently loading) Spring processes; needed for validation-tests
-			fileStreams[i]->open((fileNames[i] + "-tmp").c_str(), std::ios::out | std::ios::binary);
-			fileStreams[i]->write(reinterpret_cast<const char*>(&fileSizes[i]), sizeof(unsigned int));
-			fileStreams[i]->flush();
-			fileStreams[i]->close();
-		}
-		#endif
+	for (unsigned int i = 0; i < nodeTrees.size(); i++) {
+		if (treeSizes[i] == 0)
+			continue;
+
+		assert(nodeTrees[i]->IsLeaf());
+
+		// read the records of tree i into nodeTrees[i]
+		const QTNodeRecord* treeEnd = nodeTrees[i]->Deserialize(nodeLayers[i], records);
+
+		assert(treeEnd == (records + treeSizes[i]));
+		records = treeEnd;
+	}
+
+	return header->pfsCheckSum;
+}
+
+void QTPFS::PathManager::WriteCacheFile(const std::string& cacheFileName) const {
+	std::vector<boost::uint32_t> treeSizes(nodeTrees.size(), 0);
+	std::vector<QTNodeRecord> records;
+
+	for (unsigned int i = 0; i < nodeTrees.size(); i++) {
+		if (moveDefHandler->GetMoveDefByPathType(i)->udRefCount == 0)
+			continue;
+
+		const size_t numRecords = records.size();
+
+		nodeTrees[i]->Serialize(records);
+		treeSizes[i] = records.size() - numRecords;
+	}
+
+	CacheFileHeader header;
+	memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC));
+
+	header.version = QTPFS_CACHE_VERSION;
+	header.mapSizeX = mapDims.mapx;
+	header.mapSizeZ = mapDims.mapy;
+	header.minNodeSizeX = QTNode::MinSizeX();
+	header.minNodeSizeZ = QTNode::MinSizeZ();
+	header.maxNodeDepth = QTNode::MaxDepth();
+	header.numTrees = treeSizes.size();
+	header.numRecords = records.size();
+	header.dataCheckSum = HsiehHash(treeSizes.data(), treeSizes.size() * sizeof(boost::uint32_t), 0);
+	header.dataCheckSum = HsiehHash(records.data(), records.size() * sizeof(QTNodeRecord), header.dataCheckSum);
+	header.pfsCheckSum = pfsCheckSum;
+
+	const boost::uint32_t fileSize = sizeof(header) + treeSizes.size() * sizeof(boost::uint32_t) + records.size() * sizeof(QTNodeRecord);
+
+	FileSystem::CreateDirectory(FileSystem::GetDirectory(cacheFileName));
+
+	// never rewrite the cache in place: other processes may have it mapped
+	// (see MapCacheFile), so write a temporary copy and rename it over the
+	// final name once it is known to be complete
+	const std::string tempFileName = cacheFileName + ".tmp";
+
+	std::ofstream fileStream(tempFileName.c_str(), std::ios::out | std::ios::binary);
 
-		delete fileStreams[i];
+	bool writeOk = fileStream.good();
+
+	writeOk = writeOk && fileStream.write(reinterpret_cast<const char*>(&header), sizeof(header)).good();
+	writeOk = writeOk && fileStream.write(reinterpret_cast<const char*>(treeSizes.data()), treeSizes.size() * sizeof(boost::uint32_t)).good();
+	writeOk = writeOk && fileStream.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(QTNodeRecord)).good();
+
+	fileStream.close();
+	writeOk = writeOk && fileStream.good();
+
+	#ifdef _WIN32
+	// rename does not replace an existing file on Windows
+	writeOk = writeOk && (!FileSystem::FileExists(cacheFileName) || FileSystem::Remove(cacheFileName));
+	#endif
+	writeOk = writeOk && (std::rename(tempFileName.c_str(), cacheFileName.c_str()) == 0);
+
+	if (!writeOk) {
+		LOG_L(L_WARNING, "[PathManager::%s] could not write cache-file %s", __FUNCTION__, cacheFileName.c_str());
+		FileSystem::Remove(tempFileName);
+		return;
+	}
+
+	#ifdef QTPFS_CACHE_XACCESS
+	{
+		// signal any other (concurrently loading) Spring processes; needed for validation-tests
+		std::ofstream sizeFile((cacheFileName + "-tmp").c_str(), std::ios::out | std::ios::binary);
+		sizeFile.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
 	}
+	#endif
+
+	char loadMsg[512] = {'\0'};
+	const char* fmtString = "[PathManager::%s] wrote %u node-records (%u KB) to cache-file";
+
+	sprintf(loadMsg, fmtString, __FUNCTION__, unsigned(records.size()), unsigned(fileSize / 1024));
+	pmLoadScreen.AddLoadMessage(loadMsg);
 }
 
 
@@ -706,8 +883,6 @@ void QTPFS::PathManager::ThreadUpdate() {
 		static unsigned int minPathTypeUpdate = 0;
 		static unsigned int maxPathTypeUpdate = numPathTypeUpdates;
 
-		sharedPaths.clear();
-
 		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
 			#ifndef QTPFS_IGNORE_DEAD_PATHS
 			QueueDeadPathSearches(pathTypeUpdate);
@@ -717,11 +892,18 @@ void QTPFS::PathManager::ThreadUpdate() {
 			// NOTE: *must* be called between QueueDeadPathSearches and ExecuteQueuedSearches
 			ExecQueuedNodeLayerUpdates(pathTypeUpdate, !pathSearches[pathTypeUpdate].empty());
 			#endif
+		}
 
+		// layers (and their trees, caches and queues) are independent, so
+		// their searches can run in parallel; each layer processes its own
+		// queue in order which keeps the results deterministic
+		for_mt(minPathTypeUpdate, maxPathTypeUpdate, [&](const int pathTypeUpdate) {
 			ExecuteQueuedSearches(pathTypeUpdate);
-		}
+		});
 
-		std::copy(numCurrExecutedSearches.begin(), numCurrExecutedSearches.end(), numPrevExecutedSearches.begin());
+		for (unsigned int pathTypeUpdate = minPathTypeUpdate; pathTypeUpdate < maxPathTypeUpdate; pathTypeUpdate++) {
+			PublishExecutedSearches(pathTypeUpdate);
+		}
 
 		minPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
 		maxPathTypeUpdate = (minPathTypeUpdate + numPathTypeUpdates);
@@ -750,17 +932,33 @@ void QTPFS::PathManager::ExecuteQueuedSearches(unsigned int pathType) {
 	std::list<IPathSearch*>& searches = pathSearches[pathType];
 	std::list<IPathSearch*>::iterator searchesIt = searches.begin();
 
+	sharedPaths[pathType].clear();
+	std::fill(numTeamSearches[pathType].begin(), numTeamSearches[pathType].end(), 0);
+
 	if (!searches.empty()) {
 		// execute pending searches collected via
 		// RequestPath and QueueDeadPathSearches
 		while (searchesIt != searches.end()) {
 			if (ExecuteSearch(searches, searchesIt, nodeLayer, pathCache, pathType)) {
-				searchStateOffset += NODE_STATE_OFFSET;
+				searchStateOffsets[pathType] += NODE_STATE_OFFSET;
 			}
 		}
 	}
 }
 
+void QTPFS::PathManager::PublishExecutedSearches(unsigned int pathType) {
+	for (const unsigned int pathID: failedPathIDs[pathType]) {
+		DeletePath(pathID);
+	}
+
+	failedPathIDs[pathType].clear();
+
+	#ifdef QTPFS_TRACE_PATH_SEARCHES
+	pathTraces.insert(newPathTraces[pathType].begin(), newPathTraces[pathType].end());
+	newPathTraces[pathType].clear();
+	#endif
+}
+
 bool QTPFS::PathManager::ExecuteSearch(
 	PathSearchList& searches,
 	PathSearchListIt& searchesIt,
@@ -795,9 +993,9 @@ bool QTPFS::PathManager::ExecuteSearch(
 
 	{
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		SharedPathMap::const_iterator sharedPathsIt = sharedPaths.find(path->GetHash());
+		SharedPathMap::const_iterator sharedPathsIt = sharedPaths[pathType].find(path->GetHash());
 
-		if (sharedPathsIt != sharedPaths.end()) {
+		if (sharedPathsIt != sharedPaths[pathType].end()) {
 			if (search->SharedFinalize(sharedPathsIt->second, path)) {
 				DeleteSearch(search, searchesIt);
 				return false;
@@ -806,30 +1004,29 @@ bool QTPFS::PathManager::ExecuteSearch(
 		#endif
 
 		#ifdef QTPFS_LIMIT_TEAM_SEARCHES
-		const unsigned int numCurrSearches = numCurrExecutedSearches[search->GetTeam()];
-		const unsigned int numPrevSearches = numPrevExecutedSearches[search->GetTeam()];
-
-		if ((numCurrSearches - numPrevSearches) >= MAX_TEAM_SEARCHES) {
+		// NOTE: the budget applies per layer, layers are updated in parallel
+		if (numTeamSearches[pathType][search->GetTeam()] >= MAX_TEAM_SEARCHES) {
 			++searchesIt; return false;
 		}
 
-		numCurrExecutedSearches[search->GetTeam()] += 1;
+		numTeamSearches[pathType][search->GetTeam()] += 1;
 		#endif
 	}
 
 	// removes path from temp-paths, adds it to live-paths
-	if (search->Execute(searchStateOffset, numTerrainChanges)) {
+	if (search->Execute(searchStateOffsets[pathType], numTerrainChanges)) {
 		search->Finalize(path);
 
 		#ifdef QTPFS_SEARCH_SHARED_PATHS
-		sharedPaths[path->GetHash()] = path;
+		sharedPaths[pathType][path->GetHash()] = path;
 		#endif
 
 		#ifdef QTPFS_TRACE_PATH_SEARCHES
-		pathTraces[path->GetID()] = search->GetExecutionTrace();
+		newPathTraces[pathType][path->GetID()] = search->GetExecutionTrace();
 		#endif
 	} else {
-		DeletePath(path->GetID());
+		// deleted by PublishExecutedSearches
+		failedPathIDs[pathType].push_back(path->GetID());
 	}
 
 	DeleteSearch(search, searchesIt);
@@ -15,6 +15,7 @@
 struct MoveDef;
 struct SRectangle;
 class CSolidObject;
+class CFileView;
 
 #ifdef QTPFS_ENABLE_THREADED_UPDATE
 namespace boost {
@@ -114,6 +115,7 @@ namespace QTPFS {
 		#endif
 
 		void ExecuteQueuedSearches(unsigned int pathType);
+		void PublishExecutedSearches(unsigned int pathType);
 		void QueueDeadPathSearches(unsigned int pathType);
 
 		unsigned int QueueSearch(
@@ -138,7 +140,9 @@ namespace QTPFS {
 
 
 		std::string GetCacheDirName(boost::uint32_t mapCheckSum, boost::uint32_t modCheckSum) const;
-		void Serialize(const std::string& cacheFileDir);
+		bool MapCacheFile(const std::string& cacheFileName, CFileView& cacheFile) const;
+		boost::uint32_t ReadCacheFile(const CFileView& cacheFile);
+		void WriteCacheFile(const std::string& cacheFileName) const;
 
 		std::vector<NodeLayer> nodeLayers;
 		std::vector<QTNode*> nodeTrees;
@@ -147,16 +151,25 @@ namespace QTPFS {
 		std::map<unsigned int, unsigned int> pathTypes;
 		std::map<unsigned int, PathSearchTrace::Execution*> pathTraces;
 
+		// NOTE:
+		//   searches for different path-types run concurrently (see
+		//   ThreadUpdate), so all state they touch is kept per layer
+		//   and changes to shared state (DeletePath, pathTraces) are
+		//   deferred to PublishExecutedSearches
+
 		// maps "hashes" of executed searches to the found paths
-		std::map<boost::uint64_t, IPath*> sharedPaths;
+		std::vector<SharedPathMap> sharedPaths;
+		// IDs of paths whose search failed during the current update
+		std::vector< std::vector<unsigned int> > failedPathIDs;
+		std::vector<PathTraceMap> newPathTraces;
 
-		std::vector<unsigned int> numCurrExecutedSearches;
-		std::vector<unsigned int> numPrevExecutedSearches;
+		// number of searches executed per team during the current update
+		std::vector< std::vector<unsigned int> > numTeamSearches;
+		std::vector<unsigned int> searchStateOffsets;
 
 		static unsigned int LAYERS_PER_UPDATE;
 		static unsigned int MAX_TEAM_SEARCHES;
 
-		unsigned int searchStateOffset;
 		unsigned int numTerrainChanges;
 		unsigned int numPathRequests;
 		unsigned int maxNumLeafNodes;
@@ -164,7 +177,7 @@ namespace QTPFS {
 		boost::uint32_t pfsCheckSum;
 
 		bool layersInited;
-		bool haveCacheDir;
+		bool haveCacheFile;
 
 		#ifdef QTPFS_ENABLE_THREADED_UPDATE
 		boost::thread* updateThread;
@@ -108,6 +108,7 @@ namespace QTPFS {
 	public:
 		PathSearch(unsigned int pathSearchType)
 			: IPathSearch(pathSearchType)
+			, openNodes(NULL)
 			, nodeLayer(NULL)
 			, pathCache(NULL)
 			, searchExec(NULL)
@@ -120,7 +121,6 @@ namespace QTPFS {
 			, haveFullPath(false)
 			, havePartPath(false)
 			{}
-		~PathSearch() { openNodes.reset(); }
 
 		void Initialize(
 			NodeLayer* layer,
@@ -139,8 +139,14 @@ namespace QTPFS {
 
 		const boost::uint64_t GetHash(boost::uint64_t N, boost::uint32_t k) const;
 
-		static void InitGlobalQueue(unsigned int n) { openNodes.reserve(n); }
-		static void FreeGlobalQueue() { openNodes.clear(); }
+		static void InitGlobalQueues(unsigned int numThreads, unsigned int n) {
+			openNodeQueues.resize(numThreads);
+
+			for (binary_heap<INode*>& queue: openNodeQueues) {
+				queue.reserve(n);
+			}
+		}
+		static void FreeGlobalQueues() { openNodeQueues.clear(); }
 
 	private:
 		void ResetState(INode* node);
@@ -153,9 +159,13 @@ namespace QTPFS {
 		void SmoothPath(IPath* path) const;
 		bool SmoothPathIter(IPath* path) const;
 
-		// global queue: allocated once, re-used by all searches without clear()'s
+		// global queues (one per thread, so searches on different node layers can
+		// run concurrently): allocated once, re-used by all searches without clear()'s
 		// this relies on INode::operator< to sort the INode*'s by increasing f-cost
-		static binary_heap<INode*> openNodes;
+		static std::vector< binary_heap<INode*> > openNodeQueues;
+
+		// queue of the thread running Execute
+		binary_heap<INode*>* openNodes;
 
 		NodeLayer* nodeLayer;
 		PathCache* pathCache;
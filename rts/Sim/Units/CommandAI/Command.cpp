@@ -1,6 +1,9 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "Command.h"
+#include "System/Log/ILog.h"
+#include "System/Platform/CrashHandler.h"
+#include "System/maindefines.h"
 
 CR_BIND(Command, )
 CR_REG_METADATA(Command, (
@@ -28,3 +31,37 @@ CR_REG_METADATA(CommandDescription, (
 	CR_MEMBER(params),
 	CR_RESERVED(32)
 ))
+
+
+
+// safe_vector reported this once per vector, keep the log readable when
+// some code keeps reading past the end every frame
+static unsigned int numOutOfBoundsErrors = 0;
+
+static void OutOfBoundsError(const char* func, size_t idx, size_t size)
+{
+	if (numOutOfBoundsErrors >= 16)
+		return;
+
+	numOutOfBoundsErrors++;
+
+	LOG_L(L_ERROR, "[%s] index " _STPF_ " out of bounds! (size " _STPF_ ")", func, idx, size);
+	CrashHandler::OutputStacktrace();
+}
+
+const float& CommandParams::safe_element(size_type idx) const {
+	static const float def = 0.0f;
+
+	OutOfBoundsError(__FUNCTION__, idx, numParams);
+	return def;
+}
+
+float& CommandParams::safe_element(size_type idx) {
+	static float def = 0.0f;
+
+	OutOfBoundsError(__FUNCTION__, idx, numParams);
+
+	// may have been written through the last reference handed out
+	def = 0.0f;
+	return def;
+}
@@ -7,8 +7,8 @@
 #include <climits> // for INT_MAX
 
 #include "System/creg/creg_cond.h"
+#include "CommandParams.h"
 #include "System/float3.h"
-#include "System/SafeVector.h"
 
 // ID's lower than 0 are reserved for build options (cmd -x = unitdefs[x])
 #define CMD_STOP                   0
@@ -279,7 +279,7 @@ public:
 	void PushParam(float par) { params.push_back(par); }
 	const float& GetParam(size_t idx) const { return params[idx]; }
 
-	/// const safe_vector<float>& GetParams() const { return params; }
+	/// const CommandParams& GetParams() const { return params; }
 	const size_t GetParamsCount() const { return params.size(); }
 
 	void SetID(int id) _deprecated { this->id = id; params.clear(); }
@@ -326,7 +326,7 @@ public:
 	unsigned char options;
 
 	/// command parameters
-	safe_vector<float> params;
+	CommandParams params;
 
 	/// unique id within a CCommandQueue
 	unsigned int tag;
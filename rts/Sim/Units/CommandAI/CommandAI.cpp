@@ -49,6 +49,55 @@ CR_REG_METADATA(CCommandQueue, (
 	CR_MEMBER(tagCounter)
 ))
 
+
+// a deque only allocates a few distinct block sizes (its element
+// blocks and its maps), so a handful of free lists covers them all
+struct CommandQueueFreeList {
+	size_t blockSize;
+	std::vector<void*> blocks;
+};
+
+static const size_t MAX_FREE_COMMAND_QUEUE_BLOCKS = 4096;
+static std::vector<CommandQueueFreeList> commandQueueFreeLists;
+
+void* AllocCommandQueueBlock(size_t size)
+{
+	for (CommandQueueFreeList& freeList: commandQueueFreeLists) {
+		if (freeList.blockSize != size || freeList.blocks.empty())
+			continue;
+
+		void* p = freeList.blocks.back();
+		freeList.blocks.pop_back();
+		return p;
+	}
+
+	return ::operator new(size);
+}
+
+void FreeCommandQueueBlock(void* p, size_t size)
+{
+	for (CommandQueueFreeList& freeList: commandQueueFreeLists) {
+		if (freeList.blockSize != size)
+			continue;
+
+		if (freeList.blocks.size() >= MAX_FREE_COMMAND_QUEUE_BLOCKS)
+			break;
+
+		freeList.blocks.push_back(p);
+		return;
+	}
+
+	// only the block sizes that are actually in use get a free list
+	if (std::find_if(commandQueueFreeLists.begin(), commandQueueFreeLists.end(), [&](const CommandQueueFreeList& fl) { return (fl.blockSize == size); }) == commandQueueFreeLists.end()) {
+		commandQueueFreeLists.push_back(CommandQueueFreeList());
+		commandQueueFreeLists.back().blockSize = size;
+		commandQueueFreeLists.back().blocks.push_back(p);
+		return;
+	}
+
+	::operator delete(p);
+}
+
 CR_BIND_DERIVED(CCommandAI, CObject, )
 CR_REG_METADATA(CCommandAI, (
 	CR_MEMBER(stockpileWeapon),
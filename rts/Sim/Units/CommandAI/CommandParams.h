@@ -0,0 +1,201 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COMMAND_PARAMS_H
+#define COMMAND_PARAMS_H
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "System/creg/creg_cond.h"
+
+/**
+ * Parameter list of a Command. Up to MAX_INLINE_PARAMS floats are stored
+ * inline, which covers positions, areas, fronts and build orders, so the
+ * vast majority of commands never allocate; longer lists spill over to the
+ * heap. Out-of-bounds indexing logs an error and yields a dummy element
+ * (like the safe_vector this replaces) instead of crashing.
+ */
+class CommandParams
+{
+public:
+	typedef float value_type;
+	typedef float& reference;
+	typedef const float& const_reference;
+	typedef float* iterator;
+	typedef const float* const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+	typedef size_t size_type;
+
+	static const size_type MAX_INLINE_PARAMS = 8;
+
+public:
+	CommandParams(): heapParams(NULL), numParams(0), maxParams(MAX_INLINE_PARAMS) {}
+	CommandParams(const CommandParams& p): heapParams(NULL), numParams(0), maxParams(MAX_INLINE_PARAMS) {
+		assign(p.begin(), p.end());
+	}
+	CommandParams(CommandParams&& p): heapParams(NULL), numParams(0), maxParams(MAX_INLINE_PARAMS) {
+		*this = std::move(p);
+	}
+	~CommandParams() { delete[] heapParams; }
+
+	CommandParams& operator = (const CommandParams& p) {
+		if (this != &p)
+			assign(p.begin(), p.end());
+
+		return *this;
+	}
+	CommandParams& operator = (CommandParams&& p) {
+		if (this == &p)
+			return *this;
+
+		if (p.heapParams == NULL) {
+			assign(p.begin(), p.end());
+		} else {
+			// steal the spilled storage
+			delete[] heapParams;
+
+			heapParams = p.heapParams;
+			numParams = p.numParams;
+			maxParams = p.maxParams;
+
+			p.heapParams = NULL;
+			p.maxParams = MAX_INLINE_PARAMS;
+		}
+
+		p.numParams = 0;
+		return *this;
+	}
+
+	template<typename InputIt>
+	void assign(InputIt first, InputIt last) {
+		clear();
+		insert(end(), first, last);
+	}
+
+	size_type size() const { return numParams; }
+	size_type capacity() const { return maxParams; }
+	bool empty() const { return (numParams == 0); }
+
+	void reserve(size_type n) {
+		if (n <= maxParams)
+			return;
+
+		float* newParams = new float[n];
+		std::copy(begin(), end(), newParams);
+
+		delete[] heapParams;
+
+		heapParams = newParams;
+		maxParams = n;
+	}
+
+	void resize(size_type n, float value = 0.0f) {
+		reserve(n);
+
+		if (n > numParams)
+			std::fill(end(), begin() + n, value);
+
+		numParams = n;
+	}
+
+	/// keeps spilled storage around, commands are often reused for the next batch of params
+	void clear() { numParams = 0; }
+
+	void push_back(float value) {
+		if (numParams == maxParams)
+			reserve(maxParams * 2);
+
+		data()[numParams++] = value;
+	}
+	void pop_back() { numParams -= (numParams > 0); }
+
+	iterator insert(const_iterator pos, float value) { return (insert(pos, &value, &value + 1)); }
+
+	template<typename InputIt>
+	iterator insert(const_iterator pos, InputIt first, InputIt last) {
+		const size_type idx = pos - begin();
+		const size_type num = std::distance(first, last);
+
+		if ((numParams + num) > maxParams)
+			reserve(std::max(numParams + num, maxParams * 2));
+
+		float* params = data();
+
+		std::copy_backward(params + idx, params + numParams, params + numParams + num);
+		std::copy(first, last, params + idx);
+
+		numParams += num;
+		return (params + idx);
+	}
+
+	iterator erase(const_iterator pos) { return (erase(pos, pos + 1)); }
+	iterator erase(const_iterator first, const_iterator last) {
+		float* params = data();
+
+		const size_type idx = first - params;
+		const size_type num = last - first;
+
+		std::copy(params + idx + num, params + numParams, params + idx);
+
+		numParams -= num;
+		return (params + idx);
+	}
+
+	const float& operator [] (size_type i) const { return ((i < numParams)? data()[i]: safe_element(i)); }
+	      float& operator [] (size_type i)       { return ((i < numParams)? data()[i]: safe_element(i)); }
+
+	const float& at(size_type i) const { return (*this)[i]; }
+	      float& at(size_type i)       { return (*this)[i]; }
+
+	const float& front() const { return (*this)[0]; }
+	      float& front()       { return (*this)[0]; }
+	const float& back() const { return (*this)[numParams - 1]; }
+	      float& back()       { return (*this)[numParams - 1]; }
+
+	const float* data() const { return ((heapParams != NULL)? heapParams: &inlineParams[0]); }
+	      float* data()       { return ((heapParams != NULL)? heapParams: &inlineParams[0]); }
+
+	const_iterator begin() const { return (data()); }
+	const_iterator end() const { return (data() + numParams); }
+	iterator begin() { return (data()); }
+	iterator end() { return (data() + numParams); }
+
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+
+	bool operator == (const CommandParams& p) const { return (numParams == p.numParams && std::equal(begin(), end(), p.begin())); }
+	bool operator != (const CommandParams& p) const { return !(*this == p); }
+
+private:
+	const float& safe_element(size_type idx) const;
+	      float& safe_element(size_type idx);
+
+private:
+	float inlineParams[MAX_INLINE_PARAMS];
+	/// NULL while the params fit into inlineParams
+	float* heapParams;
+
+	size_type numParams;
+	size_type maxParams;
+};
+
+
+#ifdef USING_CREG
+namespace creg
+{
+	/// serialized like a std::vector<float>: element count, then the elements
+	template<>
+	struct DeduceType<CommandParams> {
+		static boost::shared_ptr<IType> Get() {
+			DeduceType<float> elemtype;
+			return boost::shared_ptr<IType>(new DynamicArrayType<CommandParams>(elemtype.Get()));
+		}
+	};
+}
+#endif // USING_CREG
+
+#endif // COMMAND_PARAMS_H
@@ -4,8 +4,49 @@
 #define _COMMAND_QUEUE_H
 
 #include <deque>
+#include <cstddef>
+#include <new>
 #include "Command.h"
 
+void* AllocCommandQueueBlock(size_t size);
+void FreeCommandQueueBlock(void* p, size_t size);
+
+/**
+ * Allocator for the deque of a CCommandQueue. Freed blocks are kept on
+ * per-size free lists and reused (by any queue), so the push/pop churn of
+ * command queues and the creation of new units do not touch the heap in
+ * steady state. The deque itself keeps its reference-stability guarantees
+ * which the CAI code relies on. Not thread-safe: queues are only modified
+ * by the sim.
+ */
+template<typename T>
+struct CommandQueueAllocator {
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<typename U> struct rebind { typedef CommandQueueAllocator<U> other; };
+
+	CommandQueueAllocator() {}
+	template<typename U> CommandQueueAllocator(const CommandQueueAllocator<U>&) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(AllocCommandQueueBlock(n * sizeof(T))); }
+	void deallocate(T* p, size_t n) { FreeCommandQueueBlock(p, n * sizeof(T)); }
+
+	template<typename U, typename... Args> void construct(U* p, Args&&... args) { new (p) U(std::forward<Args>(args)...); }
+	template<typename U> void destroy(U* p) { p->~U(); }
+
+	size_t max_size() const { return (size_t(-1) / sizeof(T)); }
+
+	template<typename U> bool operator == (const CommandQueueAllocator<U>&) const { return true; }
+	template<typename U> bool operator != (const CommandQueueAllocator<U>&) const { return false; }
+};
+
+
 /// A wrapper class for std::deque<Command> to keep track of commands
 class CCommandQueue {
 
@@ -28,7 +69,7 @@ class CCommandQueue {
 		/// limit to a float's integer range
 		static const int maxTagValue = (1 << 24); // 16777216
 
-		typedef std::deque<Command> basis;
+		typedef std::deque<Command, CommandQueueAllocator<Command> > basis;
 
 		typedef basis::size_type              size_type;
 		typedef basis::iterator               iterator;
@@ -98,7 +139,7 @@ class CCommandQueue {
 		inline void SetQueueType(QueueType type) { queueType = type; }
 
 	private:
-		std::deque<Command> queue;
+		basis queue;
 		QueueType queueType;
 		int tagCounter;
 };
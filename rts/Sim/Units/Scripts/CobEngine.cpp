@@ -8,6 +8,8 @@
 #include "UnitScriptLog.h"
 #include "System/FileSystem/FileHandler.h"
 
+#include <algorithm>
+
 #ifndef _CONSOLE
 #include "System/TimeProfiler.h"
 #endif
@@ -28,7 +30,10 @@ int GCurrentTime;
 
 
 CCobEngine::CCobEngine()
-	: curThread(NULL)
+	: wheelTime(0)
+	, sleepSequence(0)
+	, numSleeping(0)
+	, curThread(NULL)
 {
 	GCurrentTime = 0;
 }
@@ -36,25 +41,7 @@ CCobEngine::CCobEngine()
 
 CCobEngine::~CCobEngine()
 {
-	//Should delete all things that the scheduler knows
-	do {
-		while (!running.empty()) {
-			CCobThread* tmp = running.front();
-			running.pop_front();
-			delete tmp;
-		}
-		while (!wantToRun.empty()) {
-			CCobThread* tmp = wantToRun.front();
-			wantToRun.pop_front();
-			delete tmp;
-		}
-		while (!sleeping.empty()) {
-			CCobThread* tmp = sleeping.top();
-			sleeping.pop();
-			delete tmp;
-		}
-		// callbacks may add new threads
-	} while (!running.empty() || !wantToRun.empty() || !sleeping.empty());
+	DeleteThreads();
 }
 
 
@@ -67,16 +54,57 @@ CCobFileHandler::~CCobFileHandler()
 }
 
 
+void CCobEngine::DeleteThreads()
+{
+	//Should delete all things that the scheduler knows
+	std::vector<CCobThread*> threads;
+
+	do {
+		threads.clear();
+		threads.insert(threads.end(), running.begin(), running.end());
+		threads.insert(threads.end(), wantToRun.begin(), wantToRun.end());
+		running.clear();
+		wantToRun.clear();
+
+		for (int i = 0; i < WHEEL_NEAR_SIZE; i++) {
+			for (const SleepingThread& st: sleepingNear[i]) {
+				threads.push_back(st.thread);
+			}
+			sleepingNear[i].clear();
+		}
+		for (int l = 0; l < WHEEL_FAR_LEVELS; l++) {
+			for (int i = 0; i < WHEEL_FAR_SIZE; i++) {
+				for (const SleepingThread& st: sleepingFar[l][i]) {
+					threads.push_back(st.thread);
+				}
+				sleepingFar[l][i].clear();
+			}
+		}
+		numSleeping = 0;
+
+		for (CCobThread* thread: threads) {
+			delete thread;
+		}
+		// callbacks may add new threads
+	} while (!threads.empty());
+
+	CCobThread::FreePooledMemory();
+}
+
+
 //A thread wants to continue running at a later time, and adds itself to the scheduler
 void CCobEngine::AddThread(CCobThread *thread)
 {
 	switch (thread->state) {
 		case CCobThread::Run:
-			wantToRun.push_front(thread);
-			break;
-		case CCobThread::Sleep:
-			sleeping.push(thread);
+			wantToRun.push_back(thread);
 			break;
+		case CCobThread::Sleep: {
+			// a negative sleep wakes up next tick, like a zero one
+			const SleepingThread st = {thread, std::max(thread->GetWakeTime(), GCurrentTime), sleepSequence++};
+			AddSleepingThread(st);
+			numSleeping++;
+		} break;
 		default:
 			LOG_L(L_ERROR, "thread added to scheduler with unknown state (%d)", thread->state);
 			break;
@@ -84,6 +112,53 @@ void CCobEngine::AddThread(CCobThread *thread)
 }
 
 
+void CCobEngine::AddSleepingThread(const SleepingThread& st)
+{
+	// wakeTime >= wheelTime always holds: GCurrentTime never lags behind
+	// the wheel and cascaded threads are at or after the slot being cascaded
+	const unsigned int delta = st.wakeTime - wheelTime;
+
+	if (delta < WHEEL_NEAR_SIZE) {
+		sleepingNear[st.wakeTime & (WHEEL_NEAR_SIZE - 1)].push_back(st);
+		return;
+	}
+
+	int level = 0;
+	int shift = WHEEL_NEAR_BITS;
+
+	// the last level takes whatever is further away
+	while (level < (WHEEL_FAR_LEVELS - 1) && delta >= (1u << (shift + WHEEL_FAR_BITS))) {
+		level += 1;
+		shift += WHEEL_FAR_BITS;
+	}
+
+	sleepingFar[level][(st.wakeTime >> shift) & (WHEEL_FAR_SIZE - 1)].push_back(st);
+}
+
+
+void CCobEngine::CascadeSleepingThreads()
+{
+	// called when wheelTime enters a new near wheel turn: move the threads of
+	// the far slot that covers it (and of higher levels that wrapped) down
+	int shift = WHEEL_NEAR_BITS;
+
+	for (int level = 0; level < WHEEL_FAR_LEVELS; level++, shift += WHEEL_FAR_BITS) {
+		const int slot = (wheelTime >> shift) & (WHEEL_FAR_SIZE - 1);
+
+		sleepingSlot.swap(sleepingFar[level][slot]);
+
+		for (const SleepingThread& st: sleepingSlot) {
+			AddSleepingThread(st);
+		}
+
+		sleepingSlot.clear();
+
+		if (slot != 0)
+			break;
+	}
+}
+
+
 void CCobEngine::TickThread(CCobThread* thread)
 {
 	curThread = thread; // for error messages originating in CUnitScript
@@ -104,12 +179,12 @@ void CCobEngine::Tick(int deltaTime)
 	LOG_L(L_DEBUG, "----");
 
 	// Advance all running threads
-	for (std::list<CCobThread*>::iterator i = running.begin(); i != running.end(); ++i) {
-		//LOG_L(L_DEBUG, "Now 1running %d: %s", GCurrentTime, (*i)->GetName().c_str());
+	for (size_t i = 0; i < running.size(); ++i) {
+		//LOG_L(L_DEBUG, "Now 1running %d: %s", GCurrentTime, running[i]->GetName().c_str());
 #ifdef _CONSOLE
 		printf("----\n");
 #endif
-		TickThread(*i);
+		TickThread(running[i]);
 	}
 
 	// A thread can never go from running->running, so clear the list
@@ -119,21 +194,35 @@ void CCobEngine::Tick(int deltaTime)
 	running.clear();
 
 	// The threads that just ran may have added new threads that should run next tick
-	for (std::list<CCobThread *>::iterator i = wantToRun.begin(); i != wantToRun.end(); ++i) {
-		running.push_front(*i);
-	}
+	running.swap(wantToRun);
+
+	//Check on the sleeping threads, waking all with wakeTime < GCurrentTime
+	if (numSleeping == 0)
+		wheelTime = GCurrentTime;
 
-	wantToRun.clear();
+	for (; wheelTime < GCurrentTime; wheelTime++) {
+		if ((wheelTime & (WHEEL_NEAR_SIZE - 1)) == 0)
+			CascadeSleepingThreads();
 
-	//Check on the sleeping threads
-	if (!sleeping.empty()) {
-		CCobThread* cur = sleeping.top();
+		std::vector<SleepingThread>& slot = sleepingNear[wheelTime & (WHEEL_NEAR_SIZE - 1)];
 
-		while ((cur != NULL) && (cur->GetWakeTime() < GCurrentTime)) {
-			// Start with removing the executing thread from the queue
-			sleeping.pop();
+		if (slot.empty())
+			continue;
 
-			//Run forward again. This can quite possibly readd the thread to the sleeping array again
+		// nothing can be added to this slot while it is being run:
+		// threads that go to sleep now wake up at GCurrentTime at the earliest
+		sleepingSlot.swap(slot);
+
+		// cascading may have interleaved threads from different levels
+		if (!std::is_sorted(sleepingSlot.begin(), sleepingSlot.end()))
+			std::sort(sleepingSlot.begin(), sleepingSlot.end());
+
+		numSleeping -= sleepingSlot.size();
+
+		for (const SleepingThread& st: sleepingSlot) {
+			CCobThread* cur = st.thread;
+
+			//Run forward again. This can quite possibly readd the thread to the sleeping wheel again
 			//But it will not interfere since it is guaranteed to sleep > 0 ms
 			//LOG_L(L_DEBUG, "Now 2running %d: %s", GCurrentTime, cur->GetName().c_str());
 #ifdef _CONSOLE
@@ -147,12 +236,9 @@ void CCobEngine::Tick(int deltaTime)
 			} else {
 				LOG_L(L_ERROR, "Sleeping thread strange state %d", cur->state);
 			}
-
-			if (!sleeping.empty())
-				cur = sleeping.top();
-			else
-				cur = NULL;
 		}
+
+		sleepingSlot.clear();
 	}
 }
 
@@ -11,35 +11,61 @@
 
 #include "CobThread.h"
 
-#include <list>
-#include <queue>
 #include <map>
+#include <vector>
+#include <boost/cstdint.hpp>
 
 class CCobThread;
 class CCobInstance;
 class CCobFile;
 
 
-class CCobThreadPtr_less : public std::binary_function<CCobThread*, CCobThread*, bool> {
-public:
-	bool operator() (const CCobThread* const& a, const CCobThread* const& b) const {
-		return a->GetWakeTime() > b->GetWakeTime();
-	}
-};
-
-
 class CCobEngine
 {
 protected:
-	std::list<CCobThread*> running;
+	struct SleepingThread {
+		CCobThread* thread;
+		int wakeTime;
+		/// threads waking up in the same ms run in the order they went to sleep
+		boost::uint64_t sequence;
+
+		bool operator < (const SleepingThread& t) const { return (sequence < t.sequence); }
+	};
+
+	static const int WHEEL_NEAR_BITS = 8;
+	static const int WHEEL_NEAR_SIZE = 1 << WHEEL_NEAR_BITS;
+	static const int WHEEL_FAR_BITS = 6;
+	static const int WHEEL_FAR_SIZE = 1 << WHEEL_FAR_BITS;
+	static const int WHEEL_FAR_LEVELS = 4;
+
+	std::vector<CCobThread*> running;
 	/**
 	 * Threads are added here if they are in Running.
 	 * And moved to real running after running is empty.
 	 */
-	std::list<CCobThread*> wantToRun;
-	std::priority_queue<CCobThread*, std::vector<CCobThread*>, CCobThreadPtr_less> sleeping;
+	std::vector<CCobThread*> wantToRun;
+
+	/**
+	 * Sleeping threads, in a hierarchical timer wheel keyed by wake time.
+	 * The near wheel has a slot for every ms of the next WHEEL_NEAR_SIZE ms,
+	 * each far level covers WHEEL_FAR_SIZE times the range of the one below
+	 * and is cascaded down when wheelTime enters one of its slots. Adding a
+	 * thread is O(1), as is waking it (plus at most WHEEL_FAR_LEVELS moves).
+	 */
+	std::vector<SleepingThread> sleepingNear[WHEEL_NEAR_SIZE];
+	std::vector<SleepingThread> sleepingFar[WHEEL_FAR_LEVELS][WHEEL_FAR_SIZE];
+	/// scratch buffer for a slot that is being woken up or cascaded
+	std::vector<SleepingThread> sleepingSlot;
+	/// the first ms whose near wheel slot has not been woken up yet
+	int wheelTime;
+	boost::uint64_t sleepSequence;
+	int numSleeping;
+
 	CCobThread* curThread;
 	void TickThread(CCobThread* thread);
+	void AddSleepingThread(const SleepingThread& st);
+	void CascadeSleepingThreads();
+	void DeleteThreads();
 public:
 	CCobEngine();
 	~CCobEngine();
@@ -157,6 +157,8 @@ CCobFile::CCobFile(CFileHandler &in, string name)
 
 	numStaticVars = ch.NumberOfStaticVars;
 
+	TranslateCode(std::min(ch.TotalScriptLen, code_octets / 4));
+
 	// If this is a TA:K script, read the sound names
 	if (ch.VersionSignature == 6) {
 		sounds.reserve(ch.NumberOfSounds);
@@ -203,6 +205,184 @@ CCobFile::~CCobFile()
 }
 
 
+int CCobFile::AddInvalidInstruction(int value, int offset, int reason)
+{
+	const CobInstruction instr = {CobInstruction::INVALID, value, reason};
+
+	instructions.push_back(instr);
+	instructionOffsets.push_back(offset);
+	return (instructions.size() - 1);
+}
+
+
+void CCobFile::TranslateCode(int codeSize)
+{
+	using namespace CobOpcode;
+
+	// code offset -> instruction index
+	std::vector<int> offsetIndices(std::max(codeSize, 0) + 1, -1);
+	std::vector<int> sortedOffsets = scriptOffsets;
+	std::sort(sortedOffsets.begin(), sortedOffsets.end());
+
+	instructions.clear();
+	instructions.reserve(codeSize);
+	instructionOffsets.clear();
+	instructionOffsets.reserve(codeSize);
+
+	int pos = 0;
+
+	while (pos < codeSize) {
+		const int opcode = code[pos];
+
+		CobInstruction instr = {CobInstruction::INVALID, 0, 0};
+		int numArgs = 0;
+
+		switch (opcode) {
+			case MOVE:                 { instr.op = CobInstruction::MOVE;                 numArgs = 2; } break;
+			case TURN:                 { instr.op = CobInstruction::TURN;                 numArgs = 2; } break;
+			case SPIN:                 { instr.op = CobInstruction::SPIN;                 numArgs = 2; } break;
+			case STOP_SPIN:            { instr.op = CobInstruction::STOP_SPIN;            numArgs = 2; } break;
+			case SHOW:                 { instr.op = CobInstruction::SHOW;                 numArgs = 1; } break;
+			case HIDE:                 { instr.op = CobInstruction::HIDE;                 numArgs = 1; } break;
+			case CACHE:                { instr.op = CobInstruction::NOP;                  numArgs = 1; } break;
+			case DONT_CACHE:           { instr.op = CobInstruction::NOP;                  numArgs = 1; } break;
+			case MOVE_NOW:             { instr.op = CobInstruction::MOVE_NOW;             numArgs = 2; } break;
+			case TURN_NOW:             { instr.op = CobInstruction::TURN_NOW;             numArgs = 2; } break;
+			case SHADE:                { instr.op = CobInstruction::NOP;                  numArgs = 1; } break;
+			case DONT_SHADE:           { instr.op = CobInstruction::NOP;                  numArgs = 1; } break;
+			case EMIT_SFX:             { instr.op = CobInstruction::EMIT_SFX;             numArgs = 1; } break;
+
+			case WAIT_TURN:            { instr.op = CobInstruction::WAIT_TURN;            numArgs = 2; } break;
+			case WAIT_MOVE:            { instr.op = CobInstruction::WAIT_MOVE;            numArgs = 2; } break;
+			case SLEEP:                { instr.op = CobInstruction::SLEEP;                numArgs = 0; } break;
+
+			case PUSH_CONSTANT:        { instr.op = CobInstruction::PUSH_CONSTANT;        numArgs = 1; } break;
+			case PUSH_LOCAL_VAR:       { instr.op = CobInstruction::PUSH_LOCAL_VAR;       numArgs = 1; } break;
+			case PUSH_STATIC:          { instr.op = CobInstruction::PUSH_STATIC;          numArgs = 1; } break;
+			case CREATE_LOCAL_VAR:     { instr.op = CobInstruction::CREATE_LOCAL_VAR;     numArgs = 0; } break;
+			case POP_LOCAL_VAR:        { instr.op = CobInstruction::POP_LOCAL_VAR;        numArgs = 1; } break;
+			case POP_STATIC:           { instr.op = CobInstruction::POP_STATIC;           numArgs = 1; } break;
+			case POP_STACK:            { instr.op = CobInstruction::POP_STACK;            numArgs = 0; } break;
+
+			case ADD:                  { instr.op = CobInstruction::ADD;                  numArgs = 0; } break;
+			case SUB:                  { instr.op = CobInstruction::SUB;                  numArgs = 0; } break;
+			case MUL:                  { instr.op = CobInstruction::MUL;                  numArgs = 0; } break;
+			case DIV:                  { instr.op = CobInstruction::DIV;                  numArgs = 0; } break;
+			case MOD:                  { instr.op = CobInstruction::MOD;                  numArgs = 0; } break;
+			case BITWISE_AND:          { instr.op = CobInstruction::BITWISE_AND;          numArgs = 0; } break;
+			case BITWISE_OR:           { instr.op = CobInstruction::BITWISE_OR;           numArgs = 0; } break;
+			case BITWISE_XOR:          { instr.op = CobInstruction::BITWISE_XOR;          numArgs = 0; } break;
+			case BITWISE_NOT:          { instr.op = CobInstruction::BITWISE_NOT;          numArgs = 0; } break;
+
+			case RAND:                 { instr.op = CobInstruction::RAND;                 numArgs = 0; } break;
+			case GET_UNIT_VALUE:       { instr.op = CobInstruction::GET_UNIT_VALUE;       numArgs = 0; } break;
+			case GET:                  { instr.op = CobInstruction::GET;                  numArgs = 0; } break;
+
+			case SET_LESS:             { instr.op = CobInstruction::SET_LESS;             numArgs = 0; } break;
+			case SET_LESS_OR_EQUAL:    { instr.op = CobInstruction::SET_LESS_OR_EQUAL;    numArgs = 0; } break;
+			case SET_GREATER:          { instr.op = CobInstruction::SET_GREATER;          numArgs = 0; } break;
+			case SET_GREATER_OR_EQUAL: { instr.op = CobInstruction::SET_GREATER_OR_EQUAL; numArgs = 0; } break;
+			case SET_EQUAL:            { instr.op = CobInstruction::SET_EQUAL;            numArgs = 0; } break;
+			case SET_NOT_EQUAL:        { instr.op = CobInstruction::SET_NOT_EQUAL;        numArgs = 0; } break;
+			case LOGICAL_AND:          { instr.op = CobInstruction::LOGICAL_AND;          numArgs = 0; } break;
+			case LOGICAL_OR:           { instr.op = CobInstruction::LOGICAL_OR;           numArgs = 0; } break;
+			case LOGICAL_XOR:          { instr.op = CobInstruction::LOGICAL_XOR;          numArgs = 0; } break;
+			case LOGICAL_NOT:          { instr.op = CobInstruction::LOGICAL_NOT;          numArgs = 0; } break;
+
+			case START:                { instr.op = CobInstruction::START;                numArgs = 2; } break;
+			case CALL:                 { instr.op = CobInstruction::CALL;                 numArgs = 2; } break;
+			case REAL_CALL:            { instr.op = CobInstruction::CALL;                 numArgs = 2; } break;
+			case LUA_CALL:             { instr.op = CobInstruction::LUA_CALL;             numArgs = 2; } break;
+			case JUMP:                 { instr.op = CobInstruction::JUMP;                 numArgs = 1; } break;
+			case RETURN:               { instr.op = CobInstruction::RETURN;               numArgs = 0; } break;
+			case JUMP_NOT_EQUAL:       { instr.op = CobInstruction::JUMP_NOT_EQUAL;       numArgs = 1; } break;
+			case SIGNAL:               { instr.op = CobInstruction::SIGNAL;               numArgs = 0; } break;
+			case SET_SIGNAL_MASK:      { instr.op = CobInstruction::SET_SIGNAL_MASK;      numArgs = 0; } break;
+
+			case EXPLODE:              { instr.op = CobInstruction::EXPLODE;              numArgs = 1; } break;
+			case PLAY_SOUND_FX:        { instr.op = CobInstruction::PLAY_SOUND_FX;        numArgs = 1; } break;
+
+			case SET:                  { instr.op = CobInstruction::SET;                  numArgs = 0; } break;
+			case ATTACH:               { instr.op = CobInstruction::ATTACH;               numArgs = 0; } break;
+			case DROP:                 { instr.op = CobInstruction::DROP;                 numArgs = 0; } break;
+		}
+
+		if (instr.op == CobInstruction::INVALID || (pos + numArgs) >= codeSize) {
+			// the length of an unknown instruction is unknown too, so
+			// continue decoding at the next script (if there is one)
+			offsetIndices[pos] = AddInvalidInstruction(opcode, pos, 0);
+
+			const std::vector<int>::const_iterator it = std::upper_bound(sortedOffsets.begin(), sortedOffsets.end(), pos);
+
+			if (it == sortedOffsets.end())
+				break;
+
+			pos = *it;
+			continue;
+		}
+
+		if (numArgs > 0) instr.arg1 = code[pos + 1];
+		if (numArgs > 1) instr.arg2 = code[pos + 2];
+
+		offsetIndices[pos] = instructions.size();
+		instructions.push_back(instr);
+		instructionOffsets.push_back(pos);
+
+		pos += (1 + numArgs);
+	}
+
+	// running off the end of the code
+	if (codeSize >= 0 && offsetIndices[codeSize] == -1)
+		offsetIndices[codeSize] = AddInvalidInstruction(codeSize, codeSize, 3);
+
+	// a bad target is reported at the instruction that refers to it
+	const auto ResolveOffset = [&](int target, int sourceOffset) -> int {
+		if (target < 0 || target > codeSize || offsetIndices[target] == -1)
+			return AddInvalidInstruction(target, sourceOffset, 1);
+
+		return offsetIndices[target];
+	};
+
+	// resolve jump and call targets
+	// (instructions may be appended to while doing so)
+	for (size_t i = 0, n = instructions.size(); i < n; i++) {
+		CobInstruction& instr = instructions[i];
+
+		switch (instr.op) {
+			case CobInstruction::JUMP:
+			case CobInstruction::JUMP_NOT_EQUAL: {
+				const int target = ResolveOffset(instr.arg1, instructionOffsets[i]);
+				instructions[i].arg1 = target;
+			} break;
+
+			case CobInstruction::CALL:
+			case CobInstruction::START: {
+				if (instr.arg1 < 0 || size_t(instr.arg1) >= scriptNames.size()) {
+					// keeps the bad script id in arg1
+					instr.arg2 = 2;
+					instr.op = CobInstruction::INVALID;
+					break;
+				}
+
+				if (instr.op == CobInstruction::CALL && scriptNames[instr.arg1].find("lua_") == 0) {
+					instr.op = CobInstruction::LUA_CALL;
+				}
+			} break;
+
+			default: {
+			} break;
+		}
+	}
+
+	scriptEntries.clear();
+	scriptEntries.reserve(scriptOffsets.size());
+
+	for (size_t i = 0; i < scriptOffsets.size(); i++) {
+		scriptEntries.push_back(ResolveOffset(scriptOffsets[i], scriptOffsets[i]));
+	}
+}
+
+
 int CCobFile::GetFunctionId(const string &name)
 {
 	std::map<std::string, int>::iterator i;
@@ -8,6 +8,7 @@
 #include <map>
 
 #include "Lua/LuaHashString.h"
+#include "CobInstructions.h"
 #include "CobScriptNames.h"
 
 class CFileHandler;
@@ -30,9 +31,21 @@ public:
 	std::vector<int> sounds;
 	std::map<std::string, int> scriptMap;
 	std::vector<LuaHashString> luaScripts;
+	/// the raw bytecode, only kept for error messages
 	int* code;
 	int numStaticVars;
 	std::string name;
+
+	/// the bytecode translated for CCobThread, see TranslateCode
+	std::vector<CobInstruction> instructions;
+	/// offset into code of every instruction
+	std::vector<int> instructionOffsets;
+	/// index of the first instruction of every script
+	std::vector<int> scriptEntries;
+
+private:
+	void TranslateCode(int codeSize);
+	int AddInvalidInstruction(int value, int offset, int reason);
 };
 
 #endif // COB_FILE_H
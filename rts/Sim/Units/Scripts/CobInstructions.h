@@ -0,0 +1,162 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_INSTRUCTIONS_H
+#define COB_INSTRUCTIONS_H
+
+// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
+// And some information from basm0.8 source (basm ops.txt)
+
+/// opcodes as stored in .cob files
+namespace CobOpcode {
+	// Model interaction
+	const int MOVE       = 0x10001000;
+	const int TURN       = 0x10002000;
+	const int SPIN       = 0x10003000;
+	const int STOP_SPIN  = 0x10004000;
+	const int SHOW       = 0x10005000;
+	const int HIDE       = 0x10006000;
+	const int CACHE      = 0x10007000;
+	const int DONT_CACHE = 0x10008000;
+	const int MOVE_NOW   = 0x1000B000;
+	const int TURN_NOW   = 0x1000C000;
+	const int SHADE      = 0x1000D000;
+	const int DONT_SHADE = 0x1000E000;
+	const int EMIT_SFX   = 0x1000F000;
+
+	// Blocking operations
+	const int WAIT_TURN  = 0x10011000;
+	const int WAIT_MOVE  = 0x10012000;
+	const int SLEEP      = 0x10013000;
+
+	// Stack manipulation
+	const int PUSH_CONSTANT    = 0x10021001;
+	const int PUSH_LOCAL_VAR   = 0x10021002;
+	const int PUSH_STATIC      = 0x10021004;
+	const int CREATE_LOCAL_VAR = 0x10022000;
+	const int POP_LOCAL_VAR    = 0x10023002;
+	const int POP_STATIC       = 0x10023004;
+	const int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
+
+	// Arithmetic operations
+	const int ADD         = 0x10031000;
+	const int SUB         = 0x10032000;
+	const int MUL         = 0x10033000;
+	const int DIV         = 0x10034000;
+	const int MOD         = 0x10034001; ///< spring specific
+	const int BITWISE_AND = 0x10035000;
+	const int BITWISE_OR  = 0x10036000;
+	const int BITWISE_XOR = 0x10037000;
+	const int BITWISE_NOT = 0x10038000;
+
+	// Native function calls
+	const int RAND           = 0x10041000;
+	const int GET_UNIT_VALUE = 0x10042000;
+	const int GET            = 0x10043000;
+
+	// Comparison
+	const int SET_LESS             = 0x10051000;
+	const int SET_LESS_OR_EQUAL    = 0x10052000;
+	const int SET_GREATER          = 0x10053000;
+	const int SET_GREATER_OR_EQUAL = 0x10054000;
+	const int SET_EQUAL            = 0x10055000;
+	const int SET_NOT_EQUAL        = 0x10056000;
+	const int LOGICAL_AND          = 0x10057000;
+	const int LOGICAL_OR           = 0x10058000;
+	const int LOGICAL_XOR          = 0x10059000;
+	const int LOGICAL_NOT          = 0x1005A000;
+
+	// Flow control
+	const int START           = 0x10061000;
+	const int CALL            = 0x10062000; ///< resolved to REAL_CALL or LUA_CALL on load
+	const int REAL_CALL       = 0x10062001; ///< spring custom
+	const int LUA_CALL        = 0x10062002; ///< spring custom
+	const int JUMP            = 0x10064000;
+	const int RETURN          = 0x10065000;
+	const int JUMP_NOT_EQUAL  = 0x10066000;
+	const int SIGNAL          = 0x10067000;
+	const int SET_SIGNAL_MASK = 0x10068000;
+
+	// Piece destruction
+	const int EXPLODE       = 0x10071000;
+	const int PLAY_SOUND_FX = 0x10072000; ///< PLAY_SOUND is #define'd by CobDefines.h
+
+	// Special functions
+	const int SET    = 0x10082000;
+	const int ATTACH = 0x10083000;
+	const int DROP   = 0x10084000;
+}
+
+
+/**
+ * One instruction of the form CCobFile translates the bytecode into on load:
+ * opcodes are numbered densely (so the interpreter switch compiles to a jump
+ * table), inline operands are decoded and jump / call targets are resolved to
+ * instruction indices.
+ */
+struct CobInstruction
+{
+	enum Op {
+		MOVE,
+		TURN,
+		SPIN,
+		STOP_SPIN,
+		SHOW,
+		HIDE,
+		MOVE_NOW,
+		TURN_NOW,
+		EMIT_SFX,
+		WAIT_TURN,
+		WAIT_MOVE,
+		SLEEP,
+		PUSH_CONSTANT,
+		PUSH_LOCAL_VAR,
+		PUSH_STATIC,
+		CREATE_LOCAL_VAR,
+		POP_LOCAL_VAR,
+		POP_STATIC,
+		POP_STACK,
+		ADD,
+		SUB,
+		MUL,
+		DIV,
+		MOD,
+		BITWISE_AND,
+		BITWISE_OR,
+		BITWISE_XOR,
+		BITWISE_NOT,
+		RAND,
+		GET_UNIT_VALUE,
+		GET,
+		SET_LESS,
+		SET_LESS_OR_EQUAL,
+		SET_GREATER,
+		SET_GREATER_OR_EQUAL,
+		SET_EQUAL,
+		SET_NOT_EQUAL,
+		LOGICAL_AND,
+		LOGICAL_OR,
+		LOGICAL_XOR,
+		LOGICAL_NOT,
+		START,
+		CALL,      ///< arg1: script id, arg2: number of arguments
+		LUA_CALL,  ///< arg1: script id, arg2: number of arguments
+		JUMP,      ///< arg1: instruction index
+		RETURN,
+		JUMP_NOT_EQUAL,
+		SIGNAL,
+		SET_SIGNAL_MASK,
+		EXPLODE,
+		PLAY_SOUND_FX,
+		SET,
+		ATTACH,
+		DROP,
+		NOP,       ///< (dont-)cache and (dont-)shade
+		INVALID,   ///< kills the thread, arg1: bad opcode, jump target or script id, arg2: which one
+	};
+
+	int op;
+	int arg1;
+	int arg2;
+};
+
+#endif // COB_INSTRUCTIONS_H
@@ -9,14 +9,68 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GlobalSynced.h"
 
+#include <algorithm>
 #include <sstream>
 
 
+static const size_t MAX_POOLED_THREADS = 4096;
+
+// freed thread memory, reused by the next thread to be created
+// intentionally leaked: GCobEngine deletes its threads during static
+// destruction, possibly after a static pool in this TU would be gone
+static std::vector<void*>& GetThreadPool()
+{
+	static std::vector<void*>* threadPool = new std::vector<void*>();
+	return *threadPool;
+}
+
+
+void* CCobThread::operator new(size_t size)
+{
+	std::vector<void*>& threadPool = GetThreadPool();
+
+	if (size != sizeof(CCobThread) || threadPool.empty())
+		return ::operator new(size);
+
+	void* p = threadPool.back();
+	threadPool.pop_back();
+	return p;
+}
+
+void CCobThread::operator delete(void* p, size_t size)
+{
+	if (p == NULL)
+		return;
+
+	std::vector<void*>& threadPool = GetThreadPool();
+
+	if (size != sizeof(CCobThread) || threadPool.size() >= MAX_POOLED_THREADS) {
+		::operator delete(p);
+		return;
+	}
+
+	threadPool.push_back(p);
+}
+
+void CCobThread::FreePooledMemory()
+{
+	std::vector<void*>& threadPool = GetThreadPool();
+
+	for (void* p: threadPool) {
+		::operator delete(p);
+	}
+
+	threadPool.clear();
+	threadPool.shrink_to_fit();
+}
+
+
 CCobThread::CCobThread(CCobFile& script, CCobInstance* owner)
 	: script(script)
 	, owner(owner)
 	, wakeTime(0)
 	, PC(0)
+	, stackSize(0)
 	, paramCount(0)
 	, retCode(0)
 	, callback(NULL)
@@ -53,7 +107,7 @@ void CCobThread::Start(int functionId, const vector<int>& args, bool schedule)
 {
 	wakeTime = 0;
 	state = Run;
-	PC = script.scriptOffsets[functionId];
+	PC = script.scriptEntries[functionId];
 
 	struct callInfo ci;
 	ci.functionId = functionId;
@@ -65,7 +119,8 @@ void CCobThread::Start(int functionId, const vector<int>& args, bool schedule)
 	callback = NULL;
 	retCode = -1;
 	// copy arguments
-	stack = args;
+	stackSize = std::min(int(args.size()), MAX_STACK_SIZE);
+	std::copy(args.begin(), args.begin() + stackSize, &stack[0]);
 
 	// Add to scheduler
 	if (schedule)
@@ -79,18 +134,18 @@ const string& CCobThread::GetName()
 
 int CCobThread::CheckStack(unsigned int size, bool warn)
 {
-	if (size <= stack.size())
+	if (size <= (unsigned int) stackSize)
 		return size;
 
 	if (warn) {
 		static char msg[512];
 		static const char* fmt =
-			"stack-size mismatch: need %u but have %lu arguments "
+			"stack-size mismatch: need %u but have %d arguments "
 			"(too many passed to function or too few returned?)";
-		SNPRINTF(msg, sizeof(msg), fmt, size, stack.size());
+		SNPRINTF(msg, sizeof(msg), fmt, size, stackSize);
 		ShowError(msg);
 	}
-	return stack.size();
+	return stackSize;
 }
 
 int CCobThread::GetStackVal(int pos)
@@ -103,86 +158,6 @@ int CCobThread::GetWakeTime() const
 	return wakeTime;
 }
 
-// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
-// And some information from basm0.8 source (basm ops.txt)
-
-// Model interaction
-const int MOVE       = 0x10001000;
-const int TURN       = 0x10002000;
-const int SPIN       = 0x10003000;
-const int STOP_SPIN  = 0x10004000;
-const int SHOW       = 0x10005000;
-const int HIDE       = 0x10006000;
-const int CACHE      = 0x10007000;
-const int DONT_CACHE = 0x10008000;
-const int MOVE_NOW   = 0x1000B000;
-const int TURN_NOW   = 0x1000C000;
-const int SHADE      = 0x1000D000;
-const int DONT_SHADE = 0x1000E000;
-const int EMIT_SFX   = 0x1000F000;
-
-// Blocking operations
-const int WAIT_TURN  = 0x10011000;
-const int WAIT_MOVE  = 0x10012000;
-const int SLEEP      = 0x10013000;
-
-// Stack manipulation
-const int PUSH_CONSTANT    = 0x10021001;
-const int PUSH_LOCAL_VAR   = 0x10021002;
-const int PUSH_STATIC      = 0x10021004;
-const int CREATE_LOCAL_VAR = 0x10022000;
-const int POP_LOCAL_VAR    = 0x10023002;
-const int POP_STATIC       = 0x10023004;
-const int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
-
-// Arithmetic operations
-const int ADD         = 0x10031000;
-const int SUB         = 0x10032000;
-const int MUL         = 0x10033000;
-const int DIV         = 0x10034000;
-const int MOD		  = 0x10034001; ///< spring specific
-const int BITWISE_AND = 0x10035000;
-const int BITWISE_OR  = 0x10036000;
-const int BITWISE_XOR = 0x10037000;
-const int BITWISE_NOT = 0x10038000;
-
-// Native function calls
-const int RAND           = 0x10041000;
-const int GET_UNIT_VALUE = 0x10042000;
-const int GET            = 0x10043000;
-
-// Comparison
-const int SET_LESS             = 0x10051000;
-const int SET_LESS_OR_EQUAL    = 0x10052000;
-const int SET_GREATER          = 0x10053000;
-const int SET_GREATER_OR_EQUAL = 0x10054000;
-const int SET_EQUAL            = 0x10055000;
-const int SET_NOT_EQUAL        = 0x10056000;
-const int LOGICAL_AND          = 0x10057000;
-const int LOGICAL_OR           = 0x10058000;
-const int LOGICAL_XOR          = 0x10059000;
-const int LOGICAL_NOT          = 0x1005A000;
-
-// Flow control
-const int START           = 0x10061000;
-const int CALL            = 0x10062000; ///< converted when executed
-const int REAL_CALL       = 0x10062001; ///< spring custom
-const int LUA_CALL        = 0x10062002; ///< spring custom
-const int JUMP            = 0x10064000;
-const int RETURN          = 0x10065000;
-const int JUMP_NOT_EQUAL  = 0x10066000;
-const int SIGNAL          = 0x10067000;
-const int SET_SIGNAL_MASK = 0x10068000;
-
-// Piece destruction
-const int EXPLODE    = 0x10071000;
-const int PLAY_SOUND = 0x10072000;
-
-// Special functions
-const int SET    = 0x10082000;
-const int ATTACH = 0x10083000;
-const int DROP   = 0x10084000;
-
 // Indices for SET, GET, and GET_UNIT_VALUE for LUA return values
 #define LUA0 110 // (LUA0 returns the lua call status, 0 or 1)
 #define LUA1 111
@@ -196,21 +171,20 @@ const int DROP   = 0x10084000;
 #define LUA9 119
 
 
-// Handy macros
-#define GET_LONG_PC() (script.code[PC++])
-// #define POP() (stack.size() > 0) ? stack.back(), stack.pop_back(); : 0
-
 int CCobThread::POP()
 {
-	if (!stack.empty()) {
-		int r = stack.back();
-		stack.pop_back();
-		return r;
-	}
+	if (stackSize > 0)
+		return stack[--stackSize];
 
 	return 0;
 }
 
+void CCobThread::PUSH(int val)
+{
+	// overflow is checked before every instruction, none pushes more than one value
+	stack[stackSize++] = val;
+}
+
 bool CCobThread::Tick()
 {
 	if (state == Sleep) {
@@ -225,381 +199,358 @@ bool CCobThread::Tick()
 	int r1, r2, r3, r4, r5, r6;
 
 	vector<int> args;
-	vector<int>::iterator ei;
-
-	execTrace.clear();
 
 	LOG_L(L_DEBUG, "Executing in %s (from %s)", script.scriptNames[callStack.back().functionId].c_str(), GetName().c_str());
 
 	while (state == Run) {
-		//int opcode = *(int*)&script.code[PC];
-
-		// Disabling exec trace gives about a 50% speedup on vm-intensive code
-		//execTrace.push_back(PC);
+		if (stackSize >= MAX_STACK_SIZE) {
+			ShowError("stack overflow");
+			state = Dead;
+			return false;
+		}
 
-		int opcode = GET_LONG_PC();
+		const CobInstruction& instr = script.instructions[PC++];
 
-		LOG_L(L_DEBUG, "PC: %x opcode: %x (%s)", PC - 1, opcode, GetOpcodeName(opcode).c_str());
+	#if LOG_IS_ENABLED_STATIC(L_DEBUG)
+		LOG_L(L_DEBUG, "PC: %x opcode: %x (%s)", script.instructionOffsets[PC - 1], script.code[script.instructionOffsets[PC - 1]], GetOpcodeName(script.code[script.instructionOffsets[PC - 1]]).c_str());
+	#endif
 
-		switch(opcode) {
-			case PUSH_CONSTANT:
-				r1 = GET_LONG_PC();
-				stack.push_back(r1);
+		switch (instr.op) {
+			case CobInstruction::MOVE:
+				r4 = POP();
+				r3 = POP();
+				owner->Move(instr.arg1, instr.arg2, r3, r4);
 				break;
-			case SLEEP:
+			case CobInstruction::TURN:
+				r2 = POP();
 				r1 = POP();
-				wakeTime = GCurrentTime + r1;
-				state = Sleep;
-				GCobEngine.AddThread(this);
-				LOG_L(L_DEBUG, "%s sleeping for %d ms", script.scriptNames[callStack.back().functionId].c_str(), r1);
-				return true;
-			case SPIN:
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+				//LOG_L(L_DEBUG, "Turning piece %s axis %d to %d speed %d", script.pieceNames[instr.arg1].c_str(), instr.arg2, r2, r1);
+				owner->Turn(instr.arg1, instr.arg2, r1, r2);
+				break;
+			case CobInstruction::SPIN:
 				r3 = POP();         // speed
 				r4 = POP();         // accel
-				owner->Spin(r1, r2, r3, r4);
+				owner->Spin(instr.arg1, instr.arg2, r3, r4);
 				break;
-			case STOP_SPIN:
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
+			case CobInstruction::STOP_SPIN:
 				r3 = POP();         // decel
-				//LOG_L(L_DEBUG, "Stop spin of %s around %d", script.pieceNames[r1].c_str(), r2);
-				owner->StopSpin(r1, r2, r3);
+				//LOG_L(L_DEBUG, "Stop spin of %s around %d", script.pieceNames[instr.arg1].c_str(), instr.arg2);
+				owner->StopSpin(instr.arg1, instr.arg2, r3);
 				break;
-			case RETURN:
-				retCode = POP();
-				if (callStack.back().returnAddr == -1) {
-					LOG_L(L_DEBUG, "%s returned %d", script.scriptNames[callStack.back().functionId].c_str(), retCode);
-					state = Dead;
-					//callStack.pop_back();
-					// Leave values intact on stack in case caller wants to check them
-					return false;
-				}
+			case CobInstruction::SHOW: {
+				int i;
+				for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
+					if (callStack.back().functionId == script.scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
+						break;
 
-				PC = callStack.back().returnAddr;
-				while (stack.size() > callStack.back().stackTop) {
-					stack.pop_back();
+				// If true, we are in a Fire-script and should show a special flare effect
+				if (i < MAX_WEAPONS_PER_UNIT) {
+					owner->ShowFlare(instr.arg1);
 				}
-				callStack.pop_back();
-				LOG_L(L_DEBUG, "Returning to %s", script.scriptNames[callStack.back().functionId].c_str());
-				break;
-			case SHADE:
-				r1 = GET_LONG_PC();
+				else {
+					owner->SetVisibility(instr.arg1, true);
+				}
+				//LOG_L(L_DEBUG, "Showing %d", instr.arg1);
+			} break;
+			case CobInstruction::HIDE:
+				owner->SetVisibility(instr.arg1, false);
+				//LOG_L(L_DEBUG, "Hiding %d", instr.arg1);
 				break;
-			case DONT_SHADE:
-				r1 = GET_LONG_PC();
+			case CobInstruction::MOVE_NOW:
+				r3 = POP();
+				owner->MoveNow(instr.arg1, instr.arg2, r3);
 				break;
-			case CACHE:
-				r1 = GET_LONG_PC();
+			case CobInstruction::TURN_NOW:
+				r3 = POP();
+				owner->TurnNow(instr.arg1, instr.arg2, r3);
 				break;
-			case DONT_CACHE:
-				r1 = GET_LONG_PC();
+			case CobInstruction::EMIT_SFX:
+				r1 = POP();
+				owner->EmitSfx(r1, instr.arg1);
 				break;
-			case CALL: {
-				r1 = GET_LONG_PC();
-				PC--;
-				const string& name = script.scriptNames[r1];
-				if (name.find("lua_") == 0) {
-					script.code[PC - 1] = LUA_CALL;
-					LuaCall();
-					break;
-				}
-				script.code[PC - 1] = REAL_CALL;
 
-				// fall through //
-			}
-			case REAL_CALL:
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				if (script.scriptLengths[r1] == 0) {
-					//LOG_L(L_DEBUG, "Preventing call to zero-len script %s", script.scriptNames[r1].c_str());
-					break;
+			case CobInstruction::WAIT_TURN:
+				//LOG_L(L_DEBUG, "Waiting for turn on piece %s around axis %d", script.pieceNames[instr.arg1].c_str(), instr.arg2);
+				if (owner->AddAnimListener(CCobInstance::ATurn, instr.arg1, instr.arg2, this)) {
+					state = WaitTurn;
+					return true;
 				}
-
-				struct callInfo ci;
-				ci.functionId = r1;
-				ci.returnAddr = PC;
-				ci.stackTop = stack.size() - r2;
-				callStack.push_back(ci);
-				paramCount = r2;
-
-				PC = script.scriptOffsets[r1];
-				//LOG_L(L_DEBUG, "Calling %s", script.scriptNames[r1].c_str());
-				break;
-			case LUA_CALL:
-				LuaCall();
-				break;
-			case POP_STATIC:
-				r1 = GET_LONG_PC();
-				r2 = POP();
-				owner->staticVars[r1] = r2;
-				//LOG_L(L_DEBUG, "Pop static var %d val %d", r1, r2);
-				break;
-			case POP_STACK:
-				POP();
 				break;
-			case START: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				if (script.scriptLengths[r1] == 0) {
-					//LOG_L(L_DEBUG, "Preventing start of zero-len script %s", script.scriptNames[r1].c_str());
-					break;
+			case CobInstruction::WAIT_MOVE:
+				//LOG_L(L_DEBUG, "Waiting for move on piece %s on axis %d", script.pieceNames[instr.arg1].c_str(), instr.arg2);
+				if (owner->AddAnimListener(CCobInstance::AMove, instr.arg1, instr.arg2, this)) {
+					state = WaitMove;
+					return true;
 				}
+				break;
+			case CobInstruction::SLEEP:
+				r1 = POP();
+				wakeTime = GCurrentTime + r1;
+				state = Sleep;
+				GCobEngine.AddThread(this);
+				LOG_L(L_DEBUG, "%s sleeping for %d ms", script.scriptNames[callStack.back().functionId].c_str(), r1);
+				return true;
 
-				args.clear();
-				args.reserve(r2);
-				for (r3 = 0; r3 < r2; ++r3) {
-					r4 = POP();
-					args.push_back(r4);
+			case CobInstruction::PUSH_CONSTANT:
+				PUSH(instr.arg1);
+				break;
+			case CobInstruction::PUSH_LOCAL_VAR:
+				r1 = callStack.back().stackTop + instr.arg1;
+				if (r1 < 0 || r1 >= stackSize) {
+					ShowError("local variable out of range");
+					state = Dead;
+					return false;
 				}
-
-				CCobThread* thread = new CCobThread(script, owner);
-				thread->Start(r1, args, true);
-
-				// Seems that threads should inherit signal mask from creator
-				thread->signalMask = signalMask;
-				LOG_L(L_DEBUG, "Starting %s %d", script.scriptNames[r1].c_str(), signalMask);
-			} break;
-			case CREATE_LOCAL_VAR:
+				PUSH(stack[r1]);
+				break;
+			case CobInstruction::PUSH_STATIC:
+				PUSH(owner->staticVars[instr.arg1]);
+				//LOG_L(L_DEBUG, "Push static %d val %d", instr.arg1, owner->staticVars[instr.arg1]);
+				break;
+			case CobInstruction::CREATE_LOCAL_VAR:
 				if (paramCount == 0) {
-					stack.push_back(0);
+					PUSH(0);
 				} else {
 					paramCount--;
 				}
 				break;
-			case GET_UNIT_VALUE:
-				r1 = POP();
-				if ((r1 >= LUA0) && (r1 <= LUA9)) {
-					stack.push_back(luaArgs[r1 - LUA0]);
-					break;
+			case CobInstruction::POP_LOCAL_VAR:
+				r2 = POP();
+				r1 = callStack.back().stackTop + instr.arg1;
+				if (r1 < 0 || r1 >= stackSize) {
+					ShowError("local variable out of range");
+					state = Dead;
+					return false;
 				}
-				r1 = owner->GetUnitVal(r1, 0, 0, 0, 0);
-				stack.push_back(r1);
+				stack[r1] = r2;
 				break;
-			case JUMP_NOT_EQUAL:
-				r1 = GET_LONG_PC();
+			case CobInstruction::POP_STATIC:
 				r2 = POP();
-				if (r2 == 0) {
-					PC = r1;
-				}
+				owner->staticVars[instr.arg1] = r2;
+				//LOG_L(L_DEBUG, "Pop static var %d val %d", instr.arg1, r2);
 				break;
-			case JUMP:
-				r1 = GET_LONG_PC();
-				// this seem to be an error in the docs..
-				//r2 = script.scriptOffsets[callStack.back().functionId] + r1;
-				PC = r1;
+			case CobInstruction::POP_STACK:
+				POP();
 				break;
-			case POP_LOCAL_VAR:
-				r1 = GET_LONG_PC();
+
+			case CobInstruction::ADD:
 				r2 = POP();
-				stack[callStack.back().stackTop + r1] = r2;
-				break;
-			case PUSH_LOCAL_VAR:
-				r1 = GET_LONG_PC();
-				r2 = stack[callStack.back().stackTop + r1];
-				stack.push_back(r2);
+				r1 = POP();
+				PUSH(r1 + r2);
 				break;
-			case SET_LESS_OR_EQUAL:
+			case CobInstruction::SUB:
 				r2 = POP();
 				r1 = POP();
-				if (r1 <= r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
+				PUSH(r1 - r2);
 				break;
-			case BITWISE_AND:
+			case CobInstruction::MUL:
 				r1 = POP();
 				r2 = POP();
-				stack.push_back(r1 & r2);
+				PUSH(r1 * r2);
 				break;
-			case BITWISE_OR: // seems to want stack contents or'd, result places on stack
+			case CobInstruction::DIV:
+				r2 = POP();
 				r1 = POP();
+				if (r2 != 0)
+					r3 = r1 / r2;
+				else {
+					r3 = 1000; // infinity!
+					LOG_L(L_ERROR, "division by zero");
+				}
+				PUSH(r3);
+				break;
+			case CobInstruction::MOD:
 				r2 = POP();
-				stack.push_back(r1 | r2);
+				r1 = POP();
+				if (r2 != 0)
+					PUSH(r1 % r2);
+				else {
+					PUSH(0);
+					LOG_L(L_ERROR, "modulo division by zero");
+				}
 				break;
-			case BITWISE_XOR:
+			case CobInstruction::BITWISE_AND:
 				r1 = POP();
 				r2 = POP();
-				stack.push_back(r1 ^ r2);
+				PUSH(r1 & r2);
 				break;
-			case BITWISE_NOT:
+			case CobInstruction::BITWISE_OR: // seems to want stack contents or'd, result places on stack
 				r1 = POP();
-				stack.push_back(~r1);
-				break;
-			case EXPLODE:
-				r1 = GET_LONG_PC();
 				r2 = POP();
-				owner->Explode(r1, r2);
+				PUSH(r1 | r2);
 				break;
-			case PLAY_SOUND:
-				r1 = GET_LONG_PC();
+			case CobInstruction::BITWISE_XOR:
+				r1 = POP();
 				r2 = POP();
-				owner->PlayUnitSound(r1, r2);
-				break;
-			case PUSH_STATIC:
-				r1 = GET_LONG_PC();
-				stack.push_back(owner->staticVars[r1]);
-				//LOG_L(L_DEBUG, "Push static %d val %d", r1, owner->staticVars[r1]);
+				PUSH(r1 ^ r2);
 				break;
-			case SET_NOT_EQUAL:
+			case CobInstruction::BITWISE_NOT:
 				r1 = POP();
+				PUSH(~r1);
+				break;
+
+			case CobInstruction::RAND:
 				r2 = POP();
-				if (r1 != r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
+				r1 = POP();
+				r3 = gs->randInt() % (r2 - r1 + 1) + r1;
+				PUSH(r3);
 				break;
-			case SET_EQUAL:
+			case CobInstruction::GET_UNIT_VALUE:
 				r1 = POP();
-				r2 = POP();
-				if (r1 == r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
+				if ((r1 >= LUA0) && (r1 <= LUA9)) {
+					PUSH(luaArgs[r1 - LUA0]);
+					break;
+				}
+				PUSH(owner->GetUnitVal(r1, 0, 0, 0, 0));
 				break;
-			case SET_LESS:
+			case CobInstruction::GET:
+				r5 = POP();
+				r4 = POP();
+				r3 = POP();
 				r2 = POP();
 				r1 = POP();
-				if (r1 < r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
+				if ((r1 >= LUA0) && (r1 <= LUA9)) {
+					PUSH(luaArgs[r1 - LUA0]);
+					break;
+				}
+				r6 = owner->GetUnitVal(r1, r2, r3, r4, r5);
+				PUSH(r6);
 				break;
-			case SET_GREATER:
+
+			case CobInstruction::SET_LESS:
 				r2 = POP();
 				r1 = POP();
-				if (r1 > r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
+				PUSH(r1 < r2);
 				break;
-			case SET_GREATER_OR_EQUAL:
+			case CobInstruction::SET_LESS_OR_EQUAL:
 				r2 = POP();
 				r1 = POP();
-				if (r1 >= r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
+				PUSH(r1 <= r2);
 				break;
-			case RAND:
+			case CobInstruction::SET_GREATER:
 				r2 = POP();
 				r1 = POP();
-				r3 = gs->randInt() % (r2 - r1 + 1) + r1;
-				stack.push_back(r3);
+				PUSH(r1 > r2);
 				break;
-			case EMIT_SFX:
+			case CobInstruction::SET_GREATER_OR_EQUAL:
+				r2 = POP();
 				r1 = POP();
-				r2 = GET_LONG_PC();
-				owner->EmitSfx(r1, r2);
+				PUSH(r1 >= r2);
 				break;
-			case MUL:
+			case CobInstruction::SET_EQUAL:
 				r1 = POP();
 				r2 = POP();
-				stack.push_back(r1 * r2);
+				PUSH(r1 == r2);
 				break;
-			case SIGNAL:
+			case CobInstruction::SET_NOT_EQUAL:
 				r1 = POP();
-				owner->Signal(r1);
+				r2 = POP();
+				PUSH(r1 != r2);
 				break;
-			case SET_SIGNAL_MASK:
+			case CobInstruction::LOGICAL_AND:
 				r1 = POP();
-				signalMask = r1;
-				break;
-			case TURN:
 				r2 = POP();
+				PUSH(r1 && r2);
+				break;
+			case CobInstruction::LOGICAL_OR:
 				r1 = POP();
-				r3 = GET_LONG_PC();
-				r4 = GET_LONG_PC();
-				//LOG_L(L_DEBUG, "Turning piece %s axis %d to %d speed %d", script.pieceNames[r3].c_str(), r4, r2, r1);
-				owner->Turn(r3, r4, r1, r2);
+				r2 = POP();
+				PUSH(r1 || r2);
 				break;
-			case GET:
-				r5 = POP();
-				r4 = POP();
-				r3 = POP();
+			case CobInstruction::LOGICAL_XOR:
+				r1 = POP();
 				r2 = POP();
+				PUSH((!!r1) ^ (!!r2));
+				break;
+			case CobInstruction::LOGICAL_NOT: // Like bitwise, but only on values 1 and 0.
 				r1 = POP();
-				if ((r1 >= LUA0) && (r1 <= LUA9)) {
-					stack.push_back(luaArgs[r1 - LUA0]);
+				PUSH(r1 == 0);
+				break;
+
+			case CobInstruction::START: {
+				if (script.scriptLengths[instr.arg1] == 0) {
+					//LOG_L(L_DEBUG, "Preventing start of zero-len script %s", script.scriptNames[instr.arg1].c_str());
 					break;
 				}
-				r6 = owner->GetUnitVal(r1, r2, r3, r4, r5);
-				stack.push_back(r6);
+
+				args.clear();
+				args.reserve(instr.arg2);
+				for (r3 = 0; r3 < instr.arg2; ++r3) {
+					r4 = POP();
+					args.push_back(r4);
+				}
+
+				CCobThread* thread = new CCobThread(script, owner);
+				thread->Start(instr.arg1, args, true);
+
+				// Seems that threads should inherit signal mask from creator
+				thread->signalMask = signalMask;
+				LOG_L(L_DEBUG, "Starting %s %d", script.scriptNames[instr.arg1].c_str(), signalMask);
+			} break;
+			case CobInstruction::CALL: {
+				if (script.scriptLengths[instr.arg1] == 0) {
+					//LOG_L(L_DEBUG, "Preventing call to zero-len script %s", script.scriptNames[instr.arg1].c_str());
+					break;
+				}
+
+				struct callInfo ci;
+				ci.functionId = instr.arg1;
+				ci.returnAddr = PC;
+				ci.stackTop = std::max(stackSize - instr.arg2, 0);
+				callStack.push_back(ci);
+				paramCount = instr.arg2;
+
+				PC = script.scriptEntries[instr.arg1];
+				//LOG_L(L_DEBUG, "Calling %s", script.scriptNames[instr.arg1].c_str());
+			} break;
+			case CobInstruction::LUA_CALL:
+				LuaCall(instr.arg1, instr.arg2);
 				break;
-			case ADD:
-				r2 = POP();
-				r1 = POP();
-				stack.push_back(r1 + r2);
+			case CobInstruction::JUMP:
+				// this seem to be an error in the docs..
+				//r2 = script.scriptOffsets[callStack.back().functionId] + r1;
+				PC = instr.arg1;
 				break;
-			case SUB:
-				r2 = POP();
-				r1 = POP();
-				r3 = r1 - r2;
-				stack.push_back(r3);
+			case CobInstruction::RETURN:
+				retCode = POP();
+				if (callStack.back().returnAddr == -1) {
+					LOG_L(L_DEBUG, "%s returned %d", script.scriptNames[callStack.back().functionId].c_str(), retCode);
+					state = Dead;
+					//callStack.pop_back();
+					// Leave values intact on stack in case caller wants to check them
+					return false;
+				}
+
+				PC = callStack.back().returnAddr;
+				stackSize = std::min(stackSize, callStack.back().stackTop);
+				callStack.pop_back();
+				LOG_L(L_DEBUG, "Returning to %s", script.scriptNames[callStack.back().functionId].c_str());
 				break;
-			case DIV:
+			case CobInstruction::JUMP_NOT_EQUAL:
 				r2 = POP();
-				r1 = POP();
-				if (r2 != 0)
-					r3 = r1 / r2;
-				else {
-					r3 = 1000; // infinity!
-					LOG_L(L_ERROR, "division by zero");
+				if (r2 == 0) {
+					PC = instr.arg1;
 				}
-				stack.push_back(r3);
 				break;
-			case MOD:
-				r2 = POP();
+			case CobInstruction::SIGNAL:
 				r1 = POP();
-				if (r2 != 0)
-					stack.push_back(r1 % r2);
-				else {
-					stack.push_back(0);
-					LOG_L(L_ERROR, "modulo division by zero");
-				}
+				owner->Signal(r1);
 				break;
-			case MOVE:
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r4 = POP();
-				r3 = POP();
-				owner->Move(r1, r2, r3, r4);
+			case CobInstruction::SET_SIGNAL_MASK:
+				r1 = POP();
+				signalMask = r1;
 				break;
-			case MOVE_NOW:{
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r3 = POP();
-				owner->MoveNow(r1, r2, r3);
-				break;}
-			case TURN_NOW:{
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r3 = POP();
-				owner->TurnNow(r1, r2, r3);
-				break;}
-			case WAIT_TURN:
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				//LOG_L(L_DEBUG, "Waiting for turn on piece %s around axis %d", script.pieceNames[r1].c_str(), r2);
-				if (owner->AddAnimListener(CCobInstance::ATurn, r1, r2, this)) {
-					state = WaitTurn;
-					return true;
-				}
-				else
-					break;
-			case WAIT_MOVE:
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				//LOG_L(L_DEBUG, "Waiting for move on piece %s on axis %d", script.pieceNames[r1].c_str(), r2);
-				if (owner->AddAnimListener(CCobInstance::AMove, r1, r2, this)) {
-					state = WaitMove;
-					return true;
-				}
+
+			case CobInstruction::EXPLODE:
+				r2 = POP();
+				owner->Explode(instr.arg1, r2);
 				break;
-			case SET:
+			case CobInstruction::PLAY_SOUND_FX:
+				r2 = POP();
+				owner->PlayUnitSound(instr.arg1, r2);
+				break;
+
+			case CobInstruction::SET:
 				r2 = POP();
 				r1 = POP();
 				//LOG_L(L_DEBUG, "Setting unit value %d to %d", r1, r2);
@@ -609,81 +560,35 @@ bool CCobThread::Tick()
 				}
 				owner->SetUnitVal(r1, r2);
 				break;
-			case ATTACH:
+			case CobInstruction::ATTACH:
 				r3 = POP();
 				r2 = POP();
 				r1 = POP();
 				owner->AttachUnit(r2, r1);
 				break;
-			case DROP:
+			case CobInstruction::DROP:
 				r1 = POP();
 				owner->DropUnit(r1);
 				break;
-			case LOGICAL_NOT: // Like bitwise, but only on values 1 and 0.
-				r1 = POP();
-				if (r1 == 0)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
-				break;
-			case LOGICAL_AND:
-				r1 = POP();
-				r2 = POP();
-				if (r1 && r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
-				break;
-			case LOGICAL_OR:
-				r1 = POP();
-				r2 = POP();
-				if (r1 || r2)
-					stack.push_back(1);
-				else
-					stack.push_back(0);
+
+			case CobInstruction::NOP:
 				break;
-			case LOGICAL_XOR:
-				r1 = POP();
-				r2 = POP();
-				if ( (!!r1) ^ (!!r2))
-					stack.push_back(1);
-				else
-					stack.push_back(0);
-				break;
-			case HIDE:
-				r1 = GET_LONG_PC();
-				owner->SetVisibility(r1, false);
-				//LOG_L(L_DEBUG, "Hiding %d", r1);
-				break;
-			case SHOW:{
-				r1 = GET_LONG_PC();
-				int i;
-				for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
-					if (callStack.back().functionId == script.scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
-						break;
 
-				// If true, we are in a Fire-script and should show a special flare effect
-				if (i < MAX_WEAPONS_PER_UNIT) {
-					owner->ShowFlare(r1);
-				}
-				else {
-					owner->SetVisibility(r1, true);
-				}
-				//LOG_L(L_DEBUG, "Showing %d", r1);
-				break;}
-			default:
-				LOG_L(L_ERROR, "Unknown opcode %x (in %s:%s at %x)",
-						opcode, script.name.c_str(),
-						script.scriptNames[callStack.back().functionId].c_str(),
-						PC - 1);
-				LOG_L(L_ERROR, "Exec trace:");
-				ei = execTrace.begin();
-				while (ei != execTrace.end()) {
-					LOG_L(L_ERROR, "PC: %3x  opcode: %s", *ei, GetOpcodeName(script.code[*ei]).c_str());
-					++ei;
-				}
+			default: {
+				static const char* fmts[] = {
+					"Unknown opcode %x",
+					"Invalid jump target %x",
+					"Invalid script id %d",
+					"Reached the end of the code at %x",
+				};
+
+				static char msg[512];
+				SNPRINTF(msg, sizeof(msg), fmts[std::min(std::max(instr.arg2, 0), 3)], instr.arg1);
+				ShowError(msg);
+
 				state = Dead;
 				return false;
+			}
 		}
 	}
 
@@ -698,15 +603,19 @@ void CCobThread::ShowError(const string& msg)
 	if (callStack.empty()) {
 		LOG_L(L_ERROR, "%s outside script execution (?)", msg.c_str());
 	} else {
+		const int offset = (PC > 0 && size_t(PC) <= script.instructionOffsets.size())? script.instructionOffsets[PC - 1]: -1;
+
 		LOG_L(L_ERROR, "%s (in %s:%s at %x)", msg.c_str(),
 				script.name.c_str(),
 				script.scriptNames[callStack.back().functionId].c_str(),
-				PC - 1);
+				offset);
 	}
 }
 
 string CCobThread::GetOpcodeName(int opcode)
 {
+	using namespace CobOpcode;
+
 	switch (opcode) {
 		case MOVE: return "move";
 		case TURN: return "turn";
@@ -770,7 +679,7 @@ string CCobThread::GetOpcodeName(int opcode)
 		case SET_SIGNAL_MASK: return "mask";
 
 		case EXPLODE: return "explode";
-		case PLAY_SOUND: return "play-sound";
+		case PLAY_SOUND_FX: return "play-sound";
 
 		case SET: return "set";
 		case ATTACH: return "attach";
@@ -788,13 +697,10 @@ void CCobThread::DependentDied(CObject* o)
 
 /******************************************************************************/
 
-void CCobThread::LuaCall()
+void CCobThread::LuaCall(int r1, int r2)
 {
-	const int r1 = GET_LONG_PC(); // script id
-	const int r2 = GET_LONG_PC(); // arg count
-
 	// setup the parameter array
-	const int size = (int) stack.size();
+	const int size = stackSize;
 	const int argCount = std::min(r2, MAX_LUA_COB_ARGS);
 	const int start = std::max(0, size - r2);
 	const int end = std::min(size, start + argCount);
@@ -803,11 +709,7 @@ void CCobThread::LuaCall()
 		luaArgs[a] = stack[i];
 		a++;
 	}
-	if (r2 >= size) {
-		stack.clear();
-	} else {
-		stack.resize(size - r2);
-	}
+	stackSize = std::max(0, size - r2);
 
 	if (!luaRules) {
 		luaArgs[0] = 0; // failure
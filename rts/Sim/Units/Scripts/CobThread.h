@@ -23,6 +23,12 @@ public:
 	/// Inform the vultures that we finally croaked
 	~CCobThread();
 
+	/// threads are started and finish all the time, recycle their memory
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+	/// returns the recycled memory of deleted threads to the heap
+	static void FreePooledMemory();
+
 	/**
 	 * Returns false if this thread is dead and needs to be killed.
 	 */
@@ -59,20 +65,27 @@ public:
 
 protected:
 	std::string GetOpcodeName(int opcode);
-	void LuaCall();
+	void LuaCall(int scriptId, int argCount);
 	// implementation of IAnimListener
 	void AnimFinished(CUnitScript::AnimType type, int piece, int axis);
 
 	inline int POP();
+	inline void PUSH(int val);
 
 
 	CCobFile& script;
 	CCobInstance* owner;
 
 	int wakeTime;
+	/// index into script.instructions
 	int PC;
-	vector<int> stack;
-	vector<int> execTrace;
+
+	static const int MAX_STACK_SIZE = 1024;
+
+	/// scripts never get anywhere near MAX_STACK_SIZE, so the stack is not
+	/// grown on demand but checked for overflow once per instruction
+	int stack[MAX_STACK_SIZE];
+	int stackSize;
 
 	int paramCount;
 	int retCode;
@@ -82,7 +95,7 @@ protected:
 	struct callInfo {
 		int functionId;
 		int returnAddr;
-		size_t stackTop;
+		int stackTop;
 	};
 	vector<struct callInfo> callStack;
 
@@ -1188,9 +1188,9 @@ int CUnitScript::GetUnitVal(int val, int p1, int p2, int p3, int p4)
 	case ABS:
 		return abs(p1);
 	case KSIN:
-		return int(1024*math::sinf(TAANG2RAD*(float)p1));
+		return int(1024*GetSinFromHeading((short int) p1));
 	case KCOS:
-		return int(1024*math::cosf(TAANG2RAD*(float)p1));
+		return int(1024*GetCosFromHeading((short int) p1));
 	case KTAN:
 		return int(1024*math::tanf(TAANG2RAD*(float)p1));
 	case SQRT:
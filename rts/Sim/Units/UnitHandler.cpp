@@ -9,10 +9,12 @@
 #include "Rendering/Models/3DModel.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/TeamHandler.h"
+#include "Sim/MoveTypes/GroundCollisionBroadphase.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/Weapons/Weapon.h"
 #include "System/EventHandler.h"
 #include "System/Log/ILog.h"
+#include "System/ThreadPool.h"
 #include "System/TimeProfiler.h"
 #include "System/myMath.h"
 #include "System/Sync/SyncTracer.h"
@@ -197,7 +199,12 @@ void CUnitHandler::Update()
 
 	{
 		SCOPED_TIMER("Unit::MoveType::Update");
-		
+
+		{
+			SCOPED_TIMER("Unit::MoveType::Update::Broadphase");
+			groundCollisionBroadphase.Update(activeUnits);
+		}
+
 		for (activeUpdateUnit = 0; activeUpdateUnit < activeUnits.size();++activeUpdateUnit) {
 			CUnit *unit = activeUnits[activeUpdateUnit];
 			AMoveType* moveType = unit->moveType;
@@ -207,6 +214,9 @@ void CUnitHandler::Update()
 			if (moveType->Update()) {
 				eventHandler.UnitMoved(unit);
 			}
+
+			groundCollisionBroadphase.MovedUnit(unit);
+
 			if (!unit->pos.IsInBounds() && (unit->speed.w > MAX_UNIT_SPEED)) {
 				// this unit is not coming back, kill it now without any death
 				// sequence (so deathScriptFinished becomes true immediately)
@@ -238,12 +248,13 @@ void CUnitHandler::Update()
 	{
 		SCOPED_TIMER("Unit::UpdatePieceMatrices");
 		//Shouldn't insert new units
-		for (CUnit* unit: activeUnits) {
-			// UnitScript only applies piece-space transforms so
-			// we apply the forward kinematics update separately
-			// (only if we have any dirty pieces)
-			unit->localModel->UpdatePieceMatrices();
-		}
+		// UnitScript only applies piece-space transforms so
+		// we apply the forward kinematics update separately
+		// (only if we have any dirty pieces)
+		// every unit only touches its own LocalModel, so this is safe to parallelize
+		for_mt(0, activeUnits.size(), [&](const int i) {
+			activeUnits[i]->localModel->UpdatePieceMatrices();
+		});
 	}
 
 	{
@@ -95,10 +95,11 @@ void CPlasmaRepulser::Update()
 		return;
 	}
 
-	for (std::map<int, CWeaponProjectile*>::iterator pi = incomingProjectiles.begin(); pi != incomingProjectiles.end(); ++pi) {
-		assert(projectileHandler->GetProjectileBySyncedID(pi->first)); // valid projectile id?
+	// indexed, ShieldPreDamaged can spawn projectiles that end up in the list
+	for (size_t n = 0; n < incomingProjectiles.size(); n++) {
+		CWeaponProjectile* pro = incomingProjectiles[n];
+		assert(projectileHandler->GetProjectileBySyncedID(pro->id)); // valid projectile id?
 
-		CWeaponProjectile* pro = pi->second;
 		const WeaponDef* proWD = pro->GetWeaponDef();
 
 		if (!pro->checkCol) {
@@ -236,7 +237,7 @@ void CPlasmaRepulser::NewProjectile(CWeaponProjectile* p)
 	// it should probably be: radius + closeLength / |projectile->speed| * |owner->speed|,
 	// but this still doesn't solve anything for e.g. teleporting shields.
 	if (closeDist < Square(radius * 1.5f)) {
-		incomingProjectiles[p->id] = p;
+		AddIncomingProjectile(p);
 		AddDeathDependence(p, DEPENDENCE_REPULSED);
 	}
 }
@@ -322,6 +322,7 @@ void CWeapon::ReAimWeapon()
 	// NOTE:
 	//   let scripts do active aiming even if we are an onlyForward weapon
 	//   (reduces how far the entire unit must turn to face worldTargetDir)
+	static const float MAX_REAIM_COSINE = math::cos(20.0f);
 
 	bool reAim = false;
 
@@ -335,7 +336,7 @@ void CWeapon::ReAimWeapon()
 
 	// check max FireAngle
 	reAim |= (wantedDir.dot(lastRequestedDir) <= weaponDef->maxFireAngle);
-	reAim |= (wantedDir.dot(lastRequestedDir) <= math::cos(20.f));
+	reAim |= (wantedDir.dot(lastRequestedDir) <= MAX_REAIM_COSINE);
 
 	//note: angleGood checks unit/maindir, not the weapon's current aim dir!!!
 	//reAim |= (!angleGood);
@@ -735,7 +736,7 @@ void CWeapon::DependentDied(CObject* o)
 
 	// NOTE: DependentDied is called from ~CObject-->Detach, object is just barely valid
 	if (weaponDef->interceptor || weaponDef->isShield) {
-		incomingProjectiles.erase(static_cast<CWeaponProjectile*>(o)->id);
+		RemoveIncomingProjectile(static_cast<CWeaponProjectile*>(o)->id);
 	}
 }
 
@@ -1082,8 +1083,7 @@ void CWeapon::UpdateInterceptTarget()
 		minInterceptTargetDistSq = aimFromPos.SqDistance(currentTarget.intercept->pos);
 	}
 
-	for (std::map<int, CWeaponProjectile*>::iterator pi = incomingProjectiles.begin(); pi != incomingProjectiles.end(); ++pi) {
-		CWeaponProjectile* p = pi->second;
+	for (CWeaponProjectile* p: incomingProjectiles) {
 		const float curInterceptTargetDistSq = aimFromPos.SqDistance(p->pos);
 
 		// set by CWeaponProjectile's ctor when the interceptor fires
@@ -1142,6 +1142,36 @@ void CWeapon::StopAttackingAllyTeam(const int ally)
 }
 
 
+static bool ProjectileIDLess(const CWeaponProjectile* p, int projectileID) { return (p->id < projectileID); }
+
+bool CWeapon::HasIncomingProjectile(int projectileID) const
+{
+	const auto it = std::lower_bound(incomingProjectiles.begin(), incomingProjectiles.end(), projectileID, ProjectileIDLess);
+	return (it != incomingProjectiles.end() && (*it)->id == projectileID);
+}
+
+void CWeapon::AddIncomingProjectile(CWeaponProjectile* p)
+{
+	// ids are handed out in increasing order, so this is almost always an append
+	const auto it = std::lower_bound(incomingProjectiles.begin(), incomingProjectiles.end(), p->id, ProjectileIDLess);
+
+	if (it != incomingProjectiles.end() && (*it)->id == p->id) {
+		*it = p;
+	} else {
+		incomingProjectiles.insert(it, p);
+	}
+}
+
+void CWeapon::RemoveIncomingProjectile(int projectileID)
+{
+	const auto it = std::lower_bound(incomingProjectiles.begin(), incomingProjectiles.end(), projectileID, ProjectileIDLess);
+
+	if (it != incomingProjectiles.end() && (*it)->id == projectileID) {
+		incomingProjectiles.erase(it);
+	}
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
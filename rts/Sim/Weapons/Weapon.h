@@ -3,7 +3,7 @@
 #ifndef WEAPON_H
 #define WEAPON_H
 
-#include <map>
+#include <vector>
 
 #include "System/Object.h"
 #include "Sim/Misc/DamageArray.h"
@@ -80,6 +80,10 @@ public:
 
 	void StopAttackingAllyTeam(const int ally);
 
+	bool HasIncomingProjectile(int projectileID) const;
+	void AddIncomingProjectile(CWeaponProjectile* p);
+	void RemoveIncomingProjectile(int projectileID);
+
 protected:
 	virtual void FireImpl(const bool scriptCall) {}
 	virtual void UpdateWantedDir();
@@ -153,7 +157,8 @@ public:
 
 	// projectiles that are on the way to our interception zone
 	// (eg. nuke toward a repulsor, or missile toward a shield)
-	std::map<int, CWeaponProjectile*> incomingProjectiles;
+	// kept sorted by projectile id, see AddIncomingProjectile
+	std::vector<CWeaponProjectile*> incomingProjectiles;
 
 	float buildPercent;           // how far we have come on building current missile if stockpiling
 	int numStockpiled;            // how many missiles we have stockpiled
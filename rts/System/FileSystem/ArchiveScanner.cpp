@@ -4,6 +4,7 @@
 #include <list>
 #include <algorithm>
 #include <stdio.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <boost/scoped_ptr.hpp>
@@ -12,6 +13,7 @@
 #include "ArchiveLoader.h"
 #include "DataDirLocater.h"
 #include "Archives/IArchive.h"
+#include "Archives/FileView.h"
 #include "FileFilter.h"
 #include "DataDirsAccess.h"
 #include "FileSystem.h"
@@ -44,7 +46,9 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ARCHIVESCANNER)
  * but mapping them all, every time to make the list is)
  */
 
-const int INTERNAL_VER = 10;
+const int INTERNAL_VER = 11;
+// last version of the lua-text cache, imported once if no binary cache exists
+const int LUA_CACHE_VER = 10;
 CArchiveScanner* archiveScanner = NULL;
 
 
@@ -342,11 +346,10 @@ CArchiveScanner::CArchiveScanner()
 {
 	// the "cache" dir is created in DataDirLocater
 	const std:: string cacheFolder = dataDirLocater.GetWriteDirPath() + FileSystem::EnsurePathSepAtEnd(FileSystem::GetCacheBaseDir());
-	cachefile = cacheFolder + IntToString(INTERNAL_VER, "ArchiveCache%i.lua");
-	ReadCacheData(GetFilepath());
-	if (archiveInfos.empty()) {
-		// when versioned ArchiveCache%i.lua is missing or empty, try old unversioned filename
-		ReadCacheData(cacheFolder + "ArchiveCache.lua");
+	cachefile = cacheFolder + IntToString(INTERNAL_VER, "ArchiveCache%i.bin");
+	if (!ReadCacheData(GetFilepath())) {
+		// when the binary cache is missing, import the one written by older versions
+		ReadLuaCacheData(cacheFolder + IntToString(LUA_CACHE_VER, "ArchiveCache%i.lua"));
 	}
 
 	const std::vector<std::string>& datadirs = dataDirLocater.GetDataDirPaths();
@@ -379,8 +382,6 @@ const std::string& CArchiveScanner::GetFilepath() const
 
 void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs, bool doChecksum)
 {
-	isDirty = true;
-
 	// scan for all archives
 	std::list<std::string> foundArchives;
 	for (const std::string& dir: scanDirs) {
@@ -407,8 +408,27 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs, bool do
 	}*/
 
 	// Create archiveInfos etc. when not being in cache already
+	std::map<std::string, std::string> queued;
+	std::vector<ScanJob> jobs;
 	for (const std::string& archive: foundArchives) {
-		ScanArchive(archive, doChecksum);
+		ScanJob job;
+		if (PrepareScanJob(archive, doChecksum, queued, job)) {
+			jobs.push_back(job);
+		}
+	}
+
+	// opening the archives and the CRCs are the expensive part, done in parallel;
+	// the meta-files are parsed (LuaParser is not thread-safe) and merged in the
+	// order the archives were found
+	for_mt(0, jobs.size(), [&](const int i) {
+		RunScanJob(jobs[i]);
+	#if !defined(DEDICATED) && !defined(UNITSYNC)
+		Watchdog::ClearTimer(WDT_MAIN);
+	#endif
+	});
+
+	for (ScanJob& job: jobs) {
+		FinishScanJob(job);
 	#if !defined(DEDICATED) && !defined(UNITSYNC)
 		Watchdog::ClearTimer(WDT_MAIN);
 	#endif
@@ -420,6 +440,7 @@ void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs, bool do
 			// Overwrite the info for this archive with a replaced pointer
 			const std::string lcname = StringToLower(replaceName);
 			ArchiveInfo& ai = archiveInfos[lcname];
+			isDirty |= (ai.replaced != aii.first);
 			ai.path = "";
 			ai.origName = lcname;
 			ai.modified = 1;
@@ -469,7 +490,7 @@ static void AddDependency(std::vector<std::string>& deps, const std::string& dep
 	deps.push_back(dependency);
 }
 
-bool CArchiveScanner::CheckCompression(const IArchive* ar,const std::string& fullName, std::string& error)
+bool CArchiveScanner::CheckCompression(const IArchive* ar, std::string& error, std::vector<std::string>& warnings)
 {
 	if (!ar->CheckForSolid())
 		return true;
@@ -490,9 +511,7 @@ bool CArchiveScanner::CheckCompression(const IArchive* ar,const std::string& ful
 			return false;
 		} else if (metaFileClass == 2) {
 			// 2nd class
-			LOG_SL(LOG_SECTION_ARCHIVESCANNER, L_WARNING,
-					"Archive %s: The cost for reading a 2nd-class meta-file is too high: %s",
-					fullName.c_str(), name.c_str());
+			warnings.push_back("The cost for reading a 2nd-class meta-file is too high: " + name);
 		}
 
 	}
@@ -528,6 +547,18 @@ static bool IsBaseContent(const std::string& fileName)
 }
 
 void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
+{
+	std::map<std::string, std::string> queued;
+	ScanJob job;
+
+	if (!PrepareScanJob(fullName, doChecksum, queued, job))
+		return;
+
+	RunScanJob(job);
+	FinishScanJob(job);
+}
+
+bool CArchiveScanner::PrepareScanJob(const std::string& fullName, bool doChecksum, std::map<std::string, std::string>& queued, ScanJob& job)
 {
 	const std::string fn    = FileSystem::GetFilename(fullName);
 	const std::string fpath = FileSystem::GetDirectory(fullName);
@@ -539,30 +570,57 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 
 	// If stat fails, assume the archive is not broken nor cached
 	if (!statfailed) {
+		// an entry imported from the lua cache has no size, only compare mtime then
+		const auto IsUnchanged = [&](unsigned int modified, boost::uint64_t size, const std::string& path) {
+			return ((unsigned)info.st_mtime == modified && (size == 0 || size == (boost::uint64_t)info.st_size) && fpath == path);
+		};
+
 		// Determine whether this archive has earlier be found to be broken
 		std::map<std::string, BrokenArchive>::iterator bai = brokenArchives.find(lcfn);
 		if (bai != brokenArchives.end()) {
-			if ((unsigned)info.st_mtime == bai->second.modified && fpath == bai->second.path) {
+			if (IsUnchanged(bai->second.modified, bai->second.size, bai->second.path)) {
 				bai->second.updated = true;
-				return;
+				if (bai->second.size == 0) {
+					bai->second.size = info.st_size;
+					isDirty = true;
+				}
+				return false;
 			}
 		}
 
+		// An archive with the same name is going to be scanned already
+		std::map<std::string, std::string>::const_iterator qi = queued.find(lcfn);
+		if (qi != queued.end()) {
+			LOG_L(L_ERROR, "Found a \"%s\" already in \"%s\", ignoring.", fullName.c_str(), qi->second.c_str());
+			if (IsBaseContent(lcfn)) {
+				throw user_error(std::string("duplicate base content detected:\n\t") + FileSystem::GetDirectory(qi->second) + std::string("\n\t") + fpath
+					+ std::string("\nPlease fix your configuration/installation as this can cause desyncs!"));
+			}
+			return false;
+		}
+
 		// Determine whether to rely on the cached info or not
 		std::map<std::string, ArchiveInfo>::iterator aii = archiveInfos.find(lcfn);
 		if (aii != archiveInfos.end()) {
 			// This archive may have been obsoleted, do not process it if so
 			if (!aii->second.replaced.empty()) {
-				return;
+				return false;
 			}
 
-			if ((unsigned)info.st_mtime == aii->second.modified && fpath == aii->second.path) {
+			if (IsUnchanged(aii->second.modified, aii->second.size, aii->second.path)) {
 				// cache found update checksum if wanted
 				aii->second.updated = true;
+				if (aii->second.size == 0) {
+					aii->second.size = info.st_size;
+					isDirty = true;
+				}
 				if (doChecksum && (aii->second.checksum == 0)) {
-					aii->second.checksum = GetCRC(fullName);
+					job.fullName = fullName;
+					job.checksumOnly = true;
+					queued[lcfn] = fullName;
+					return true;
 				}
-				return;
+				return false;
 			} else {
 				if (aii->second.updated) {
 					const std::string filename = aii->first;
@@ -571,7 +629,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 						throw user_error(std::string("duplicate base content detected:\n\t") + aii->second.path + std::string("\n\t") + fpath
 							+ std::string("\nPlease fix your configuration/installation as this can cause desyncs!"));
 					}
-					return;
+					return false;
 				}
 
 				// If we are here, we could have invalid info in the cache
@@ -583,40 +641,104 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		}
 	}
 
-	boost::scoped_ptr<IArchive> ar(archiveLoader.OpenArchive(fullName));
+	job.fullName = fullName;
+	job.modified = info.st_mtime;
+	job.size = info.st_size;
+	job.doChecksum = doChecksum;
+	queued[lcfn] = fullName;
+	return true;
+}
+
+void CArchiveScanner::RunScanJob(ScanJob& job)
+{
+	// NOTE: runs on the thread pool, must not touch any member state
+	if (job.checksumOnly) {
+		job.checksum = GetCRC(job.fullName);
+		return;
+	}
+
+	boost::scoped_ptr<IArchive> ar(archiveLoader.OpenArchive(job.fullName));
 	if (!ar || !ar->IsOpen()) {
+		return;
+	}
+
+	job.opened = true;
+	job.hasModinfo = ar->FileExists("modinfo.lua");
+	job.hasMapinfo = ar->FileExists("mapinfo.lua");
+
+	if (job.hasMapinfo || job.hasModinfo) {
+		const std::string infoFile = (job.hasMapinfo)? "mapinfo.lua": "modinfo.lua";
+		std::vector<boost::uint8_t> buf;
+
+		if (ar->GetFile(infoFile, buf) && !buf.empty()) {
+			job.infoData.assign((char*)(&buf[0]), buf.size());
+		} else {
+			job.error = "Error reading " + infoFile + " from " + ar->GetArchiveName();
+		}
+	}
+
+	// only needed for maps which do not set the mapfile in their mapinfo
+	// (only known after parsing it), but cheap compared to opening the archive
+	if (!job.hasModinfo || job.hasMapinfo) {
+		job.mapFile = SearchMapFile(ar.get(), job.error);
+	}
+
+	CheckCompression(ar.get(), job.error, job.warnings);
+
+	if (job.error.empty() && job.doChecksum) {
+		job.checksum = GetCRC(job.fullName);
+	}
+}
+
+void CArchiveScanner::FinishScanJob(ScanJob& job)
+{
+	const std::string& fullName = job.fullName;
+	const std::string fn    = FileSystem::GetFilename(fullName);
+	const std::string fpath = FileSystem::GetDirectory(fullName);
+	const std::string lcfn  = StringToLower(fn);
+
+	isDirty = true;
+
+	if (job.checksumOnly) {
+		archiveInfos[lcfn].checksum = job.checksum;
+		return;
+	}
+
+	if (!job.opened) {
 		LOG_L(L_WARNING, "Unable to open archive: %s", fullName.c_str());
 
 		// record it as broken, so we don't need to look inside everytime
 		BrokenArchive& ba = brokenArchives[lcfn];
 		ba.path = fpath;
-		ba.modified = info.st_mtime;
+		ba.modified = job.modified;
+		ba.size = job.size;
 		ba.updated = true;
 		ba.problem = "Unable to open archive";
 		return;
 	}
 
-	std::string error;
-	std::string mapfile;
-
-	const bool hasModinfo = ar->FileExists("modinfo.lua");
-	const bool hasMapinfo = ar->FileExists("mapinfo.lua");
+	for (const std::string& warning: job.warnings) {
+		LOG_SL(LOG_SECTION_ARCHIVESCANNER, L_WARNING, "Archive %s: %s", fullName.c_str(), warning.c_str());
+	}
 
+	std::string& error = job.error;
+	std::string mapfile;
 
 	ArchiveInfo ai;
 	auto& ad = ai.archiveData;
-	if (hasMapinfo) {
-		ScanArchiveLua(ar.get(), "mapinfo.lua", ai, error);
+	if (job.hasMapinfo) {
+		if (error.empty())
+			ScanArchiveLua(job.infoData, "mapinfo.lua", ai, error);
 		if (ad.GetMapFile().empty()) {
 			LOG_L(L_WARNING, "%s: mapfile isn't set in mapinfo.lua, please set it for faster loading!", fullName.c_str());
-			mapfile = SearchMapFile(ar.get(), error);
+			mapfile = job.mapFile;
 		}
-	} else if (hasModinfo) {
-		ScanArchiveLua(ar.get(), "modinfo.lua", ai, error);
+	} else if (job.hasModinfo) {
+		if (error.empty())
+			ScanArchiveLua(job.infoData, "modinfo.lua", ai, error);
 	} else {
-		mapfile = SearchMapFile(ar.get(), error);
+		mapfile = job.mapFile;
 	}
-	CheckCompression(ar.get(), fullName, error);
 
 	if (!error.empty()) {
 		// for some reason, the archive is marked as broken
@@ -625,13 +747,14 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		// record it as broken, so we don't need to look inside everytime
 		BrokenArchive& ba = brokenArchives[lcfn];
 		ba.path = fpath;
-		ba.modified = info.st_mtime;
+		ba.modified = job.modified;
+		ba.size = job.size;
 		ba.updated = true;
 		ba.problem = error;
 		return;
 	}
 
-	if (hasMapinfo || !mapfile.empty()) {
+	if (job.hasMapinfo || !mapfile.empty()) {
 		// it is a map
 		if (ad.GetName().empty()) {
 			// FIXME The name will never be empty, if version is set (see HACK in ArchiveData)
@@ -646,7 +769,7 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 		ad.SetInfoItemValueInteger("modType", modtype::map);
 
 		LOG_S(LOG_SECTION_ARCHIVESCANNER, "Found new map: %s", ad.GetNameVersioned().c_str());
-	} else if (hasModinfo) {
+	} else if (job.hasModinfo) {
 		// it is a game
 		if (ad.GetModType() == modtype::primary) {
 			AddDependency(ad.GetDependencies(), "Spring content v1");
@@ -659,22 +782,17 @@ void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
 	}
 
 	ai.path = fpath;
-	ai.modified = info.st_mtime;
+	ai.modified = job.modified;
+	ai.size = job.size;
 	ai.origName = fn;
 	ai.updated = true;
-	ai.checksum = (doChecksum) ? GetCRC(fullName) : 0;
+	ai.checksum = job.checksum;
 	archiveInfos[lcfn] = ai;
 }
 
-bool CArchiveScanner::ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err)
+bool CArchiveScanner::ScanArchiveLua(const std::string& infoData, const std::string& fileName, ArchiveInfo& ai, std::string& err)
 {
-	std::vector<boost::uint8_t> buf;
-	if (!ar->GetFile(fileName, buf) || buf.empty()) {
-		err = "Error reading " + fileName + " from " + ar->GetArchiveName();
-		return false;
-	}
-
-	LuaParser p(std::string((char*)(&buf[0]), buf.size()), SPRING_VFS_MOD);
+	LuaParser p(infoData, SPRING_VFS_MOD);
 	if (!p.Execute()) {
 		err = "Error in " + fileName + ": " + p.GetErrorLog();
 		return false;
@@ -793,10 +911,173 @@ unsigned int CArchiveScanner::GetCRC(const std::string& arcName)
 	return digest;
 }
 
-void CArchiveScanner::ReadCacheData(const std::string& filename)
+namespace {
+	const boost::uint32_t CACHE_MAGIC = 0x43414153; // "SAAC"
+
+	class CacheWriter {
+	public:
+		void WriteInt(boost::uint32_t v) { WriteBytes(&v, sizeof(v)); }
+		void WriteInt64(boost::uint64_t v) { WriteBytes(&v, sizeof(v)); }
+		void WriteFloat(float v) { WriteBytes(&v, sizeof(v)); }
+		void WriteString(const std::string& str) {
+			WriteInt(str.size());
+			WriteBytes(str.data(), str.size());
+		}
+		void WriteStrings(const std::vector<std::string>& strs) {
+			WriteInt(strs.size());
+			for (const std::string& str: strs) {
+				WriteString(str);
+			}
+		}
+
+		const std::vector<boost::uint8_t>& GetBuffer() const { return buf; }
+
+	private:
+		void WriteBytes(const void* data, size_t size) {
+			const boost::uint8_t* bytes = reinterpret_cast<const boost::uint8_t*>(data);
+			buf.insert(buf.end(), bytes, bytes + size);
+		}
+
+	private:
+		std::vector<boost::uint8_t> buf;
+	};
+
+	/// reads from a memory block, all reads fail once the end was reached
+	class CacheReader {
+	public:
+		CacheReader(const boost::uint8_t* data, size_t size): cur(data), end(data + size), good(true) {}
+
+		boost::uint32_t ReadInt() { boost::uint32_t v = 0; ReadBytes(&v, sizeof(v)); return v; }
+		boost::uint64_t ReadInt64() { boost::uint64_t v = 0; ReadBytes(&v, sizeof(v)); return v; }
+		float ReadFloat() { float v = 0.0f; ReadBytes(&v, sizeof(v)); return v; }
+		std::string ReadString() {
+			const boost::uint32_t size = ReadInt();
+			if (!good || size > size_t(end - cur)) {
+				good = false;
+				return "";
+			}
+			const std::string str(reinterpret_cast<const char*>(cur), size);
+			cur += size;
+			return str;
+		}
+		void ReadStrings(std::vector<std::string>& strs) {
+			const boost::uint32_t count = ReadInt();
+			for (boost::uint32_t i = 0; i < count && good; ++i) {
+				strs.push_back(ReadString());
+			}
+		}
+
+		bool IsGood() const { return good; }
+		bool AtEnd() const { return (cur == end); }
+
+	private:
+		void ReadBytes(void* data, size_t size) {
+			if (!good || size > size_t(end - cur)) {
+				good = false;
+				return;
+			}
+			memcpy(data, cur, size);
+			cur += size;
+		}
+
+	private:
+		const boost::uint8_t* cur;
+		const boost::uint8_t* end;
+		bool good;
+	};
+}
+
+bool CArchiveScanner::ReadCacheData(const std::string& filename)
 {
 	if (!FileSystem::FileExists(filename)) {
 		LOG_L(L_INFO, "Archive cache doesn't exist: %s", filename.c_str());
+		return false;
+	}
+
+	CFileView view;
+	if (!view.Map(filename, 0, FileSystem::GetFileSize(filename))) {
+		LOG_L(L_ERROR, "Failed to read archive cache: %s", filename.c_str());
+		return false;
+	}
+
+	CacheReader reader(view.GetData(), view.GetSize());
+
+	// Do not load old version caches
+	if (reader.ReadInt() != CACHE_MAGIC || reader.ReadInt() != INTERNAL_VER) {
+		return false;
+	}
+
+	std::map<std::string, ArchiveInfo> infos;
+	std::map<std::string, BrokenArchive> broken;
+
+	const boost::uint32_t numArchives = reader.ReadInt();
+	for (boost::uint32_t i = 0; i < numArchives && reader.IsGood(); ++i) {
+		ArchiveInfo ai;
+		ai.origName = reader.ReadString();
+		ai.path     = reader.ReadString();
+		ai.replaced = reader.ReadString();
+		ai.modified = reader.ReadInt();
+		ai.size     = reader.ReadInt64();
+		ai.checksum = reader.ReadInt();
+		ai.updated = false;
+
+		ArchiveData& ad = ai.archiveData;
+		const boost::uint32_t numItems = reader.ReadInt();
+		for (boost::uint32_t j = 0; j < numItems && reader.IsGood(); ++j) {
+			const std::string key = reader.ReadString();
+
+			switch (reader.ReadInt()) {
+				case INFO_VALUE_TYPE_STRING: {
+					ad.SetInfoItemValueString(key, reader.ReadString());
+				} break;
+				case INFO_VALUE_TYPE_INTEGER: {
+					ad.SetInfoItemValueInteger(key, reader.ReadInt());
+				} break;
+				case INFO_VALUE_TYPE_FLOAT: {
+					ad.SetInfoItemValueFloat(key, reader.ReadFloat());
+				} break;
+				case INFO_VALUE_TYPE_BOOL: {
+					ad.SetInfoItemValueBool(key, reader.ReadInt() != 0);
+				} break;
+				default: {
+					return false;
+				}
+			}
+		}
+		reader.ReadStrings(ad.GetDependencies());
+		reader.ReadStrings(ad.GetReplaces());
+
+		infos[StringToLower(ai.origName)] = ai;
+	}
+
+	const boost::uint32_t numBroken = reader.ReadInt();
+	for (boost::uint32_t i = 0; i < numBroken && reader.IsGood(); ++i) {
+		const std::string name = reader.ReadString();
+
+		BrokenArchive& ba = broken[name];
+		ba.path = reader.ReadString();
+		ba.problem = reader.ReadString();
+		ba.modified = reader.ReadInt();
+		ba.size = reader.ReadInt64();
+		ba.updated = false;
+	}
+
+	// the end marker catches truncated files
+	if (reader.ReadInt() != CACHE_MAGIC || !reader.IsGood() || !reader.AtEnd()) {
+		LOG_L(L_ERROR, "Archive cache is corrupt: %s", filename.c_str());
+		return false;
+	}
+
+	archiveInfos.swap(infos);
+	brokenArchives.swap(broken);
+
+	isDirty = false;
+	return true;
+}
+
+void CArchiveScanner::ReadLuaCacheData(const std::string& filename)
+{
+	if (!FileSystem::FileExists(filename)) {
 		return;
 	}
 
@@ -808,8 +1089,8 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 	const LuaTable archiveCache = p.GetRoot();
 
 	// Do not load old version caches
-	const int ver = archiveCache.GetInt("internalVer", (INTERNAL_VER + 1));
-	if (ver != INTERNAL_VER) {
+	const int ver = archiveCache.GetInt("internalVer", (LUA_CACHE_VER + 1));
+	if (ver != LUA_CACHE_VER) {
 		return;
 	}
 
@@ -851,44 +1132,19 @@ void CArchiveScanner::ReadCacheData(const std::string& filename)
 		ba.problem = curArchive.GetString("problem", "unknown");
 	}
 
-	isDirty = false;
-}
-
-static inline void SafeStr(FILE* out, const char* prefix, const std::string& str)
-{
-	if (str.empty()) {
-		return;
-	}
-	if ( (str.find_first_of("\\\"") != std::string::npos) || (str.find_first_of("\n") != std::string::npos )) {
-		fprintf(out, "%s[[%s]],\n", prefix, str.c_str());
-	} else {
-		fprintf(out, "%s\"%s\",\n", prefix, str.c_str());
-	}
-}
-
-void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
-{
-	auto it = std::remove_if(deps.begin(), deps.end(), [&](const std::string& dep) { return (dep == exclude); });
-	deps.erase(it, deps.end());
+	// get the binary cache written
+	isDirty = true;
+	LOG_L(L_INFO, "Imported archive cache: %s", filename.c_str());
 }
 
 void CArchiveScanner::WriteCacheData(const std::string& filename)
 {
-	if (!isDirty) {
-		return;
-	}
-
-	FILE* out = fopen(filename.c_str(), "wt");
-	if (!out) {
-		LOG_L(L_ERROR, "Failed to write to \"%s\"!", filename.c_str());
-		return;
-	}
-
 	// First delete all outdated information
 	// TODO: this pattern should be moved into an utility function..
 	for (std::map<std::string, ArchiveInfo>::iterator i = archiveInfos.begin(); i != archiveInfos.end(); ) {
 		if (!i->second.updated) {
 			i = set_erase(archiveInfos, i);
+			isDirty = true;
 		} else {
 			++i;
 		}
@@ -896,93 +1152,105 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 	for (std::map<std::string, BrokenArchive>::iterator i = brokenArchives.begin(); i != brokenArchives.end(); ) {
 		if (!i->second.updated) {
 			i = set_erase(brokenArchives, i);
+			isDirty = true;
 		} else {
 			++i;
 		}
 	}
 
-	fprintf(out, "local archiveCache = {\n\n");
-	fprintf(out, "\tinternalver = %i,\n\n", INTERNAL_VER);
-	fprintf(out, "\tarchives = {  -- count = " _STPF_ "\n", archiveInfos.size());
-
-	std::map<std::string, ArchiveInfo>::const_iterator arcIt;
-	for (arcIt = archiveInfos.begin(); arcIt != archiveInfos.end(); ++arcIt) {
-		const ArchiveInfo& arcInfo = arcIt->second;
+	if (!isDirty) {
+		return;
+	}
 
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ",              arcInfo.origName);
-		SafeStr(out, "\t\t\tpath = ",              arcInfo.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", arcInfo.modified);
-		fprintf(out, "\t\t\tchecksum = \"%u\",\n", arcInfo.checksum);
-		SafeStr(out, "\t\t\treplaced = ",          arcInfo.replaced);
+	CacheWriter writer;
+	writer.WriteInt(CACHE_MAGIC);
+	writer.WriteInt(INTERNAL_VER);
+	writer.WriteInt(archiveInfos.size());
 
-		// mod info?
+	for (const auto& aii: archiveInfos) {
+		const ArchiveInfo& arcInfo = aii.second;
 		const ArchiveData& archData = arcInfo.archiveData;
-		if (!archData.GetName().empty()) {
-			fprintf(out, "\t\t\tarchivedata = {\n");
-
-			const std::map<std::string, InfoItem>& info = archData.GetInfo();
-			std::map<std::string, InfoItem>::const_iterator ii;
-			for (ii = info.begin(); ii != info.end(); ++ii) {
-				switch (ii->second.valueType) {
-					case INFO_VALUE_TYPE_STRING: {
-						SafeStr(out, std::string("\t\t\t\t" + ii->first + " = ").c_str(), ii->second.valueTypeString);
-					} break;
-					case INFO_VALUE_TYPE_INTEGER: {
-						fprintf(out, "\t\t\t\t%s = %d,\n", ii->first.c_str(), ii->second.value.typeInteger);
-					} break;
-					case INFO_VALUE_TYPE_FLOAT: {
-						fprintf(out, "\t\t\t\t%s = %f,\n", ii->first.c_str(), ii->second.value.typeFloat);
-					} break;
-					case INFO_VALUE_TYPE_BOOL: {
-						fprintf(out, "\t\t\t\t%s = %d,\n", ii->first.c_str(), (int)ii->second.value.typeBool);
-					} break;
-				}
-			}
 
-			std::vector<std::string> deps = archData.GetDependencies();
-			if (archData.GetModType() == modtype::map) {
-				FilterDep(deps, "Map Helper v1");
-			} else if (archData.GetModType() == modtype::primary) {
-				FilterDep(deps, "Spring content v1");
-			}
+		writer.WriteString(arcInfo.origName);
+		writer.WriteString(arcInfo.path);
+		writer.WriteString(arcInfo.replaced);
+		writer.WriteInt(arcInfo.modified);
+		writer.WriteInt64(arcInfo.size);
+		writer.WriteInt(arcInfo.checksum);
 
-			if (!deps.empty()) {
-				fprintf(out, "\t\t\t\tdepend = {\n");
-				for (unsigned d = 0; d < deps.size(); d++) {
-					SafeStr(out, "\t\t\t\t\t", deps[d]);
-				}
-				fprintf(out, "\t\t\t\t},\n");
+		const std::map<std::string, InfoItem>& info = archData.GetInfo();
+		writer.WriteInt(info.size());
+
+		for (const auto& ii: info) {
+			const InfoItem& item = ii.second;
+
+			writer.WriteString(item.key);
+			writer.WriteInt(item.valueType);
+
+			switch (item.valueType) {
+				case INFO_VALUE_TYPE_STRING: {
+					writer.WriteString(item.valueTypeString);
+				} break;
+				case INFO_VALUE_TYPE_INTEGER: {
+					writer.WriteInt(item.value.typeInteger);
+				} break;
+				case INFO_VALUE_TYPE_FLOAT: {
+					writer.WriteFloat(item.value.typeFloat);
+				} break;
+				case INFO_VALUE_TYPE_BOOL: {
+					writer.WriteInt(item.value.typeBool);
+				} break;
 			}
-			fprintf(out, "\t\t\t},\n");
 		}
 
-		fprintf(out, "\t\t},\n");
+		writer.WriteStrings(archData.GetDependencies());
+		writer.WriteStrings(archData.GetReplaces());
 	}
 
-	fprintf(out, "\t},\n\n"); // close 'archives'
+	writer.WriteInt(brokenArchives.size());
 
-	fprintf(out, "\tbrokenArchives = {  -- count = " _STPF_ "\n", brokenArchives.size());
+	for (const auto& bai: brokenArchives) {
+		const BrokenArchive& ba = bai.second;
 
-	std::map<std::string, BrokenArchive>::const_iterator bai;
-	for (bai = brokenArchives.begin(); bai != brokenArchives.end(); ++bai) {
-		const BrokenArchive& ba = bai->second;
+		writer.WriteString(bai.first);
+		writer.WriteString(ba.path);
+		writer.WriteString(ba.problem);
+		writer.WriteInt(ba.modified);
+		writer.WriteInt64(ba.size);
+	}
 
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ", bai->first);
-		SafeStr(out, "\t\t\tpath = ", ba.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", ba.modified);
-		SafeStr(out, "\t\t\tproblem = ", ba.problem);
-		fprintf(out, "\t\t},\n");
+	writer.WriteInt(CACHE_MAGIC);
+
+	// ReadCacheData maps the cache, so it must never be rewritten in place;
+	// write a copy next to it and rename that over the old file instead
+	const std::string tempFilename = filename + ".tmp";
+
+	FILE* out = fopen(tempFilename.c_str(), "wb");
+	if (!out) {
+		LOG_L(L_ERROR, "Failed to write to \"%s\"!", tempFilename.c_str());
+		return;
 	}
 
-	fprintf(out, "\t},\n"); // close 'brokenArchives'
+	const std::vector<boost::uint8_t>& buf = writer.GetBuffer();
+	const size_t written = fwrite(&buf[0], 1, buf.size(), out);
+
+	if ((fclose(out) == EOF) || (written != buf.size())) {
+		LOG_L(L_ERROR, "Failed to write to \"%s\"!", tempFilename.c_str());
+		FileSystem::Remove(tempFilename);
+		return;
+	}
 
-	fprintf(out, "}\n\n"); // close 'archiveCache'
-	fprintf(out, "return archiveCache\n");
+#ifdef _WIN32
+	// rename does not replace an existing file on Windows
+	if (FileSystem::FileExists(filename))
+		FileSystem::Remove(filename);
+#endif
 
-	if (fclose(out) == EOF)
-		LOG_L(L_ERROR, "Failed to write to \"%s\"!", filename.c_str());
+	if (rename(tempFilename.c_str(), filename.c_str()) != 0) {
+		LOG_L(L_ERROR, "Failed to rename \"%s\" to \"%s\"!", tempFilename.c_str(), filename.c_str());
+		FileSystem::Remove(tempFilename);
+		return;
+	}
 
 	isDirty = false;
 }
@@ -7,6 +7,7 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <boost/cstdint.hpp>
 #include "System/Info.h"
 
 class IArchive;
@@ -132,6 +133,7 @@ private:
 	{
 		ArchiveInfo()
 			: modified(0)
+			, size(0)
 			, checksum(0)
 			, updated(false)
 			{}
@@ -140,6 +142,7 @@ private:
 		std::string replaced;     ///< If not empty, use that archive instead
 		ArchiveData archiveData;
 		unsigned int modified;
+		boost::uint64_t size;     ///< 0 if unknown (imported from the old lua cache)
 		unsigned int checksum;
 		bool updated;
 	};
@@ -147,20 +150,65 @@ private:
 	{
 		BrokenArchive()
 			: modified(0)
+			, size(0)
 			, updated(false)
 			{}
 		std::string path;
 		unsigned int modified;
+		boost::uint64_t size;
 		bool updated;
 		std::string problem;
 	};
 
+	/**
+	 * An archive that has to be (re-)scanned, or only checksummed if its
+	 * cached info is still valid. The expensive part (opening the archive,
+	 * reading its meta-files, CRC) runs on the thread pool, the results are
+	 * merged in the order the archives were found.
+	 */
+	struct ScanJob
+	{
+		ScanJob()
+			: modified(0)
+			, size(0)
+			, checksum(0)
+			, doChecksum(false)
+			, checksumOnly(false)
+			, opened(false)
+			, hasModinfo(false)
+			, hasMapinfo(false)
+			{}
+		std::string fullName;
+		std::string infoData;     ///< content of mapinfo.lua or modinfo.lua
+		std::string mapFile;
+		std::string error;
+		std::vector<std::string> warnings;
+		unsigned int modified;
+		boost::uint64_t size;
+		unsigned int checksum;
+		bool doChecksum;
+		bool checksumOnly;
+		bool opened;
+		bool hasModinfo;
+		bool hasMapinfo;
+	};
+
 private:
 	void ScanDirs(const std::vector<std::string>& dirs, bool checksum = false);
 	void ScanDir(const std::string& curPath, std::list<std::string>* foundArchives);
 
+	/**
+	 * Checks <fullName> against the cache and the archives queued so far.
+	 * @return true if the archive needs to be looked at, <job> is set up then
+	 */
+	bool PrepareScanJob(const std::string& fullName, bool doChecksum, std::map<std::string, std::string>& queued, ScanJob& job);
+	/// opens the archive and reads its meta-files; thread-safe
+	void RunScanJob(ScanJob& job);
+	/// parses the meta-files and stores the result in archiveInfos or brokenArchives
+	void FinishScanJob(ScanJob& job);
+
 	/// scan mapinfo / modinfo lua files
-	bool ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err);
+	bool ScanArchiveLua(const std::string& infoData, const std::string& fileName, ArchiveInfo& ai, std::string& err);
 
 	/**
 	 * scan archive for map file
@@ -169,8 +217,11 @@ private:
 	std::string SearchMapFile(const IArchive* ar, std::string& error);
 
 
-	void ReadCacheData(const std::string& filename);
+	/// reads the binary cache, returns false if it is missing or outdated
+	bool ReadCacheData(const std::string& filename);
 	void WriteCacheData(const std::string& filename);
+	/// imports the lua-text cache written by older versions
+	void ReadLuaCacheData(const std::string& filename);
 
 	IFileFilter* CreateIgnoreFilter(IArchive* ar);
 
@@ -199,7 +250,7 @@ private:
 	 *         2 if the file is a second class meta-file
 	 */
 	static unsigned char GetMetaFileClass(const std::string& filePath);
-	static bool CheckCompression(const IArchive* ar,const std::string& fullName, std::string& error);
+	static bool CheckCompression(const IArchive* ar, std::string& error, std::vector<std::string>& warnings);
 
 private:
 	std::map<std::string, ArchiveInfo> archiveInfos;
@@ -2,6 +2,7 @@
 
 
 #include "DirArchive.h"
+#include "FileView.h"
 
 #include <assert.h>
 #include <fstream>
@@ -77,6 +78,20 @@ bool CDirArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 	}
 }
 
+bool CDirArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	assert(IsFileId(fid));
+
+	const std::string rawPath = dataDirsAccess.LocateFile(dirName + searchFiles[fid]);
+	const size_t fileSize = FileSystem::GetFileSize(rawPath);
+
+	// empty files can not be mapped, GetFile handles them (and missing ones)
+	if (fileSize > 0 && fileSize != size_t(-1) && view.Map(rawPath, 0, fileSize))
+		return true;
+
+	return IArchive::GetFileView(fid, view);
+}
+
 void CDirArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 {
 	assert(IsFileId(fid));
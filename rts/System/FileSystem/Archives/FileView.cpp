@@ -0,0 +1,110 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "FileView.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+#endif
+
+
+CFileView::CFileView()
+	: mapBase(NULL)
+	, mapSize(0)
+	, dataPtr(NULL)
+	, dataSize(0)
+{
+}
+
+CFileView::~CFileView()
+{
+	Release();
+}
+
+
+void CFileView::Release()
+{
+	if (mapBase != NULL) {
+	#ifdef _WIN32
+		UnmapViewOfFile(mapBase);
+	#else
+		munmap(mapBase, mapSize);
+	#endif
+	}
+
+	buffer.clear();
+
+	mapBase = NULL;
+	mapSize = 0;
+	dataPtr = NULL;
+	dataSize = 0;
+}
+
+
+void CFileView::Assign(std::vector<boost::uint8_t>& buf)
+{
+	Release();
+
+	buffer.swap(buf);
+
+	dataPtr = (buffer.empty())? NULL: &buffer[0];
+	dataSize = buffer.size();
+}
+
+
+bool CFileView::Map(const std::string& filePath, boost::uint64_t offset, boost::uint64_t size)
+{
+	Release();
+
+	if (size == 0 || size > boost::uint64_t(size_t(-1)))
+		return false;
+
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+
+	const boost::uint64_t mapOffset = offset - (offset % si.dwAllocationGranularity);
+	const size_t headSize = offset - mapOffset;
+
+	HANDLE file = CreateFile(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	// the mapping object and file handle can be closed right away, the view keeps them alive
+	HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+
+	if (mapping == NULL)
+		return false;
+
+	mapBase = MapViewOfFile(mapping, FILE_MAP_READ, DWORD(mapOffset >> 32), DWORD(mapOffset & 0xFFFFFFFF), headSize + size);
+	CloseHandle(mapping);
+#else
+	const boost::uint64_t pageSize = sysconf(_SC_PAGESIZE);
+	const boost::uint64_t mapOffset = offset - (offset % pageSize);
+	const size_t headSize = offset - mapOffset;
+
+	const int fd = open(filePath.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	mapBase = mmap(NULL, headSize + size, PROT_READ, MAP_PRIVATE, fd, mapOffset);
+	close(fd);
+
+	if (mapBase == MAP_FAILED)
+		mapBase = NULL;
+#endif
+
+	if (mapBase == NULL)
+		return false;
+
+	mapSize = headSize + size;
+	dataPtr = reinterpret_cast<const boost::uint8_t*>(mapBase) + headSize;
+	dataSize = size;
+	return true;
+}
@@ -0,0 +1,57 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _FILE_VIEW_H
+#define _FILE_VIEW_H
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+/**
+ * @brief Read-only view on the content of a (VFS) file
+ *
+ * Either maps a byte-range of a file on disk directly into memory
+ * (directory archives, entries stored uncompressed in zip archives)
+ * or owns a copy of the content for everything else. Unlike the
+ * buffers filled by IArchive::GetFile, a mapped view does not count
+ * towards the heap and its pages are only read when touched.
+ * A view stays valid after the archive which created it is closed.
+ */
+class CFileView : boost::noncopyable
+{
+public:
+	CFileView();
+	~CFileView();
+
+	/**
+	 * Maps <size> bytes starting at <offset> of the file at (absolute)
+	 * <filePath> read-only into memory, replacing the previous content.
+	 * @return false if the range could not be mapped, the view is empty then
+	 */
+	bool Map(const std::string& filePath, boost::uint64_t offset, boost::uint64_t size);
+	/**
+	 * Takes over the content of <buffer> (which is left empty),
+	 * used when the data can not be mapped
+	 */
+	void Assign(std::vector<boost::uint8_t>& buffer);
+	void Release();
+
+	bool IsMapped() const { return (mapBase != NULL); }
+	bool Empty() const { return (dataSize == 0); }
+
+	const boost::uint8_t* GetData() const { return dataPtr; }
+	size_t GetSize() const { return dataSize; }
+
+private:
+	std::vector<boost::uint8_t> buffer;
+
+	/// page-aligned start and length of the mapping (if any)
+	void* mapBase;
+	size_t mapSize;
+
+	const boost::uint8_t* dataPtr;
+	size_t dataSize;
+};
+
+#endif // _FILE_VIEW_H
@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "IArchive.h"
+#include "FileView.h"
 
 #include "System/CRC.h"
 #include "System/Util.h"
@@ -63,3 +64,24 @@ bool IArchive::GetFile(const std::string& name, std::vector<boost::uint8_t>& buf
 
 	return found;
 }
+
+bool IArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	std::vector<boost::uint8_t> buffer;
+
+	if (!GetFile(fid, buffer))
+		return false;
+
+	view.Assign(buffer);
+	return true;
+}
+
+bool IArchive::GetFileView(const std::string& name, CFileView& view)
+{
+	const unsigned int fid = FindFile(name);
+
+	if (fid >= NumFiles())
+		return false;
+
+	return GetFileView(fid, view);
+}
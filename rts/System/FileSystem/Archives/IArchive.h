@@ -8,6 +8,8 @@
 #include <map>
 #include <boost/cstdint.hpp>
 
+class CFileView;
+
 /**
  * @brief Abstraction of different archive types
  *
@@ -72,6 +74,21 @@ public:
 	 * @see GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 	 */
 	bool GetFile(const std::string& name, std::vector<boost::uint8_t>& buffer);
+	/**
+	 * Provides read-only access to the content of a file by its ID
+	 * without copying it where possible: archives which store the file
+	 * uncompressed map it into memory, the default implementation
+	 * falls back to GetFile.
+	 * @param fid file ID in [0, NumFiles())
+	 * @param view on success, this will provide the file contents
+	 * @return true if the file was found and view has been populated
+	 */
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
+	/**
+	 * Provides read-only access to the content of a file by its name.
+	 * @see GetFileView(unsigned int fid, CFileView& view)
+	 */
+	bool GetFileView(const std::string& name, CFileView& view);
 	/**
 	 * Fetches the name and size in bytes of a file by its ID.
 	 */
@@ -108,11 +108,26 @@ const char* CSevenZipArchive::GetErrorStr(int err)
 }
 
 
+CSevenZipArchive::SolidBlock::SolidBlock(const CSevenZipArchive* archive, UInt32 index, size_t unpackedSize)
+	: archive(archive)
+	, folderIndex(index)
+	, unpackedSize(unpackedSize)
+	, lastUse(0)
+	, data(NULL)
+	, size(0)
+	, decoded(false)
+	, valid(false)
+{
+}
+
+CSevenZipArchive::SolidBlock::~SolidBlock()
+{
+	SzFree(NULL, data);
+}
+
+
 CSevenZipArchive::CSevenZipArchive(const std::string& name):
-	CBufferedArchive(name, false),
-	blockIndex(0xFFFFFFFF),
-	outBuffer(NULL),
-	outBufferSize(0),
+	IArchive(name),
 	tempBuf(NULL),
 	tempBufSize(0),
 	isOpen(false)
@@ -124,28 +139,22 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 
 	SzArEx_Init(&db);
 
-	WRes wres = InFile_Open(&archiveStream.file, name.c_str());
-	if (wres) {
-		boost::system::error_code e(wres, boost::system::get_system_category());
-		LOG_L(L_ERROR, "Error opening \"%s\": %s (%i)",
-				name.c_str(), e.message().c_str(), e.value());
+	ArchiveStream* stream = OpenStream();
+	if (stream == NULL) {
 		return;
 	}
 
-	FileInStream_CreateVTable(&archiveStream);
-	LookToRead_CreateVTable(&lookStream, False);
-
-	lookStream.realStream = &archiveStream.s;
-	LookToRead_Init(&lookStream);
-
 	CrcGenerateTable();
 
-	SRes res = SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp);
+	SRes res = SzArEx_Open(&db, &stream->lookStream.s, &allocImp, &allocTempImp);
 	if (res == SZ_OK) {
 		isOpen = true;
+		freeStreams.push_back(stream);
 	} else {
 		isOpen = false;
 		LOG_L(L_ERROR, "Error opening \"%s\": %s", name.c_str(), GetErrorStr(res));
+		File_Close(&stream->archiveStream.file);
+		delete stream;
 		return;
 	}
 
@@ -156,6 +165,18 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 		folderUnpackSizes[fi] = SzFolder_GetUnpackSize(db.db.Folders + fi);
 	}
 
+	// the files of a solid block are stored back-to-back in file-index order
+	std::vector<UInt64> fileOffsets(db.db.NumFiles, 0);
+	std::vector<UInt64> folderOffsets(db.db.NumFolders, 0);
+	for (unsigned int i = 0; i < db.db.NumFiles; ++i) {
+		const UInt32 folderIndex = db.FileIndexToFolderIndexMap[i];
+		if (folderIndex == ((UInt32)-1))
+			continue;
+
+		fileOffsets[i] = folderOffsets[folderIndex];
+		folderOffsets[folderIndex] += db.db.Files[i].Size;
+	}
+
 	// Get contents of archive and store name->int mapping
 	for (unsigned int i = 0; i < db.db.NumFiles; ++i) {
 		CSzFileItem* f = db.db.Files + i;
@@ -177,8 +198,11 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 			fd.fp = i;
 			fd.size = f->Size;
 			fd.crc = (f->Size > 0) ? f->Crc: 0;
+			fd.crcDefined = f->CrcDefined;
 
 			const UInt32 folderIndex = db.FileIndexToFolderIndexMap[i];
+			fd.folderIndex = folderIndex;
+			fd.offset = fileOffsets[i];
 			if (folderIndex == ((UInt32)-1)) {
 				// file has no folder assigned
 				fd.unpackedSize = f->Size;
@@ -200,11 +224,25 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name):
 
 CSevenZipArchive::~CSevenZipArchive()
 {
-	if (outBuffer) {
-		IAlloc_Free(&allocImp, outBuffer);
+	// no reader may be active anymore, so all streams are free
+	for (ArchiveStream* stream: freeStreams) {
+		File_Close(&stream->archiveStream.file);
+		delete stream;
 	}
-	if (isOpen) {
-		File_Close(&archiveStream.file);
+	{
+		BlockCache& cache = GetBlockCache();
+		boost::mutex::scoped_lock lck(cache.lock);
+
+		for (size_t i = 0; i < cache.blocks.size(); ) {
+			if (cache.blocks[i]->archive != this) {
+				++i;
+				continue;
+			}
+
+			cache.size -= cache.blocks[i]->unpackedSize;
+			cache.blocks[i] = cache.blocks.back();
+			cache.blocks.pop_back();
+		}
 	}
 	SzArEx_Free(&db, &allocImp);
 	SzFree(NULL, tempBuf);
@@ -212,6 +250,48 @@ CSevenZipArchive::~CSevenZipArchive()
 	tempBufSize = 0;
 }
 
+CSevenZipArchive::ArchiveStream* CSevenZipArchive::OpenStream()
+{
+	ArchiveStream* stream = new ArchiveStream();
+
+	WRes wres = InFile_Open(&stream->archiveStream.file, GetArchiveName().c_str());
+	if (wres) {
+		boost::system::error_code e(wres, boost::system::get_system_category());
+		LOG_L(L_ERROR, "Error opening \"%s\": %s (%i)",
+				GetArchiveName().c_str(), e.message().c_str(), e.value());
+		delete stream;
+		return NULL;
+	}
+
+	FileInStream_CreateVTable(&stream->archiveStream);
+	LookToRead_CreateVTable(&stream->lookStream, False);
+
+	stream->lookStream.realStream = &stream->archiveStream.s;
+	LookToRead_Init(&stream->lookStream);
+	return stream;
+}
+
+CSevenZipArchive::ArchiveStream* CSevenZipArchive::AcquireStream()
+{
+	{
+		boost::mutex::scoped_lock lck(streamLock);
+
+		if (!freeStreams.empty()) {
+			ArchiveStream* stream = freeStreams.back();
+			freeStreams.pop_back();
+			return stream;
+		}
+	}
+
+	return OpenStream();
+}
+
+void CSevenZipArchive::ReleaseStream(ArchiveStream* stream)
+{
+	boost::mutex::scoped_lock lck(streamLock);
+	freeStreams.push_back(stream);
+}
+
 bool CSevenZipArchive::IsOpen()
 {
 	return isOpen;
@@ -222,23 +302,126 @@ unsigned int CSevenZipArchive::NumFiles() const
 	return fileData.size();
 }
 
-bool CSevenZipArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+CSevenZipArchive::BlockCache& CSevenZipArchive::GetBlockCache()
 {
-	assert(IsFileId(fid));
-	
-	// Get 7zip to decompress it
+	// intentionally leaked, archives may still be closed during static destruction
+	static BlockCache* cache = new BlockCache();
+	return *cache;
+}
+
+boost::shared_ptr<CSevenZipArchive::SolidBlock> CSevenZipArchive::GetSolidBlock(const FileData& fd)
+{
+	BlockCache& cache = GetBlockCache();
+	boost::mutex::scoped_lock lck(cache.lock);
+
+	for (auto it = cache.blocks.begin(); it != cache.blocks.end(); ++it) {
+		const boost::shared_ptr<SolidBlock>& block = *it;
+
+		if (block->archive != this || block->folderIndex != fd.folderIndex)
+			continue;
+
+		// a failed decode is retried by the next reader
+		// (a block being decoded right now holds its decodeLock)
+		bool failed = false;
+		{
+			boost::mutex::scoped_try_lock blockLck(block->decodeLock);
+			failed = (blockLck.owns_lock() && block->decoded && !block->valid);
+		}
+		if (failed) {
+			cache.size -= block->unpackedSize;
+			cache.blocks.erase(it);
+			break;
+		}
+
+		block->lastUse = ++cache.tick;
+		return block;
+	}
+
+	// drop the least recently used blocks (of any archive),
+	// readers still holding one keep it alive
+	while (!cache.blocks.empty() && (cache.size + fd.unpackedSize) > MAX_BLOCK_CACHE_SIZE) {
+		auto lru = cache.blocks.begin();
+		for (auto it = cache.blocks.begin(); it != cache.blocks.end(); ++it) {
+			if ((*it)->lastUse < (*lru)->lastUse) {
+				lru = it;
+			}
+		}
+
+		cache.size -= (*lru)->unpackedSize;
+		cache.blocks.erase(lru);
+	}
+
+	boost::shared_ptr<SolidBlock> block(new SolidBlock(this, fd.folderIndex, fd.unpackedSize));
+	block->lastUse = ++cache.tick;
+
+	cache.blocks.push_back(block);
+	cache.size += fd.unpackedSize;
+	return block;
+}
+
+void CSevenZipArchive::DecodeSolidBlock(const FileData& fd, SolidBlock& block)
+{
+	ArchiveStream* stream = AcquireStream();
+
+	block.decoded = true;
+	block.valid = false;
+
+	if (stream == NULL) {
+		return;
+	}
+
+	// extracting any file of a block unpacks the whole block into block.data
+	UInt32 blockIndex = 0xFFFFFFFF;
 	size_t offset;
 	size_t outSizeProcessed;
-	SRes res;
+	SRes res = SzArEx_Extract(&db, &stream->lookStream.s, fd.fp, &blockIndex, &block.data, &block.size, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
 
-	res = SzArEx_Extract(&db, &lookStream.s, fileData[fid].fp, &blockIndex, &outBuffer, &outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
-	if (res == SZ_OK) {
-		buffer.resize(outSizeProcessed);
-		memcpy(&buffer[0], (char*)outBuffer+offset, outSizeProcessed);
+	ReleaseStream(stream);
+
+	if (res != SZ_OK) {
+		LOG_L(L_ERROR, "Error extracting \"%s\" from \"%s\": %s", fd.origName.c_str(), GetArchiveName().c_str(), GetErrorStr(res));
+		return;
+	}
+
+	assert(offset == fd.offset);
+	block.valid = true;
+}
+
+bool CSevenZipArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+{
+	assert(IsFileId(fid));
+	const FileData& fd = fileData[fid];
+
+	if (fd.folderIndex == ((UInt32)-1)) {
+		// empty file
+		buffer.clear();
 		return true;
-	} else {
+	}
+
+	const boost::shared_ptr<SolidBlock> block = GetSolidBlock(fd);
+
+	{
+		// readers of other blocks are not blocked by this
+		boost::mutex::scoped_lock lck(block->decodeLock);
+
+		if (!block->decoded) {
+			DecodeSolidBlock(fd, *block);
+		}
+	}
+
+	if (!block->valid || (fd.offset + fd.size) > block->size) {
 		return false;
 	}
+
+	const Byte* fileStart = block->data + fd.offset;
+
+	if (fd.crcDefined && CrcCalc(fileStart, fd.size) != fd.crc) {
+		LOG_L(L_ERROR, "Error extracting \"%s\" from \"%s\": %s", fd.origName.c_str(), GetArchiveName().c_str(), GetErrorStr(SZ_ERROR_CRC));
+		return false;
+	}
+
+	buffer.assign(fileStart, fileStart + fd.size);
+	return true;
 }
 
 void CSevenZipArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
@@ -249,6 +432,7 @@ void CSevenZipArchive::FileInfo(unsigned int fid, std::string& name, int& size)
 }
 
 
+const size_t CSevenZipArchive::MAX_BLOCK_CACHE_SIZE = 64 * 1024 * 1024;
 const size_t CSevenZipArchive::COST_LIMIT_UNPACK_OVERSIZE = 32 * 1024;
 const size_t CSevenZipArchive::COST_LIMIT_DISC_READ       = 32 * 1024;
 
@@ -9,9 +9,10 @@ extern "C" {
 }
 
 #include "ArchiveFactory.h"
-#include "BufferedArchive.h"
 #include <vector>
 #include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include "IArchive.h"
 
 /**
@@ -29,8 +30,13 @@ private:
 
 /**
  * An LZMA/7zip compressed, single-file archive.
+ *
+ * Solid blocks are decompressed as a whole and kept in a small LRU cache
+ * shared by all open archives, so all files of a block are served by a
+ * single decode. Different blocks
+ * can be decoded concurrently, each reader uses its own file handle.
  */
-class CSevenZipArchive : public CBufferedArchive
+class CSevenZipArchive : public IArchive
 {
 public:
 	CSevenZipArchive(const std::string& name);
@@ -39,15 +45,19 @@ public:
 	virtual bool IsOpen();
 	
 	virtual unsigned int NumFiles() const;
-	virtual bool GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
 	virtual void FileInfo(unsigned int fid, std::string& name, int& size) const;
 	virtual bool HasLowReadingCost(unsigned int fid) const;
 	virtual unsigned GetCrc32(unsigned int fid);
 
 private:
-	UInt32 blockIndex;
-	Byte* outBuffer;
-	size_t outBufferSize;
+	/**
+	 * Unpacked data of the decoded solid blocks of all archives is kept
+	 * up to this size, the least recently used blocks are dropped first.
+	 * A single block larger than this is still cached (alone).
+	 * The budget is global because VFS archives stay open all session.
+	 */
+	static const size_t MAX_BLOCK_CACHE_SIZE;
 
 	/**
 	 * How much more unpacked data may be allowed in a solid block,
@@ -68,6 +78,11 @@ private:
 	struct FileData
 	{
 		int fp;
+		/// solid block containing the file, (UInt32)-1 for empty files
+		UInt32 folderIndex;
+		/// position of the file in the unpacked solid block
+		size_t offset;
+		bool crcDefined;
 		/**
 		 * Real/unpacked size of the file in bytes.
 		 * @see #unpackedSize
@@ -94,19 +109,66 @@ private:
 		 */
 		int packedSize;
 	};
+	struct SolidBlock
+	{
+		SolidBlock(const CSevenZipArchive* archive, UInt32 index, size_t unpackedSize);
+		~SolidBlock();
+
+		boost::mutex decodeLock;
+
+		const CSevenZipArchive* archive;
+		UInt32 folderIndex;
+		size_t unpackedSize;
+		unsigned int lastUse;
+
+		Byte* data;
+		size_t size;
+		/// both only change under decodeLock
+		bool decoded;
+		bool valid;
+	};
+
+	/// decoded solid blocks of all archives, see MAX_BLOCK_CACHE_SIZE
+	struct BlockCache
+	{
+		BlockCache(): size(0), tick(0) {}
+
+		boost::mutex lock;
+		std::vector< boost::shared_ptr<SolidBlock> > blocks;
+		size_t size;
+		unsigned int tick;
+	};
+
+	/// the 7z streams keep a read position, so every concurrent reader needs its own
+	struct ArchiveStream
+	{
+		CFileInStream archiveStream;
+		CLookToRead lookStream;
+	};
+
 	int GetFileName(const CSzArEx* db, int i);
 	const char* GetErrorStr(int res);
 
+	ArchiveStream* OpenStream();
+	ArchiveStream* AcquireStream();
+	void ReleaseStream(ArchiveStream* stream);
+
+	static BlockCache& GetBlockCache();
+
+	boost::shared_ptr<SolidBlock> GetSolidBlock(const FileData& fd);
+	void DecodeSolidBlock(const FileData& fd, SolidBlock& block);
+
 	std::vector<FileData> fileData;
 	UInt16 *tempBuf;
 	size_t tempBufSize;
 
-	CFileInStream archiveStream;
 	CSzArEx db;
-	CLookToRead lookStream;
 	ISzAlloc allocImp;
 	ISzAlloc allocTempImp;
 
+	boost::mutex streamLock; // guards freeStreams
+	std::vector<ArchiveStream*> freeStreams;
+
 	bool isOpen;
 };
 
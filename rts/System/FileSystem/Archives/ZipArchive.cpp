@@ -2,6 +2,7 @@
 
 
 #include "ZipArchive.h"
+#include "FileView.h"
 
 #include <algorithm>
 #include <stdexcept>
@@ -127,3 +128,40 @@ bool CZipArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buf
 
 	return ret;
 }
+
+// Entries which are stored (not deflated) and not encrypted are mapped
+// straight from the archive file, everything else gets decompressed
+bool CZipArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	if (!zip) {
+		return false;
+	}
+	assert(IsFileId(fid));
+
+	boost::uint64_t dataOffset = 0;
+	boost::uint64_t dataSize = 0;
+
+	{
+		boost::mutex::scoped_lock lck(archiveLock);
+
+		unzGoToFilePos(zip, &fileData[fid].fp);
+
+		unz_file_info fi;
+		unzGetCurrentFileInfo(zip, &fi, NULL, 0, NULL, 0, NULL, 0);
+
+		int method = 0;
+		int level = 0;
+
+		// raw mode: only parses the local header, no inflate state is set up
+		if (fi.compression_method == 0 && (fi.flag & 1) == 0 && unzOpenCurrentFile2(zip, &method, &level, 1) == UNZ_OK) {
+			dataOffset = unzGetCurrentFileZStreamPos64(zip);
+			dataSize = fi.uncompressed_size;
+			unzCloseCurrentFile(zip);
+		}
+	}
+
+	if (dataSize > 0 && view.Map(GetArchiveName(), dataOffset, dataSize))
+		return true;
+
+	return IArchive::GetFileView(fid, view);
+}
@@ -29,15 +29,21 @@ using std::string;
 /******************************************************************************/
 /******************************************************************************/
 
+CFileHandler::CFileHandler()
+	: filePos(0), fileSize(-1), useFileView(false)
+{
+}
+
+
 CFileHandler::CFileHandler(const char* fileName, const char* modes)
-	: filePos(0), fileSize(-1)
+	: filePos(0), fileSize(-1), useFileView(false)
 {
 	Open(fileName, modes);
 }
 
 
 CFileHandler::CFileHandler(const string& fileName, const string& modes)
-	: filePos(0), fileSize(-1)
+	: filePos(0), fileSize(-1), useFileView(false)
 {
 	Open(fileName, modes);
 }
@@ -76,6 +82,17 @@ bool CFileHandler::TryReadFromRawFS(const string& fileName)
 {
 #ifndef TOOLS
 	const string rawpath = dataDirsAccess.LocateFile(fileName);
+
+	if (useFileView) {
+		const size_t rawSize = FileSystem::GetFileSize(rawpath);
+
+		// empty files can not be mapped, fall through to the stream
+		if (rawSize > 0 && rawSize != size_t(-1) && fileView.Map(rawpath, 0, rawSize)) {
+			fileSize = rawSize;
+			return true;
+		}
+	}
+
 	ifs.open(rawpath.c_str(), std::ios::in | std::ios::binary);
 	if (ifs && !ifs.bad() && ifs.is_open()) {
 		ifs.seekg(0, std::ios_base::end);
@@ -97,6 +114,15 @@ bool CFileHandler::TryReadFromModFS(const string& fileName)
 	}
 
 	const string file = StringToLower(fileName);
+
+	if (useFileView) {
+		if (!vfsHandler->LoadFileView(file, fileView))
+			return false;
+
+		fileSize = fileView.GetSize();
+		return true;
+	}
+
 	if (vfsHandler->LoadFile(file, fileBuffer)) {
 		// did we allocated more mem than needed
 		// (e.g. because of incorrect usage of std::vector)?
@@ -137,6 +163,27 @@ void CFileHandler::Open(const string& fileName, const string& modes)
 }
 
 
+void CFileHandler::OpenView(const string& fileName, const string& modes)
+{
+	useFileView = true;
+	Open(fileName, modes);
+}
+
+
+const boost::uint8_t* CFileHandler::GetData(int pos) const
+{
+	if (pos < 0 || pos >= fileSize)
+		return NULL;
+
+	if (!fileView.Empty())
+		return (fileView.GetData() + pos);
+	if (!fileBuffer.empty())
+		return (&fileBuffer[0] + pos);
+
+	return NULL;
+}
+
+
 /******************************************************************************/
 
 bool CFileHandler::FileExists(const std::string& filePath, const std::string& modes)
@@ -184,13 +231,12 @@ int CFileHandler::Read(void* buf, int length)
 		ifs.read(static_cast<char*>(buf), length);
 		return ifs.gcount();
 	}
-	else if (!fileBuffer.empty()) {
+	else if (!fileBuffer.empty() || !fileView.Empty()) {
 		if ((length + filePos) > fileSize) {
 			length = fileSize - filePos;
 		}
 		if (length > 0) {
-			assert(fileBuffer.size() >= (filePos + length));
-			memcpy(buf, &fileBuffer[filePos], length);
+			memcpy(buf, GetData(filePos), length);
 			filePos += length;
 		}
 		return length;
@@ -226,7 +272,7 @@ void CFileHandler::Seek(int length, std::ios_base::seekdir where)
 		ifs.clear();
 		ifs.seekg(length, where);
 	}
-	else if (!fileBuffer.empty())
+	else if (!fileBuffer.empty() || !fileView.Empty())
 	{
 		if (where == std::ios_base::beg)
 		{
@@ -248,7 +294,7 @@ bool CFileHandler::Eof() const
 	if (ifs.is_open()) {
 		return ifs.eof();
 	}
-	if (!fileBuffer.empty()) {
+	if (!fileBuffer.empty() || !fileView.Empty()) {
 		return (filePos >= fileSize);
 	}
 	return true;
@@ -10,6 +10,7 @@
 #include <boost/cstdint.hpp>
 
 #include "VFSModes.h"
+#include "Archives/FileView.h"
 
 /**
  * This is for direct VFS file content access.
@@ -23,11 +24,20 @@
 class CFileHandler
 {
 public:
+	/// creates a closed handler, call Open or OpenView before use
+	CFileHandler();
 	CFileHandler(const char* fileName, const char* modes = SPRING_VFS_RAW_FIRST);
 	CFileHandler(const std::string& fileName, const std::string& modes = SPRING_VFS_RAW_FIRST);
 	~CFileHandler();
 
 	void Open(const std::string& fileName, const std::string& modes = SPRING_VFS_RAW_FIRST);
+	/**
+	 * Same as Open, but files stored uncompressed (raw files, files in
+	 * directory archives and stored zip entries) are memory-mapped
+	 * instead of being copied into an internal buffer.
+	 * The content can then be accessed in-place through GetData.
+	 */
+	void OpenView(const std::string& fileName, const std::string& modes = SPRING_VFS_RAW_FIRST);
 
 	int Read(void* buf, int length);
 	int ReadString(void* buf, int length); //< stops after the first 0 char
@@ -40,6 +50,14 @@ public:
 	int GetPos();
 	int FileSize() const;
 
+	/**
+	 * @return read-only pointer to the file content at <pos> if it is
+	 *   held in memory (always the case after OpenView), NULL otherwise
+	 */
+	const boost::uint8_t* GetData(int pos = 0) const;
+	/// @return true if the content is memory-mapped (see OpenView)
+	bool IsMapped() const { return fileView.IsMapped(); }
+
 	bool LoadStringData(std::string& data);
 	std::string GetFileExt() const;
 
@@ -73,8 +91,10 @@ private:
 	std::string fileName;
 	std::ifstream ifs;
 	std::vector<boost::uint8_t> fileBuffer;
+	CFileView fileView;
 	int filePos;
 	int fileSize;
+	bool useFileView;
 };
 
 #endif // _FILE_HANDLER_H
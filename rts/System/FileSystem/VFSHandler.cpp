@@ -175,6 +175,26 @@ bool CVFSHandler::LoadFile(const std::string& filePath, std::vector<boost::uint8
 	return true;
 }
 
+bool CVFSHandler::LoadFileView(const std::string& filePath, CFileView& view)
+{
+	LOG_L(L_DEBUG, "LoadFileView(filePath = \"%s\", )", filePath.c_str());
+
+	const std::string normalizedPath = GetNormalizedPath(filePath);
+
+	const FileData* fileData = GetFileData(normalizedPath);
+	if (fileData == NULL) {
+		LOG_L(L_DEBUG, "LoadFileView: File '%s' does not exist in VFS.", filePath.c_str());
+		return false;
+	}
+
+	if (!fileData->ar->GetFileView(normalizedPath, view))
+	{
+		LOG_L(L_DEBUG, "LoadFileView: File '%s' does not exist in archive.", filePath.c_str());
+		return false;
+	}
+	return true;
+}
+
 bool CVFSHandler::FileExists(const std::string& filePath)
 {
 	LOG_L(L_DEBUG, "FileExists(filePath = \"%s\", )", filePath.c_str());
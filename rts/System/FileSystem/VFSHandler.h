@@ -9,6 +9,7 @@
 #include <boost/cstdint.hpp>
 
 class IArchive;
+class CFileView;
 
 /**
  * Main API for accessing the Virtual File System (VFS).
@@ -37,6 +38,15 @@ public:
 	 * @return true if the file exists in the VFS and was successfully read
 	 */
 	bool LoadFile(const std::string& filePath, std::vector<boost::uint8_t>& buffer);
+	/**
+	 * Provides read-only access to the contents of a file from within the
+	 * VFS, memory-mapping it if its archive stores it uncompressed.
+	 * @param filePath raw file path, for example "maps/myMap.smf",
+	 *   case-insensitive
+	 * @return true if the file exists in the VFS and view was populated
+	 * @see IArchive::GetFileView
+	 */
+	bool LoadFileView(const std::string& filePath, CFileView& view);
 
 	/**
 	 * Returns all the files in the given (virtual) directory without the
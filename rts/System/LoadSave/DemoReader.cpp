@@ -12,14 +12,20 @@ CONFIG(bool, DisableDemoVersionCheck).defaultValue(false).description("Allow to
 #include "System/Net/RawPacket.h"
 #include "Game/GameVersion.h"
 
+#include <algorithm>
 #include <limits.h>
 #include <stdexcept>
 #include <cassert>
 #include <cstring>
 
+#include <zlib.h>
+
 
 CDemoReader::CDemoReader(const std::string& filename, float curTime)
 	: playbackDemo(NULL)
+	, inflateStream(NULL)
+	, inflatedPos(0)
+	, inflateEof(false)
 {
 	playbackDemo = new CFileHandler(filename, SPRING_VFS_PWD_ALL);
 
@@ -28,7 +34,26 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime)
 		throw user_error(std::string("Demofile not found: ")+filename);
 	}
 
-	playbackDemo->Read((char*)&fileHeader, sizeof(fileHeader));
+	{
+		unsigned char magic[2] = {0, 0};
+
+		playbackDemo->Read(magic, sizeof(magic));
+		playbackDemo->Seek(0);
+
+		// gzip-compressed demo
+		if (magic[0] == 0x1f && magic[1] == 0x8b) {
+			inflateStream = new z_stream();
+			inflateBuffer.resize(64 * 1024);
+
+			if (inflateInit2(inflateStream, 15 + 16) != Z_OK) {
+				delete inflateStream;
+				inflateStream = NULL;
+				throw std::runtime_error(std::string("Demofile ") + filename + " could not be decompressed.");
+			}
+		}
+	}
+
+	ReadDemo((char*)&fileHeader, sizeof(fileHeader));
 	fileHeader.swab();
 
 	if (memcmp(fileHeader.magic, DEMOFILE_MAGIC, sizeof(fileHeader.magic))
@@ -53,20 +78,26 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime)
 
 	if (fileHeader.scriptSize != 0) {
 		char* buf = new char[fileHeader.scriptSize];
-		playbackDemo->Read(buf, fileHeader.scriptSize);
+		ReadDemo(buf, fileHeader.scriptSize);
 		setupScript = std::string(buf, fileHeader.scriptSize);
 		delete[] buf;
 	}
 
-	playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader));
+	ReadDemo((char*)&chunkHeader, sizeof(chunkHeader));
 	chunkHeader.swab();
 
 	demoTimeOffset = curTime - chunkHeader.modGameTime - 0.1f;
 	nextDemoReadTime = curTime - 0.01f;
 
-	long curPos = playbackDemo->GetPos();
-	playbackDemo->Seek(0, std::ios::end);
-	playbackDemoSize = playbackDemo->GetPos();
+	long curPos = GetDemoPos();
+	if (inflateStream != NULL) {
+		// the decompressed size is not known in advance, read until the end of the stream
+		playbackDemoSize = INT_MAX;
+	} else {
+		playbackDemo->Seek(0, std::ios::end);
+		playbackDemoSize = playbackDemo->GetPos();
+		playbackDemo->Seek(curPos);
+	}
 	if (fileHeader.demoStreamSize != 0) {
 		bytesRemaining = fileHeader.demoStreamSize;
 	}
@@ -77,16 +108,103 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime)
 		// (if this had still used CFileHandler that would have been easier ;-))
 		bytesRemaining = playbackDemoSize - curPos;
 	}
-	playbackDemo->Seek(curPos);
 }
 
 
 CDemoReader::~CDemoReader()
 {
+	if (inflateStream != NULL) {
+		inflateEnd(inflateStream);
+		delete inflateStream;
+	}
+
 	delete playbackDemo;
 }
 
 
+int CDemoReader::ReadDemo(void* buf, int length)
+{
+	if (inflateStream == NULL)
+		return (playbackDemo->Read(buf, length));
+
+	inflateStream->next_out = reinterpret_cast<Bytef*>(buf);
+	inflateStream->avail_out = length;
+
+	while (inflateStream->avail_out > 0 && !inflateEof) {
+		if (inflateStream->avail_in == 0) {
+			const int numBytes = playbackDemo->Read(&inflateBuffer[0], inflateBuffer.size());
+
+			if (numBytes <= 0) {
+				// end of file, or of what has been written so far if the demo is still being recorded
+				inflateEof = true;
+				break;
+			}
+
+			inflateStream->next_in = &inflateBuffer[0];
+			inflateStream->avail_in = numBytes;
+		}
+
+		switch (inflate(inflateStream, Z_NO_FLUSH)) {
+			case Z_OK:
+			case Z_BUF_ERROR: {
+			} break;
+			case Z_STREAM_END: {
+				// the header is a gzip member of its own, the rest of the demo follows in the next one
+				inflateReset(inflateStream);
+			} break;
+			default: {
+				LOG_L(L_WARNING, "[DemoReader::%s] corrupt demo stream: %s", __FUNCTION__, (inflateStream->msg != NULL)? inflateStream->msg: "unknown error");
+				inflateEof = true;
+			} break;
+		}
+	}
+
+	const int numRead = length - inflateStream->avail_out;
+	inflatedPos += numRead;
+	return numRead;
+}
+
+void CDemoReader::SeekDemo(int pos)
+{
+	if (inflateStream == NULL) {
+		playbackDemo->Seek(pos);
+		return;
+	}
+
+	// gzip streams can only be read forward, so restart from the beginning for going back
+	if (pos < inflatedPos) {
+		playbackDemo->Seek(0);
+		inflateReset(inflateStream);
+
+		inflateStream->avail_in = 0;
+		inflatedPos = 0;
+		inflateEof = false;
+	}
+
+	std::vector<char> skipBuffer(std::min(pos - inflatedPos, 64 * 1024));
+
+	while (inflatedPos < pos && !inflateEof) {
+		ReadDemo(&skipBuffer[0], std::min(pos - inflatedPos, int(skipBuffer.size())));
+	}
+}
+
+int CDemoReader::GetDemoPos()
+{
+	if (inflateStream == NULL)
+		return (playbackDemo->GetPos());
+
+	return inflatedPos;
+}
+
+bool CDemoReader::DemoEof() const
+{
+	if (inflateStream == NULL)
+		return (playbackDemo->Eof());
+
+	return inflateEof;
+}
+
+
 netcode::RawPacket* CDemoReader::GetData(const float readTime)
 {
 	if (ReachedEnd())
@@ -97,7 +215,7 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 	// check needed
 	if (readTime >= nextDemoReadTime) {
 		netcode::RawPacket* buf = new netcode::RawPacket(chunkHeader.length);
-		if (playbackDemo->Read((char*)(buf->data), chunkHeader.length) < chunkHeader.length) {
+		if (ReadDemo((char*)(buf->data), chunkHeader.length) < chunkHeader.length) {
 			delete buf;
 			bytesRemaining = 0;
 			return NULL;
@@ -106,7 +224,7 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 
 		if (!ReachedEnd()) {
 			// read next chunk header
-			if (playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader)) < sizeof(chunkHeader)) {
+			if (ReadDemo((char*)&chunkHeader, sizeof(chunkHeader)) < sizeof(chunkHeader)) {
 				delete buf;
 				bytesRemaining = 0;
 				return NULL;
@@ -127,8 +245,8 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 
 bool CDemoReader::ReachedEnd()
 {
-	if (bytesRemaining <= 0 || playbackDemo->Eof() ||
-		(playbackDemo->GetPos() > playbackDemoSize) )
+	if (bytesRemaining <= 0 || DemoEof() ||
+		(GetDemoPos() > playbackDemoSize) )
 		return true;
 	else
 		return false;
@@ -142,8 +260,8 @@ void CDemoReader::LoadStats()
 		return;
 	}
 
-	const int curPos = playbackDemo->GetPos();
-	playbackDemo->Seek(fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize);
+	const int curPos = GetDemoPos();
+	SeekDemo(fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize);
 
 	winningAllyTeams.clear();
 	playerStats.clear();
@@ -151,13 +269,13 @@ void CDemoReader::LoadStats()
 
 	for (int allyTeamNum = 0; allyTeamNum < fileHeader.winningAllyTeamsSize; ++allyTeamNum) {
 		unsigned char winnerAllyTeam;
-		playbackDemo->Read((char*) &winnerAllyTeam, sizeof(unsigned char));
+		ReadDemo((char*) &winnerAllyTeam, sizeof(unsigned char));
 		winningAllyTeams.push_back(winnerAllyTeam);
 	}
 
 	for (int playerNum = 0; playerNum < fileHeader.numPlayers; ++playerNum) {
 		PlayerStatistics buf;
-		playbackDemo->Read(reinterpret_cast<char*>(&buf), sizeof(PlayerStatistics));
+		ReadDemo(reinterpret_cast<char*>(&buf), sizeof(PlayerStatistics));
 		buf.swab();
 		playerStats.push_back(buf);
 	}
@@ -166,17 +284,20 @@ void CDemoReader::LoadStats()
 		teamStats.resize(fileHeader.numTeams);
 		// Read the array containing the number of team stats for each team.
 		std::vector<int> numStatsPerTeam(fileHeader.numTeams, 0);
-		playbackDemo->Read((char*) (&numStatsPerTeam[0]), numStatsPerTeam.size());
+		if (!numStatsPerTeam.empty())
+			ReadDemo((char*) (&numStatsPerTeam[0]), numStatsPerTeam.size() * sizeof(int));
 
 		for (int teamNum = 0; teamNum < fileHeader.numTeams; ++teamNum) {
+			numStatsPerTeam[teamNum] = swabDWord(numStatsPerTeam[teamNum]);
+
 			for (int i = 0; i < numStatsPerTeam[teamNum]; ++i) {
 				TeamStatistics buf;
-				playbackDemo->Read(reinterpret_cast<char*>(&buf), sizeof(TeamStatistics));
+				ReadDemo(reinterpret_cast<char*>(&buf), sizeof(TeamStatistics));
 				buf.swab();
 				teamStats[teamNum].push_back(buf);
 			}
 		}
 	}
 
-	playbackDemo->Seek(curPos);
+	SeekDemo(curPos);
 }
@@ -13,9 +13,13 @@
 
 namespace netcode { class RawPacket; }
 class CFileHandler;
+struct z_stream_s;
 
 /**
  * @brief Utility class for reading demofiles
+ *
+ * Compressed demos (gzip, see CDemoRecorder) are detected by their magic
+ * bytes and decompressed on the fly while reading.
  */
 class CDemoReader : public CDemo
 {
@@ -55,9 +59,22 @@ public:
 	/// Not needed for normal demo watching
 	void LoadStats();
 
+private:
+	int ReadDemo(void* buf, int length);
+	void SeekDemo(int pos);
+	int GetDemoPos();
+	bool DemoEof() const;
+
 private:
 	CFileHandler* playbackDemo;
 
+	/// inflate state if the demo is compressed, NULL otherwise
+	z_stream_s* inflateStream;
+	std::vector<unsigned char> inflateBuffer;
+	/// position in the decompressed demo
+	int inflatedPos;
+	bool inflateEof;
+
 	float demoTimeOffset;
 	float nextDemoReadTime;
 	int bytesRemaining;
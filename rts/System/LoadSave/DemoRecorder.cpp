@@ -7,6 +7,8 @@
 #include "System/FileSystem/FileHandler.h"
 #include "Game/GameVersion.h"
 #include "Sim/Misc/TeamStatistics.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/Platform/Threading.h"
 #include "System/Util.h"
 #include "System/TimeUtil.h"
 
@@ -15,15 +17,47 @@
 #include <cassert>
 #include <cerrno>
 #include <cstring>
+#include <sstream>
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <zlib.h>
 
-CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo):
-demoStream(std::ios::binary | std::ios::out)
+CONFIG(bool, CompressDemos).defaultValue(false).description("Write demos gzip-compressed (*.sdfz).");
+
+/// the writer thread flushes the demo to disk at least this often, so little is lost on a crash
+static const int DEMO_FLUSH_INTERVAL = 1000;
+/// producers wake up the writer thread when this much data is queued
+static const unsigned int DEMO_WRITE_BATCH_SIZE = 64 * 1024;
+
+
+CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo)
+	: headerQueued(false)
+	, quitWriter(false)
+	, writerThread(NULL)
+	, deflateStream(NULL)
+	, headerBlockSize(0)
 {
+	if (configHandler->GetBool("CompressDemos")) {
+		deflateStream = new z_stream();
+		deflateBuffer.resize(DEMO_WRITE_BATCH_SIZE);
+
+		// gzip-wrapper, so the file can also be unpacked with standard tools
+		if (deflateInit2(deflateStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			LOG_L(L_ERROR, "[%s] could not initialize zlib, writing an uncompressed demo", __FUNCTION__);
+
+			delete deflateStream;
+			deflateStream = NULL;
+		}
+	}
+
 	SetName(mapName, modName, serverDemo);
 	SetFileHeader();
 
 	file.open(demoName.c_str(), std::ios::binary | std::ios::out);
+
+	lastFlushTime = spring_gettime();
+	writerThread = new boost::thread(boost::bind(&CDemoRecorder::WriteDemoFile, this));
 }
 
 CDemoRecorder::~CDemoRecorder()
@@ -33,7 +67,22 @@ CDemoRecorder::~CDemoRecorder()
 	WritePlayerStats();
 	WriteTeamStats();
 	WriteFileHeader(true);
-	WriteDemoFile();
+
+	{
+		boost::mutex::scoped_lock lock(bufferMutex);
+		quitWriter = true;
+	}
+
+	bufferCond.notify_one();
+	writerThread->join();
+	delete writerThread;
+
+	if (deflateStream != NULL) {
+		deflateEnd(deflateStream);
+		delete deflateStream;
+	}
+
+	file.close();
 }
 
 void CDemoRecorder::SetFileHeader()
@@ -49,20 +98,153 @@ void CDemoRecorder::SetFileHeader()
 	fileHeader.teamStatPeriod = TeamStatistics::statsPeriod;
 	fileHeader.winningAllyTeamsSize = 0;
 
-	demoStream.seekp(WriteFileHeader(false) + sizeof(DemoFileHeader));
+	// reserves the space for the header at the start of the file
+	WriteFileHeader(false);
 }
 
+/**
+ * @brief Writer thread
+ * Writes out the queued data (and header), flushing the file every
+ * DEMO_FLUSH_INTERVAL milliseconds, until the recorder is destroyed.
+ */
 void CDemoRecorder::WriteDemoFile()
 {
-	// using operator<<(basic_stringbuf*) requires the stream to be opened with std::ios::in
-	// stringbuf::{eback(), egptr(), gptr()} are protected so we cannot access them directly
-	// (plus data is not guaranteed to be stored contiguously) ==> the only clean OO solution
-	// that avoids str()'s copy would be to supply our own stringbuffer backend to demoStream
-	// which is slightly overdoing it
-	const std::string data = demoStream.str();
-	file.write(data.c_str(), data.size());
-	file.flush();
-	file.close();
+	Threading::SetThreadName("demowriter");
+
+	// whether anything was written since the last flush
+	bool unflushed = false;
+
+	for (bool quit = false; !quit; ) {
+		DemoFileHeader header;
+		bool writeHeader = false;
+
+		{
+			boost::mutex::scoped_lock lock(bufferMutex);
+
+			if (writeBuffer.empty() && !headerQueued && !quitWriter)
+				bufferCond.timed_wait(lock, boost::posix_time::milliseconds(DEMO_FLUSH_INTERVAL));
+
+			flushBuffer.swap(writeBuffer);
+
+			if ((writeHeader = headerQueued))
+				memcpy(&header, &queuedHeader, sizeof(header));
+
+			headerQueued = false;
+			quit = quitWriter;
+		}
+
+		// the header goes first, it has to be at the start of the file
+		if (writeHeader)
+			WriteHeaderBlock(header);
+
+		unflushed |= (writeHeader || !flushBuffer.empty());
+
+		const spring_time now = spring_gettime();
+		const bool flush = quit || (unflushed && spring_diffmsecs(now, lastFlushTime) >= DEMO_FLUSH_INTERVAL);
+
+		if (quit) {
+			WriteStreamData(Z_FINISH);
+		} else {
+			WriteStreamData(flush? Z_SYNC_FLUSH: Z_NO_FLUSH);
+		}
+
+		flushBuffer.clear();
+
+		if (flush) {
+			file.flush();
+			lastFlushTime = now;
+			unflushed = false;
+		}
+	}
+}
+
+/**
+ * @brief Write a header block
+ * Writes the header at the start of the file and restores the original
+ * position in the file afterwards. Compressed demos keep the header in a
+ * separate stored (level 0) gzip member, so it always has the same size
+ * and can be patched like in an uncompressed file.
+ */
+void CDemoRecorder::WriteHeaderBlock(const DemoFileHeader& header)
+{
+	DemoFileHeader tmpHeader;
+	memcpy(&tmpHeader, &header, sizeof(header));
+	tmpHeader.swab(); // to little endian
+
+	std::vector<unsigned char> block(sizeof(tmpHeader));
+	memcpy(&block[0], &tmpHeader, sizeof(tmpHeader));
+
+	if (deflateStream != NULL) {
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+		deflateInit2(&zs, Z_NO_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+
+		std::vector<unsigned char> member(deflateBound(&zs, block.size()));
+
+		zs.next_in = &block[0];
+		zs.avail_in = block.size();
+		zs.next_out = &member[0];
+		zs.avail_out = member.size();
+
+		deflate(&zs, Z_FINISH);
+		member.resize(member.size() - zs.avail_out);
+		deflateEnd(&zs);
+
+		block.swap(member);
+	}
+
+	if (headerBlockSize == 0) {
+		// first header, nothing else has been written yet
+		headerBlockSize = block.size();
+		file.write((const char*) &block[0], block.size());
+		return;
+	}
+
+	assert(block.size() == headerBlockSize);
+
+	const std::streampos pos = file.tellp();
+
+	file.seekp(0);
+	file.write((const char*) &block[0], block.size());
+	file.seekp(pos);
+}
+
+/** @brief Write (or compress) the data in flushBuffer at the current position in the file. */
+void CDemoRecorder::WriteStreamData(int flushMode)
+{
+	if (deflateStream == NULL) {
+		if (!flushBuffer.empty())
+			file.write(&flushBuffer[0], flushBuffer.size());
+
+		return;
+	}
+
+	deflateStream->next_in = (flushBuffer.empty())? Z_NULL: reinterpret_cast<Bytef*>(&flushBuffer[0]);
+	deflateStream->avail_in = flushBuffer.size();
+
+	do {
+		deflateStream->next_out = &deflateBuffer[0];
+		deflateStream->avail_out = deflateBuffer.size();
+
+		deflate(deflateStream, flushMode);
+
+		file.write((const char*) &deflateBuffer[0], deflateBuffer.size() - deflateStream->avail_out);
+	} while (deflateStream->avail_out == 0);
+}
+
+void CDemoRecorder::WriteToDemo(const void* data, unsigned int size)
+{
+	bool wakeWriter = false;
+
+	{
+		boost::mutex::scoped_lock lock(bufferMutex);
+
+		writeBuffer.insert(writeBuffer.end(), (const char*) data, (const char*) data + size);
+		wakeWriter = (writeBuffer.size() >= DEMO_WRITE_BATCH_SIZE);
+	}
+
+	if (wakeWriter)
+		bufferCond.notify_one();
 }
 
 void CDemoRecorder::WriteSetupText(const std::string& text)
@@ -73,7 +255,9 @@ void CDemoRecorder::WriteSetupText(const std::string& text)
 	}
 
 	fileHeader.scriptSize = length;
-	demoStream.write(text.c_str(), length);
+	WriteToDemo(text.c_str(), length);
+	// the script is needed to watch the demo, even if Spring crashes
+	WriteFileHeader(false);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
@@ -83,8 +267,8 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	chunkHeader.modGameTime = modGameTime;
 	chunkHeader.length = length;
 	chunkHeader.swab();
-	demoStream.write((char*) &chunkHeader, sizeof(chunkHeader));
-	demoStream.write((char*) buf, length);
+	WriteToDemo(&chunkHeader, sizeof(chunkHeader));
+	WriteToDemo(buf, length);
 	fileHeader.demoStreamSize += length + sizeof(chunkHeader);
 }
 
@@ -108,12 +292,13 @@ void CDemoRecorder::SetName(const std::string& mapName, const std::string& modNa
 	// oss << FileSystem::GetBasename(modName);
 	// oss << "_";
 	oss << SpringVersion::GetSync();
-	buf << oss.str() << ".sdf";
+	const char* ext = (deflateStream != NULL)? ".sdfz": ".sdf";
+	buf << oss.str() << ext;
 
 	int n = 0;
 	while (FileSystem::FileExists(buf.str()) && (n < 99)) {
 		buf.str(""); // clears content
-		buf << oss.str() << "_" << n++ << ".sdf";
+		buf << oss.str() << "_" << n++ << ext;
 	}
 
 	demoName = dataDirsAccess.LocateFile(buf.str(), FileQueryFlags::WRITE);
@@ -177,49 +362,33 @@ void CDemoRecorder::SetWinningAllyTeams(const std::vector<unsigned char>& winnin
 }
 
 /** @brief Write DemoFileHeader
-Write the DemoFileHeader at the start of the file and restores the original
-position in the file afterwards. */
-unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
+Queues the DemoFileHeader for the writer thread, which writes it at the
+start of the file. */
+void CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 {
-#ifdef _MSC_VER // MSVC8 behaves strange if tell/seek is called before anything has been written
-	const bool empty = (demoStream.str() == "");
-	const unsigned int pos = empty? 0 : demoStream.tellp();
-#else
-	const unsigned int pos = demoStream.tellp();
-#endif
-
-	DemoFileHeader tmpHeader;
-	memcpy(&tmpHeader, &fileHeader, sizeof(fileHeader));
-	if (!updateStreamLength)
-		tmpHeader.demoStreamSize = 0;
-	tmpHeader.swab(); // to little endian
-
-#ifdef _MSC_VER
-	if (!empty)
-#endif
 	{
-		demoStream.seekp(0);
-	}
+		boost::mutex::scoped_lock lock(bufferMutex);
 
+		memcpy(&queuedHeader, &fileHeader, sizeof(fileHeader));
+		if (!updateStreamLength)
+			queuedHeader.demoStreamSize = 0;
 
-	demoStream.write((char*) &tmpHeader, sizeof(tmpHeader));
-	demoStream.seekp(pos);
+		headerQueued = true;
+	}
 
-	return pos;
+	bufferCond.notify_one();
 }
 
 /** @brief Write the CPlayer::Statistics at the current position in the file. */
 void CDemoRecorder::WritePlayerStats()
 {
-	int pos = demoStream.tellp();
-
 	for (PlayerStatistics& stats: playerStats) {
 		stats.swab();
-		demoStream.write(reinterpret_cast<char*>(&stats), sizeof(PlayerStatistics));
+		WriteToDemo(&stats, sizeof(PlayerStatistics));
 	}
 
 	fileHeader.numPlayers = playerStats.size();
-	fileHeader.playerStatSize = (int)demoStream.tellp() - pos;
+	fileHeader.playerStatSize = playerStats.size() * sizeof(PlayerStatistics);
 
 	playerStats.clear();
 }
@@ -232,39 +401,38 @@ void CDemoRecorder::WriteWinnerList()
 	if (fileHeader.numTeams == 0)
 		return;
 
-	const int pos = demoStream.tellp();
-
 	// Write the array of winningAllyTeams.
-	for (std::vector<unsigned char>::const_iterator it = winningAllyTeams.begin(); it != winningAllyTeams.end(); ++it) {
-		demoStream.write((char*) &(*it), sizeof(unsigned char));
-	}
+	if (!winningAllyTeams.empty())
+		WriteToDemo(&winningAllyTeams[0], winningAllyTeams.size() * sizeof(unsigned char));
 
-	winningAllyTeams.clear();
+	fileHeader.winningAllyTeamsSize = winningAllyTeams.size() * sizeof(unsigned char);
 
-	fileHeader.winningAllyTeamsSize = int(demoStream.tellp()) - pos;
+	winningAllyTeams.clear();
 }
 
 /** @brief Write the TeamStatistics at the current position in the file. */
 void CDemoRecorder::WriteTeamStats()
 {
-	int pos = demoStream.tellp();
+	int teamStatSize = 0;
 
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
-		demoStream.write((char*)&c, sizeof(unsigned int));
+		WriteToDemo(&c, sizeof(unsigned int));
+		teamStatSize += sizeof(unsigned int);
 	}
 
 	// Write big array of TeamStatistics.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		for (TeamStatistics& stats: history) {
 			stats.swab();
-			demoStream.write(reinterpret_cast<char*>(&stats), sizeof(TeamStatistics));
+			WriteToDemo(&stats, sizeof(TeamStatistics));
+			teamStatSize += sizeof(TeamStatistics);
 		}
 	}
 
 	fileHeader.numTeams = teamStats.size();
-	fileHeader.teamStatSize = (int)demoStream.tellp() - pos;
+	fileHeader.teamStatSize = teamStatSize;
 
 	teamStats.clear();
 }
@@ -5,15 +5,29 @@
 
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <list>
 
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include "Demo.h"
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
+#include "System/Misc/SpringTime.h"
+
+namespace boost {
+	class thread;
+}
+struct z_stream_s;
 
 /**
  * @brief Used to record demos
+ *
+ * The demo is streamed to disk as it is recorded: the data is queued and
+ * written (optionally gzip-compressed, see CompressDemos) by a background
+ * thread. The file header is rewritten in place whenever it changes, its
+ * demoStreamSize stays 0 until the demo is closed (like before, readers
+ * take that as "Spring crashed while recording").
  */
 class CDemoRecorder : public CDemo
 {
@@ -40,16 +54,45 @@ public:
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
 private:
-	unsigned int WriteFileHeader(bool updateStreamLength);
+	void WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
 	void WritePlayerStats();
 	void WriteTeamStats();
 	void WriteWinnerList();
+	void WriteToDemo(const void* data, unsigned int size);
+
+	/// the writer thread
 	void WriteDemoFile();
+	void WriteHeaderBlock(const DemoFileHeader& header);
+	void WriteStreamData(int flushMode);
 
 private:
 	std::ofstream file;
-	std::stringstream demoStream;
+
+	/// data queued for the writer thread (guarded by bufferMutex)
+	std::vector<char> writeBuffer;
+	/// data the writer thread is currently writing out
+	std::vector<char> flushBuffer;
+	std::vector<unsigned char> deflateBuffer;
+
+	/// header queued for the writer thread (guarded by bufferMutex)
+	DemoFileHeader queuedHeader;
+
+	bool headerQueued;
+	bool quitWriter;
+
+	boost::thread* writerThread;
+	boost::mutex bufferMutex;
+	boost::condition_variable bufferCond;
+
+	/// deflate state of the demo stream if compressed, NULL otherwise
+	z_stream_s* deflateStream;
+
+	/// size of the header at the start of the file (a stored gzip member if compressed)
+	unsigned int headerBlockSize;
+
+	spring_time lastFlushTime;
+
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
 	std::vector<unsigned char> winningAllyTeams;
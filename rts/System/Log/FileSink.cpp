@@ -9,11 +9,21 @@
 #include "System/Log/ILog.h"
 #include "System/Log/Level.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <list>
 #include <map>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 
 namespace {
@@ -48,6 +58,127 @@ namespace {
 	};
 	typedef std::map<std::string, LogFileDetails> logFiles_t;
 
+
+	struct AsyncRecord {
+		std::string section;
+		int level;
+		std::string text; // frame-prefix + record + newline
+	};
+
+	/**
+	 * Bounded lock-free multi-producer single-consumer ring of records.
+	 * Every cell carries a sequence number telling whether it is free
+	 * for the producer claiming position N (sequence == N) or holds the
+	 * record of position N for the consumer (sequence == N + 1).
+	 */
+	class AsyncRecordQueue {
+	public:
+		AsyncRecordQueue(): mask(0), pushPos(0), popPos(0) {}
+
+		void Init(size_t size) {
+			size_t n = 2;
+			while (n < size)
+				n <<= 1;
+
+			cells.reset(new Cell[n]);
+			mask = n - 1;
+
+			for (size_t i = 0; i < n; i++) {
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+
+			pushPos.store(0);
+			popPos = 0;
+		}
+
+		/// @return false if the queue is full
+		bool Push(AsyncRecord& record) {
+			size_t pos = pushPos.load(std::memory_order_relaxed);
+			Cell* cell = NULL;
+
+			for (;;) {
+				cell = &cells[pos & mask];
+
+				const size_t seq = cell->sequence.load(std::memory_order_acquire);
+				const ptrdiff_t diff = ptrdiff_t(seq) - ptrdiff_t(pos);
+
+				if (diff == 0) {
+					if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				} else if (diff < 0) {
+					return false;
+				} else {
+					pos = pushPos.load(std::memory_order_relaxed);
+				}
+			}
+
+			cell->record.section.swap(record.section);
+			cell->record.text.swap(record.text);
+			cell->record.level = record.level;
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		/// only one thread at a time may pop
+		bool Pop(AsyncRecord& record) {
+			Cell* cell = &cells[popPos & mask];
+
+			if (ptrdiff_t(cell->sequence.load(std::memory_order_acquire)) - ptrdiff_t(popPos + 1) < 0)
+				return false;
+
+			record.section.swap(cell->record.section);
+			record.text.swap(cell->record.text);
+			record.level = cell->record.level;
+			cell->sequence.store(popPos + mask + 1, std::memory_order_release);
+			popPos += 1;
+			return true;
+		}
+
+	private:
+		struct Cell {
+			std::atomic<size_t> sequence;
+			AsyncRecord record;
+		};
+
+		std::unique_ptr<Cell[]> cells;
+		size_t mask;
+
+		std::atomic<size_t> pushPos;
+		size_t popPos;
+	};
+
+	/**
+	 * State of the asynchronous mode, in which records are formatted on
+	 * the logging thread and written out by a dedicated writer thread.
+	 */
+	struct AsyncWriter {
+		AsyncWriter()
+			: thread(NULL)
+			, enabled(false)
+			, quit(false)
+			, numDropped(0)
+			, overflowPolicy(LOG_FILE_ASYNC_BLOCK)
+		{}
+
+		AsyncRecordQueue queue;
+		std::vector<AsyncRecord> batch;
+		std::string fileBuffer;
+
+		boost::thread* thread;
+		boost::mutex wakeMutex;
+		boost::condition_variable wakeCond;
+		/// held by whoever pops from the queue (the writer or a flushing thread)
+		boost::mutex popMutex;
+		/// guards logFiles against being modified while the writer uses it
+		boost::mutex filesMutex;
+
+		std::atomic<bool> enabled;
+		std::atomic<bool> quit;
+		std::atomic<unsigned int> numDropped;
+
+		int overflowPolicy;
+	};
+
 	/**
 	 * This is only used to check whether some code tries to access the
 	 * log-files contianer after it got deleted.
@@ -60,22 +191,35 @@ namespace {
 	 */
 	struct LogFilesContainer {
 		~LogFilesContainer() {
+			log_file_disableAsync();
 			log_file_removeAllLogFiles();
 			logFilesValidTracker = false;
 		}
 		logFiles_t& GetLogFiles() {
 			return logFiles;
 		}
+		AsyncWriter& GetAsyncWriter() {
+			return asyncWriter;
+		}
 
 	private:
 		logFiles_t logFiles;
+		AsyncWriter asyncWriter;
 	};
 
-	inline logFiles_t& log_file_getLogFiles() {
+	inline LogFilesContainer& log_file_getContainer() {
 		static LogFilesContainer logFilesContainer;
 
 		assert(logFilesValidTracker);
-		return logFilesContainer.GetLogFiles();
+		return logFilesContainer;
+	}
+
+	inline logFiles_t& log_file_getLogFiles() {
+		return log_file_getContainer().GetLogFiles();
+	}
+
+	inline AsyncWriter& log_file_getAsyncWriter() {
+		return log_file_getContainer().GetAsyncWriter();
 	}
 
 	/**
@@ -168,6 +312,161 @@ namespace {
 	{
 		log_file_getRecordBuffer().push_back(LogRecord(section, level, record));
 	}
+
+
+	/**
+	 * Pops all queued records and writes them to the files wanting them,
+	 * with one fwrite per file and batch.
+	 * The caller has to hold the popMutex.
+	 */
+	void log_file_writeQueuedRecords(AsyncWriter& writer) {
+		static const size_t MAX_BATCH_SIZE = 1024;
+
+		for (;;) {
+			writer.batch.resize(MAX_BATCH_SIZE);
+
+			size_t batchSize = 0;
+
+			while (batchSize < MAX_BATCH_SIZE && writer.queue.Pop(writer.batch[batchSize]))
+				batchSize++;
+
+			const unsigned int numDropped = writer.numDropped.exchange(0);
+
+			if (batchSize == 0 && numDropped == 0)
+				return;
+
+			boost::mutex::scoped_lock lock(writer.filesMutex);
+
+			const logFiles_t& logFiles = log_file_getLogFiles();
+
+			for (auto lfi = logFiles.begin(); lfi != logFiles.end(); ++lfi) {
+				FILE* outStream = lfi->second.GetOutStream();
+
+				if (outStream == NULL)
+					continue;
+
+				std::string& buffer = writer.fileBuffer;
+				bool flush = false;
+
+				buffer.clear();
+
+				if (numDropped > 0) {
+					char msg[128];
+					SNPRINTF(msg, sizeof(msg), "[FileSink] %u log records dropped, the queue was full\n", numDropped);
+					buffer += msg;
+				}
+
+				for (size_t n = 0; n < batchSize; n++) {
+					const AsyncRecord& record = writer.batch[n];
+
+					if (!lfi->second.IsLogging(record.section.c_str(), record.level))
+						continue;
+
+					buffer += record.text;
+					flush |= lfi->second.FlushOnWrite(record.level);
+				}
+
+				if (buffer.empty())
+					continue;
+
+				fwrite(buffer.data(), 1, buffer.size(), outStream);
+
+				if (flush)
+					fflush(outStream);
+			}
+
+			if (batchSize < MAX_BATCH_SIZE)
+				return;
+		}
+	}
+
+	/**
+	 * Locks the filesMutex for synchronous writing, unless some other
+	 * thread holds it for longer than a moment (which might be the writer
+	 * thread having crashed while writing); the caller writes anyway then.
+	 * @return true if the caller has to unlock the filesMutex
+	 */
+	bool log_file_tryLockFiles(AsyncWriter& writer) {
+		for (int n = 0; n < 100; n++) {
+			if (writer.filesMutex.try_lock())
+				return true;
+
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+		}
+
+		return false;
+	}
+
+	/**
+	 * Writes the queued records on the calling thread, unless some other
+	 * thread keeps popping them for longer than a moment (which might be
+	 * the writer thread having crashed while doing so).
+	 */
+	void log_file_tryWriteQueuedRecords(AsyncWriter& writer) {
+		for (int n = 0; n < 100; n++) {
+			if (writer.popMutex.try_lock()) {
+				log_file_writeQueuedRecords(writer);
+				writer.popMutex.unlock();
+				return;
+			}
+
+			boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+		}
+	}
+
+	void log_file_asyncWriterLoop() {
+		AsyncWriter& writer = log_file_getAsyncWriter();
+
+		while (!writer.quit.load()) {
+			{
+				boost::mutex::scoped_lock lock(writer.popMutex);
+				log_file_writeQueuedRecords(writer);
+			}
+
+			// producers only notify when the queue ran full
+			boost::mutex::scoped_lock lock(writer.wakeMutex);
+			writer.wakeCond.timed_wait(lock, boost::posix_time::milliseconds(5));
+		}
+	}
+
+	/**
+	 * Formats and queues a record for the writer thread.
+	 * @return false if the record has to be written synchronously
+	 */
+	bool log_file_queueRecord(const char* section, int level, const char* record) {
+		AsyncWriter& writer = log_file_getAsyncWriter();
+
+		if (!writer.enabled.load(std::memory_order_acquire))
+			return false;
+
+		char framePrefix[128] = {'\0'};
+		log_framePrefixer_createPrefix(framePrefix, sizeof(framePrefix));
+
+		AsyncRecord asyncRecord;
+		asyncRecord.section = section;
+		asyncRecord.level = level;
+		asyncRecord.text.reserve(strlen(framePrefix) + strlen(record) + 1);
+		asyncRecord.text += framePrefix;
+		asyncRecord.text += record;
+		asyncRecord.text += '\n';
+
+		while (!writer.queue.Push(asyncRecord)) {
+			writer.wakeCond.notify_one();
+
+			if (writer.overflowPolicy == LOG_FILE_ASYNC_DROP) {
+				writer.numDropped.fetch_add(1);
+				return true;
+			}
+
+			// the writer went away (crash), fall back to synchronous writing
+			if (!writer.enabled.load(std::memory_order_acquire))
+				return false;
+
+			boost::this_thread::yield();
+		}
+
+		return true;
+	}
 }
 
 
@@ -186,21 +485,32 @@ void log_file_addLogFile(const char* filePath, const char* sections, int minLeve
 		return;
 	}
 
-	FILE* tmpStream = fopen(filePath, "w");
-	if (tmpStream == NULL) {
-		LOG_L(L_ERROR, "Failed to open log file for writing: %s", filePath);
-		return;
-	}
+	FILE* tmpStream = NULL;
 
-	setvbuf(tmpStream, NULL, _IOFBF, (BUFSIZ < 8192) ? BUFSIZ : 8192); // limit buffer to 8kB
+	{
+		boost::mutex::scoped_lock lock(log_file_getAsyncWriter().filesMutex);
+
+		tmpStream = fopen(filePath, "w");
+
+		if (tmpStream != NULL) {
+			setvbuf(tmpStream, NULL, _IOFBF, (BUFSIZ < 8192) ? BUFSIZ : 8192); // limit buffer to 8kB
+
+			const std::string sectionsStr = (sections == NULL) ? "" : sections;
+			logFiles[filePathStr] = LogFileDetails(tmpStream, sectionsStr, minLevel, flushLevel);
+		}
+	}
 
-	const std::string sectionsStr = (sections == NULL) ? "" : sections;
-	logFiles[filePathStr] = LogFileDetails(tmpStream, sectionsStr, minLevel, flushLevel);
+	// not while holding the filesMutex, the writer thread
+	// (or this record, if it has to be written synchronously) needs it
+	if (tmpStream == NULL)
+		LOG_L(L_ERROR, "Failed to open log file for writing: %s", filePath);
 }
 
 void log_file_removeLogFile(const char* filePath) {
 	assert(filePath != NULL);
 
+	boost::mutex::scoped_lock lock(log_file_getAsyncWriter().filesMutex);
+
 	logFiles_t& logFiles = log_file_getLogFiles();
 	const std::string filePathStr = filePath;
 	const logFiles_t::iterator lfi = logFiles.find(filePathStr);
@@ -216,6 +526,50 @@ void log_file_removeLogFile(const char* filePath) {
 	tmpStream = NULL;
 }
 
+void log_file_enableAsync(int queueSize, int overflowPolicy) {
+	AsyncWriter& writer = log_file_getAsyncWriter();
+
+	if (writer.thread != NULL)
+		return;
+
+	writer.queue.Init(std::max(queueSize, 2));
+	writer.overflowPolicy = overflowPolicy;
+	writer.quit.store(false);
+	writer.enabled.store(true, std::memory_order_release);
+	writer.thread = new boost::thread(&log_file_asyncWriterLoop);
+}
+
+void log_file_stopAsync() {
+	AsyncWriter& writer = log_file_getAsyncWriter();
+
+	if (!writer.enabled.exchange(false))
+		return;
+
+	writer.quit.store(true);
+	writer.wakeCond.notify_one();
+
+	// do not join the writer, it might be the thread that crashed
+	log_file_tryWriteQueuedRecords(writer);
+	log_file_flushFiles();
+}
+
+void log_file_disableAsync() {
+	AsyncWriter& writer = log_file_getAsyncWriter();
+
+	if (writer.thread == NULL)
+		return;
+
+	log_file_stopAsync();
+
+	writer.thread->join();
+	delete writer.thread;
+	writer.thread = NULL;
+
+	// records pushed while the writer was shutting down
+	boost::mutex::scoped_lock lock(writer.popMutex);
+	log_file_writeQueuedRecords(writer);
+}
+
 void log_file_removeAllLogFiles() {
 	while (!log_file_getLogFiles().empty()) {
 		const logFiles_t::const_iterator lfi = log_file_getLogFiles().begin();
@@ -234,11 +588,21 @@ static void log_sink_record_file(const char* section, int level,
 		const char* record)
 {
 	if (logFilesValidTracker && log_file_isActivelyLogging()) {
+		if (log_file_queueRecord(section, level, record))
+			return;
+
+		// a stopped writer thread may still be finishing its last batch
+		AsyncWriter& writer = log_file_getAsyncWriter();
+		const bool locked = log_file_tryLockFiles(writer);
+
 		// write buffer to log file
 		log_file_writeBufferToFiles();
 
 		// write current record to log file
 		log_file_writeToFiles(section, level, record);
+
+		if (locked)
+			writer.filesMutex.unlock();
 	} else {
 		// buffer until a log file is ready for output
 		log_file_writeToBuffer(section, level, record);
@@ -248,6 +612,12 @@ static void log_sink_record_file(const char* section, int level,
 /// Cleans up all log streams, by flushing them.
 static void log_sink_cleanup_file() {
 	if (log_file_isActivelyLogging()) {
+		AsyncWriter& writer = log_file_getAsyncWriter();
+
+		// write out what the writer thread did not get to yet
+		if (writer.enabled.load())
+			log_file_tryWriteQueuedRecords(writer);
+
 		// flush the log buffers to files
 		log_file_flushFiles();
 	}
@@ -37,6 +37,36 @@ void log_file_removeLogFile(const char* filePath);
 
 void log_file_removeAllLogFiles();
 
+
+/// overflow policies of the asynchronous mode
+enum {
+	/// records logged while the queue is full are dropped (and counted)
+	LOG_FILE_ASYNC_DROP  = 0,
+	/// the logging thread waits until the writer made room
+	LOG_FILE_ASYNC_BLOCK = 1,
+};
+
+/**
+ * Write to the log files from a dedicated thread.
+ * Records are formatted on the logging thread and queued, the writer thread
+ * writes them out in batches (flushing as per the files flushLevel).
+ * @param queueSize number of records that can be queued
+ * @param overflowPolicy LOG_FILE_ASYNC_DROP or LOG_FILE_ASYNC_BLOCK
+ */
+void log_file_enableAsync(int queueSize, int overflowPolicy);
+
+/**
+ * Writes out all queued records on the calling thread and returns to writing
+ * synchronously, without waiting for the writer thread.
+ * Meant for crash handlers, the writer thread might be the one that crashed.
+ */
+void log_file_stopAsync();
+
+/**
+ * Like log_file_stopAsync, but also waits for the writer thread to finish.
+ */
+void log_file_disableAsync();
+
 ///@}
 
 #ifdef __cplusplus
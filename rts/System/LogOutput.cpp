@@ -38,6 +38,15 @@ CONFIG(std::string, LogSections).defaultValue("")
 CONFIG(int, LogFlushLevel).defaultValue(LOG_LEVEL_ERROR)
 		.description("Flush the logfile when level of message is above LogFlushLevel. i.e. ERROR is flushed as default, WARNING isn't.");
 
+CONFIG(bool, LogAsync).defaultValue(false)
+		.description("Write the logfile from a separate thread, so logging does not stall the thread doing it.");
+
+CONFIG(int, LogAsyncQueueSize).defaultValue(8192).minimumValue(16)
+		.description("Number of log messages that can wait for being written when LogAsync is enabled.");
+
+CONFIG(int, LogAsyncOverflowPolicy).defaultValue(LOG_FILE_ASYNC_BLOCK).minimumValue(LOG_FILE_ASYNC_DROP).maximumValue(LOG_FILE_ASYNC_BLOCK)
+		.description("What to do when LogAsyncQueueSize messages are waiting already. 0 = drop new messages (their number is logged), 1 = wait.");
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -256,6 +265,10 @@ void CLogOutput::Initialize()
 		RotateLogFile();
 
 	log_file_addLogFile(filePath.c_str(), NULL, LOG_LEVEL_ALL, configHandler->GetInt("LogFlushLevel"));
+
+	if (configHandler->GetBool("LogAsync"))
+		log_file_enableAsync(configHandler->GetInt("LogAsyncQueueSize"), configHandler->GetInt("LogAsyncOverflowPolicy"));
+
 	InitializeLogSections();
 
 	LOG("LogOutput initialized.");
@@ -0,0 +1,57 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "BroadcastBlock.h"
+#include "ProtocolDef.h"
+#include "UDPConnection.h"
+#include "System/Log/ILog.h"
+
+#include <algorithm>
+
+namespace netcode {
+
+BroadcastBlock::BroadcastBlock(MessageList& msgs)
+	: length(0)
+{
+	messages.reserve(msgs.size());
+
+	for (const boost::shared_ptr<const RawPacket>& packet: msgs) {
+		// same check as in UDPConnection::Flush, done once for the whole group
+		if (!ProtocolDef::GetInstance()->IsValidPacket(packet->data, packet->length)) {
+			LOG_L(L_ERROR,
+				"Discarding outgoing invalid packet: ID %d, LEN %d",
+				((packet->length > 0) ? (int)packet->data[0] : -1),
+				packet->length);
+			continue;
+		}
+
+		messages.push_back(packet);
+		length += packet->length;
+	}
+
+	msgs.clear();
+
+	// messages can span chunks, the receiver reassembles the stream
+	boost::uint8_t buffer[Chunk::maxSize];
+	unsigned pos = 0;
+
+	for (const boost::shared_ptr<const RawPacket>& packet: messages) {
+		for (unsigned copied = 0; copied < packet->length; ) {
+			const unsigned numBytes = std::min(Chunk::maxSize - pos, packet->length - copied);
+
+			std::copy(packet->data + copied, packet->data + copied + numBytes, buffer + pos);
+			pos += numBytes;
+			copied += numBytes;
+
+			if (pos == Chunk::maxSize) {
+				chunks.push_back(ChunkDataPtr(new ChunkData(buffer, pos)));
+				pos = 0;
+			}
+		}
+	}
+
+	if (pos > 0) {
+		chunks.push_back(ChunkDataPtr(new ChunkData(buffer, pos)));
+	}
+}
+
+} // namespace netcode
@@ -0,0 +1,52 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _BROADCAST_BLOCK_H
+#define _BROADCAST_BLOCK_H
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+#include "RawPacket.h"
+
+namespace netcode
+{
+class ChunkData;
+typedef boost::shared_ptr<const ChunkData> ChunkDataPtr;
+
+/**
+ * @brief A batch of messages that is sent to a group of connections
+ *
+ * The messages are packed into chunk payloads and checksummed once when
+ * the block is created; every UDPConnection of the group then sends these
+ * payloads as they are and only adds its own chunk headers, instead of
+ * copying and chunking each message again (see CConnection::SendSharedData).
+ */
+class BroadcastBlock : public boost::noncopyable
+{
+public:
+	typedef std::vector< boost::shared_ptr<const RawPacket> > MessageList;
+
+	/**
+	 * @brief pack messages into shared chunks
+	 * @param msgs the messages in send order, taken over by the block
+	 *   (msgs is empty afterwards)
+	 */
+	BroadcastBlock(MessageList& msgs);
+
+	const MessageList& GetMessages() const { return messages; }
+	const std::vector<ChunkDataPtr>& GetChunks() const { return chunks; }
+
+	/// total size of the messages in bytes
+	unsigned GetLength() const { return length; }
+
+private:
+	MessageList messages;
+	std::vector<ChunkDataPtr> chunks;
+
+	unsigned length;
+};
+
+} // namespace netcode
+
+#endif // _BROADCAST_BLOCK_H
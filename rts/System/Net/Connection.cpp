@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "Connection.h"
+#include "BroadcastBlock.h"
 
 namespace netcode {
 
@@ -10,4 +11,11 @@ CConnection::CConnection()
 {
 }
 
+void CConnection::SendSharedData(boost::shared_ptr<const BroadcastBlock> block)
+{
+	for (const boost::shared_ptr<const RawPacket>& packet: block->GetMessages()) {
+		SendData(packet);
+	}
+}
+
 } // namespace netcode
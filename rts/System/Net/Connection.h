@@ -10,6 +10,7 @@
 
 namespace netcode
 {
+class BroadcastBlock;
 
 /**
  * @brief Base class for connecting to various recievers / senders
@@ -27,6 +28,14 @@ public:
 	 */
 	virtual void SendData(boost::shared_ptr<const RawPacket> data) = 0;
 
+	/**
+	 * @brief Send a block of messages that also goes to other connections
+	 *
+	 * The default sends the messages one by one, UDPConnection sends the
+	 * already chunked payload of the block.
+	 */
+	virtual void SendSharedData(boost::shared_ptr<const BroadcastBlock> block);
+
 	virtual bool HasIncomingData() const = 0;
 
 	/**
@@ -103,9 +103,10 @@ public:
 		pos += sizeof(t);
 	}
 
-	void Unpack(std::vector<boost::uint8_t>& t, unsigned unpackLength) {
-		std::copy(data + pos, data + pos + unpackLength, std::back_inserter(t));
+	const unsigned char* UnpackData(unsigned unpackLength) {
+		const unsigned char* t = data + pos;
 		pos += unpackLength;
+		return t;
 	}
 
 	unsigned Remaining() const {
@@ -135,6 +136,9 @@ public:
 	void Pack(std::vector<boost::uint8_t>& _data) {
 		std::copy(_data.begin(), _data.end(), std::back_inserter(data));
 	}
+	void Pack(const std::vector<boost::uint8_t>& _data) {
+		std::copy(_data.begin(), _data.end(), std::back_inserter(data));
+	}
 
 private:
 	std::vector<boost::uint8_t>& data;
@@ -142,14 +146,21 @@ private:
 
 
 
+ChunkData::ChunkData(const boost::uint8_t* data, unsigned length)
+	: bytes(data, data + length)
+	, checksum(CRC().Update(data, length).GetDigest())
+{
+}
+
+
+
 void Chunk::UpdateChecksum(CRC& crc) const {
 
 	crc << chunkNumber;
 	crc << (unsigned int)chunkSize;
-
-	if (!data.empty()) {
-		crc.Update(&data[0], data.size());
-	}
+	// the payload enters through its own CRC, which is computed only once
+	// for chunks that are shared between connections
+	crc << data->checksum;
 }
 
 
@@ -180,7 +191,7 @@ Packet::Packet(const unsigned char* data, unsigned length)
 		buf.Unpack(temp->chunkNumber);
 		buf.Unpack(temp->chunkSize);
 		if (buf.Remaining() >= temp->chunkSize) {
-			buf.Unpack(temp->data, temp->chunkSize);
+			temp->data.reset(new ChunkData(buf.UnpackData(temp->chunkSize), temp->chunkSize));
 			chunks.push_back(temp);
 		} else {
 			// defective, ignore
@@ -232,7 +243,7 @@ void Packet::Serialize(std::vector<boost::uint8_t>& data)
 	for (auto ci = chunks.begin(); ci != chunks.end(); ++ci) {
 		buf.Pack((*ci)->chunkNumber);
 		buf.Pack((*ci)->chunkSize);
-		buf.Pack((*ci)->data);
+		buf.Pack((*ci)->data->bytes);
 	}
 }
 
@@ -298,6 +309,7 @@ void UDPConnection::Init()
 	numTotalGetDataCalls = 0;
 	#endif
 	currentPacketChunkNum = 0;
+	outgoingBlockChunk = 0;
 
 	lastNak = -1;
 	sentOverhead = 0;
@@ -312,6 +324,7 @@ void UDPConnection::Init()
 	muted = true;
 	closed = false;
 	resend = false;
+	logMessages = false;
 
 	#ifndef UNIT_TEST
 	logMessages = configHandler->GetBool("UDPConnectionLogDebugMessages");
@@ -347,7 +360,20 @@ UDPConnection::~UDPConnection()
 void UDPConnection::SendData(boost::shared_ptr<const RawPacket> data)
 {
 	assert(data->length > 0);
-	outgoingData.push_back(data);
+
+	OutgoingData entry;
+	entry.packet = data;
+	outgoingData.push_back(entry);
+}
+
+void UDPConnection::SendSharedData(boost::shared_ptr<const BroadcastBlock> block)
+{
+	if (block->GetChunks().empty())
+		return;
+
+	OutgoingData entry;
+	entry.block = block;
+	outgoingData.push_back(entry);
 }
 
 boost::shared_ptr<const RawPacket> UDPConnection::Peek(unsigned ahead) const
@@ -545,7 +571,7 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 			continue;
 		}
 
-		waitingPackets.insert(c->chunkNumber, new RawPacket(&c->data[0], c->data.size()));
+		waitingPackets.insert(c->chunkNumber, new RawPacket(&c->data->bytes[0], c->data->GetSize()));
 	}
 
 	packetMap::iterator wpi;
@@ -634,7 +660,7 @@ void UDPConnection::Flush(const bool forced)
 
 	if (!waitMore) {
 		for (auto pi = outgoingData.begin(); (pi != outgoingData.end()) && (outgoingLength <= requiredLength); ++pi) {
-			outgoingLength += (*pi)->length;
+			outgoingLength += pi->GetLength();
 		}
 	}
 
@@ -652,8 +678,24 @@ void UDPConnection::Flush(const bool forced)
 			sendMore  = (outgoing.GetAverage(true) <= globalConfig->linkOutgoingBandwidth);
 			sendMore |= ((globalConfig->linkOutgoingBandwidth <= 0) || partialPacket || forced);
 
-			if (!outgoingData.empty() && sendMore) {
-				boost::shared_ptr<const RawPacket>& packet = *(outgoingData.begin());
+			if (!outgoingData.empty() && sendMore && outgoingData.front().block != NULL) {
+				const std::vector<ChunkDataPtr>& blockChunks = outgoingData.front().block->GetChunks();
+
+				// shared chunks can not take any of our own data, so close the current one
+				if (pos > 0) {
+					CreateChunk(buffer, pos, currentPacketChunkNum++);
+					pos = 0;
+				}
+
+				outgoing.DataSent(blockChunks[outgoingBlockChunk]->GetSize(), true);
+				CreateChunk(blockChunks[outgoingBlockChunk++], currentPacketChunkNum++);
+
+				if (outgoingBlockChunk == blockChunks.size()) {
+					outgoingData.pop_front();
+					outgoingBlockChunk = 0;
+				}
+			} else if (!outgoingData.empty() && sendMore) {
+				boost::shared_ptr<const RawPacket>& packet = outgoingData.front().packet;
 
 				if (!partialPacket && !ProtocolDef::GetInstance()->IsValidPacket(packet->data, packet->length)) {
 					LOG_L(L_ERROR,
@@ -758,10 +800,15 @@ void UDPConnection::SetMTU(unsigned mtu2)
 void UDPConnection::CreateChunk(const unsigned char* data, const unsigned length, const int packetNum)
 {
 	assert((length > 0) && (length < 255));
+	CreateChunk(ChunkDataPtr(new ChunkData(data, length)), packetNum);
+}
+
+void UDPConnection::CreateChunk(ChunkDataPtr data, const int packetNum)
+{
 	ChunkPtr buf(new Chunk);
 	buf->chunkNumber = packetNum;
-	buf->chunkSize = length;
-	std::copy(data, data+length, std::back_inserter(buf->data));
+	buf->chunkSize = data->GetSize();
+	buf->data = data;
 	newChunks.push_back(buf);
 	lastChunkCreatedTime = spring_gettime();
 }
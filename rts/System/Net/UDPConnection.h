@@ -9,6 +9,7 @@
 #include <deque>
 #include <list>
 
+#include "BroadcastBlock.h"
 #include "Connection.h"
 #include "System/Misc/SpringTime.h"
 
@@ -27,16 +28,30 @@ namespace netcode {
 #define PACKET_MAX_LATENCY 1250               // in [milliseconds] maximum latency
 #define ENABLE_DEBUG_STATS
 
+/**
+ * @brief payload of a chunk
+ * Immutable, so chunks of different connections can share it (see BroadcastBlock).
+ */
+class ChunkData
+{
+public:
+	ChunkData(const boost::uint8_t* data, unsigned length);
+	unsigned GetSize() const { return bytes.size(); }
+	const std::vector<boost::uint8_t> bytes;
+	/// CRC of bytes, computed once
+	const unsigned int checksum;
+};
+
 class Chunk
 {
 public:
-	unsigned GetSize() const { return (data.size() + headerSize); }
+	unsigned GetSize() const { return (data->GetSize() + headerSize); }
 	void UpdateChecksum(CRC& crc) const;
 	static const unsigned maxSize = 254;
 	static const unsigned headerSize = 5;
 	boost::int32_t chunkNumber;
 	boost::uint8_t chunkSize;
-	std::vector<boost::uint8_t> data;
+	ChunkDataPtr data;
 };
 typedef boost::shared_ptr<Chunk> ChunkPtr;
 
@@ -87,6 +102,7 @@ public:
 
 	// START overriding CConnection
 	void SendData(boost::shared_ptr<const RawPacket> data);
+	void SendSharedData(boost::shared_ptr<const BroadcastBlock> block);
 	bool HasIncomingData() const { return !msgQueue.empty(); }
 	boost::shared_ptr<const RawPacket> Peek(unsigned ahead) const;
 	boost::shared_ptr<const RawPacket> GetData();
@@ -138,6 +154,7 @@ private:
 	/// add header to data and send it
 	void CreateChunk(const unsigned char* data, const unsigned length,
 			const int packetNum);
+	void CreateChunk(ChunkDataPtr data, const int packetNum);
 	void SendIfNecessary(bool flushed);
 	void AckChunks(int lastAck);
 
@@ -155,8 +172,16 @@ private:
 	spring_time lastFramePacketRecvTime;
 	#endif
 
+	/// a single message or a block of them that is shared with other connections
+	struct OutgoingData {
+		unsigned GetLength() const { return ((block != NULL)? block->GetLength(): packet->length); }
+
+		boost::shared_ptr<const RawPacket> packet;
+		boost::shared_ptr<const BroadcastBlock> block;
+	};
+
 	typedef boost::ptr_map<int,RawPacket> packetMap;
-	typedef std::list< boost::shared_ptr<const RawPacket> > packetList;
+	typedef std::list<OutgoingData> packetList;
 	/// address of the other end
 	boost::asio::ip::udp::endpoint addr;
 
@@ -174,6 +199,8 @@ private:
 
 	/// outgoing stuff (pure data without header) waiting to be sent
 	packetList outgoingData;
+	/// index of the next chunk to send from the block at the front of outgoingData
+	unsigned int outgoingBlockChunk;
 	/// packets we have received but not yet read
 	packetMap waitingPackets;
 
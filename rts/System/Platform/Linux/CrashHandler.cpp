@@ -25,6 +25,7 @@
 
 #include "System/FileSystem/FileSystem.h"
 #include "Game/GameVersion.h"
+#include "System/Log/FileSink.h"
 #include "System/Log/ILog.h"
 #include "System/Log/LogSinkHandler.h"
 #include "System/LogOutput.h"
@@ -879,6 +880,8 @@ namespace CrashHandler
 		ucontext_t* uctx = reinterpret_cast<ucontext_t*> (pctx);
 
 		logSinkHandler.SetSinking(false);
+		// write out queued records, the crash report is then logged synchronously
+		log_file_stopAsync();
 
 		std::string error = strsignal(signal);
 		// append the signal name (it seems there is no OS function to map signum to signame :<)
@@ -12,6 +12,7 @@
 #include <process.h>
 #include <shlobj.h>
 #include <shlwapi.h>
+#include <psapi.h>
 #ifndef SHGFP_TYPE_CURRENT
 	#define SHGFP_TYPE_CURRENT 0
 #endif
@@ -35,6 +36,7 @@
 #endif
 
 #if !defined(WIN32)
+#include <sys/resource.h> // for getrusage()
 #include <sys/utsname.h> // for uname()
 #include <sys/types.h> // for getpw
 #include <pwd.h> // for getpw
@@ -428,6 +430,40 @@ bool IsRunningInGDB() {
 	#endif
 }
 
+#ifdef WIN32
+typedef BOOL (WINAPI *LPFN_GETPROCESSMEMORYINFO) (HANDLE, PPROCESS_MEMORY_COUNTERS, DWORD);
+
+unsigned long long GetPeakMemoryUsage()
+{
+	// resolved at runtime, so we do not need to link against psapi
+	LPFN_GETPROCESSMEMORYINFO fnGetProcessMemoryInfo = (LPFN_GETPROCESSMEMORYINFO)GetProcAddress(
+		GetModuleHandle(TEXT("kernel32")), "K32GetProcessMemoryInfo");
+
+	PROCESS_MEMORY_COUNTERS pmc;
+
+	if (fnGetProcessMemoryInfo == NULL)
+		return 0;
+	if (!fnGetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+
+	return pmc.PeakWorkingSetSize;
+}
+#else
+unsigned long long GetPeakMemoryUsage()
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	#ifdef __APPLE__
+	return usage.ru_maxrss; // bytes
+	#else
+	return (usage.ru_maxrss * 1024ULL); // kilobytes
+	#endif
+}
+#endif
+
 std::string GetShortFileName(const std::string& file) {
 #ifdef WIN32
 	std::vector<TCHAR> shortPathC(file.size() + 1, 0);
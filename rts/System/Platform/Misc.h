@@ -85,6 +85,12 @@ bool Is64Bit();
 bool Is32BitEmulation();
 bool IsRunningInGDB();
 
+/**
+ * @return peak resident set size (working set on windows) of this process
+ *   in bytes, or 0 if it can not be determined
+ */
+unsigned long long GetPeakMemoryUsage();
+
 /**
  * Executes a native binary, file and args have to be not escaped!
  * http://linux.die.net/man/3/execvp
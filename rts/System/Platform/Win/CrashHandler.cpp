@@ -7,6 +7,7 @@
 
 #include "System/Platform/CrashHandler.h"
 #include "System/Platform/errorhandler.h"
+#include "System/Log/FileSink.h"
 #include "System/Log/ILog.h"
 #include "System/Log/LogSinkHandler.h"
 #include "System/LogOutput.h"
@@ -29,6 +30,9 @@ int dummyStackLock = stackLockInit();
 
 static void SigAbrtHandler(int signal)
 {
+	// write out queued records, the crash report is then logged synchronously
+	log_file_stopAsync();
+
 	// cause an exception if on windows
 	LOG_L(L_ERROR, "Spring received an ABORT signal");
 
@@ -338,6 +342,7 @@ LONG CALLBACK ExceptionHandler(LPEXCEPTION_POINTERS e)
 {
 	// Prologue.
 	logSinkHandler.SetSinking(false);
+	log_file_stopAsync();
 	LOG_L(L_ERROR, "Spring %s has crashed.", (SpringVersion::GetFull()).c_str());
 	PrepareStacktrace();
 
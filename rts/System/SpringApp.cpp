@@ -638,6 +638,7 @@ void SpringApp::ParseCmdLine(const std::string& binaryName)
 	cmdline->AddSwitch('t', "textureatlas",       "Dump each finalized textureatlas in textureatlasN.tga");
 	cmdline->AddInt(   0,   "benchmark",          "Enable benchmark mode (writes a benchmark.data file). The given number specifies the timespan to test.");
 	cmdline->AddInt(   0,   "benchmarkstart",     "Benchmark start time in minutes.");
+	cmdline->AddString(0,   "benchmarkreport",    "Run the whole benchmark at max sim speed and write a JSON summary (sim frames/sec, per-timer profiling, peak memory) to the given file.");
 
 	cmdline->AddSwitch(0,   "list-ai-interfaces", "Dump a list of available AI Interfaces to stdout");
 	cmdline->AddSwitch(0,   "list-skirmish-ais",  "Dump a list of available Skirmish AIs to stdout");
@@ -758,6 +759,9 @@ void SpringApp::ParseCmdLine(const std::string& binaryName)
 			CBenchmark::startFrame = cmdline->GetInt("benchmarkstart") * 60 * GAME_SPEED;
 		}
 		CBenchmark::endFrame = CBenchmark::startFrame + cmdline->GetInt("benchmark") * 60 * GAME_SPEED;
+		if (cmdline->IsSet("benchmarkreport")) {
+			CBenchmark::reportFile = cmdline->GetString("benchmarkreport");
+		}
 	}
 }
 
@@ -860,7 +864,7 @@ void SpringApp::Startup()
 
 		clientSetup->isHost = false;
 		pregame = new CPreGame(clientSetup);
-	} else if (extension == "sdf") {
+	} else if (extension == "sdf" || extension == "sdfz") {
 		// demo
 		clientSetup->isHost        = true;
 		clientSetup->myPlayerName += " (spec)";
@@ -943,6 +947,9 @@ void SpringApp::Reload(const std::string& script)
  */
 int SpringApp::Update()
 {
+	// collect the timings of the last frame, outside of any timed section
+	profiler.ProcessEvents();
+
 	if (globalRendering->FSAA)
 		glEnable(GL_MULTISAMPLE_ARB);
 
@@ -952,12 +959,12 @@ int SpringApp::Update()
 		ret = activeController->Update();
 
 		if (ret) {
-			ScopedTimer cputimer("GameController::Draw");
+			SCOPED_TIMER("GameController::Draw");
 			ret = activeController->Draw();
 		}
 	}
 
-	ScopedTimer cputimer("SwapBuffers");
+	SCOPED_TIMER("SwapBuffers");
 	spring_time pre = spring_now();
 	VSync.Delay();
 	SDL_GL_SwapWindow(window);
@@ -103,8 +103,10 @@ void good_fpu_control_registers(const char* text)
 		LOG_L(L_WARNING, "[%s] Sync warning: (env.sse_mode) MXCSR 0x%04X instead of 0x%04X or 0x%04X (\"%s\")", __FUNCTION__, fsse, sse_a, sse_b, text);
 		LOG_L(L_WARNING, "[%s] Sync warning: (env.x87_mode) FPUCW 0x%04X instead of 0x%04X or 0x%04X (\"%s\")", __FUNCTION__, fx87, x87_a, x87_b, text);
 
-		// Set single precision floating point math.
+		// Set single precision floating point math; streflop_init
+		// leaves the rounding mode alone so that is reset separately
 		streflop::streflop_init<streflop::Simple>();
+		streflop::fesetround(streflop::FE_TONEAREST);
 	#if defined(__SUPPORT_SNAN__)
 		streflop::feraiseexcept(streflop::FPU_Exceptions(streflop::FE_INVALID | streflop::FE_DIVBYZERO | streflop::FE_OVERFLOW));
 	#endif
@@ -120,8 +122,10 @@ void good_fpu_control_registers(const char* text)
 	if (!ret) {
 		LOG_L(L_WARNING, "[%s] Sync warning: FPUCW 0x%04X instead of 0x%04X or 0x%04X (\"%s\")", __FUNCTION__, fenv, x87_a, x87_b, text);
 
-		// Set single precision floating point math.
+		// Set single precision floating point math; streflop_init
+		// leaves the rounding mode alone so that is reset separately
 		streflop::streflop_init<streflop::Simple>();
+		streflop::fesetround(streflop::FE_TONEAREST);
 	#if defined(__SUPPORT_SNAN__)
 		streflop::feraiseexcept(streflop::FPU_Exceptions(streflop::FE_INVALID | streflop::FE_DIVBYZERO | streflop::FE_OVERFLOW));
 	#endif
@@ -6,8 +6,14 @@
 #include "SyncChecker.h"
 
 
-unsigned CSyncChecker::g_checksum;
+CSyncChecker::Lane CSyncChecker::lanes[NUM_SYNC_LANES];
 int CSyncChecker::inSyncedCode;
 
+#if defined(_MSC_VER)
+__declspec(thread) unsigned CSyncChecker::currentLane = SYNC_LANE_GENERAL;
+#else
+__thread unsigned CSyncChecker::currentLane = SYNC_LANE_GENERAL;
+#endif
+
 
 #endif // SYNCDEBUG
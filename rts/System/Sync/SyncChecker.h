@@ -3,6 +3,63 @@
 #ifndef SYNCCHECKER_H
 #define SYNCCHECKER_H
 
+#include <algorithm>
+
+/**
+ * Synced subsystems that keep their own checksum lane, in the order they
+ * are updated by CGame::SimFrame. Everything outside a SCOPED_SYNC_LANE
+ * (net commands, Lua GameFrame, ...) goes to SYNC_LANE_GENERAL.
+ */
+enum SyncLane {
+	SYNC_LANE_GENERAL     = 0,
+	SYNC_LANE_PATHING     = 1,
+	SYNC_LANE_UNITS       = 2,
+	SYNC_LANE_PROJECTILES = 3,
+	SYNC_LANE_FEATURES    = 4,
+	SYNC_LANE_SCRIPTS     = 5,
+	SYNC_LANE_LOS         = 6,
+	SYNC_LANE_TEAMS       = 7,
+	NUM_SYNC_LANES        = 8,
+};
+
+static inline const char* GetSyncLaneName(unsigned int lane) {
+	static const char* names[NUM_SYNC_LANES + 1] = {
+		"general",
+		"pathing",
+		"units",
+		"projectiles",
+		"features",
+		"scripts",
+		"los",
+		"teams",
+		"unknown",
+	};
+
+	return names[std::min(lane, unsigned(NUM_SYNC_LANES))];
+}
+
+/**
+ * The checksums a client reports for a frame (NETMSG_SYNCRESPONSE).
+ */
+struct SyncChecksums {
+	/**
+	 * Lanes are updated in SimFrame order, so the first one that differs
+	 * is the subsystem that diverged first (within the frame where the
+	 * desync shows up). Returns NUM_SYNC_LANES if all of them match.
+	 */
+	unsigned int FirstDivergingLane(const SyncChecksums& c) const {
+		unsigned int lane = 0;
+
+		while (lane < NUM_SYNC_LANES && laneChecksums[lane] == c.laneChecksums[lane])
+			++lane;
+
+		return lane;
+	}
+
+	unsigned int checksum;
+	unsigned int laneChecksums[NUM_SYNC_LANES];
+};
+
 #ifdef SYNCCHECK
 
 #ifdef TRACE_SYNC
@@ -14,12 +71,23 @@
 #endif
 
 #include <assert.h>
+#include <emmintrin.h>
 
 /**
  * @brief sync checker class
  *
  * A Lightweight sync debugger that just keeps a running checksum over all
  * assignments to synced variables.
+ *
+ * The checksum is split into lanes (one per SyncLane), each thread writes
+ * to the lane it has selected with SCOPED_SYNC_LANE. The lanes are folded
+ * together in a fixed order by GetChecksum; when clients desync the per-lane
+ * checksums tell which subsystem diverged first.
+ *
+ * The selected lane is not inherited by ThreadPool workers (for_mt and co.),
+ * those write to SYNC_LANE_GENERAL. Like before the split, synced variables
+ * must not be assigned from workers at all: concurrent updates of a lane
+ * would make its checksum depend on thread timing.
  */
 class CSyncChecker {
 
@@ -34,10 +102,49 @@ class CSyncChecker {
 		/**
 		 * Keeps a running checksum over all assignments to synced variables.
 		 */
-		static unsigned GetChecksum() { return g_checksum; }
-		static void NewFrame() { g_checksum = 0xfade1eaf; }
+		static unsigned GetChecksum() {
+			unsigned checksum = 0xfade1eaf;
+
+			for (unsigned n = 0; n < NUM_SYNC_LANES; ++n) {
+				checksum += lanes[n].checksum;
+				checksum ^= checksum << 16;
+				checksum += checksum >> 11;
+			}
+
+			return checksum;
+		}
+		static unsigned GetLaneChecksum(unsigned lane) { return lanes[lane].checksum; }
+		static SyncChecksums GetChecksums() {
+			SyncChecksums checksums;
+			checksums.checksum = GetChecksum();
+
+			for (unsigned n = 0; n < NUM_SYNC_LANES; ++n) {
+				checksums.laneChecksums[n] = lanes[n].checksum;
+			}
+
+			return checksums;
+		}
+
+		static void NewFrame() {
+			for (unsigned n = 0; n < NUM_SYNC_LANES; ++n) {
+				lanes[n].checksum = 0xfade1eaf + n;
+			}
+		}
+
+		/**
+		 * Selects the lane that Sync() of the calling thread writes to,
+		 * returns the previous one.
+		 */
+		static unsigned SetLane(unsigned lane) {
+			const unsigned prevLane = currentLane;
+			currentLane = lane;
+			return prevLane;
+		}
+		static unsigned GetLane() { return currentLane; }
 
 		static void Sync(const void* p, unsigned size) {
+			unsigned& g_checksum = lanes[currentLane].checksum;
+
 			// most common cases first, make it easy for compiler to optimize for it
 			// simple xor is not enough to detect multiple zeroes, e.g.
 #ifdef TRACE_SYNC_HEAVY
@@ -57,7 +164,7 @@ class CSyncChecker {
 			case 3:
 				// just here to make the switch statements contiguous (so it can be optimized)
 				for (unsigned i = 0; i < 3; ++i) {
-					g_checksum += *(const unsigned char*)p + i;
+					g_checksum += *((const unsigned char*)p + i);
 					g_checksum ^= g_checksum << 10;
 					g_checksum += g_checksum >> 1;
 				}
@@ -70,13 +177,19 @@ class CSyncChecker {
 			default:
 			{
 				unsigned i = 0;
+
+				if (size >= BULK_SYNC_SIZE) {
+					g_checksum = SyncBulk(p, size / 16, g_checksum);
+					i = (size / 16) * 4;
+				}
+
 				for (; i < (size & ~3) / 4; ++i) {
 					g_checksum += *(reinterpret_cast<const unsigned int*>(p) + i);
 					g_checksum ^= g_checksum << 16;
 					g_checksum += g_checksum >> 11;
 				}
-				for (; i < size; ++i) {
-					g_checksum += *(const unsigned char*)p + i;
+				for (i *= 4; i < size; ++i) {
+					g_checksum += *((const unsigned char*)p + i);
 					g_checksum ^= g_checksum << 10;
 					g_checksum += g_checksum >> 1;
 				}
@@ -87,11 +200,55 @@ class CSyncChecker {
 		}
 
 	private:
+		/**
+		 * Hashes numBlocks 16-byte blocks as four interleaved word streams
+		 * (same mixing steps as a single word, four at a time with SSE2) and
+		 * folds the streams into checksum. Used for arrays and large structs.
+		 */
+		static unsigned SyncBulk(const void* p, unsigned numBlocks, unsigned checksum) {
+			__m128i acc = _mm_set_epi32(checksum, checksum ^ 0x01, checksum ^ 0x02, checksum ^ 0x03);
+
+			for (unsigned n = 0; n < numBlocks; ++n) {
+				acc = _mm_add_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + n));
+				acc = _mm_xor_si128(acc, _mm_slli_epi32(acc, 16));
+				acc = _mm_add_epi32(acc, _mm_srli_epi32(acc, 11));
+			}
+
+			unsigned streams[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(streams), acc);
+
+			for (unsigned i = 0; i < 4; ++i) {
+				checksum += streams[i];
+				checksum ^= checksum << 16;
+				checksum += checksum >> 11;
+			}
+
+			return checksum;
+		}
+
+	private:
+		/// Sync() calls of at least this many bytes go through SyncBulk
+		static const unsigned BULK_SYNC_SIZE = 32;
+
+		/**
+		 * The sync checksum of a lane, one cacheline each so threads
+		 * updating different lanes do not contend.
+		 */
+		struct Lane {
+			unsigned checksum;
+			char padding[64 - sizeof(unsigned)];
+		};
+
+		static Lane lanes[NUM_SYNC_LANES];
 
 		/**
-		 * The sync checksum
+		 * Lane selected by the current thread.
 		 */
-		static unsigned g_checksum;
+#if defined(_MSC_VER)
+		static __declspec(thread) unsigned currentLane;
+#else
+		static __thread unsigned currentLane;
+#endif
 
 		/**
 		 * @brief in synced code
@@ -101,6 +258,20 @@ class CSyncChecker {
 		static int inSyncedCode;
 };
 
-#endif // SYNCDEBUG
 
-#endif // SYNCDEBUGGER_H
+/**
+ * Routes the sync checksum updates of the current thread into a lane
+ * until the end of the scope.
+ */
+class CScopedSyncLane {
+	public:
+		CScopedSyncLane(unsigned lane): prevLane(CSyncChecker::SetLane(lane)) {}
+		~CScopedSyncLane() { CSyncChecker::SetLane(prevLane); }
+
+	private:
+		unsigned prevLane;
+};
+
+#endif // SYNCCHECK
+
+#endif // SYNCCHECKER_H
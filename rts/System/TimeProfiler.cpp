@@ -2,10 +2,13 @@
 
 #include "System/TimeProfiler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstring>
-#include <boost/unordered_map.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/locks.hpp>
+#include <boost/thread/tss.hpp>
 
 #include "System/Log/ILog.h"
 #include "System/UnsyncedRNG.h"
@@ -13,104 +16,147 @@
 	#include "System/ThreadPool.h"
 #endif
 
+/// guards the TimeRecords
 static boost::mutex m;
-static std::map<int, std::string> hashToName;
-static std::map<int, int> refs;
 
+/// guards the timer names, the list of event buffers and the thread numbers
+static boost::mutex registryMutex;
+static std::vector<std::string> timerNames;
+static std::map<std::string, int> timerIDs;
+
+
+namespace {
+	enum {
+		EVENT_SHOW_GRAPH = 1,
+		EVENT_MT_TIMER   = 2,
+	};
+
+	struct TimerEvent {
+		int timerID;
+		int flags;
+		spring_time startTime;
+		spring_time endTime;
+	};
+
+	/**
+	 * Single-producer single-consumer ring of timer events, written only by
+	 * the thread owning it and drained by CTimeProfiler::ProcessEvents.
+	 */
+	struct ThreadEventBuffer {
+		ThreadEventBuffer(int _threadID, int _threadNum)
+			: head(0)
+			, tail(0)
+			, numDropped(0)
+			, orphaned(false)
+			, threadID(_threadID)
+			, threadNum(_threadNum)
+		{}
+
+		void Push(const TimerEvent& e) {
+			const unsigned h = head.load(std::memory_order_relaxed);
+
+			if ((h - tail.load(std::memory_order_acquire)) >= NUM_EVENTS) {
+				numDropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
 
+			events[h & (NUM_EVENTS - 1)] = e;
+			head.store(h + 1, std::memory_order_release);
+		}
 
-static unsigned hash_(const std::string& s)
-{
-	unsigned hash = s.size();
-	for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
-		hash += *it;
-	}
-	return hash;
-}
+		/// nesting depth per timer ID, only touched by the owning thread
+		unsigned& GetDepth(const int timerID) {
+			if (timerID >= depths.size())
+				depths.resize(timerID + 1, 0);
 
-static unsigned hash_(const char* s)
-{
-	unsigned hash = 0;
-	for (size_t i = 0; ; ++i) {
-		if (s[i]) {
-			hash += s[i];
-		} else {
-			unsigned len = i;
-			hash += len;
-			break;
+			return depths[timerID];
 		}
-	}
-	return hash;
-}
 
+		static const unsigned NUM_EVENTS = 32768;
 
-BasicTimer::BasicTimer(const std::string& myname)
-: hash(hash_(myname))
-, starttime(spring_gettime())
+		TimerEvent events[NUM_EVENTS];
 
-{
-	nameIterator = hashToName.find(hash);
-	if (nameIterator == hashToName.end()) {
-		nameIterator = hashToName.insert(std::pair<int,std::string>(hash, myname)).first;
-	}
+		std::atomic<unsigned> head;
+		std::atomic<unsigned> tail;
+		std::atomic<unsigned> numDropped;
+		/// set when the owning thread exited, the buffer is freed once drained
+		std::atomic<bool> orphaned;
+
+		std::vector<unsigned> depths;
+
+		/// index in threadNums, used as tid in traces
+		const int threadID;
+		/// ThreadPool thread number, for CTimeProfiler::profileCore
+		const int threadNum;
+	};
 }
 
+static std::vector<ThreadEventBuffer*> eventBuffers;
+static __thread ThreadEventBuffer* threadEventBuffer = NULL;
 
-BasicTimer::BasicTimer(const char* myname)
-: hash(hash_(myname))
-, starttime(spring_gettime())
+/// ThreadPool thread number of every thread that ever had a buffer, by threadID
+static std::vector<int> threadNums;
+/// events dropped by the buffers already freed
+static unsigned numDroppedFreed = 0;
 
+/// hands the buffer of an exiting thread over to DrainEventBuffers
+static void OrphanThreadEventBuffer(ThreadEventBuffer* buffer)
 {
-	nameIterator = hashToName.find(hash);
-	if (nameIterator == hashToName.end()) {
-		nameIterator = hashToName.insert(std::pair<int,std::string>(hash, myname)).first;
-	}
+	threadEventBuffer = NULL;
+	buffer->orphaned.store(true, std::memory_order_release);
 }
 
+/// only used for its cleanup at thread exit, threadEventBuffer is faster
+static boost::thread_specific_ptr<ThreadEventBuffer> threadEventBufferOwner(&OrphanThreadEventBuffer);
 
-const std::string& BasicTimer::GetName() const
-{
-	return nameIterator->second;
-}
+static const size_t MAX_TRACE_EVENTS = 1 << 21;
 
 
-spring_time BasicTimer::GetDuration() const
+static ThreadEventBuffer* GetThreadEventBuffer()
 {
-	return spring_difftime(spring_gettime(), starttime);
+	if (threadEventBuffer != NULL)
+		return threadEventBuffer;
+
+#ifdef THREADPOOL
+	const int threadNum = ThreadPool::GetThreadNum();
+#else
+	const int threadNum = 0;
+#endif
+
+	{
+		boost::lock_guard<boost::mutex> lk(registryMutex);
+
+		threadEventBuffer = new ThreadEventBuffer(threadNums.size(), threadNum);
+		threadNums.push_back(threadNum);
+		eventBuffers.push_back(threadEventBuffer);
+	}
+
+	threadEventBufferOwner.reset(threadEventBuffer);
+	return threadEventBuffer;
 }
 
 
-ScopedTimer::ScopedTimer(const std::string& name, bool autoShow)
-	: BasicTimer(name)
-	, autoShowGraph(autoShow)
 
+spring_time BasicTimer::GetDuration() const
 {
-	it = refs.find(hash);
-	if (it == refs.end()) {
-		it = refs.insert(std::pair<int,int>(hash, 0)).first;
-	}
-	++(it->second);
+	return spring_difftime(spring_gettime(), starttime);
 }
 
 
-ScopedTimer::ScopedTimer(const char* name, bool autoShow)
-	: BasicTimer(name)
+ScopedTimer::ScopedTimer(const int _timerID, bool autoShow)
+	: timerID(_timerID)
 	, autoShowGraph(autoShow)
-
 {
-	it = refs.find(hash);
-	if (it == refs.end()) {
-		it = refs.insert(std::pair<int,int>(hash, 0)).first;
-	}
-	++(it->second);
+	++(GetThreadEventBuffer()->GetDepth(timerID));
 }
 
 
 ScopedTimer::~ScopedTimer()
 {
-	int& ref = it->second;
-	if (--ref == 0)
-		profiler.AddTime(GetName(), GetDuration(), autoShowGraph);
+	ThreadEventBuffer* buffer = GetThreadEventBuffer();
+
+	if (--(buffer->GetDepth(timerID)) == 0)
+		profiler.AddTime(timerID, starttime, spring_gettime(), autoShowGraph);
 }
 
 ScopedOnceTimer::~ScopedOnceTimer()
@@ -120,15 +166,8 @@ ScopedOnceTimer::~ScopedOnceTimer()
 
 
 
-ScopedMtTimer::ScopedMtTimer(const std::string& name, bool autoShow)
-	: BasicTimer(name)
-	, autoShowGraph(autoShow)
-{
-}
-
-
-ScopedMtTimer::ScopedMtTimer(const char* name, bool autoShow)
-	: BasicTimer(name)
+ScopedMtTimer::ScopedMtTimer(const int _timerID, bool autoShow)
+	: timerID(_timerID)
 	, autoShowGraph(autoShow)
 {
 }
@@ -136,11 +175,7 @@ ScopedMtTimer::ScopedMtTimer(const char* name, bool autoShow)
 
 ScopedMtTimer::~ScopedMtTimer()
 {
-	profiler.AddTime(GetName(), GetDuration(), autoShowGraph);
-#ifdef THREADPOOL
-	auto& list = profiler.profileCore[ThreadPool::GetThreadNum()];
-	list.emplace_back(starttime, spring_gettime());
-#endif
+	profiler.AddTime(timerID, starttime, spring_gettime(), autoShowGraph, true);
 }
 
 
@@ -150,6 +185,7 @@ ScopedMtTimer::~ScopedMtTimer()
 //////////////////////////////////////////////////////////////////////
 
 CTimeProfiler::CTimeProfiler():
+	tracing(false),
 	lastBigUpdate(spring_gettime()),
 	currentPosition(0)
 {
@@ -170,12 +206,40 @@ CTimeProfiler& CTimeProfiler::GetInstance()
 	return tp;
 }
 
+int CTimeProfiler::GetTimerID(const std::string& name)
+{
+	boost::lock_guard<boost::mutex> lk(registryMutex);
+
+	const auto it = timerIDs.find(name);
+
+	if (it != timerIDs.end())
+		return it->second;
+
+	timerNames.push_back(name);
+	return (timerIDs[name] = timerNames.size() - 1);
+}
+
+void CTimeProfiler::AddTime(const int timerID, const spring_time startTime, const spring_time endTime, const bool showGraph, const bool mtTimer)
+{
+	const TimerEvent e = {
+		timerID,
+		(EVENT_SHOW_GRAPH * showGraph) | (EVENT_MT_TIMER * mtTimer),
+		startTime,
+		endTime
+	};
+
+	GetThreadEventBuffer()->Push(e);
+}
+
 void CTimeProfiler::Update()
 {
 	//FIXME non-locking threadsafe
 	boost::unique_lock<boost::mutex> ulk(m, boost::defer_lock);
 	while (!ulk.try_lock()) {}
 
+	// account the pending events to the current position before moving on
+	DrainEventBuffers();
+
 	++currentPosition;
 	currentPosition &= TimeRecord::frames_size-1;
 	for (auto& pi: profile) {
@@ -208,6 +272,14 @@ void CTimeProfiler::Update()
 	}
 }
 
+void CTimeProfiler::ProcessEvents()
+{
+	boost::unique_lock<boost::mutex> ulk(m, boost::defer_lock);
+	while (!ulk.try_lock()) {}
+
+	DrainEventBuffers();
+}
+
 float CTimeProfiler::GetPercent(const char* name)
 {
 	boost::unique_lock<boost::mutex> ulk(m, boost::defer_lock);
@@ -216,38 +288,188 @@ float CTimeProfiler::GetPercent(const char* name)
 	return profile[name].percent;
 }
 
-void CTimeProfiler::AddTime(const std::string& name, const spring_time time, const bool showGraph)
+CTimeProfiler::TimeRecord& CTimeProfiler::GetRecord(const int timerID, const bool showGraph)
+{
+	if (timerID < records.size() && records[timerID] != NULL)
+		return *records[timerID];
+
+	std::string name;
+	{
+		boost::lock_guard<boost::mutex> lk(registryMutex);
+		name = timerNames[timerID];
+	}
+
+	// create a new profile
+	auto& p = profile[name];
+	static UnsyncedRNG rand;
+	rand.Seed(spring_tomsecs(spring_gettime()));
+	p.color.x = rand.RandFloat();
+	p.color.y = rand.RandFloat();
+	p.color.z = rand.RandFloat();
+	p.showGraph = showGraph;
+
+	if (timerID >= records.size())
+		records.resize(timerID + 1, NULL);
+
+	return *(records[timerID] = &p);
+}
+
+void CTimeProfiler::DrainEventBuffers()
+{
+	std::vector<ThreadEventBuffer*> buffers;
+	{
+		boost::lock_guard<boost::mutex> lk(registryMutex);
+		buffers = eventBuffers;
+	}
+
+	for (ThreadEventBuffer* buffer: buffers) {
+		// read before head, so all events of an exited thread are seen
+		const bool orphaned = buffer->orphaned.load(std::memory_order_acquire);
+		const unsigned head = buffer->head.load(std::memory_order_acquire);
+		const unsigned tail = buffer->tail.load(std::memory_order_relaxed);
+
+		for (unsigned n = tail; n != head; ++n) {
+			const TimerEvent& e = buffer->events[n & (ThreadEventBuffer::NUM_EVENTS - 1)];
+			const spring_time time = e.endTime - e.startTime;
+
+			auto& p = GetRecord(e.timerID, (e.flags & EVENT_SHOW_GRAPH) != 0);
+			p.total   += time;
+			p.current += time;
+			p.frames[currentPosition] += time;
+			if (p.maxLag < time.toMilliSecsf()) {
+				p.maxLag     = time.toMilliSecsf();
+				p.newLagPeak = true;
+			}
+
+		#ifdef THREADPOOL
+			if ((e.flags & EVENT_MT_TIMER) != 0 && buffer->threadNum < profileCore.size())
+				profileCore[buffer->threadNum].emplace_back(e.startTime, e.endTime);
+		#endif
+
+			if (!tracing)
+				continue;
+
+			if (traceEvents.size() >= MAX_TRACE_EVENTS) {
+				LOG_L(L_WARNING, "[TimeProfiler] trace reached %u events, recording stopped", unsigned(MAX_TRACE_EVENTS));
+				tracing = false;
+				continue;
+			}
+
+			const TraceEvent te = {e.timerID, buffer->threadID, e.startTime, e.endTime};
+			traceEvents.push_back(te);
+		}
+
+		buffer->tail.store(head, std::memory_order_release);
+
+		if (!orphaned)
+			continue;
+
+		{
+			boost::lock_guard<boost::mutex> lk(registryMutex);
+
+			numDroppedFreed += buffer->numDropped.load(std::memory_order_relaxed);
+			eventBuffers.erase(std::find(eventBuffers.begin(), eventBuffers.end(), buffer));
+		}
+
+		delete buffer;
+	}
+}
+
+void CTimeProfiler::StartTrace()
+{
+	boost::unique_lock<boost::mutex> ulk(m, boost::defer_lock);
+	while (!ulk.try_lock()) {}
+
+	// events buffered so far belong to the time before the trace
+	DrainEventBuffers();
+
+	traceEvents.clear();
+	traceStartTime = spring_gettime();
+	tracing = true;
+}
+
+bool CTimeProfiler::StopTrace(const std::string& fileName)
+{
+	boost::unique_lock<boost::mutex> ulk(m, boost::defer_lock);
+	while (!ulk.try_lock()) {}
+
+	DrainEventBuffers();
+	tracing = false;
+
+	const bool ret = WriteTrace(fileName);
+
+	traceEvents.clear();
+	traceEvents.shrink_to_fit();
+	return ret;
+}
+
+static void WriteJSONString(FILE* file, const std::string& str)
 {
-	auto pi = profile.find(name);
-	if (pi != profile.end()) {
-		// profile already exists
-		//FIXME use atomic ints
-		auto& p = pi->second;
-		p.total   += time;
-		p.current += time;
-		p.frames[currentPosition] += time;
-		if (p.maxLag < time.toMilliSecsf()) {
-			p.maxLag     = time.toMilliSecsf();
-			p.newLagPeak = true;
+	fputc('"', file);
+
+	for (const char c: str) {
+		if (c == '"' || c == '\\') {
+			fputc('\\', file);
+			fputc(c, file);
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			fprintf(file, "\\u%04x", c);
+		} else {
+			fputc(c, file);
 		}
-	} else {
-		boost::unique_lock<boost::mutex> ulk(m, boost::defer_lock);
-		while (!ulk.try_lock()) {}
-
-		// create a new profile
-		auto& p = profile[name];
-		p.total   = time;
-		p.current = time;
-		p.maxLag  = time.toMilliSecsf();
-		p.percent = 0;
-		memset(p.frames, 0, TimeRecord::frames_size * sizeof(unsigned));
-		static UnsyncedRNG rand;
-		rand.Seed(spring_tomsecs(spring_gettime()));
-		p.color.x = rand.RandFloat();
-		p.color.y = rand.RandFloat();
-		p.color.z = rand.RandFloat();
-		p.showGraph = showGraph;
 	}
+
+	fputc('"', file);
+}
+
+bool CTimeProfiler::WriteTrace(const std::string& fileName) const
+{
+	FILE* file = fopen(fileName.c_str(), "w");
+
+	if (file == NULL) {
+		LOG_L(L_ERROR, "[TimeProfiler] could not open \"%s\" for writing the trace", fileName.c_str());
+		return false;
+	}
+
+	std::vector<std::string> names;
+	std::vector<int> threadNumbers;
+	{
+		boost::lock_guard<boost::mutex> lk(registryMutex);
+		names = timerNames;
+		threadNumbers = threadNums;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	// records are separated by a comma before every one but the first,
+	// so the list stays valid JSON if either part of it is empty
+	const char* separator = "";
+
+	// thread names, those of the ThreadPool carry its thread number
+	for (size_t n = 0; n < threadNumbers.size(); ++n) {
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"thread %u (%i)\"}}", separator, unsigned(n), unsigned(n), threadNumbers[n]);
+		separator = ",\n";
+	}
+
+	// complete events, timestamps in microseconds since the trace started
+	for (size_t n = 0; n < traceEvents.size(); ++n) {
+		const TraceEvent& te = traceEvents[n];
+
+		fprintf(file, "%s{\"name\":", separator);
+		WriteJSONString(file, names[te.timerID]);
+		fprintf(file, ",\"cat\":\"spring\",\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+			te.threadID,
+			(te.startTime - traceStartTime).toNanoSecsi() * 1e-3,
+			(te.endTime - te.startTime).toNanoSecsi() * 1e-3);
+		separator = ",\n";
+	}
+
+	fprintf(file, "\n]}\n");
+
+	const bool ok = (ferror(file) == 0);
+	fclose(file);
+
+	LOG("[TimeProfiler] wrote %u trace events to \"%s\"", unsigned(traceEvents.size()), fileName.c_str());
+	return ok;
 }
 
 void CTimeProfiler::PrintProfilingInfo() const
@@ -260,4 +482,16 @@ void CTimeProfiler::PrintProfilingInfo() const
 
 		LOG("%35s %16.2fms %5.2f%%", name.c_str(), tr.total.toMilliSecsf(), tr.percent * 100);
 	}
+
+	unsigned numDropped = 0;
+	{
+		boost::lock_guard<boost::mutex> lk(registryMutex);
+		numDropped = numDroppedFreed;
+
+		for (const ThreadEventBuffer* buffer: eventBuffers)
+			numDropped += buffer->numDropped.load(std::memory_order_relaxed);
+	}
+
+	if (numDropped > 0)
+		LOG("%35s %u (event buffers were full)", "Dropped timer events", numDropped);
 }
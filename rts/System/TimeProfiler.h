@@ -15,23 +15,21 @@
 
 // disable this if you want minimal profiling
 // (sim time is still measured because of game slowdown)
-#define SCOPED_TIMER(name) ScopedTimer myScopedTimerFromMakro(name);
-#define SCOPED_MT_TIMER(name) ScopedMtTimer myScopedTimerFromMakro(name);
+// the timer ID is looked up once per call-site, the timers themselves only
+// read the clock and append to the profiler's per-thread event buffer
+#define SCOPED_TIMER(name) static const int myScopedTimerIDFromMakro = profiler.GetTimerID(name); ScopedTimer myScopedTimerFromMakro(myScopedTimerIDFromMakro);
+#define SCOPED_MT_TIMER(name) static const int myScopedTimerIDFromMakro = profiler.GetTimerID(name); ScopedMtTimer myScopedTimerFromMakro(myScopedTimerIDFromMakro);
 
 
 class BasicTimer : public boost::noncopyable
 {
 public:
-	BasicTimer(const std::string& myname);
-	BasicTimer(const char* myname);
+	BasicTimer(): starttime(spring_gettime()) {}
 
-	const std::string& GetName() const;
 	spring_time GetDuration() const;
 
 protected:
-	const unsigned hash;
 	const spring_time starttime;
-	std::map<int, std::string>::iterator nameIterator;
 };
 
 
@@ -40,30 +38,29 @@ protected:
  *
  * Construct an instance of this class where you want to begin time measuring,
  * and destruct it at the end (or let it be autodestructed).
+ * Nested timers with the same ID on the same thread are only counted once.
  */
 class ScopedTimer : public BasicTimer
 {
 public:
-	ScopedTimer(const std::string& name, bool autoShow = false);
-	ScopedTimer(const char* name, bool autoShow = false);
+	ScopedTimer(const int timerID, bool autoShow = false);
 	~ScopedTimer();
 
 private:
+	const int timerID;
 	const bool autoShowGraph;
-	std::map<int, int>::iterator it;
 };
 
 
 class ScopedMtTimer : public BasicTimer
 {
 public:
-	ScopedMtTimer(const std::string& name, bool autoShow = false);
-	ScopedMtTimer(const char* name, bool autoShow = false);
+	ScopedMtTimer(const int timerID, bool autoShow = false);
 	~ScopedMtTimer();
 
 private:
+	const int timerID;
 	const bool autoShowGraph;
-	std::map<int, int>::iterator it;
 };
 
 
@@ -74,9 +71,14 @@ private:
 class ScopedOnceTimer : public BasicTimer
 {
 public:
-	ScopedOnceTimer(const std::string& name): BasicTimer(name) {}
-	ScopedOnceTimer(const char* name): BasicTimer(name) {}
+	ScopedOnceTimer(const std::string& name): name(name) {}
+	ScopedOnceTimer(const char* name): name(name) {}
 	~ScopedOnceTimer();
+
+	const std::string& GetName() const { return name; }
+
+private:
+	const std::string name;
 };
 
 
@@ -94,7 +96,26 @@ public:
 
 	void PrintProfilingInfo() const;
 
-	void AddTime(const std::string& name, const spring_time time, const bool showGraph = false);
+	/// returns the ID of the timer called <name>, registers it on first use
+	int GetTimerID(const std::string& name);
+
+	/**
+	 * Appends a begin/end event to the calling thread's event buffer, events
+	 * are dropped (and counted) if the buffer is full. Lock-free, callable
+	 * from any thread.
+	 */
+	void AddTime(const int timerID, const spring_time startTime, const spring_time endTime, const bool showGraph = false, const bool mtTimer = false);
+
+	/// moves the buffered events of all threads into the TimeRecords (main thread)
+	void ProcessEvents();
+
+	/**
+	 * While recording a trace all processed events are kept and written out
+	 * in the Chrome trace-event format (chrome://tracing, Perfetto) on stop.
+	 */
+	void StartTrace();
+	bool StopTrace(const std::string& fileName);
+	bool IsTracing() const { return tracing; }
 
 public:
 	struct TimeRecord {
@@ -129,6 +150,25 @@ public:
 	std::vector<std::deque<std::pair<spring_time,spring_time>>> profileCore;
 
 private:
+	void DrainEventBuffers();
+	TimeRecord& GetRecord(const int timerID, const bool showGraph);
+	bool WriteTrace(const std::string& fileName) const;
+
+	struct TraceEvent {
+		int timerID;
+		int threadID;
+		spring_time startTime;
+		spring_time endTime;
+	};
+
+private:
+	/// per timer ID, point into profile
+	std::vector<TimeRecord*> records;
+
+	std::vector<TraceEvent> traceEvents;
+	spring_time traceStartTime;
+	bool tracing;
+
 	spring_time lastBigUpdate;
 	/// increases each update, from 0 to (frames_size-1)
 	unsigned currentPosition;
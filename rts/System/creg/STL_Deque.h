@@ -12,11 +12,11 @@
 namespace creg
 {
 	/// Deque type (uses vector implementation)
-	template<typename T>
-	struct DeduceType< std::deque <T> > {
+	template<typename T, typename A>
+	struct DeduceType< std::deque <T, A> > {
 		static boost::shared_ptr<IType> Get() {
 			DeduceType<T> elemtype;
-			return boost::shared_ptr<IType>(new DynamicArrayType< std::deque<T> >(elemtype.Get()));
+			return boost::shared_ptr<IType>(new DynamicArrayType< std::deque<T, A> >(elemtype.Get()));
 		}
 	};
 }
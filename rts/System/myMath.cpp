@@ -14,6 +14,7 @@
 #undef near
 
 float2 CMyMath::headingToVectorTable[NUM_HEADINGS];
+float CMyMath::headingToSineTable[NUM_HEADING_SINES];
 
 void CMyMath::Init()
 {
@@ -26,6 +27,9 @@ void CMyMath::Init()
 			v.y = math::cos(ang);
 		headingToVectorTable[a] = v;
 	}
+	for (int a = 0; a < NUM_HEADING_SINES; ++a) {
+		headingToSineTable[a] = math::sin(a * TAANG2RAD);
+	}
 
 	unsigned checksum = 0;
 	for (int a = 0; a < NUM_HEADINGS; ++a) {
@@ -34,6 +38,11 @@ void CMyMath::Init()
 		checksum = 33 * checksum + *(unsigned*) &headingToVectorTable[a].y;
 	}
 
+	unsigned sineChecksum = 0;
+	for (int a = 0; a < NUM_HEADING_SINES; ++a) {
+		sineChecksum = 33 * sineChecksum + *(unsigned*) &headingToSineTable[a];
+	}
+
 #ifdef USE_VALGRIND
 	if (RUNNING_ON_VALGRIND) {
 		// Valgrind doesn't allow us setting the FPU, so syncing is impossible
@@ -49,6 +58,12 @@ void CMyMath::Init()
 			" your streflop library was not compiled with the correct"
 			" options, or you are not using streflop at all.");
 	}
+	if (sineChecksum != HEADING_SINE_CHECKSUM) {
+		throw unsupported_error(
+			"Invalid headingToSineTable checksum. Most likely"
+			" your streflop library was not compiled with the correct"
+			" options, or you are not using streflop at all.");
+	}
 #endif
 }
 
@@ -8,6 +8,7 @@
 #include "System/float3.h"
 
 #include <algorithm> // std::{min,max}
+#include <cstdlib> // std::abs
 
 #ifdef __GNUC__
 	#define _const __attribute__((const))
@@ -42,6 +43,10 @@ static const int SPRING_CIRCLE_DIVS = (SHORTINT_MAXVALUE << 1);
 	#error "HEADING_CHECKSUM not set, invalid NUM_HEADINGS?"
 #endif
 
+/// one entry per heading of the first quadrant, both ends included
+#define NUM_HEADING_SINES ((SHORTINT_MAXVALUE >> 1) + 1)
+#define HEADING_SINE_CHECKSUM 0xa0be2578
+
 enum FacingMap {
 	FACING_NORTH = 2,
 	FACING_SOUTH = 0,
@@ -54,6 +59,7 @@ class CMyMath {
 public:
 	static void Init();
 	static float2 headingToVectorTable[NUM_HEADINGS];
+	static float headingToSineTable[NUM_HEADING_SINES];
 };
 
 
@@ -69,6 +75,8 @@ short int GetHeadingFromVector(const float dx, const float dz) _pure _warn_unuse
 shortint2 GetHAndPFromVector(const float3 vec) _pure _warn_unused_result; // vec should be normalized
 float2 GetHAndPFromVectorF(const float3 vec) _pure _warn_unused_result; // vec should be normalized
 float3 GetVectorFromHeading(const short int heading) _pure _warn_unused_result;
+float GetSinFromHeading(const short int heading) _pure _warn_unused_result;
+float GetCosFromHeading(const short int heading) _pure _warn_unused_result;
 float3 GetVectorFromHAndPExact(const short int heading, const short int pitch) _pure _warn_unused_result;
 
 float3 CalcBeizer(const float i, const float3 p1, const float3 p2, const float3 p3, const float3 p4) _pure _warn_unused_result;
@@ -121,6 +121,31 @@ inline float3 GetVectorFromHeading(const short int heading)
 	return float3(vec.x, 0.0f, vec.y);
 }
 
+/**
+ * Sync-safe replacements for math::sin(heading * TAANG2RAD) and
+ * math::cos(heading * TAANG2RAD) at full heading resolution: the
+ * first quadrant comes straight from streflop (at CMyMath::Init),
+ * the others are mirrored from it.
+ */
+inline float GetSinFromHeading(const short int heading)
+{
+	const int absHeading = std::abs(int(heading));
+	const int idx = (absHeading <= (SHORTINT_MAXVALUE >> 1))? absHeading: (SHORTINT_MAXVALUE - absHeading);
+	const float s = CMyMath::headingToSineTable[idx];
+
+	return ((heading < 0)? -s: s);
+}
+
+inline float GetCosFromHeading(const short int heading)
+{
+	const int absHeading = std::abs(int(heading));
+
+	if (absHeading <= (SHORTINT_MAXVALUE >> 1))
+		return CMyMath::headingToSineTable[(SHORTINT_MAXVALUE >> 1) - absHeading];
+
+	return -CMyMath::headingToSineTable[absHeading - (SHORTINT_MAXVALUE >> 1)];
+}
+
 inline float3 CalcBeizer(const float i, const float3 p1, const float3 p2, const float3 p3, const float3 p4)
 {
 	const float ni = 1.0f - i;
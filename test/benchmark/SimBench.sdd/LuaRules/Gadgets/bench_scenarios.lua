@@ -0,0 +1,204 @@
+function gadget:GetInfo()
+return {
+	name    = "SimBench-Scenarios",
+	desc    = "Sets up and drives the sim benchmark scenarios (modoption scenario)",
+	author  = "spring",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+if (not gadgetHandler:IsSyncedCode()) then
+	return
+end
+
+-- timings, sim frames/sec and peak memory are measured by the engine
+-- (see spring --benchmarkreport), this only creates the load
+
+local CreateUnit = Spring.CreateUnit
+local GiveOrderToUnit = Spring.GiveOrderToUnit
+local SpawnProjectile = Spring.SpawnProjectile
+local GetGroundHeight = Spring.GetGroundHeight
+local GetUnitWeaponHaveFreeLineOfFire = Spring.GetUnitWeaponHaveFreeLineOfFire
+local random = math.random
+
+local modOptions = Spring.GetModOptions() or {}
+local scenario = modOptions.scenario or "pathing"
+local count = tonumber(modOptions.count or "")
+
+local mapx, mapz = Game.mapSizeX, Game.mapSizeZ
+
+local function RandomPos(border)
+	border = border or 64
+	return border + random() * (mapx - 2 * border), border + random() * (mapz - 2 * border)
+end
+
+local function SpawnUnits(defName, num, teamID, xmin, xmax)
+	local units = {}
+	for i = 1, num do
+		local x = xmin + random() * (xmax - xmin)
+		local z = 64 + random() * (mapz - 128)
+		local unitID = CreateUnit(defName, x, GetGroundHeight(x, z), z, 0, teamID)
+		if unitID then
+			units[#units + 1] = unitID
+		end
+	end
+	return units
+end
+
+
+local scenarios = {}
+
+-- N units per team crossing the map (through the passes of the generated map's ridge)
+scenarios.pathing = {
+	Start = function(self)
+		local num = count or 500
+		self.west = SpawnUnits("benchtank", num, 0, 64, mapx * 0.2)
+		self.east = SpawnUnits("benchtank", num, 1, mapx * 0.8, mapx - 64)
+	end,
+	GameFrame = function(self, n)
+		if n % 900 ~= 1 then
+			return
+		end
+		-- send both groups to the far side, back and forth
+		local toEast = (math.floor(n / 900) % 2 == 0)
+		for _, unitID in ipairs(self.west) do
+			local x = toEast and (mapx - 128 - random() * 256) or (128 + random() * 256)
+			GiveOrderToUnit(unitID, CMD.MOVE, {x, 0, 64 + random() * (mapz - 128)}, {})
+		end
+		for _, unitID in ipairs(self.east) do
+			local x = toEast and (128 + random() * 256) or (mapx - 128 - random() * 256)
+			GiveOrderToUnit(unitID, CMD.MOVE, {x, 0, 64 + random() * (mapz - 128)}, {})
+		end
+	end,
+}
+
+-- shells raining down on the whole map, every impact deforms the terrain
+scenarios.artillery = {
+	Start = function(self)
+		self.shellDefID = WeaponDefNames["benchshell"].id
+		self.perFrame = count or 40
+		-- something to hit, so craters also have to move units around
+		SpawnUnits("benchtank", 100, 0, 64, mapx - 64)
+	end,
+	GameFrame = function(self, n)
+		for i = 1, self.perFrame do
+			local x, z = RandomPos()
+			local y = GetGroundHeight(x, z) + 600
+			SpawnProjectile(self.shellDefID, {
+				pos = {x, y, z},
+				speed = {random() * 2 - 1, -2, random() * 2 - 1},
+				gravity = -0.15,
+				team = 0,
+			})
+		end
+	end,
+}
+
+-- keep ~count slow ballistic projectiles in the air at all times
+scenarios.projectiles = {
+	Start = function(self)
+		self.shellDefID = WeaponDefNames["benchslowshell"].id
+		self.num = count or 10000
+		-- vy = 2, gravity = 0.02: each shell flies ~200 frames
+		self.perFrame = math.ceil(self.num / 200)
+	end,
+	GameFrame = function(self, n)
+		for i = 1, self.perFrame do
+			local x, z = RandomPos()
+			SpawnProjectile(self.shellDefID, {
+				pos = {x, GetGroundHeight(x, z) + 10, z},
+				speed = {random() - 0.5, 2, random() - 0.5},
+				gravity = -0.02,
+				team = 1,
+			})
+		end
+	end,
+}
+
+-- fast units with large sight and radar ranges milling about, so LOS and
+-- radar coverage of both allyteams changes every frame
+scenarios.los = {
+	Start = function(self)
+		local num = count or 300
+		self.units = SpawnUnits("benchscout", num, 0, 64, mapx - 64)
+		local others = SpawnUnits("benchscout", num, 1, 64, mapx - 64)
+		for _, unitID in ipairs(others) do
+			self.units[#self.units + 1] = unitID
+		end
+	end,
+	GameFrame = function(self, n)
+		-- re-target a rotating tenth of the units each frame
+		local units = self.units
+		for i = (n % 10) + 1, #units, 10 do
+			local x, z = RandomPos()
+			GiveOrderToUnit(units[i], CMD.MOVE, {x, 0, z}, {})
+		end
+	end,
+}
+
+-- line-of-fire checks along long random rays over the whole map, i.e.
+-- mostly ground collision tests (CGround::LineGroundCol)
+scenarios.raycast = {
+	Start = function(self)
+		self.turrets = SpawnUnits("benchturret", 50, 0, 64, mapx - 64)
+		self.perFrame = count or 2000
+	end,
+	GameFrame = function(self, n)
+		local turrets = self.turrets
+		if #turrets == 0 then
+			return
+		end
+		for i = 1, self.perFrame do
+			local x, z = RandomPos()
+			local y = GetGroundHeight(x, z) + random() * 200
+			GetUnitWeaponHaveFreeLineOfFire(turrets[(i % #turrets) + 1], 1, x, y, z)
+		end
+	end,
+}
+
+-- missiles crossing the map through a field of anti-missile turrets,
+-- i.e. interceptor matching (CInterceptHandler)
+scenarios.intercept = {
+	Start = function(self)
+		self.missileDefID = WeaponDefNames["benchmissile"].id
+		self.perFrame = count or 20
+		SpawnUnits("benchinterceptor", 300, 1, 64, mapx - 64)
+	end,
+	GameFrame = function(self, n)
+		for i = 1, self.perFrame do
+			local x, z = RandomPos()
+			local tx, tz = RandomPos()
+			local y = GetGroundHeight(x, z) + 300
+			local dx, dz = tx - x, tz - z
+			local len = math.max(1, math.sqrt(dx * dx + dz * dz))
+			SpawnProjectile(self.missileDefID, {
+				pos = {x, y, z},
+				speed = {8 * dx / len, 0, 8 * dz / len},
+				["end"] = {tx, GetGroundHeight(tx, tz), tz},
+				ttl = 300,
+				team = 0,
+			})
+		end
+	end,
+}
+
+
+local current = scenarios[scenario]
+
+function gadget:Initialize()
+	if current == nil then
+		Spring.Log(gadget:GetInfo().name, LOG.ERROR, "unknown scenario: " .. tostring(scenario))
+		gadgetHandler:RemoveGadget()
+	end
+end
+
+function gadget:GameFrame(n)
+	if n == 1 then
+		Spring.Echo("SimBench: running scenario " .. scenario)
+		current:Start()
+	end
+	current:GameFrame(n)
+end
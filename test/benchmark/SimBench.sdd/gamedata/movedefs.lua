@@ -0,0 +1,11 @@
+return {
+	{
+		name = "BENCHTANK2",
+		speedModClass = 0, -- tank
+		footprintX = 2,
+		footprintZ = 2,
+		maxSlope = 18,
+		maxWaterDepth = 20,
+		crushStrength = 50,
+	},
+}
@@ -0,0 +1,7 @@
+-- teams start without units, the scenarios spawn what they need
+return {
+	{
+		name = "Bench",
+		startUnit = "benchtank",
+	},
+}
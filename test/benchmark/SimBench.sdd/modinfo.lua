@@ -0,0 +1,13 @@
+-- content-free game for the sim benchmark suite, see test/benchmark/run.sh
+local modinfo = {
+	name        = "SimBench",
+	shortname   = "SimBench",
+	version     = "1",
+	description = "Scripted sim benchmark scenarios, needs no external content",
+	modtype     = 1,
+	depend = {
+		"Spring content v1",
+	},
+}
+
+return modinfo
@@ -0,0 +1,20 @@
+-- no model and no script, like benchturret: the intercept scenario only
+-- needs many interceptor weapons spread over the map
+return {
+	benchinterceptor = {
+		name = "Bench Interceptor",
+		description = "Static anti-missile unit for the intercept scenario",
+		objectName = "benchinterceptor.s3o",
+		footprintX = 2,
+		footprintZ = 2,
+		maxDamage = 100000,
+		sightDistance = 400,
+		buildCostMetal = 100,
+		buildCostEnergy = 100,
+		buildTime = 100,
+		category = "GROUND",
+		weapons = {
+			{ def = "BENCHANTIMISSILE" },
+		},
+	},
+}
@@ -0,0 +1,23 @@
+return {
+	benchscout = {
+		name = "Bench Scout",
+		description = "Fast unit with a large LOS radius for the LOS churn scenario",
+		objectName = "benchscout.s3o",
+		movementClass = "BENCHTANK2",
+		footprintX = 2,
+		footprintZ = 2,
+		maxDamage = 200,
+		maxVelocity = 5.0,
+		acceleration = 0.3,
+		brakeRate = 0.5,
+		turnRate = 1200,
+		sightDistance = 900,
+		airSightDistance = 900,
+		radarDistance = 1500,
+		buildCostMetal = 50,
+		buildCostEnergy = 50,
+		buildTime = 50,
+		canMove = true,
+		category = "GROUND",
+	},
+}
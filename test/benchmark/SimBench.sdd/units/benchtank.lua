@@ -0,0 +1,24 @@
+-- no model and no script on purpose: the engine falls back to a
+-- dummy model and a null script, the scenarios only need movement
+return {
+	benchtank = {
+		name = "Bench Tank",
+		description = "Ground unit for the pathing and LOS scenarios",
+		objectName = "benchtank.s3o",
+		movementClass = "BENCHTANK2",
+		footprintX = 2,
+		footprintZ = 2,
+		maxDamage = 1000,
+		maxVelocity = 2.5,
+		acceleration = 0.1,
+		brakeRate = 0.3,
+		turnRate = 800,
+		sightDistance = 400,
+		radarDistance = 800,
+		buildCostMetal = 100,
+		buildCostEnergy = 100,
+		buildTime = 100,
+		canMove = true,
+		category = "GROUND",
+	},
+}
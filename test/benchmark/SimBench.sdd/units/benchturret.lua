@@ -0,0 +1,20 @@
+-- no model and no script, like benchtank: the raycast scenario only
+-- needs a weapon to ask for line-of-fire checks
+return {
+	benchturret = {
+		name = "Bench Turret",
+		description = "Static unit with a long-range weapon for the raycast scenario",
+		objectName = "benchturret.s3o",
+		footprintX = 2,
+		footprintZ = 2,
+		maxDamage = 1000,
+		sightDistance = 400,
+		buildCostMetal = 100,
+		buildCostEnergy = 100,
+		buildTime = 100,
+		category = "GROUND",
+		weapons = {
+			{ def = "BENCHLASER" },
+		},
+	},
+}
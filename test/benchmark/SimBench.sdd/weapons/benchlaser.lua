@@ -0,0 +1,14 @@
+-- only used for Spring.GetUnitWeaponHaveFreeLineOfFire, never fired
+return {
+	benchlaser = {
+		name = "Bench Laser",
+		weaponType = "LaserCannon",
+		range = 8000,
+		weaponVelocity = 1000,
+		reloadTime = 1000,
+		areaOfEffect = 8,
+		damage = {
+			default = 1,
+		},
+	},
+}
@@ -0,0 +1,35 @@
+-- benchmissile is spawned directly by the intercept scenario through
+-- Spring.SpawnProjectile, benchantimissile shoots at them
+return {
+	benchmissile = {
+		name = "Bench Missile",
+		weaponType = "MissileLauncher",
+		range = 8000,
+		weaponVelocity = 8,
+		startVelocity = 8,
+		weaponAcceleration = 0,
+		flightTime = 60,
+		areaOfEffect = 16,
+		craterMult = 0.0,
+		craterBoost = 0.0,
+		impulseFactor = 0.0,
+		targetable = 1,
+		damage = {
+			default = 1,
+		},
+	},
+	benchantimissile = {
+		name = "Bench Anti-Missile",
+		weaponType = "MissileLauncher",
+		range = 800,
+		coverage = 600,
+		interceptor = 1,
+		weaponVelocity = 20,
+		startVelocity = 20,
+		reloadTime = 2,
+		areaOfEffect = 8,
+		damage = {
+			default = 1,
+		},
+	},
+}
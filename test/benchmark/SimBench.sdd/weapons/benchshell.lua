@@ -0,0 +1,31 @@
+-- spawned directly by the scenarios through Spring.SpawnProjectile
+return {
+	benchshell = {
+		name = "Bench Artillery Shell",
+		weaponType = "Cannon",
+		range = 2000,
+		weaponVelocity = 400,
+		areaOfEffect = 96,
+		craterMult = 1.0,
+		craterBoost = 0.5,
+		impulseFactor = 0.5,
+		myGravity = 0.15,
+		damage = {
+			default = 50,
+		},
+	},
+	benchslowshell = {
+		name = "Bench Slow Shell",
+		weaponType = "Cannon",
+		range = 2000,
+		weaponVelocity = 60,
+		areaOfEffect = 16,
+		craterMult = 0.0,
+		craterBoost = 0.0,
+		impulseFactor = 0.0,
+		myGravity = 0.02,
+		damage = {
+			default = 1,
+		},
+	},
+}
@@ -0,0 +1,128 @@
+#!/bin/sh
+
+# Runs the content-free sim benchmark scenarios on spring-headless and
+# collects one JSON report (sim frames/sec, per-timer profiling, peak RSS)
+# per scenario in the output directory.
+
+set -e # abort on error
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 /path/to/spring-headless outputdir [scenario[:count] ...]"
+	echo "Scenarios: pathing artillery projectiles los raycast intercept (default: all)"
+	exit 1
+fi
+
+SPRING="$1"
+OUTDIR="$2"
+shift 2
+
+if [ ! -x "$SPRING" ]; then
+	echo "Parameter 1 $SPRING isn't executable!"
+	exit 1
+fi
+
+SCENARIOS="$*"
+if [ -z "$SCENARIOS" ]; then
+	SCENARIOS="pathing artillery projectiles los raycast intercept"
+fi
+
+# warm up for one minute of game time, then measure two
+BENCH_START=1
+BENCH_LENGTH=2
+
+BENCHDIR=$(cd "$(dirname "$0")" && pwd)
+SPRINGDIR=$(cd "$(dirname "$SPRING")" && pwd)
+
+mkdir -p "$OUTDIR"
+OUTDIR=$(cd "$OUTDIR" && pwd)
+
+# private write-dir, so caches and configs of other installs do not interfere
+WRITEDIR="$OUTDIR/writedir"
+rm -rf "$WRITEDIR"
+mkdir -p "$WRITEDIR/games"
+ln -s "$BENCHDIR/SimBench.sdd" "$WRITEDIR/games/SimBench.sdd"
+
+# base content is searched next to the binary (build or install dir)
+export SPRING_DATADIR="$SPRINGDIR:$SPRINGDIR/share/games/spring"
+
+EXIT=0
+
+for ENTRY in $SCENARIOS; do
+	SCENARIO=${ENTRY%%:*}
+	COUNT=""
+	if [ "$SCENARIO" != "$ENTRY" ]; then
+		COUNT=${ENTRY#*:}
+	fi
+
+	SCRIPT="$WRITEDIR/$SCENARIO.txt"
+	cat > "$SCRIPT" <<EOD
+[GAME]
+{
+	GameType=SimBench 1;
+	MapName=SimBenchMap;
+	MapSeed=1;
+	IsHost=1;
+	MyPlayerName=SimBench;
+	StartPosType=0;
+
+	[MAPOPTIONS]
+	{
+		mapsize=8;
+	}
+
+	[MODOPTIONS]
+	{
+		scenario=$SCENARIO;
+		count=$COUNT;
+		MaxSpeed=100;
+	}
+
+	[PLAYER0]
+	{
+		Name=SimBench;
+		Spectator=1;
+		Team=0;
+	}
+
+	[TEAM0]
+	{
+		TeamLeader=0;
+		AllyTeam=0;
+	}
+	[TEAM1]
+	{
+		TeamLeader=0;
+		AllyTeam=1;
+	}
+
+	[ALLYTEAM0]
+	{
+		NumAllies=0;
+	}
+	[ALLYTEAM1]
+	{
+		NumAllies=0;
+	}
+}
+EOD
+
+	echo "Running scenario $ENTRY"
+	REPORT="$OUTDIR/$SCENARIO.json"
+	rm -f "$REPORT"
+
+	set +e # temp disable abort on error
+	"$SPRING" --nocolor --write-dir "$WRITEDIR" \
+		--benchmark $BENCH_LENGTH --benchmarkstart $BENCH_START --benchmarkreport "$REPORT" \
+		"$SCRIPT" > "$OUTDIR/$SCENARIO.log" 2>&1
+	RET=$?
+	set -e
+
+	if [ $RET -ne 0 ] || [ ! -f "$REPORT" ]; then
+		echo "Scenario $ENTRY failed (exit code $RET), see $OUTDIR/$SCENARIO.log"
+		EXIT=1
+	else
+		grep '"simFramesPerSec"\|"peakRSS"' "$REPORT"
+	fi
+done
+
+exit $EXIT
@@ -0,0 +1,188 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosMap.h"
+#include "Map/ReadMap.h"
+#include "Game/GlobalUnsynced.h"
+#include "System/Misc/SpringTime.h"
+#include <cmath>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+#define BOOST_TEST_MODULE LosMap
+#include <boost/test/unit_test.hpp>
+
+// LosMap.cpp only touches these when sending readmap events (disabled here)
+CReadMap* readMap = nullptr;
+CGlobalUnsynced* gu = nullptr;
+void CReadMap::UpdateLOS(const SRectangle& rect) {}
+
+
+static const int MAP_SIZE = 128;
+static const int NUM_INSTANCES = 100;
+static const int NUM_TERRAIN_CHANGES = 300;
+
+
+static inline float randf()
+{
+	return rand() / float(RAND_MAX);
+}
+
+static inline int randi(int min, int max)
+{
+	return min + rand() % (max - min + 1);
+}
+
+
+static bool SameSquares(const SLosInstance& a, const SLosInstance& b)
+{
+	if (a.squares.size() != b.squares.size())
+		return false;
+
+	for (size_t i = 0; i < a.squares.size(); ++i) {
+		if (a.squares[i].start != b.squares[i].start || a.squares[i].length != b.squares[i].length)
+			return false;
+	}
+
+	return true;
+}
+
+
+/// same test as ILosType::UpdateHeightMapSynced
+static bool Overlaps(const SLosInstance& li, const SRectangle& rect)
+{
+	const int dx = std::max(0, std::max(rect.x1 - li.basePos.x, li.basePos.x - rect.x2));
+	const int dy = std::max(0, std::max(rect.y1 - li.basePos.y, li.basePos.y - rect.y2));
+
+	return (Square(dx) + Square(dy)) <= Square(li.radius + 1);
+}
+
+
+BOOST_AUTO_TEST_CASE( IncrementalRaycast )
+{
+	spring_clock::PushTickRate();
+	spring_time::setstarttime(spring_time::gettime(true));
+
+	srand( time(NULL) );
+
+	const int2 size(MAP_SIZE, MAP_SIZE);
+	std::vector<float> heightmap(MAP_SIZE * MAP_SIZE);
+
+	// some hills, so rays actually get blocked
+	for (int y = 0; y < MAP_SIZE; ++y) {
+		for (int x = 0; x < MAP_SIZE; ++x) {
+			heightmap[y * MAP_SIZE + x] = 40.0f * (std::sin(x * 0.15f) + std::cos(y * 0.1f)) + randf() * 10.0f;
+		}
+	}
+
+	CLosMap incMap(size, false, &heightmap[0], &heightmap[0], size);
+	CLosMap fullMap(size, false, &heightmap[0], &heightmap[0], size);
+
+	std::vector<SLosInstance> incInstances;
+	std::vector<SLosInstance> fullInstances;
+
+	for (int n = 0; n < NUM_INSTANCES; ++n) {
+		SLosInstance li(n);
+		li.allyteam = 0;
+		li.radius = randi(1, 40);
+		// includes emitters at and outside of the map borders
+		li.basePos = int2(randi(-10, MAP_SIZE + 9), randi(-10, MAP_SIZE + 9));
+		li.baseHeight = randf() * 100.0f - 20.0f;
+		li.refCount = 1;
+
+		incMap.PrepareRaycast(&li);
+		incMap.AddRaycast(&li, 1);
+		fullMap.AddRaycast(&li, 1);
+
+		incInstances.push_back(li);
+		fullInstances.push_back(li);
+	}
+
+	spring_time incTime;
+	spring_time fullTime;
+	int numIncremental = 0;
+	bool fail = false;
+
+	for (int n = 0; n < NUM_TERRAIN_CHANGES && !fail; ++n) {
+		// craters and walls
+		SRectangle rect;
+		rect.x1 = randi(0, MAP_SIZE - 1);
+		rect.y1 = randi(0, MAP_SIZE - 1);
+		rect.x2 = std::min(rect.x1 + randi(0, 8), MAP_SIZE - 1);
+		rect.y2 = std::min(rect.y1 + randi(0, 8), MAP_SIZE - 1);
+
+		const float dh = (randf() < 0.5f) ? (randf() * 60.0f - 30.0f) : (randf() * 200.0f);
+
+		for (int y = rect.y1; y <= rect.y2; ++y) {
+			for (int x = rect.x1; x <= rect.x2; ++x) {
+				heightmap[y * MAP_SIZE + x] += dh;
+			}
+		}
+
+		// #1: incremental update, as ILosType does it
+		spring_time t0 = spring_gettime();
+		for (SLosInstance& li: incInstances) {
+			if (!Overlaps(li, rect))
+				continue;
+
+			li.terraRect = rect;
+
+			if (incMap.CanUpdateRaycast(&li)) {
+				std::vector<int> squaresAdded;
+				std::vector<int> squaresRemoved;
+				incMap.PrepareRaycastUpdate(&li, squaresAdded, squaresRemoved);
+				incMap.AddSquares(&li, squaresRemoved, -1);
+				incMap.AddSquares(&li, squaresAdded, 1);
+				++numIncremental;
+			} else {
+				incMap.AddRaycast(&li, -1);
+				li.squares.clear();
+				incMap.PrepareRaycast(&li);
+				incMap.AddRaycast(&li, 1);
+			}
+		}
+		incTime += (spring_gettime() - t0);
+
+		// #2: recast from scratch, as before
+		// (the untimed pass also verifies the overlap test)
+		for (int pass = 0; pass < 2; ++pass) {
+			t0 = spring_gettime();
+			for (SLosInstance& li: fullInstances) {
+				if (Overlaps(li, rect) != (pass == 0))
+					continue;
+
+				fullMap.AddRaycast(&li, -1);
+				li.squares.clear();
+				fullMap.PrepareRaycast(&li);
+				fullMap.AddRaycast(&li, 1);
+			}
+			if (pass == 0)
+				fullTime += (spring_gettime() - t0);
+		}
+
+		// compare
+		for (int i = 0; i < NUM_INSTANCES; ++i) {
+			if (SameSquares(incInstances[i], fullInstances[i]))
+				continue;
+
+			const SLosInstance& li = fullInstances[i];
+			BOOST_TEST_MESSAGE("instance " << i << " (radius " << li.radius << " at " << li.basePos.x << "," << li.basePos.y << ") differs after change " << n);
+			fail = true;
+		}
+
+		for (int y = 0; y < MAP_SIZE; ++y) {
+			for (int x = 0; x < MAP_SIZE; ++x) {
+				if (incMap.At(int2(x, y)) == fullMap.At(int2(x, y)))
+					continue;
+
+				BOOST_TEST_MESSAGE("losmap differs at " << x << "," << y << " after change " << n);
+				fail = true;
+			}
+		}
+	}
+
+	BOOST_CHECK(!fail);
+	BOOST_TEST_MESSAGE("terrain changes: " << NUM_TERRAIN_CHANGES << ", incremental updates: " << numIncremental);
+	BOOST_TEST_MESSAGE("incremental: " << incTime.toMilliSecsf() << "ms, from scratch: " << fullTime.toMilliSecsf() << "ms");
+	BOOST_WARN(incTime < fullTime);
+}
@@ -11,6 +11,8 @@
 using boost::test_tools::output_test_stream;
 
 #include <cstdarg>
+#include <cstdio>
+#include <cstring>
 
 
 
@@ -236,5 +238,37 @@ BOOST_AUTO_TEST_CASE(IsEnabled)
 }
 
 
+BOOST_AUTO_TEST_CASE(AsyncFile)
+{
+	static const int numRecords = 1000;
+
+	// tiny queue, so the logging thread has to wait for the writer
+	log_file_enableAsync(16, LOG_FILE_ASYNC_BLOCK);
+
+	for (int i = 0; i < numRecords; ++i) {
+		LOG("Testing asynchronous file logging %i", i);
+	}
+
+	log_file_disableAsync();
+
+	FILE* file = fopen(logFile.c_str(), "r");
+	BOOST_REQUIRE(file != NULL);
+
+	char line[1024];
+	int numFound = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (strstr(line, "Testing asynchronous file logging") == NULL)
+			continue;
+
+		BOOST_CHECK(strstr(line, ("logging " + IntToString(numFound) + "\n").c_str()) != NULL);
+		numFound++;
+	}
+
+	fclose(file);
+	BOOST_CHECK_EQUAL(numFound, numRecords);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -0,0 +1,177 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Net/BroadcastBlock.h"
+#include "System/Net/UDPConnection.h"
+#include "System/GlobalConfig.h"
+#include "System/Misc/SpringTime.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+
+#include <boost/format.hpp>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE BroadcastBlock
+#include <boost/test/unit_test.hpp>
+
+typedef boost::shared_ptr<const netcode::RawPacket> PacketPtr;
+typedef boost::shared_ptr<netcode::UDPConnection> ConnectionPtr;
+
+static const int NUM_CLIENTS = 100;
+static const int NUM_FRAMES = 300;
+/// new frames sent per round, as when the server catches up
+static const int NUM_CATCHUP_FRAMES = 3;
+
+
+struct Loopback {
+	Loopback(int basePort) {
+		for (int i = 0; i < NUM_CLIENTS; ++i) {
+			servers.push_back(ConnectionPtr(new netcode::UDPConnection(basePort + i, "127.0.0.1", basePort + NUM_CLIENTS + i)));
+			clients.push_back(ConnectionPtr(new netcode::UDPConnection(basePort + NUM_CLIENTS + i, "127.0.0.1", basePort + i)));
+			servers.back()->Unmute();
+			clients.back()->Unmute();
+
+			// like a joining client, send something first so both ends are in sync
+			clients.back()->SendData(CBaseNetProtocol::Get().SendSystemMessage(0, "hello"));
+			clients.back()->Flush(true);
+		}
+
+		expected.resize(NUM_CLIENTS);
+		received.resize(NUM_CLIENTS);
+	}
+
+	void Broadcast(PacketPtr packet, bool shared) {
+		if (shared) {
+			pending.push_back(packet);
+		} else {
+			for (ConnectionPtr& conn: servers) {
+				conn->SendData(packet);
+			}
+		}
+
+		for (std::string& e: expected) {
+			e.append(packet->data, packet->data + packet->length);
+		}
+	}
+
+	void FlushBroadcasts() {
+		if (pending.empty())
+			return;
+
+		const boost::shared_ptr<const netcode::BroadcastBlock> block(new netcode::BroadcastBlock(pending));
+
+		for (ConnectionPtr& conn: servers) {
+			conn->SendSharedData(block);
+		}
+	}
+
+	void SendTo(int client, PacketPtr packet, bool shared) {
+		if (shared)
+			FlushBroadcasts();
+
+		servers[client]->SendData(packet);
+		expected[client].append(packet->data, packet->data + packet->length);
+	}
+
+	void Update() {
+		const spring_time t0 = spring_gettime();
+
+		for (ConnectionPtr& conn: servers) {
+			conn->Update();
+
+			while (conn->GetData() != NULL) {
+			}
+		}
+
+		serverTime += (spring_gettime() - t0);
+
+		for (int i = 0; i < NUM_CLIENTS; ++i) {
+			clients[i]->Update();
+
+			for (PacketPtr packet; (packet = clients[i]->GetData()) != NULL; ) {
+				received[i].append(packet->data, packet->data + packet->length);
+			}
+		}
+	}
+
+	bool Done() const {
+		for (int i = 0; i < NUM_CLIENTS; ++i) {
+			if (received[i].size() < expected[i].size())
+				return false;
+		}
+
+		return true;
+	}
+
+	std::vector<ConnectionPtr> servers;
+	std::vector<ConnectionPtr> clients;
+
+	std::vector<PacketPtr> pending;
+
+	std::vector<std::string> expected;
+	std::vector<std::string> received;
+
+	spring_time serverTime;
+};
+
+
+static spring_time RunLoopback(int basePort, bool shared)
+{
+	Loopback loopback(basePort);
+
+	CBaseNetProtocol& proto = CBaseNetProtocol::Get();
+
+	for (int frame = 0; frame < NUM_FRAMES; ++frame) {
+		const spring_time t0 = spring_gettime();
+
+		for (int n = 0; n < NUM_CATCHUP_FRAMES; ++n) {
+			loopback.Broadcast(proto.SendNewFrame(), shared);
+		}
+		if ((frame % 16) == 0) {
+			loopback.Broadcast(proto.SendKeyFrame(frame), shared);
+		}
+		if ((frame % 10) == 0) {
+			// spans several chunks
+			loopback.Broadcast(proto.SendSystemMessage(0, std::string(300 + frame, 'x')), shared);
+		}
+		if ((frame % 3) == 0) {
+			loopback.SendTo(frame % NUM_CLIENTS, proto.SendSystemMessage(0, str(boost::format("private %d") %frame)), shared);
+		}
+
+		loopback.Broadcast(proto.SendSystemMessage(0, str(boost::format("frame %d") %frame)), shared);
+
+		if (shared)
+			loopback.FlushBroadcasts();
+
+		loopback.serverTime += (spring_gettime() - t0);
+		loopback.Update();
+	}
+
+	for (spring_time t = spring_gettime(); !loopback.Done() && (spring_gettime() - t) < spring_secs(30); ) {
+		spring_sleep(spring_msecs(5));
+		loopback.Update();
+	}
+
+	for (int i = 0; i < NUM_CLIENTS; ++i) {
+		BOOST_CHECK_MESSAGE(loopback.received[i] == loopback.expected[i], "client " << i << " received a different stream");
+	}
+
+	return loopback.serverTime;
+}
+
+
+BOOST_AUTO_TEST_CASE(BroadcastLoopback)
+{
+	spring_clock::PushTickRate();
+	spring_time::setstarttime(spring_time::gettime(true));
+
+	GlobalConfig::Instantiate();
+	globalConfig->linkOutgoingBandwidth = 0;
+
+	const spring_time perConnTime = RunLoopback(23000, false);
+	const spring_time sharedTime = RunLoopback(23400, true);
+
+	BOOST_TEST_MESSAGE("server time for " << NUM_CLIENTS << " clients: " << perConnTime.toMilliSecsf() << "ms per connection, " << sharedTime.toMilliSecsf() << "ms with shared blocks");
+	BOOST_WARN(sharedTime < perConnTime);
+
+	GlobalConfig::Deallocate();
+}
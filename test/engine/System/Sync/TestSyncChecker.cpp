@@ -0,0 +1,77 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Sync/SyncChecker.h"
+
+#include <boost/thread.hpp>
+#include <vector>
+
+#define BOOST_TEST_MODULE SyncChecker
+#include <boost/test/unit_test.hpp>
+
+
+static void SyncRange(unsigned int lane, unsigned int first, unsigned int count)
+{
+	CScopedSyncLane scopedLane(lane);
+
+	for (unsigned int i = first; i < first + count; ++i) {
+		CSyncChecker::Sync(&i, sizeof(i));
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( EveryByteCounts )
+{
+	std::vector<unsigned char> data(100);
+
+	for (unsigned int size = 1; size <= data.size(); ++size) {
+		for (unsigned int i = 0; i < size; ++i) {
+			std::fill(data.begin(), data.end(), 0);
+
+			CSyncChecker::NewFrame();
+			CSyncChecker::Sync(&data[0], size);
+			const unsigned int checksum = CSyncChecker::GetChecksum();
+
+			data[i] = 1;
+
+			CSyncChecker::NewFrame();
+			CSyncChecker::Sync(&data[0], size);
+			BOOST_CHECK_MESSAGE(checksum != CSyncChecker::GetChecksum(), "size " << size << ", byte " << i);
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( LanesAreIndependent )
+{
+	CSyncChecker::NewFrame();
+	SyncRange(SYNC_LANE_UNITS, 0, 1000);
+	SyncRange(SYNC_LANE_PROJECTILES, 1000, 1000);
+	const SyncChecksums serial = CSyncChecker::GetChecksums();
+
+	// the order in which lanes are written does not matter
+	CSyncChecker::NewFrame();
+	SyncRange(SYNC_LANE_PROJECTILES, 1000, 1000);
+	SyncRange(SYNC_LANE_UNITS, 0, 1000);
+	BOOST_CHECK_EQUAL(serial.checksum, CSyncChecker::GetChecksum());
+
+	// neither does writing them from different threads
+	CSyncChecker::NewFrame();
+	boost::thread units(SyncRange, SYNC_LANE_UNITS, 0, 1000);
+	boost::thread projectiles(SyncRange, SYNC_LANE_PROJECTILES, 1000, 1000);
+	units.join();
+	projectiles.join();
+	BOOST_CHECK_EQUAL(serial.checksum, CSyncChecker::GetChecksum());
+
+	// but which lane a write goes to does
+	CSyncChecker::NewFrame();
+	SyncRange(SYNC_LANE_UNITS, 0, 1000);
+	SyncRange(SYNC_LANE_FEATURES, 1000, 1000);
+	const SyncChecksums desynced = CSyncChecker::GetChecksums();
+
+	BOOST_CHECK(serial.checksum != desynced.checksum);
+	BOOST_CHECK_EQUAL(serial.FirstDivergingLane(desynced), unsigned(SYNC_LANE_PROJECTILES));
+	BOOST_CHECK_EQUAL(serial.FirstDivergingLane(serial), unsigned(NUM_SYNC_LANES));
+
+	// the lane is restored at the end of the scope
+	BOOST_CHECK_EQUAL(CSyncChecker::GetLane(), unsigned(SYNC_LANE_GENERAL));
+}
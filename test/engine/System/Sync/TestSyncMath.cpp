@@ -0,0 +1,116 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/myMath.h"
+#include "System/FastMath.h"
+#include "System/Sync/FPUCheck.h"
+#include "Sim/Units/Scripts/CobInstance.h" // TAANG2RAD
+
+#include <boost/thread.hpp>
+
+#define BOOST_TEST_MODULE SyncMath
+#include <boost/test/unit_test.hpp>
+
+
+// SyncMathChecksum() of a correct (streflop SSE) build
+#define SYNC_MATH_CHECKSUM 0x6fefb679u
+
+/// bitwise hash over the synced math kernels, fed with a fixed set of inputs
+static unsigned int SyncMathChecksum()
+{
+	unsigned int checksum = 0;
+
+	const auto hash = [&checksum](float f) {
+		checksum = 33 * checksum + *(unsigned int*) &f;
+	};
+
+	for (int h = -SHORTINT_MAXVALUE; h < SHORTINT_MAXVALUE; h += 7) {
+		const float3 v = GetVectorFromHeading(h);
+
+		hash(GetSinFromHeading(h));
+		hash(GetCosFromHeading(h));
+		hash(v.x);
+		hash(v.z);
+		hash(GetHeadingFromVector(v.x, v.z));
+	}
+
+	for (int i = 1; i < 100000; i += 13) {
+		const float x = i * 0.37f;
+		const float a = (i % 2001) * 0.001f - 1.0f;
+
+		hash(math::sqrt(x));
+		hash(math::isqrt(x));
+		hash(math::sin(x));
+		hash(math::cos(x));
+		hash(math::acos(a));
+		hash(math::atan2(a, x));
+		hash(float3(a, x, -a).Normalize().y);
+	}
+
+	return checksum;
+}
+
+
+struct InitSyncMath {
+	InitSyncMath() {
+		good_fpu_init();
+		// throws if the heading tables do not match their checksums
+		CMyMath::Init();
+	}
+};
+
+BOOST_GLOBAL_FIXTURE(InitSyncMath);
+
+
+BOOST_AUTO_TEST_CASE( HeadingTables )
+{
+	for (int h = 0; h <= (SHORTINT_MAXVALUE >> 1); h++) {
+		// first quadrant is exact
+		BOOST_CHECK(GetSinFromHeading(h) == math::sin(h * TAANG2RAD));
+		BOOST_CHECK(GetSinFromHeading(-h) == -GetSinFromHeading(h));
+	}
+
+	for (int h = -SHORTINT_MAXVALUE; h < SHORTINT_MAXVALUE; h++) {
+		BOOST_CHECK_SMALL(GetSinFromHeading(h) - math::sin(h * TAANG2RAD), 1e-6f);
+		BOOST_CHECK_SMALL(GetCosFromHeading(h) - math::cos(h * TAANG2RAD), 1e-6f);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE( KnownResults )
+{
+	// same value on every machine and compiler, or clients built with
+	// them will desync: if this changes on purpose update the constant
+	const unsigned int checksum = SyncMathChecksum();
+
+	BOOST_CHECK_EQUAL(checksum, SYNC_MATH_CHECKSUM);
+}
+
+
+BOOST_AUTO_TEST_CASE( ReproducibleAfterFPUReset )
+{
+	const unsigned int checksum = SyncMathChecksum();
+
+	BOOST_CHECK_EQUAL(checksum, SyncMathChecksum());
+
+	// mess up the rounding mode, FPUCheck has to restore the synced state
+	streflop::fesetround(streflop::FE_UPWARD);
+	good_fpu_control_registers("ReproducibleAfterFPUReset");
+
+	BOOST_CHECK_EQUAL(checksum, SyncMathChecksum());
+}
+
+
+BOOST_AUTO_TEST_CASE( ReproducibleInThreads )
+{
+	const unsigned int checksum = SyncMathChecksum();
+	unsigned int threadChecksum = 0;
+
+	boost::thread thread([&]() {
+		// what streflop_init_omp does for the worker threads
+		streflop::streflop_init<streflop::Simple>();
+		threadChecksum = SyncMathChecksum();
+	});
+	thread.join();
+
+	BOOST_CHECK_EQUAL(checksum, threadChecksum);
+}
@@ -0,0 +1,145 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/TimeProfiler.h"
+#include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <boost/thread.hpp>
+
+#define BOOST_TEST_MODULE TimeProfiler
+#include <boost/test/unit_test.hpp>
+
+
+struct InitSpringTime {
+	InitSpringTime() {
+		spring_clock::PushTickRate();
+		spring_time::setstarttime(spring_time::gettime(true));
+	}
+};
+
+BOOST_GLOBAL_FIXTURE(InitSpringTime);
+
+
+static void TimedFunction()
+{
+	SCOPED_TIMER("TestTimer");
+}
+
+/// stops the running trace and returns the written JSON
+static std::string StopTrace()
+{
+	const std::string fileName = "testTimeProfiler_trace.json";
+	BOOST_CHECK(profiler.StopTrace(fileName));
+	BOOST_CHECK(!profiler.IsTracing());
+
+	std::ifstream file(fileName.c_str());
+	std::stringstream json;
+	json << file.rdbuf();
+	file.close();
+	std::remove(fileName.c_str());
+
+	return json.str();
+}
+
+/// number of trace events of the timer called <name>
+static int CountEvents(const std::string& trace, const std::string& name)
+{
+	const std::string quotedName = "\"" + name + "\"";
+	int numEvents = 0;
+
+	for (size_t pos = trace.find(quotedName); pos != std::string::npos; pos = trace.find(quotedName, pos + 1)) {
+		numEvents++;
+	}
+
+	return numEvents;
+}
+
+
+BOOST_AUTO_TEST_CASE( TimerIDs )
+{
+	const int id = profiler.GetTimerID("TestTimerID");
+
+	BOOST_CHECK(id >= 0);
+	BOOST_CHECK(profiler.GetTimerID("TestTimerID") == id);
+	BOOST_CHECK(profiler.GetTimerID("TestTimerID2") != id);
+}
+
+
+BOOST_AUTO_TEST_CASE( NestedTimers )
+{
+	const int id = profiler.GetTimerID("TestNested");
+	const int innerID = profiler.GetTimerID("TestNestedInner");
+
+	profiler.StartTrace();
+	{
+		ScopedTimer outer(id);
+		ScopedTimer inner(id);
+		ScopedTimer innermost(innerID);
+	}
+
+	const std::string str = StopTrace();
+
+	// nested timers with the same ID are only counted once
+	BOOST_CHECK_EQUAL(CountEvents(str, "TestNested"), 1);
+	BOOST_CHECK_EQUAL(CountEvents(str, "TestNestedInner"), 1);
+
+	// events are recorded when the timers end, so the innermost comes first
+	BOOST_CHECK(str.find("\"TestNestedInner\"") < str.find("\"TestNested\""));
+}
+
+
+BOOST_AUTO_TEST_CASE( ThreadedTimersAndTrace )
+{
+	const int numThreads = 4;
+	const int numCalls = 1000;
+
+	profiler.StartTrace();
+
+	std::vector<boost::thread*> threads;
+	for (int i = 0; i < numThreads; i++) {
+		threads.push_back(new boost::thread([&]() {
+			for (int n = 0; n < numCalls; n++) {
+				TimedFunction();
+			}
+		}));
+	}
+	for (boost::thread* t: threads) {
+		t->join();
+		delete t;
+	}
+
+	// the buffers of the exited threads are drained (and freed) here
+	const std::string str = StopTrace();
+
+	// all events of the threads must have been processed into the record
+	BOOST_CHECK(profiler.profile.find("TestTimer") != profiler.profile.end());
+
+	BOOST_CHECK(str.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+	BOOST_CHECK(str.find("]}") != std::string::npos);
+	BOOST_CHECK_EQUAL(CountEvents(str, "TestTimer"), numThreads * numCalls);
+
+	// a thread started after the freed ones gets a new buffer
+	profiler.StartTrace();
+	boost::thread t(&TimedFunction);
+	t.join();
+	BOOST_CHECK_EQUAL(CountEvents(StopTrace(), "TestTimer"), 1);
+}
+
+
+BOOST_AUTO_TEST_CASE( EmptyTrace )
+{
+	// the threads of the previous cases are still named in the trace
+	profiler.StartTrace();
+
+	const std::string str = StopTrace();
+
+	BOOST_CHECK_EQUAL(CountEvents(str, "TestTimer"), 0);
+	BOOST_CHECK(str.find("thread_name") != std::string::npos);
+
+	// no separator may be left dangling before the end of the list
+	BOOST_CHECK(str.find(",\n]") == std::string::npos);
+	BOOST_CHECK(str.find(",]") == std::string::npos);
+}
@@ -0,0 +1,132 @@
+function gadget:GetInfo()
+return {
+	name    = "COB-Benchmark",
+	desc    = "Measures COB script calls per second and sim frame times + autoexit",
+	author  = "spring",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+local startframe = 150 -- let the game spawn its units first
+local numframes = 300 -- frames to measure for
+local numunits = 200 -- COB units to spawn
+local callsperunit = 10 -- calls of every benchmarked function per unit and frame
+
+if (gadgetHandler:IsSyncedCode()) then
+
+-- functions most COB scripts implement, the ones a unit lacks are skipped
+local funcnames = {"QueryWeapon1", "AimFromWeapon1", "QueryPrimary", "AimFromPrimary", "Activate", "Deactivate"}
+
+local CallCOBScript = Spring.CallCOBScript
+local GetCOBScriptID = Spring.GetCOBScriptID
+local random = math.random
+
+local units = {}
+
+local function SpawnUnits()
+	local cobdefs = {}
+	for udid, ud in pairs(UnitDefs) do
+		if (ud.scriptName:lower():find("%.cob$")) then
+			cobdefs[#cobdefs + 1] = udid
+		end
+	end
+	if (#cobdefs == 0) then
+		Spring.Echo("COB benchmark: no COB scripted unitdefs found")
+		return
+	end
+	table.sort(cobdefs)
+
+	local mapx, mapz = Game.mapSizeX, Game.mapSizeZ
+	local teamID = Spring.GetTeamList()[1]
+	for i = 1, numunits do
+		local x, z = random() * mapx, random() * mapz
+		local unitID = Spring.CreateUnit(cobdefs[(i % #cobdefs) + 1], x, Spring.GetGroundHeight(x, z), z, "n", teamID)
+		if (unitID) then
+			local funcs = {}
+			for _, name in ipairs(funcnames) do
+				local funcID = GetCOBScriptID(unitID, name)
+				if (funcID) then
+					funcs[#funcs + 1] = funcID
+				end
+			end
+			units[#units + 1] = {unitID, funcs}
+		end
+	end
+end
+
+function gadget:GameFrame(n)
+	if n < startframe or n >= startframe + numframes then
+		return
+	end
+	if n == startframe then
+		SpawnUnits()
+	end
+
+	-- the unsynced part times everything between these two
+	local calls = 0
+	SendToUnsynced("bench_cob", "begin")
+	for i = 1, #units do
+		local unitID, funcs = units[i][1], units[i][2]
+		for j = 1, #funcs do
+			for k = 1, callsperunit do
+				CallCOBScript(unitID, funcs[j], 1, 0)
+			end
+			calls = calls + callsperunit
+		end
+	end
+	SendToUnsynced("bench_cob", "end", calls, #units)
+end
+
+else -- unsynced: timers are not available to synced code
+
+local GetTimer = Spring.GetTimer
+local DiffTimers = Spring.DiffTimers
+
+local spawnedunits = 0
+local calls = 0
+local calltime = 0
+local calltimer = nil
+local frames = 0
+local frametime = 0
+local lastframe = nil
+
+local function ShowStats()
+	Spring.Echo("COB benchmark done:")
+	Spring.Echo(string.format("calls  %10.0f calls/s (%i calls, %i units, %.3fs)",
+		calls / math.max(calltime, 1e-6), calls, spawnedunits, calltime))
+	Spring.Echo(string.format("frames %10.3f ms/frame (%i frames)",
+		frametime * 1000 / math.max(frames, 1), frames))
+end
+
+function gadget:RecvFromSynced(cmd, what, n, units)
+	if cmd ~= "bench_cob" then
+		return false
+	end
+	if what == "begin" then
+		calltimer = GetTimer()
+	elseif calltimer then
+		calltime = calltime + DiffTimers(GetTimer(), calltimer)
+		calls = calls + n
+		spawnedunits = units
+	end
+	return true
+end
+
+function gadget:GameFrame(n)
+	local now = GetTimer()
+	if (lastframe and n > startframe) then
+		frametime = frametime + DiffTimers(now, lastframe)
+		frames = frames + 1
+	end
+	lastframe = now
+
+	if n == startframe + numframes then
+		ShowStats()
+		Spring.SendCommands("quitforce")
+	end
+end
+
+end
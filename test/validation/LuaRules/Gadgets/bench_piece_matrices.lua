@@ -0,0 +1,114 @@
+function gadget:GetInfo()
+return {
+	name    = "PieceMatrices-Benchmark",
+	desc    = "Measures sim frame times with many units animating all their pieces + autoexit",
+	author  = "spring",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+local startframe = 150 -- let the game spawn its units first
+local numframes = 300 -- frames to measure for
+local numunits = 5000 -- units to spawn
+local minpieces = 30 -- prefer unitdefs with at least this many pieces
+
+if (gadgetHandler:IsSyncedCode()) then
+
+local random = math.random
+
+-- the unitdef whose model has the most pieces (the first one with >= minpieces)
+local function FindUnitDef()
+	local bestudid, bestcount = nil, 0
+	local x, z = Game.mapSizeX * 0.5, Game.mapSizeZ * 0.5
+	local teamID = Spring.GetTeamList()[1]
+
+	for udid in pairs(UnitDefs) do
+		local unitID = Spring.CreateUnit(udid, x, Spring.GetGroundHeight(x, z), z, "n", teamID)
+		if (unitID) then
+			local count = #(Spring.GetUnitPieceList(unitID) or {})
+			Spring.DestroyUnit(unitID, false, true)
+			if (count > bestcount) then
+				bestudid, bestcount = udid, count
+			end
+			if (bestcount >= minpieces) then
+				break
+			end
+		end
+	end
+	return bestudid
+end
+
+local function SpawnUnits()
+	local udid = FindUnitDef()
+	if (not udid) then
+		Spring.Echo("PieceMatrices benchmark: no unitdef could be spawned")
+		return
+	end
+
+	local Spin = Spring.UnitScript.Spin
+	local mapx, mapz = Game.mapSizeX, Game.mapSizeZ
+	local teamID = Spring.GetTeamList()[1]
+	local numpieces = 0
+	for i = 1, numunits do
+		local x, z = random() * mapx, random() * mapz
+		local unitID = Spring.CreateUnit(udid, x, Spring.GetGroundHeight(x, z), z, "n", teamID)
+		if (unitID) then
+			local pieces = Spring.GetUnitPieceList(unitID)
+			-- spinning pieces dirty their matrices (and those of their children) every frame
+			for p = 1, #pieces do
+				Spring.UnitScript.CallAsUnit(unitID, Spin, p, (p % 3) + 1, 0.5 + random())
+			end
+			numpieces = numpieces + #pieces
+		end
+	end
+	SendToUnsynced("bench_piece_matrices", numpieces)
+end
+
+function gadget:GameFrame(n)
+	if n == startframe then
+		SpawnUnits()
+	end
+end
+
+else -- unsynced: timers are not available to synced code
+
+local GetTimer = Spring.GetTimer
+local DiffTimers = Spring.DiffTimers
+
+local numpieces = 0
+local frames = 0
+local frametime = 0
+local lastframe = nil
+
+local function ShowStats()
+	Spring.Echo("PieceMatrices benchmark done:")
+	Spring.Echo(string.format("%i pieces, %10.3f ms/frame (%i frames)",
+		numpieces, frametime * 1000 / math.max(frames, 1), frames))
+end
+
+function gadget:RecvFromSynced(cmd, pieces)
+	if cmd ~= "bench_piece_matrices" then
+		return false
+	end
+	numpieces = pieces
+	return true
+end
+
+function gadget:GameFrame(n)
+	local now = GetTimer()
+	if (lastframe and n > startframe + 1) then
+		frametime = frametime + DiffTimers(now, lastframe)
+		frames = frames + 1
+	end
+	lastframe = now
+
+	if n == startframe + numframes then
+		ShowStats()
+		Spring.SendCommands("quitforce")
+	end
+end
+
+end
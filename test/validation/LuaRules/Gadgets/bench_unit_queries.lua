@@ -0,0 +1,113 @@
+function gadget:GetInfo()
+return {
+	name    = "UnitQueries-Benchmark",
+	desc    = "Measures spatial unit queries per second (GetUnitsIn*) + autoexit",
+	author  = "spring",
+	date    = "Oct. 2026",
+	license = "GNU GPL, v2 or later",
+	layer   = 0,
+	enabled = true,
+}
+end
+
+-- timers are only available to unsynced code, the queries work in both
+if (gadgetHandler:IsSyncedCode()) then
+	return
+end
+
+local startframe = 150 -- let the game spawn its units first
+local numframes = 300 -- frames to measure for
+local queriesperframe = 200 -- centres sampled per frame
+local radius = 400
+
+local GetUnitsInCylinder = Spring.GetUnitsInCylinder
+local GetUnitsInCylinders = Spring.GetUnitsInCylinders
+local GetUnitsInRectangle = Spring.GetUnitsInRectangle
+local GetTimer = Spring.GetTimer
+local DiffTimers = Spring.DiffTimers
+local random = math.random
+
+local stats = {
+	single = {time = 0, queries = 0, units = 0},
+	reused = {time = 0, queries = 0, units = 0},
+	batched = {time = 0, queries = 0, units = 0},
+	rectangle = {time = 0, queries = 0, units = 0},
+}
+
+local centres = {}
+local cylinders = {}
+local result = {}
+local results = {}
+
+local function SampleCentres()
+	local mapx, mapz = Game.mapSizeX, Game.mapSizeZ
+	for i = 1, queriesperframe do
+		local x, z = random() * mapx, random() * mapz
+		centres[i * 2 - 1] = x
+		centres[i * 2    ] = z
+		cylinders[i * 3 - 2] = x
+		cylinders[i * 3 - 1] = z
+		cylinders[i * 3    ] = radius
+	end
+end
+
+local function Measure(name, func)
+	local s = stats[name]
+	local timer = GetTimer()
+	s.units = s.units + func()
+	s.time = s.time + DiffTimers(GetTimer(), timer)
+	s.queries = s.queries + queriesperframe
+end
+
+local function ShowStats()
+	Spring.Echo("UnitQueries benchmark done:")
+	for _, name in ipairs({"single", "reused", "batched", "rectangle"}) do
+		local s = stats[name]
+		Spring.Echo(string.format("%-10s %10.0f queries/s (%i queries, %i units, %.3fs)",
+			name, s.queries / math.max(s.time, 1e-6), s.queries, s.units, s.time))
+	end
+end
+
+function gadget:GameFrame(n)
+	if n < startframe then
+		return
+	end
+	if n == startframe + numframes then
+		ShowStats()
+		Spring.SendCommands("quitforce")
+		return
+	end
+
+	SampleCentres()
+
+	Measure("single", function()
+		local cnt = 0
+		for i = 1, queriesperframe do
+			cnt = cnt + #GetUnitsInCylinder(centres[i * 2 - 1], centres[i * 2], radius)
+		end
+		return cnt
+	end)
+	Measure("reused", function()
+		local cnt = 0
+		for i = 1, queriesperframe do
+			cnt = cnt + #GetUnitsInCylinder(centres[i * 2 - 1], centres[i * 2], radius, nil, result)
+		end
+		return cnt
+	end)
+	Measure("batched", function()
+		local cnt = 0
+		GetUnitsInCylinders(cylinders, nil, results)
+		for i = 1, queriesperframe do
+			cnt = cnt + #results[i]
+		end
+		return cnt
+	end)
+	Measure("rectangle", function()
+		local cnt = 0
+		for i = 1, queriesperframe do
+			local x, z = centres[i * 2 - 1], centres[i * 2]
+			cnt = cnt + #GetUnitsInRectangle(x - radius, z - radius, x + radius, z + radius, nil, result)
+		end
+		return cnt
+	end)
+end